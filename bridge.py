@@ -1,33 +1,121 @@
 #!/usr/bin/env python3
-import serial
+import argparse
+import functools
 import json
 import threading
 import time
 import glob
-from http.server import HTTPServer, BaseHTTPRequestHandler
+from http.server import ThreadingHTTPServer, BaseHTTPRequestHandler
 
-latest_data = {}
-data_lock = threading.Lock()
-connection_status = {"connected": False}
+from telemetry import HISTORY_TIERS, FrameReader, encode_frame, merge_sample
+
+try:
+    import serial
+except ImportError:
+    serial = None   # only needed without --fake
+
+KEEPALIVE_S = 15
+
+class Snapshot:
+    """
+    One published state, serialized once. Snapshots are never modified:
+    publish() swaps in a new one and sets the old one's `superseded` event,
+    so readers only need the current reference and no lock.
+    """
+    __slots__ = ('version', 'data', 'connected', 'body', 'event', 'superseded')
+    
+    def __init__(self, version, data, connected):
+        self.version = version
+        self.data = data
+        self.connected = connected
+        response = dict(data)
+        response['connected'] = connected
+        self.body = json.dumps(response).encode()
+        self.event = b'data: ' + self.body + b'\n\n'
+        self.superseded = threading.Event()
+
+current = Snapshot(0, {}, False)
+publish_lock = threading.Lock()
+
+# Device history per tier, backfilled on every connect; replaced whole, never modified
+history = {}
+history_pending = {}
+
+def publish(data=None, connected=None):
+    """Publish a new sample and/or connection state and wake stream clients"""
+    global current
+    with publish_lock:
+        old = current
+        if data is None and (connected is None or connected == old.connected):
+            return
+        current = Snapshot(old.version + 1,
+                           old.data if data is None else data,
+                           old.connected if connected is None else connected)
+    old.superseded.set()
 
 class Handler(BaseHTTPRequestHandler):
+    # Keep-alive for polling clients; headers and body go out in separate
+    # writes, so without TCP_NODELAY each response waits for a delayed ACK
+    protocol_version = 'HTTP/1.1'
+    disable_nagle_algorithm = True
+    
     def do_GET(self):
         if self.path == '/api/sensors':
+            body = current.body
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(body)))
+            self.send_header('Access-Control-Allow-Origin', '*')
+            self.end_headers()
+            self.wfile.write(body)
+        elif self.path == '/api/stream':
+            self.stream()
+        elif self.path == '/api/history':
+            body = json.dumps(history).encode()
             self.send_response(200)
             self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(body)))
             self.send_header('Access-Control-Allow-Origin', '*')
             self.end_headers()
-            with data_lock:
-                response = dict(latest_data)
-                response['connected'] = connection_status['connected']
-                self.wfile.write(json.dumps(response).encode())
+            self.wfile.write(body)
         else:
             self.send_response(404)
+            self.send_header('Content-Length', '0')
             self.end_headers()
     
+    def stream(self):
+        """Server-Sent Events: one event per snapshot, comments as keepalive"""
+        self.close_connection = True
+        self.send_response(200)
+        self.send_header('Content-Type', 'text/event-stream')
+        self.send_header('Cache-Control', 'no-cache')
+        self.send_header('Connection', 'close')
+        self.send_header('Access-Control-Allow-Origin', '*')
+        self.end_headers()
+        
+        snap = current
+        event = snap.event
+        while True:
+            try:
+                self.wfile.write(event)
+                self.wfile.flush()
+            except (BrokenPipeError, ConnectionResetError):
+                return
+            # Intermediate snapshots are skipped if this client falls behind
+            if snap.superseded.wait(KEEPALIVE_S):
+                snap = current
+                event = snap.event
+            else:
+                event = b": keepalive\n\n"
+    
     def log_message(self, *args):
         pass
 
+class BridgeServer(ThreadingHTTPServer):
+    daemon_threads = True
+    # Many dashboards may connect at once
+    request_queue_size = 128
+
 def find_esp32_port():
     """Find available serial ports, preferring /dev/ttyUSB*"""
     try:
@@ -39,8 +127,33 @@ def find_esp32_port():
         pass
     return None
 
+def request_history(ser):
+    """Ask the device for everything it kept while nobody was listening"""
+    history_pending.clear()
+    for tier in HISTORY_TIERS:
+        ser.write(f"history {tier}\n".encode())
+
+def take_history(samples):
+    """Collect history lines from the device; returns the live samples"""
+    global history
+    live = []
+    for sample in samples:
+        if 'history' in sample:
+            point = dict(sample['history'])
+            history_pending.setdefault(point.pop('tier'), []).append(point)
+        elif 'history_block' in sample:
+            block = sample['history_block']
+            history_pending.setdefault(block['tier'], []).extend(block['points'])
+        elif 'history_end' in sample:
+            tier = sample['history_end']['tier']
+            history = dict(history, **{tier: history_pending.pop(tier, [])})
+        elif 'log_chunk' in sample or 'log_end' in sample:
+            pass    # a log export, for sample_log.py
+        else:
+            live.append(sample)
+    return live
+
 def read_serial():
-    global latest_data
     last_port = None
     
     while True:
@@ -51,7 +164,7 @@ def read_serial():
                 if last_port:
                     print(f"✗ ESP32 disconnected (port {last_port} not found)")
                     last_port = None
-                connection_status['connected'] = False
+                publish(connected=False)
                 time.sleep(1)
                 continue
             
@@ -61,33 +174,68 @@ def read_serial():
             
             ser = serial.Serial(port, 115200, timeout=2)
             print(f"✓ Connected to ESP32 on {port}")
-            connection_status['connected'] = True
+            publish(connected=True)
+            reader = FrameReader()
+            request_history(ser)
             
             while True:
                 try:
-                    line = ser.readline().decode('utf-8', errors='ignore').strip()
-                    if line.startswith('{') and line.endswith('}'):
-                        data = json.loads(line)
-                        with data_lock:
-                            latest_data = data
-                except json.JSONDecodeError:
-                    pass
+                    # Binary frames and JSON debug lines are both accepted
+                    samples = take_history(reader.feed(ser.read(ser.in_waiting or 1)))
+                    if samples:
+                        publish(data=functools.reduce(merge_sample, samples, current.data))
                 except Exception as e:
                     print(f"Read error: {e}")
                     break
         except serial.SerialException as e:
-            connection_status['connected'] = False
+            publish(connected=False)
             print(f"✗ Serial error: {e}")
             time.sleep(1)
         except Exception as e:
-            connection_status['connected'] = False
+            publish(connected=False)
             print(f"✗ Error: {e}")
             time.sleep(1)
 
+def fake_serial(rate_hz):
+    """Synthetic telemetry frames through the same decode path, for load tests"""
+    reader = FrameReader()
+    publish(connected=True)
+    seq = 0
+    while True:
+        pm2_5 = 20 + seq % 60
+        frame = encode_frame({
+            'timestamp_ms': seq * 3000, 'temperature': 22.0 + (seq % 400) * 0.01,
+            'humidity': 45.0, 'pressure': 1008.0, 'iaq': 50.0, 'h2s': 1200,
+            'odor': 900, 'pm1_0': pm2_5 * 6 // 10, 'pm2_5': pm2_5,
+            'pm10': pm2_5 * 16 // 10, 'aqi': 60.0, 'aqi_level': 'Moderate', 'aqi_pollutant': 'pm2_5',
+            'h2s_voltage': 0.905, 'odor_voltage': 0.680,
+            'h2s_noise_mv': 1.2, 'odor_noise_mv': 1.1,
+            'exhaust': {'temperature': 22.8, 'humidity': 43.0, 'pressure': 1007.9, 'iaq': 30.0},
+        }, seq & 0xFFFF)
+        for sample in reader.feed(frame):
+            publish(data=sample)
+        seq += 1
+        time.sleep(1 / rate_hz)
+
 if __name__ == '__main__':
-    threading.Thread(target=read_serial, daemon=True).start()
-    server = HTTPServer(('localhost', 8888), Handler)
-    print("API: http://localhost:8888/api/sensors")
-    print("Auto-detecting ESP32 on serial ports...")
+    parser = argparse.ArgumentParser(description='Serve ESP32 telemetry over HTTP')
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', type=int, default=8888)
+    parser.add_argument('--fake', type=float, metavar='HZ',
+                        help='publish synthetic samples at HZ instead of reading serial')
+    args = parser.parse_args()
+    if not args.fake and serial is None:
+        parser.error('pyserial is not installed (pip install pyserial)')
+    
+    if args.fake:
+        threading.Thread(target=fake_serial, args=(args.fake,), daemon=True).start()
+    else:
+        threading.Thread(target=read_serial, daemon=True).start()
+    server = BridgeServer((args.host, args.port), Handler)
+    print(f"API: http://{args.host}:{args.port}/api/sensors")
+    print(f"Stream: http://{args.host}:{args.port}/api/stream")
+    print(f"History: http://{args.host}:{args.port}/api/history")
+    if not args.fake:
+        print("Auto-detecting ESP32 on serial ports...")
     print("Press Ctrl+C to stop")
     server.serve_forever()
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Load test for bridge.py.
+
+Starts the bridge with a fake serial source (bridge.py --fake) unless --port
+points at a running one, then measures:
+
+  poll:   N keep-alive clients looping GET /api/sensors -> requests/s, latency
+  stream: N clients on GET /api/stream -> events delivered, fan-out spread
+          (arrival of each sample at a client minus its first arrival anywhere)
+
+  python3 bridge_loadtest.py [-c 100] [-d 10] [--rate 10] [--port PORT]
+"""
+import argparse
+import asyncio
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+
+def percentile(values, p):
+    if not values:
+        return float('nan')
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+async def read_headers(reader):
+    status = await reader.readline()
+    length = None
+    while True:
+        line = await reader.readline()
+        if line in (b'\r\n', b'\n', b''):
+            break
+        name, _, value = line.partition(b':')
+        if name.strip().lower() == b'content-length':
+            length = int(value)
+    return status, length
+
+
+async def poll_client(host, port, deadline, latencies, errors):
+    reader, writer = await asyncio.open_connection(host, port)
+    request = f'GET /api/sensors HTTP/1.1\r\nHost: {host}\r\n\r\n'.encode()
+    try:
+        while time.perf_counter() < deadline:
+            t0 = time.perf_counter()
+            writer.write(request)
+            status, length = await read_headers(reader)
+            if length is None:
+                errors.append(status)
+                return
+            await reader.readexactly(length)
+            latencies.append(time.perf_counter() - t0)
+            if not status.startswith(b'HTTP/1.1 200'):
+                errors.append(status)
+    finally:
+        writer.close()
+
+
+async def stream_client(host, port, deadline, arrivals, errors):
+    reader, writer = await asyncio.open_connection(host, port)
+    writer.write(f'GET /api/stream HTTP/1.1\r\nHost: {host}\r\n\r\n'.encode())
+    received = []
+    try:
+        status, _ = await read_headers(reader)
+        if not status.startswith(b'HTTP/1.1 200'):
+            errors.append(status)
+            return
+        while True:
+            remaining = deadline - time.perf_counter()
+            if remaining <= 0:
+                break
+            try:
+                line = await asyncio.wait_for(reader.readline(), remaining)
+            except asyncio.TimeoutError:
+                break
+            if not line:
+                errors.append(b'closed')
+                break
+            if line.startswith(b'data: '):
+                sample = json.loads(line[6:])
+                if 'seq' in sample:
+                    received.append((sample['seq'], time.perf_counter()))
+    finally:
+        writer.close()
+        arrivals.append(received)
+
+
+async def run_poll(args):
+    latencies, errors = [], []
+    start = time.perf_counter()
+    deadline = start + args.duration
+    await asyncio.gather(*(poll_client(args.host, args.port, deadline, latencies, errors)
+                           for _ in range(args.clients)))
+    elapsed = time.perf_counter() - start
+    print(f"poll:   {args.clients} clients, {len(latencies)} requests in {elapsed:.1f} s, "
+          f"{len(latencies) / elapsed:.0f} req/s, errors {len(errors)}")
+    print(f"        latency p50 {percentile(latencies, 50) * 1e3:.2f} ms, "
+          f"p99 {percentile(latencies, 99) * 1e3:.2f} ms, max {max(latencies) * 1e3:.2f} ms")
+
+
+async def run_stream(args):
+    arrivals, errors = [], []
+    deadline = time.perf_counter() + args.duration
+    await asyncio.gather(*(stream_client(args.host, args.port, deadline, arrivals, errors)
+                           for _ in range(args.clients)))
+
+    first = {}
+    for received in arrivals:
+        for seq, t in received:
+            first[seq] = min(t, first.get(seq, t))
+    spread = [t - first[seq] for received in arrivals for seq, t in received]
+    events = sum(len(received) for received in arrivals)
+    # A client misses samples only if it fell behind by more than one snapshot
+    missed = sum(len(first) - len(received) for received in arrivals)
+    print(f"stream: {args.clients} clients, {len(first)} samples, {events} events delivered, "
+          f"missed {missed}, errors {len(errors)}")
+    print(f"        fan-out spread p50 {percentile(spread, 50) * 1e3:.2f} ms, "
+          f"p99 {percentile(spread, 99) * 1e3:.2f} ms, max {max(spread, default=0) * 1e3:.2f} ms")
+
+
+def wait_for_port(host, port, timeout=10):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            socket.create_connection((host, port), timeout=0.2).close()
+            return True
+        except OSError:
+            time.sleep(0.1)
+    return False
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(('127.0.0.1', 0))
+        return s.getsockname()[1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-c', '--clients', type=int, default=100)
+    parser.add_argument('-d', '--duration', type=float, default=10, help='seconds per phase')
+    parser.add_argument('--rate', type=float, default=10, help='fake samples per second')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, help='use a bridge already running on this port')
+    args = parser.parse_args()
+
+    bridge = None
+    if args.port is None:
+        args.port = free_port()
+        here = os.path.dirname(os.path.abspath(__file__))
+        bridge = subprocess.Popen([sys.executable, os.path.join(here, 'bridge.py'), '--fake', str(args.rate),
+                                   '--host', args.host, '--port', str(args.port)],
+                                  stdout=subprocess.DEVNULL)
+    try:
+        if not wait_for_port(args.host, args.port):
+            sys.exit('bridge did not start')
+        asyncio.run(run_poll(args))
+        asyncio.run(run_stream(args))
+    finally:
+        if bridge is not None:
+            bridge.terminate()
+            bridge.wait()
+
+
+if __name__ == '__main__':
+    main()
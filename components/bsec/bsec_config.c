@@ -0,0 +1,43 @@
+#include <string.h>
+
+#include "bsec_config.h"
+
+uint8_t bsec_work_buffer[BSEC_MAX_WORKBUFFER_SIZE];
+
+#ifndef BSEC_CONFIG_NAME
+#define BSEC_CONFIG_NAME    "none"
+#endif
+
+#if BSEC_CONFIG_EMBEDDED
+/* Linked by target_add_binary_data() from the copy in the build directory */
+extern const uint8_t config_start[] asm("_binary_bsec_config_bin_start");
+extern const uint8_t config_end[] asm("_binary_bsec_config_bin_end");
+#endif
+
+const char *bsec_config_name(void)
+{
+    return BSEC_CONFIG_NAME;
+}
+
+uint32_t bsec_config_blob(const uint8_t **blob)
+{
+#if BSEC_CONFIG_EMBEDDED
+    uint32_t len = (uint32_t)(config_end - config_start);
+    uint32_t prefix = 0;
+
+    /* Some releases store the blob behind its own little-endian length */
+    if (len > 4) {
+        memcpy(&prefix, config_start, sizeof(prefix));
+    }
+    if (len > 4 && prefix == len - 4) {
+        *blob = config_start + 4;
+        return prefix;
+    }
+
+    *blob = config_start;
+    return len;
+#else
+    *blob = NULL;
+    return 0;
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef BSEC_CONFIG_H
+#define BSEC_CONFIG_H
+
+#include <stdint.h>
+
+#include "bsec_datatypes.h"
+
+/*
+ * Configuration blob selected in Kconfig (BSEC_CONFIG) and linked into the
+ * component, plus the work buffer BSEC needs to parse configuration and
+ * state blobs. The buffer is static so the 4 KB never lands on a task stack;
+ * it is shared, so only use it with BSEC locked.
+ */
+
+extern uint8_t bsec_work_buffer[BSEC_MAX_WORKBUFFER_SIZE];
+
+/* Name of the selected configuration, e.g. "bme680_iaq_33v_3s_4d" */
+const char *bsec_config_name(void);
+
+/* Point `blob` at the embedded configuration; returns its size, 0 when none is linked */
+uint32_t bsec_config_blob(const uint8_t **blob);
+
+#endif
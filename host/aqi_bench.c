@@ -0,0 +1,316 @@
+/*
+ * AQI engine: cost per sample of each scale next to the if/else ladder it
+ * replaced, and checks of the tables.
+ *
+ * The legacy scale must give what the ladder gave: the same level and the
+ * same printed index for every reading the PM sensor can report (all u16
+ * values), and on a 0.001 ug/m3 sweep the index within 0.001. The ladder
+ * compared the float reading with double breakpoints, so a reading that
+ * rounds to just above 35.4, 55.4, 150.4 or 250.4 went to the upper level
+ * there; those ties are counted apart. Every table must be monotonic, a
+ * few readings must give the index worked out by hand, and every level
+ * name must have a telemetry index.
+ *
+ *   aqi_bench [-n samples] [-s seed]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aqi.h"
+#include "telemetry.h"
+
+#define DEFAULT_SAMPLES     1000000
+#define SWEEP_STEP          0.001
+#define SWEEP_MAX           600.0
+
+static uint32_t rng_state;
+static volatile float sink;
+
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* The firmware's calculate_aqi() before the engine, verbatim */
+static void ladder_aqi(float pm25_concentration, float *aqi, const char **aqi_level)
+{
+    if (pm25_concentration <= 12.0) {
+        *aqi = pm25_concentration * (50.0 / 12.0);
+        *aqi_level = "Good";
+    }
+    else if (pm25_concentration <= 35.4) {
+        *aqi = 50.0 + (pm25_concentration - 12.0) * ((100.0 - 50.0) / (35.4 - 12.0));
+        *aqi_level = "Moderate";
+    }
+    else if (pm25_concentration <= 55.4) {
+        *aqi = 100.0 + (pm25_concentration - 35.4) * ((150.0 - 100.0) / (55.4 - 35.4));
+        *aqi_level = "Unhealthy for Sensitive Groups";
+    }
+    else if (pm25_concentration <= 150.4) {
+        *aqi = 150.0 + (pm25_concentration - 55.4) * ((200.0 - 150.0) / (150.4 - 55.4));
+        *aqi_level = "Unhealthy";
+    }
+    else if (pm25_concentration <= 250.4) {
+        *aqi = 200.0 + (pm25_concentration - 150.4) * ((300.0 - 200.0) / (250.4 - 150.4));
+        *aqi_level = "Very Unhealthy";
+    }
+    else {
+        *aqi = 300.0;
+        *aqi_level = "Hazardous";
+    }
+}
+
+static void legacy_aqi(float pm2_5, aqi_result_t *r)
+{
+    float c[AQI_N_POLLUTANTS] = { pm2_5, -1.0f };
+    aqi_compute(AQI_SCALE_LEGACY, c, r);
+}
+
+static int same_printed(float a, float b)
+{
+    char x[32], y[32];
+    snprintf(x, sizeof(x), "%.1f", a);
+    snprintf(y, sizeof(y), "%.1f", b);
+    return strcmp(x, y) == 0;
+}
+
+/* Float readings the ladder put above a breakpoint it should have included */
+static int breakpoint_tie(float c)
+{
+    static const double breakpoints[] = { 12.0, 35.4, 55.4, 150.4, 250.4 };
+
+    for (size_t i = 0; i < sizeof(breakpoints) / sizeof(breakpoints[0]); i++) {
+        if (c == (float)breakpoints[i] && (double)c > breakpoints[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint32_t check_ladder_readings(void)
+{
+    uint32_t mismatches = 0;
+
+    for (uint32_t pm = 0; pm <= UINT16_MAX; pm++) {
+        float aqi;
+        const char *level;
+        aqi_result_t r;
+
+        ladder_aqi((float)pm, &aqi, &level);
+        legacy_aqi((float)pm, &r);
+        if (strcmp(level, r.level) != 0 || !same_printed(aqi, r.index)) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static uint32_t check_ladder_sweep(uint32_t *points, uint32_t *ties, double *max_diff)
+{
+    uint32_t mismatches = 0;
+
+    *points = 0;
+    *ties = 0;
+    *max_diff = 0.0;
+    for (uint32_t k = 0; k * SWEEP_STEP <= SWEEP_MAX; k++) {
+        float c = (float)(k * SWEEP_STEP);
+        float aqi;
+        const char *level;
+        aqi_result_t r;
+
+        ladder_aqi(c, &aqi, &level);
+        legacy_aqi(c, &r);
+
+        double diff = fabs((double)aqi - r.index);
+        *max_diff = (diff > *max_diff) ? diff : *max_diff;
+        if (strcmp(level, r.level) != 0 && breakpoint_tie(c)) {
+            (*ties)++;
+        } else if (strcmp(level, r.level) != 0 || diff > 1e-3) {
+            mismatches++;
+        }
+        (*points)++;
+    }
+    return mismatches;
+}
+
+/* Sub-index and level never go down as the concentration goes up */
+static uint32_t check_monotonic(uint8_t scale, uint8_t pollutant)
+{
+    uint32_t violations = 0;
+    float prev_index = -1.0f;
+    uint8_t prev_level = 0;
+
+    for (uint32_t k = 0; k <= 20000; k++) {
+        uint8_t level;
+        float index = aqi_sub_index(scale, pollutant, (float)(k * 0.05), &level);
+
+        if (index < prev_index || level < prev_level) {
+            violations++;
+        }
+        prev_index = index;
+        prev_level = level;
+    }
+    return violations;
+}
+
+/* Worked out by hand from the breakpoints, at two decimals */
+static uint32_t check_reference(void)
+{
+    static const struct {
+        uint8_t scale;
+        float pm2_5, pm10;
+        const char *index;
+        const char *level;
+        uint8_t dominant;
+    } ref[] = {
+        { AQI_SCALE_EPA, 5.0f, 0.0f, "27.78", "Good", AQI_POLLUTANT_PM2_5 },
+        { AQI_SCALE_EPA, 12.0f, 0.0f, "56.40", "Moderate", AQI_POLLUTANT_PM2_5 },
+        { AQI_SCALE_EPA, 35.45f, 0.0f, "100.00", "Moderate", AQI_POLLUTANT_PM2_5 },
+        { AQI_SCALE_EPA, 300.0f, 0.0f, "449.40", "Hazardous", AQI_POLLUTANT_PM2_5 },
+        { AQI_SCALE_EPA, 10.0f, 200.0f, "123.27", "Unhealthy for Sensitive Groups", AQI_POLLUTANT_PM10 },
+        { AQI_SCALE_EPA_2012, 12.0f, 0.0f, "50.00", "Good", AQI_POLLUTANT_PM2_5 },
+        { AQI_SCALE_EPA_2012, 300.0f, 0.0f, "350.05", "Hazardous", AQI_POLLUTANT_PM2_5 },
+        { AQI_SCALE_CAQI, 21.0f, 20.0f, "35.00", "Low", AQI_POLLUTANT_PM2_5 },
+        { AQI_SCALE_NAQI, 45.0f, 40.0f, "74.66", "Satisfactory", AQI_POLLUTANT_PM2_5 },
+    };
+    uint32_t mismatches = 0;
+
+    for (size_t i = 0; i < sizeof(ref) / sizeof(ref[0]); i++) {
+        float c[AQI_N_POLLUTANTS] = { ref[i].pm2_5, ref[i].pm10 };
+        aqi_result_t r;
+        char index[16];
+
+        aqi_compute(ref[i].scale, c, &r);
+        snprintf(index, sizeof(index), "%.2f", r.index);
+        if (strcmp(index, ref[i].index) != 0 || strcmp(r.level, ref[i].level) != 0 ||
+            r.dominant != ref[i].dominant) {
+            fprintf(stderr, "%s %.2f/%.0f: %s %s, expected %s %s\n", aqi_scale_names[ref[i].scale], ref[i].pm2_5,
+                    ref[i].pm10, index, r.level, ref[i].index, ref[i].level);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static uint32_t check_level_names(void)
+{
+    uint32_t missing = 0;
+
+    for (uint8_t s = 0; s < AQI_N_SCALES; s++) {
+        uint8_t n;
+        const char *const *levels = aqi_scale_levels(s, &n);
+
+        for (uint8_t l = 0; l < n; l++) {
+            int found = 0;
+            for (int i = 0; i < TELEMETRY_N_AQI_LEVELS; i++) {
+                found |= (strcmp(levels[l], telemetry_aqi_levels[i]) == 0);
+            }
+            if (!found) {
+                fprintf(stderr, "%s level \"%s\" has no telemetry index\n", aqi_scale_names[s], levels[l]);
+                missing++;
+            }
+        }
+    }
+    return missing;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n_samples = DEFAULT_SAMPLES;
+    uint32_t seed = 1;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:")) != -1) {
+        switch (c) {
+            case 'n':
+                n_samples = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n_samples == 0) {
+        return 2;
+    }
+    rng_state = seed;
+
+    /* PM readings as the sensor gives them: whole ug/m3, PM10 above PM2.5 */
+    float (*pm)[AQI_N_POLLUTANTS] = malloc(n_samples * sizeof(*pm));
+    if (pm == NULL) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n_samples; i++) {
+        uint32_t pm2_5 = rng_next() % 500;
+        pm[i][AQI_POLLUTANT_PM2_5] = (float)pm2_5;
+        pm[i][AQI_POLLUTANT_PM10] = (float)(pm2_5 * 16 / 10 + rng_next() % 40);
+    }
+
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < n_samples; i++) {
+        float aqi;
+        const char *level;
+        ladder_aqi(pm[i][AQI_POLLUTANT_PM2_5], &aqi, &level);
+        sink = aqi;
+    }
+    printf("%-8s %6.1f ns/sample\n", "ladder", (double)(now_ns() - t0) / n_samples);
+
+    for (uint8_t s = 0; s < AQI_N_SCALES; s++) {
+        uint32_t pm10_dominant = 0;
+
+        t0 = now_ns();
+        for (uint32_t i = 0; i < n_samples; i++) {
+            aqi_result_t r;
+            aqi_compute(s, pm[i], &r);
+            sink = r.index;
+            pm10_dominant += (r.dominant == AQI_POLLUTANT_PM10);
+        }
+        printf("%-8s %6.1f ns/sample, PM10 dominant in %.1f%%\n", aqi_scale_names[s],
+               (double)(now_ns() - t0) / n_samples, 100.0 * pm10_dominant / n_samples);
+    }
+
+    uint32_t points, ties;
+    double max_diff;
+    uint32_t reading_mismatches = check_ladder_readings();
+    uint32_t sweep_mismatches = check_ladder_sweep(&points, &ties, &max_diff);
+    printf("legacy vs ladder: %u readings, %u mismatches; sweep of %u points, %u mismatches, %u breakpoint ties, "
+           "max difference %.2g\n",
+           UINT16_MAX + 1, (unsigned)reading_mismatches, (unsigned)points, (unsigned)sweep_mismatches,
+           (unsigned)ties, max_diff);
+
+    uint32_t violations = 0;
+    uint32_t tables = 0;
+    for (uint8_t s = 0; s < AQI_N_SCALES; s++) {
+        for (uint8_t p = 0; p < AQI_N_POLLUTANTS; p++) {
+            uint8_t level;
+            if (aqi_sub_index(s, p, 0.0f, &level) >= 0.0f) {
+                violations += check_monotonic(s, p);
+                tables++;
+            }
+        }
+    }
+    uint32_t ref_mismatches = check_reference();
+    uint32_t missing = check_level_names();
+    printf("tables: %u monotonic checks, %u violations; %u reference mismatches; "
+           "%u level names without a telemetry index\n",
+           (unsigned)tables, (unsigned)violations, (unsigned)ref_mismatches, (unsigned)missing);
+
+    free(pm);
+    return (reading_mismatches || sweep_mismatches || violations || ref_mismatches || missing) ? 1 : 0;
+}
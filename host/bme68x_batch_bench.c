@@ -0,0 +1,291 @@
+/*
+ * Throughput of bme68x_compensate_batch() on a large log of raw fields,
+ * reported Google Benchmark style: one row per case with time per pass,
+ * CPU time, passes run and samples/s. Passes repeat until they add up to
+ * at least MIN_TIME_NS.
+ *
+ * The batch cases run a parallel-for: the log is cut into one contiguous
+ * chunk per thread and each thread compensates its chunk with the shared,
+ * read-only context. Before timing, every batch result is checked against
+ * bme68x_compensate_field() on the same record.
+ *
+ *   bme68x_batch_bench [-n fields] [-t max_threads] [-g]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bme68x.h"
+#include "sensor_hal_host.h"
+#include "sim_bme680.h"
+
+#define DEFAULT_FIELDS      (1u << 20)
+#define MAX_THREADS         64
+#define MIN_TIME_NS         500000000LL
+
+static host_hal_t host;
+static sensor_hal_t hal;
+static sim_bme680_t emu;
+
+static int64_t clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint32_t rng_state = 0x2545F491;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* A field as the sensor would report it, with ADC values in the working range */
+static void make_field(uint8_t *f)
+{
+    uint32_t temp_adc = 350000 + rng() % 300000;
+    uint32_t pres_adc = 200000 + rng() % 450000;
+    uint16_t hum_adc = (uint16_t)(rng() % 65536);
+    uint16_t gas_adc = (uint16_t)(rng() % 1024);
+    uint8_t gas_range = (uint8_t)(rng() % 16);
+
+    memset(f, 0, BME68X_LEN_FIELD);
+    f[0] = (uint8_t)(BME68X_NEW_DATA_MSK | (rng() % 10));
+    f[1] = (uint8_t)rng();
+    f[2] = (uint8_t)(pres_adc >> 12);
+    f[3] = (uint8_t)(pres_adc >> 4);
+    f[4] = (uint8_t)((pres_adc & 0x0F) << 4);
+    f[5] = (uint8_t)(temp_adc >> 12);
+    f[6] = (uint8_t)(temp_adc >> 4);
+    f[7] = (uint8_t)((temp_adc & 0x0F) << 4);
+    f[8] = (uint8_t)(hum_adc >> 8);
+    f[9] = (uint8_t)hum_adc;
+    f[13] = f[15] = (uint8_t)(gas_adc >> 2);
+    f[14] = f[16] = (uint8_t)(((gas_adc & 0x03) << 6) | BME68X_GASM_VALID_MSK | gas_range);
+}
+
+/* ===== PARALLEL FOR ===== */
+typedef struct {
+    const uint8_t *fields;
+    uint32_t first;
+    uint32_t count;
+    uint8_t variant;
+    const struct bme68x_comp_ctx *ctx;
+    const struct bme68x_data_soa *out;
+} chunk_t;
+
+static void *run_chunk(void *arg)
+{
+    const chunk_t *c = arg;
+    struct bme68x_data_soa part = {
+        .status = &c->out->status[c->first],
+        .gas_index = &c->out->gas_index[c->first],
+        .temperature = &c->out->temperature[c->first],
+        .pressure = &c->out->pressure[c->first],
+        .humidity = &c->out->humidity[c->first],
+        .gas_resistance = &c->out->gas_resistance[c->first],
+    };
+
+    bme68x_compensate_batch(&c->fields[(size_t)c->first * BME68X_LEN_FIELD], c->count, c->variant, c->ctx, &part);
+    return NULL;
+}
+
+/* Compensate all `n` fields on `threads` threads, one contiguous chunk each */
+static void parallel_batch(const uint8_t *fields, uint32_t n, uint8_t variant, const struct bme68x_comp_ctx *ctx,
+                           const struct bme68x_data_soa *out, uint32_t threads)
+{
+    pthread_t tid[MAX_THREADS];
+    chunk_t chunk[MAX_THREADS];
+    uint32_t per = (n + threads - 1) / threads;
+
+    for (uint32_t t = 0; t < threads; t++) {
+        uint32_t first = t * per;
+        chunk[t] = (chunk_t){ fields, first, first < n ? (n - first < per ? n - first : per) : 0, variant, ctx, out };
+    }
+
+    /* The calling thread takes the first chunk */
+    for (uint32_t t = 1; t < threads; t++) {
+        pthread_create(&tid[t], NULL, run_chunk, &chunk[t]);
+    }
+    run_chunk(&chunk[0]);
+    for (uint32_t t = 1; t < threads; t++) {
+        pthread_join(tid[t], NULL);
+    }
+}
+
+/* ===== CASES ===== */
+typedef struct {
+    const uint8_t *fields;
+    uint32_t n;
+    uint8_t variant;
+    const struct bme68x_comp_ctx *ctx;
+    const struct bme68x_data_soa *out;
+    uint32_t threads;       /* 0: one bme68x_compensate_field() call per record */
+} bench_case_t;
+
+static void run_pass(const bench_case_t *b)
+{
+    if (b->threads > 0) {
+        parallel_batch(b->fields, b->n, b->variant, b->ctx, b->out, b->threads);
+        return;
+    }
+
+    for (uint32_t i = 0; i < b->n; i++) {
+        struct bme68x_data d;
+        bme68x_compensate_field(&b->fields[(size_t)i * BME68X_LEN_FIELD], b->variant, b->ctx, &d);
+        b->out->temperature[i] = d.temperature;
+        b->out->pressure[i] = d.pressure;
+        b->out->humidity[i] = d.humidity;
+        b->out->gas_resistance[i] = d.gas_resistance;
+    }
+}
+
+static void report(const char *name, const bench_case_t *b)
+{
+    uint64_t passes = 0;
+    int64_t wall0 = clock_ns(CLOCK_MONOTONIC);
+    int64_t cpu0 = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    int64_t wall;
+
+    do {
+        run_pass(b);
+        passes++;
+        wall = clock_ns(CLOCK_MONOTONIC) - wall0;
+    } while (wall < MIN_TIME_NS);
+    int64_t cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu0;
+
+    printf("%-40s %9.2f ms %9.2f ms %8llu %12.3fM/s\n", name,
+           (double)wall / passes / 1e6, (double)cpu / passes / 1e6, (unsigned long long)passes,
+           (double)b->n * passes / ((double)wall / 1e9) / 1e6);
+}
+
+static int same_float(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+/* Batch results that differ from compensating the same record on its own */
+static uint32_t check(const uint8_t *fields, uint32_t n, uint8_t variant, const struct bme68x_comp_ctx *ctx,
+                      const struct bme68x_data_soa *out, uint32_t threads)
+{
+    uint32_t mismatches = 0;
+
+    parallel_batch(fields, n, variant, ctx, out, threads);
+    for (uint32_t i = 0; i < n; i++) {
+        struct bme68x_data d;
+        bme68x_compensate_field(&fields[(size_t)i * BME68X_LEN_FIELD], variant, ctx, &d);
+        mismatches += !(same_float(d.temperature, out->temperature[i]) && same_float(d.pressure, out->pressure[i]) &&
+                        same_float(d.humidity, out->humidity[i]) &&
+                        same_float(d.gas_resistance, out->gas_resistance[i]) && d.status == out->status[i] &&
+                        d.gas_index == out->gas_index[i]);
+    }
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n_fields = DEFAULT_FIELDS;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t max_threads = (uint32_t)(cores < 1 ? 1 : (cores > MAX_THREADS ? MAX_THREADS : cores));
+    uint8_t variant = BME68X_VARIANT_GAS_LOW;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:t:g")) != -1) {
+        switch (c) {
+            case 'n':
+                n_fields = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                max_threads = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'g':
+                variant = BME68X_VARIANT_GAS_HIGH;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n fields] [-t max_threads] [-g]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n_fields == 0 || max_threads == 0 || max_threads > MAX_THREADS) {
+        return 2;
+    }
+
+    /* Calibration as bme68x_init() reads it from the emulator */
+    const sim_bme680_bus_t bus = { .hal = &hal, .addr = BME68X_I2C_ADDR_LOW };
+    struct bme68x_dev dev;
+
+    host_hal_init(&host, &hal);
+    sim_bme680_init(&emu, &host.now_us);
+    host_hal_attach(&host, bus.addr, sim_bme680_read, sim_bme680_write, &emu);
+
+    sim_bme680_bind(&dev, &bus);
+
+    if (bme68x_init(&dev) != BME68X_OK) {
+        fprintf(stderr, "bme68x_init failed\n");
+        return 1;
+    }
+
+    struct bme68x_comp_ctx fctx, ictx;
+    bme68x_calc_comp_ctx(&dev.calib, BME68X_COMP_FLOAT, &fctx);
+    bme68x_calc_comp_ctx(&dev.calib, BME68X_COMP_INT, &ictx);
+
+    uint8_t *fields = malloc((size_t)n_fields * BME68X_LEN_FIELD);
+    struct bme68x_data_soa out = {
+        .status = malloc(n_fields),
+        .gas_index = malloc(n_fields),
+        .temperature = malloc(n_fields * sizeof(float)),
+        .pressure = malloc(n_fields * sizeof(float)),
+        .humidity = malloc(n_fields * sizeof(float)),
+        .gas_resistance = malloc(n_fields * sizeof(float)),
+    };
+    if (fields == NULL || out.status == NULL || out.gas_index == NULL || out.temperature == NULL ||
+        out.pressure == NULL || out.humidity == NULL || out.gas_resistance == NULL) {
+        fprintf(stderr, "out of memory for %u fields\n", n_fields);
+        return 1;
+    }
+    for (uint32_t i = 0; i < n_fields; i++) {
+        make_field(&fields[(size_t)i * BME68X_LEN_FIELD]);
+    }
+
+    uint32_t mismatches = check(fields, n_fields, variant, &fctx, &out, max_threads) +
+                          check(fields, n_fields, variant, &ictx, &out, max_threads);
+
+    printf("fields: %u (%s), cores: %ld, batch vs per-field mismatches: %u\n", n_fields,
+           variant == BME68X_VARIANT_GAS_HIGH ? "BME688" : "BME680", cores, mismatches);
+    printf("%-40s %12s %12s %8s %13s\n", "Benchmark", "Time", "CPU", "Passes", "samples/s");
+    printf("------------------------------------------------------------------------------------\n");
+
+    const struct { const char *mode; const struct bme68x_comp_ctx *ctx; } modes[] = {
+        { "float", &fctx },
+        { "int", &ictx },
+    };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        bench_case_t b = { fields, n_fields, variant, modes[m].ctx, &out, 0 };
+        char name[64];
+
+        snprintf(name, sizeof(name), "BM_compensate_field/%s", modes[m].mode);
+        report(name, &b);
+        for (uint32_t t = 1; t <= max_threads; t *= 2) {
+            b.threads = t;
+            snprintf(name, sizeof(name), "BM_compensate_batch/%s/threads:%u", modes[m].mode, t);
+            report(name, &b);
+        }
+    }
+
+    free(fields);
+    free(out.status);
+    free(out.gas_index);
+    free(out.temperature);
+    free(out.pressure);
+    free(out.humidity);
+    free(out.gas_resistance);
+    return mismatches != 0;
+}
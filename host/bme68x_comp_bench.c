@@ -0,0 +1,580 @@
+/*
+ * Compensation cost and exactness of the precomputed bme68x_comp_ctx.
+ *
+ * The reference below is the per-sample vendor arithmetic that read_field_data()
+ * used before the context existed, copied as it was (float and integer
+ * variants). Every field is compensated both ways and must match bit for bit:
+ * the float path against the float formulas, the integer path against the
+ * BME68X_DO_NOT_USE_FPU formulas converted to float units.
+ *
+ * The timing runs `repeats` passes over the fields per path, the four paths
+ * taking turns, and reports the min and median ns per field of each. One
+ * mean per path run back to back mostly measured what else the machine was
+ * doing at the time.
+ *
+ *   bme68x_comp_bench [-n fields] [-r repeats] [-c calibrations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bme68x.h"
+#include "sensor_hal_host.h"
+#include "sim_bme680.h"
+
+#define DEFAULT_FIELDS      65536
+#define DEFAULT_REPEATS     50
+#define DEFAULT_CALIBS      64
+
+/* Per calibration: random fields checked per variant */
+#define CHECK_FIELDS        100000
+
+static host_hal_t host;
+static sensor_hal_t hal;
+static sim_bme680_t emu;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint32_t rng_state = 0x2545F491;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* ===== REFERENCE: PER-SAMPLE VENDOR FORMULAS ===== */
+typedef struct {
+    uint32_t temp;
+    uint32_t pres;
+    uint16_t hum;
+    uint16_t gas;
+    uint8_t gas_range;
+} ref_adc_t;
+
+/* The status bytes as read_field_data() took them, so both sides do the same stores */
+static void ref_parse(const uint8_t *buff, uint8_t variant_id, struct bme68x_data *data, ref_adc_t *adc)
+{
+    uint8_t gas = (variant_id == BME68X_VARIANT_GAS_HIGH) ? 15 : 13;
+
+    data->status = buff[0] & BME68X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+    data->status |= buff[gas + 1] & BME68X_GASM_VALID_MSK;
+    data->status |= buff[gas + 1] & BME68X_HEAT_STAB_MSK;
+    data->idac = 0;
+    data->res_heat = 0;
+    data->gas_wait = 0;
+
+    adc->pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
+    adc->temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
+    adc->hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
+    adc->gas = (uint16_t)((uint32_t)buff[gas] * 4 | (((uint32_t)buff[gas + 1]) / 64));
+    adc->gas_range = buff[gas + 1] & BME68X_GAS_RANGE_MSK;
+}
+
+static int16_t ref_temperature_int(uint32_t temp_adc, const struct bme68x_calib_data *calib, int32_t *t_fine)
+{
+    int64_t var1;
+    int64_t var2;
+    int64_t var3;
+
+    var1 = ((int32_t)temp_adc >> 3) - ((int32_t)calib->par_t1 << 1);
+    var2 = (var1 * (int32_t)calib->par_t2) >> 11;
+    var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
+    var3 = ((var3) * ((int32_t)calib->par_t3 << 4)) >> 14;
+    *t_fine = (int32_t)(var2 + var3);
+    return (int16_t)(((*t_fine * 5) + 128) >> 8);
+}
+
+static uint32_t ref_pressure_int(uint32_t pres_adc, const struct bme68x_calib_data *calib, int32_t t_fine)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t pressure_comp;
+    const int32_t pres_ovf_check = INT32_C(0x40000000);
+
+    var1 = (((int32_t)t_fine) >> 1) - 64000;
+    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)calib->par_p6) >> 2;
+    var2 = var2 + ((var1 * (int32_t)calib->par_p5) << 1);
+    var2 = (var2 >> 2) + ((int32_t)calib->par_p4 << 16);
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)calib->par_p3 << 5)) >> 3) +
+           (((int32_t)calib->par_p2 * var1) >> 1);
+    var1 = var1 >> 18;
+    var1 = ((32768 + var1) * (int32_t)calib->par_p1) >> 15;
+    pressure_comp = 1048576 - pres_adc;
+    pressure_comp = (int32_t)((pressure_comp - (var2 >> 12)) * ((uint32_t)3125));
+    if (pressure_comp >= pres_ovf_check) {
+        pressure_comp = ((pressure_comp / var1) << 1);
+    } else {
+        pressure_comp = ((pressure_comp << 1) / var1);
+    }
+
+    var1 = ((int32_t)calib->par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)calib->par_p8) >> 13;
+    var3 =
+        ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
+         (int32_t)calib->par_p10) >> 17;
+    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)calib->par_p7 << 7)) >> 4);
+    return (uint32_t)pressure_comp;
+}
+
+static uint32_t ref_humidity_int(uint16_t hum_adc, const struct bme68x_calib_data *calib, int32_t t_fine)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    int32_t var6;
+    int32_t temp_scaled;
+    int32_t calc_hum;
+
+    temp_scaled = (((int32_t)t_fine * 5) + 128) >> 8;
+    var1 = (int32_t)(hum_adc - ((int32_t)((int32_t)calib->par_h1 * 16))) -
+           (((temp_scaled * (int32_t)calib->par_h3) / ((int32_t)100)) >> 1);
+    var2 =
+        ((int32_t)calib->par_h2 *
+         (((temp_scaled * (int32_t)calib->par_h4) / ((int32_t)100)) +
+          (((temp_scaled * ((temp_scaled * (int32_t)calib->par_h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
+          (int32_t)(1 << 14))) >> 10;
+    var3 = var1 * var2;
+    var4 = (int32_t)calib->par_h6 << 7;
+    var4 = ((var4) + ((temp_scaled * (int32_t)calib->par_h7) / ((int32_t)100))) >> 4;
+    var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
+    var6 = (var4 * var5) >> 1;
+    calc_hum = (((var3 + var6) >> 10) * ((int32_t)1000)) >> 12;
+    if (calc_hum > 100000) {
+        calc_hum = 100000;
+    } else if (calc_hum < 0) {
+        calc_hum = 0;
+    }
+    return (uint32_t)calc_hum;
+}
+
+static uint32_t ref_gas_low_int(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_calib_data *calib)
+{
+    int64_t var1;
+    uint64_t var2;
+    int64_t var3;
+    uint32_t lookup_table1[16] = {
+        UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
+        UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
+        UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
+        UINT32_C(2147483647)
+    };
+    uint32_t lookup_table2[16] = {
+        UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
+        UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000),
+        UINT32_C(4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
+    };
+
+    var1 = (int64_t)((1340 + (5 * (int64_t)calib->range_sw_err)) * ((int64_t)lookup_table1[gas_range])) >> 16;
+    var2 = (((int64_t)((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + var1);
+    var3 = (((int64_t)lookup_table2[gas_range] * (int64_t)var1) >> 9);
+    return (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
+}
+
+static uint32_t ref_gas_high_int(uint16_t gas_res_adc, uint8_t gas_range)
+{
+    uint32_t calc_gas_res;
+    uint32_t var1 = UINT32_C(262144) >> gas_range;
+    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
+
+    var2 *= INT32_C(3);
+    var2 = INT32_C(4096) + var2;
+    calc_gas_res = (UINT32_C(10000) * var1) / (uint32_t)var2;
+    return calc_gas_res * 100;
+}
+
+static float ref_temperature_float(uint32_t temp_adc, const struct bme68x_calib_data *calib, float *t_fine)
+{
+    float var1;
+    float var2;
+
+    var1 = ((((float)temp_adc / 16384.0f) - ((float)calib->par_t1 / 1024.0f)) * ((float)calib->par_t2));
+    var2 =
+        (((((float)temp_adc / 131072.0f) - ((float)calib->par_t1 / 8192.0f)) *
+          (((float)temp_adc / 131072.0f) - ((float)calib->par_t1 / 8192.0f))) * ((float)calib->par_t3 * 16.0f));
+    *t_fine = (var1 + var2);
+    return ((*t_fine) / 5120.0f);
+}
+
+static float ref_pressure_float(uint32_t pres_adc, const struct bme68x_calib_data *calib, float t_fine)
+{
+    float var1;
+    float var2;
+    float var3;
+    float calc_pres;
+
+    var1 = (((float)t_fine / 2.0f) - 64000.0f);
+    var2 = var1 * var1 * (((float)calib->par_p6) / (131072.0f));
+    var2 = var2 + (var1 * ((float)calib->par_p5) * 2.0f);
+    var2 = (var2 / 4.0f) + (((float)calib->par_p4) * 65536.0f);
+    var1 = (((((float)calib->par_p3 * var1 * var1) / 16384.0f) + ((float)calib->par_p2 * var1)) / 524288.0f);
+    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)calib->par_p1));
+    calc_pres = (1048576.0f - ((float)pres_adc));
+    if ((int)var1 != 0) {
+        calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
+        var1 = (((float)calib->par_p9) * calc_pres * calc_pres) / 2147483648.0f;
+        var2 = calc_pres * (((float)calib->par_p8) / 32768.0f);
+        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (calib->par_p10 / 131072.0f));
+        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)calib->par_p7 * 128.0f)) / 16.0f);
+    } else {
+        calc_pres = 0;
+    }
+    return calc_pres;
+}
+
+static float ref_humidity_float(uint16_t hum_adc, const struct bme68x_calib_data *calib, float t_fine)
+{
+    float calc_hum;
+    float var1;
+    float var2;
+    float var3;
+    float var4;
+    float temp_comp;
+
+    temp_comp = ((t_fine) / 5120.0f);
+    var1 = (float)((float)hum_adc) -
+           (((float)calib->par_h1 * 16.0f) + (((float)calib->par_h3 / 2.0f) * temp_comp));
+    var2 = var1 *
+           ((float)(((float)calib->par_h2 / 262144.0f) *
+                    (1.0f + (((float)calib->par_h4 / 16384.0f) * temp_comp) +
+                     (((float)calib->par_h5 / 1048576.0f) * temp_comp * temp_comp))));
+    var3 = (float)calib->par_h6 / 16384.0f;
+    var4 = (float)calib->par_h7 / 2097152.0f;
+    calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
+    if (calc_hum > 100.0f) {
+        calc_hum = 100.0f;
+    } else if (calc_hum < 0.0f) {
+        calc_hum = 0.0f;
+    }
+    return calc_hum;
+}
+
+static float ref_gas_low_float(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_calib_data *calib)
+{
+    float var1;
+    float var2;
+    float var3;
+    float gas_res_f = gas_res_adc;
+    float gas_range_f = (1U << gas_range);
+    const float lookup_k1_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
+    };
+    const float lookup_k2_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+    };
+
+    var1 = (1340.0f + (5.0f * calib->range_sw_err));
+    var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
+    var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
+    return 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
+}
+
+static float ref_gas_high_float(uint16_t gas_res_adc, uint8_t gas_range)
+{
+    uint32_t var1 = UINT32_C(262144) >> gas_range;
+    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
+
+    var2 *= INT32_C(3);
+    var2 = INT32_C(4096) + var2;
+    return 1000000.0f * (float)var1 / (float)var2;
+}
+
+/* Out of line like bme68x_compensate_field() in the library, so the timing compares arithmetic, not inlining */
+__attribute__((noinline)) static void ref_compensate_float(const uint8_t *field, uint8_t variant_id, const struct bme68x_calib_data *calib,
+                                 struct bme68x_data *data)
+{
+    ref_adc_t adc;
+    float t_fine;
+
+    ref_parse(field, variant_id, data, &adc);
+    data->temperature = ref_temperature_float(adc.temp, calib, &t_fine);
+    data->pressure = ref_pressure_float(adc.pres, calib, t_fine);
+    data->humidity = ref_humidity_float(adc.hum, calib, t_fine);
+    data->gas_resistance = (variant_id == BME68X_VARIANT_GAS_HIGH) ? ref_gas_high_float(adc.gas, adc.gas_range) :
+                           ref_gas_low_float(adc.gas, adc.gas_range, calib);
+}
+
+__attribute__((noinline)) static void ref_compensate_int(const uint8_t *field, uint8_t variant_id, const struct bme68x_calib_data *calib,
+                               struct bme68x_data *data)
+{
+    ref_adc_t adc;
+    int32_t t_fine;
+
+    ref_parse(field, variant_id, data, &adc);
+    data->temperature = (float)ref_temperature_int(adc.temp, calib, &t_fine) / 100.0f;
+    data->pressure = (float)ref_pressure_int(adc.pres, calib, t_fine);
+    data->humidity = (float)ref_humidity_int(adc.hum, calib, t_fine) / 1000.0f;
+    data->gas_resistance = (float)((variant_id == BME68X_VARIANT_GAS_HIGH) ? ref_gas_high_int(adc.gas, adc.gas_range) :
+                                   ref_gas_low_int(adc.gas, adc.gas_range, calib));
+}
+
+/* ===== INPUTS ===== */
+
+/* A field as the sensor would report it, with ADC values in the working range */
+static void make_field(uint8_t *f)
+{
+    /* Roughly -40..85 degC, 300..1100 hPa and the full humidity and gas codes */
+    uint32_t temp_adc = 350000 + rng() % 300000;
+    uint32_t pres_adc = 200000 + rng() % 450000;
+    uint16_t hum_adc = (uint16_t)(rng() % 65536);
+    uint16_t gas_adc = (uint16_t)(rng() % 1024);
+    uint8_t gas_range = (uint8_t)(rng() % 16);
+
+    memset(f, 0, BME68X_LEN_FIELD);
+    f[0] = BME68X_NEW_DATA_MSK;
+    f[2] = (uint8_t)(pres_adc >> 12);
+    f[3] = (uint8_t)(pres_adc >> 4);
+    f[4] = (uint8_t)((pres_adc & 0x0F) << 4);
+    f[5] = (uint8_t)(temp_adc >> 12);
+    f[6] = (uint8_t)(temp_adc >> 4);
+    f[7] = (uint8_t)((temp_adc & 0x0F) << 4);
+    f[8] = (uint8_t)(hum_adc >> 8);
+    f[9] = (uint8_t)hum_adc;
+
+    /* Gas in both register pairs, so either variant can read it */
+    f[13] = f[15] = (uint8_t)(gas_adc >> 2);
+    f[14] = f[16] = (uint8_t)(((gas_adc & 0x03) << 6) | BME68X_GASM_VALID_MSK | gas_range);
+}
+
+static int16_t jitter(int32_t value, int32_t span, int32_t lo, int32_t hi)
+{
+    value += (int32_t)(rng() % (uint32_t)(2 * span + 1)) - span;
+    return (int16_t)(value < lo ? lo : (value > hi ? hi : value));
+}
+
+/* Another plausible part: every coefficient moved a little from `base` */
+static void perturb(const struct bme68x_calib_data *base, struct bme68x_calib_data *c)
+{
+    *c = *base;
+    c->par_t1 = (uint16_t)jitter(base->par_t1, 2000, 0, 32767);
+    c->par_t2 = jitter(base->par_t2, 2000, -32768, 32767);
+    c->par_t3 = (int8_t)jitter(base->par_t3, 10, -128, 127);
+    c->par_p1 = (uint16_t)jitter(base->par_p1, 3000, 1, 32767) + 3000;
+    c->par_p2 = jitter(base->par_p2, 1000, -32768, 32767);
+    c->par_p3 = (int8_t)jitter(base->par_p3, 30, -128, 127);
+    c->par_p4 = jitter(base->par_p4, 1000, -32768, 32767);
+    c->par_p5 = jitter(base->par_p5, 100, -32768, 32767);
+    c->par_p6 = (int8_t)jitter(base->par_p6, 20, -128, 127);
+    c->par_p7 = (int8_t)jitter(base->par_p7, 20, -128, 127);
+    c->par_p8 = jitter(base->par_p8, 500, -32768, 32767);
+    c->par_p9 = jitter(base->par_p9, 500, -32768, 32767);
+    c->par_p10 = (uint8_t)jitter(base->par_p10, 20, 0, 255);
+    c->par_h1 = (uint16_t)jitter(base->par_h1, 100, 0, 4095);
+    c->par_h2 = (uint16_t)jitter(base->par_h2, 100, 0, 4095);
+    c->par_h3 = (int8_t)jitter(base->par_h3, 10, -128, 127);
+    c->par_h4 = (int8_t)jitter(base->par_h4, 10, -128, 127);
+    c->par_h5 = (int8_t)jitter(base->par_h5, 10, -128, 127);
+    c->par_h6 = (uint8_t)jitter(base->par_h6, 30, 0, 255);
+    c->par_h7 = (int8_t)jitter(base->par_h7, 30, -128, 127);
+    c->range_sw_err = (int8_t)jitter(0, 8, -8, 7);
+}
+
+static int same_data(const struct bme68x_data *a, const struct bme68x_data *b)
+{
+    return memcmp(&a->temperature, &b->temperature, sizeof(float)) == 0 &&
+           memcmp(&a->pressure, &b->pressure, sizeof(float)) == 0 &&
+           memcmp(&a->humidity, &b->humidity, sizeof(float)) == 0 &&
+           memcmp(&a->gas_resistance, &b->gas_resistance, sizeof(float)) == 0;
+}
+
+/* ===== CHECK ===== */
+
+/* Fields of one calibration whose compensated values differ from the reference */
+static uint32_t check_calib(const struct bme68x_calib_data *calib, uint32_t *checked)
+{
+    struct bme68x_comp_ctx fctx, ictx;
+    uint32_t mismatches = 0;
+
+    bme68x_calc_comp_ctx(calib, BME68X_COMP_FLOAT, &fctx);
+    bme68x_calc_comp_ctx(calib, BME68X_COMP_INT, &ictx);
+
+    for (uint32_t i = 0; i < CHECK_FIELDS; i++) {
+        uint8_t f[BME68X_LEN_FIELD];
+        make_field(f);
+
+        for (uint8_t variant = BME68X_VARIANT_GAS_LOW; variant <= BME68X_VARIANT_GAS_HIGH; variant++) {
+            struct bme68x_data ref, got;
+
+            ref_compensate_float(f, variant, calib, &ref);
+            bme68x_compensate_field(f, variant, &fctx, &got);
+            mismatches += !same_data(&ref, &got);
+
+            ref_compensate_int(f, variant, calib, &ref);
+            bme68x_compensate_field(f, variant, &ictx, &got);
+            mismatches += !same_data(&ref, &got);
+
+            *checked += 2;
+        }
+    }
+    return mismatches;
+}
+
+/* ===== TIMING ===== */
+typedef enum { REF_FLOAT, REF_INT, CTX_FLOAT, CTX_INT, N_PATHS } path_t;
+
+static const char *const path_names[N_PATHS] = { "ref float", "ref int", "ctx float", "ctx int" };
+
+static float sink;
+
+/* One pass over the fields; returns ns per field */
+static double time_pass(path_t path, const uint8_t *fields, uint32_t n, const struct bme68x_calib_data *calib,
+                        const struct bme68x_comp_ctx *ctx, uint8_t variant)
+{
+    struct bme68x_data d;
+    float sum = 0;
+
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        const uint8_t *f = &fields[i * BME68X_LEN_FIELD];
+        switch (path) {
+            case REF_FLOAT:
+                ref_compensate_float(f, variant, calib, &d);
+                break;
+            case REF_INT:
+                ref_compensate_int(f, variant, calib, &d);
+                break;
+            default:
+                bme68x_compensate_field(f, variant, ctx, &d);
+                break;
+        }
+        sum += d.temperature + d.pressure + d.humidity + d.gas_resistance;
+    }
+    int64_t elapsed = now_ns() - t0;
+
+    /* Keeps the loop from being optimized away */
+    sink += sum;
+    return (double)elapsed / n;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Min and median ns per field of every path over `repeats` passes each.
+ * The paths take turns pass by pass, in a rotating order, so frequency
+ * changes and other load hit all of them alike.
+ */
+static int time_paths(const uint8_t *fields, uint32_t n, uint32_t repeats, const struct bme68x_calib_data *calib,
+                      uint8_t variant, double min[N_PATHS], double median[N_PATHS])
+{
+    struct bme68x_comp_ctx fctx, ictx;
+    double *ns = malloc((size_t)N_PATHS * repeats * sizeof(*ns));
+
+    if (ns == NULL) {
+        return -1;
+    }
+    bme68x_calc_comp_ctx(calib, BME68X_COMP_FLOAT, &fctx);
+    bme68x_calc_comp_ctx(calib, BME68X_COMP_INT, &ictx);
+
+    for (uint32_t r = 0; r < repeats; r++) {
+        for (uint32_t k = 0; k < N_PATHS; k++) {
+            path_t path = (path_t)((r + k) % N_PATHS);
+            ns[path * repeats + r] = time_pass(path, fields, n, calib, path == CTX_INT ? &ictx : &fctx, variant);
+        }
+    }
+    for (int path = 0; path < N_PATHS; path++) {
+        double *runs = &ns[path * repeats];
+        qsort(runs, repeats, sizeof(*runs), cmp_double);
+        min[path] = runs[0];
+        median[path] = runs[repeats / 2];
+    }
+    free(ns);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n_fields = DEFAULT_FIELDS;
+    uint32_t repeats = DEFAULT_REPEATS;
+    uint32_t n_calibs = DEFAULT_CALIBS;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:r:c:")) != -1) {
+        switch (c) {
+            case 'n':
+                n_fields = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                repeats = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                n_calibs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n fields] [-r repeats] [-c calibrations]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n_fields == 0 || repeats == 0) {
+        return 2;
+    }
+
+    /* Calibration as bme68x_init() reads it from the emulator */
+    const sim_bme680_bus_t bus = { .hal = &hal, .addr = BME68X_I2C_ADDR_LOW };
+    struct bme68x_dev dev;
+
+    host_hal_init(&host, &hal);
+    sim_bme680_init(&emu, &host.now_us);
+    host_hal_attach(&host, bus.addr, sim_bme680_read, sim_bme680_write, &emu);
+
+    sim_bme680_bind(&dev, &bus);
+
+    if (bme68x_init(&dev) != BME68X_OK) {
+        fprintf(stderr, "bme68x_init failed\n");
+        return 1;
+    }
+
+    /* Exactness: the emulator's part and perturbed copies of it */
+    uint32_t checked = 0, mismatches = check_calib(&dev.calib, &checked);
+    for (uint32_t i = 0; i < n_calibs; i++) {
+        struct bme68x_calib_data calib;
+        perturb(&dev.calib, &calib);
+        mismatches += check_calib(&calib, &checked);
+    }
+
+    uint8_t *fields = malloc((size_t)n_fields * BME68X_LEN_FIELD);
+    if (fields == NULL) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n_fields; i++) {
+        make_field(&fields[i * BME68X_LEN_FIELD]);
+    }
+
+    printf("exactness: %u calibrations, %u fields compensated, %u mismatches\n",
+           n_calibs + 1, checked, mismatches);
+    printf("ns/sample, min and median of %u interleaved passes of %u fields\n", (unsigned)repeats,
+           (unsigned)n_fields);
+    for (uint8_t variant = BME68X_VARIANT_GAS_LOW; variant <= BME68X_VARIANT_GAS_HIGH; variant++) {
+        double min[N_PATHS], median[N_PATHS];
+
+        if (time_paths(fields, n_fields, repeats, &dev.calib, variant, min, median) != 0) {
+            return 1;
+        }
+        for (int path = 0; path < N_PATHS; path++) {
+            printf("%s %-9s %6.1f min %6.1f median\n", variant == BME68X_VARIANT_GAS_HIGH ? "BME688" : "BME680",
+                   path_names[path], min[path], median[path]);
+        }
+    }
+
+    free(fields);
+    return mismatches != 0;
+}
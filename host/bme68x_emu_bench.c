@@ -0,0 +1,213 @@
+/*
+ * Drives bme68x.c directly against the BME680 emulator and measures the
+ * cost of bme68x_get_data(): host CPU time and I2C transactions per call,
+ * plus the overall replay rate in samples per second.
+ *
+ *   bme68x_emu_bench [-m forced|parallel|sequential] [-n calls] [-c conditions.csv]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bme68x.h"
+#include "sensor_hal_host.h"
+#include "sim_bme680.h"
+
+#define DEFAULT_CALLS       100000
+#define FORCED_HEATR_TEMP   320
+#define FORCED_HEATR_DUR    150
+
+/* Heater profiles from the Bosch parallel and sequential mode examples */
+static uint16_t par_temp_prof[10] = { 320, 100, 100, 100, 200, 200, 200, 320, 320, 320 };
+static uint16_t par_mul_prof[10] = { 5, 2, 10, 30, 5, 5, 5, 5, 5, 5 };
+static uint16_t seq_temp_prof[10] = { 200, 240, 280, 320, 360, 360, 320, 280, 240, 200 };
+static uint16_t seq_dur_prof[10] = { 100, 100, 100, 100, 100, 100, 100, 100, 100, 100 };
+
+static host_hal_t host;
+static sensor_hal_t hal;
+static sim_bme680_t emu;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int parse_mode(const char *name, uint8_t *mode)
+{
+    if (strcmp(name, "forced") == 0)
+        *mode = BME68X_FORCED_MODE;
+    else if (strcmp(name, "parallel") == 0)
+        *mode = BME68X_PARALLEL_MODE;
+    else if (strcmp(name, "sequential") == 0)
+        *mode = BME68X_SEQUENTIAL_MODE;
+    else
+        return -1;
+    return 0;
+}
+
+/* Heater setup for `mode`; returns the wait between get_data calls in us */
+static uint32_t configure(uint8_t mode, struct bme68x_conf *conf, struct bme68x_dev *dev)
+{
+    struct bme68x_heatr_conf heatr;
+    uint32_t meas_dur;
+
+    conf->os_hum = BME68X_OS_2X;
+    conf->os_pres = BME68X_OS_4X;
+    conf->os_temp = BME68X_OS_8X;
+    conf->filter = BME68X_FILTER_OFF;
+    conf->odr = BME68X_ODR_NONE;
+    bme68x_set_conf(conf, dev);
+
+    memset(&heatr, 0, sizeof(heatr));
+    heatr.enable = BME68X_ENABLE;
+    meas_dur = bme68x_get_meas_dur(mode, conf, dev);
+
+    switch (mode) {
+        case BME68X_PARALLEL_MODE:
+            heatr.heatr_temp_prof = par_temp_prof;
+            heatr.heatr_dur_prof = par_mul_prof;
+            heatr.shared_heatr_dur = (uint16_t)(140 - meas_dur / 1000);
+            heatr.profile_len = 10;
+            bme68x_set_heatr_conf(mode, &heatr, dev);
+            return meas_dur + heatr.shared_heatr_dur * 1000;
+        case BME68X_SEQUENTIAL_MODE:
+            heatr.heatr_temp_prof = seq_temp_prof;
+            heatr.heatr_dur_prof = seq_dur_prof;
+            heatr.profile_len = 10;
+            bme68x_set_heatr_conf(mode, &heatr, dev);
+            return meas_dur + seq_dur_prof[0] * 1000;
+        default:
+            heatr.heatr_temp = FORCED_HEATR_TEMP;
+            heatr.heatr_dur = FORCED_HEATR_DUR;
+            bme68x_set_heatr_conf(mode, &heatr, dev);
+            return meas_dur + FORCED_HEATR_DUR * 1000;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t mode = BME68X_FORCED_MODE;
+    uint32_t n_calls = DEFAULT_CALLS;
+    const char *csv = NULL;
+    int c;
+
+    while ((c = getopt(argc, argv, "m:n:c:")) != -1) {
+        switch (c) {
+            case 'm':
+                if (parse_mode(optarg, &mode) != 0) {
+                    fprintf(stderr, "unknown mode %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'n':
+                n_calls = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                csv = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-m forced|parallel|sequential] [-n calls] [-c conditions.csv]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n_calls == 0) {
+        return 2;
+    }
+
+    const sim_bme680_bus_t bus = { .hal = &hal, .addr = BME68X_I2C_ADDR_LOW };
+    struct bme68x_dev dev;
+    struct bme68x_conf conf;
+
+    host_hal_init(&host, &hal);
+    sim_bme680_init(&emu, &host.now_us);
+    host_hal_attach(&host, bus.addr, sim_bme680_read, sim_bme680_write, &emu);
+
+    sim_bme680_conditions_t *replay = NULL;
+    if (csv != NULL) {
+        uint32_t n_rows = sim_bme680_load_csv(csv, &replay);
+        if (n_rows == 0) {
+            fprintf(stderr, "no conditions in %s\n", csv);
+            return 1;
+        }
+        sim_bme680_set_replay(&emu, replay, n_rows);
+    }
+
+    sim_bme680_bind(&dev, &bus);
+
+    if (bme68x_init(&dev) != BME68X_OK) {
+        fprintf(stderr, "bme68x_init failed\n");
+        return 1;
+    }
+
+    uint32_t period_us = configure(mode, &conf, &dev);
+    if (mode != BME68X_FORCED_MODE) {
+        bme68x_set_op_mode(mode, &dev);
+    }
+
+    int64_t *cost_ns = malloc(n_calls * sizeof(*cost_ns));
+    if (cost_ns == NULL) {
+        return 1;
+    }
+
+    uint64_t reads = 0, writes = 0, bytes = 0, fields = 0;
+    uint32_t no_data = 0;
+    int64_t start = now_ns();
+
+    for (uint32_t i = 0; i < n_calls; i++) {
+        struct bme68x_data data[3];
+        uint8_t n_fields = 0;
+
+        if (mode == BME68X_FORCED_MODE) {
+            bme68x_set_op_mode(BME68X_FORCED_MODE, &dev);
+        }
+        hal.delay_us(hal.ctx, period_us);
+
+        host_hal_stats_t before = host.stats;
+        int64_t t0 = now_ns();
+        int8_t rslt = bme68x_get_data(mode, data, &n_fields, &dev);
+        cost_ns[i] = now_ns() - t0;
+
+        reads += host.stats.reads - before.reads;
+        writes += host.stats.writes - before.writes;
+        bytes += host.stats.bytes - before.bytes;
+        fields += n_fields;
+        if (rslt != BME68X_OK) {
+            no_data++;
+        }
+    }
+
+    double elapsed_s = (double)(now_ns() - start) / 1e9;
+
+    qsort(cost_ns, n_calls, sizeof(*cost_ns), cmp_i64);
+    int64_t total = 0;
+    for (uint32_t i = 0; i < n_calls; i++) {
+        total += cost_ns[i];
+    }
+
+    printf("mode: %s, calls: %u, fields: %llu, no data: %u\n",
+           mode == BME68X_FORCED_MODE ? "forced" : (mode == BME68X_PARALLEL_MODE ? "parallel" : "sequential"),
+           n_calls, (unsigned long long)fields, no_data);
+    printf("get_data: mean %lld ns, p50 %lld ns, p99 %lld ns\n",
+           (long long)(total / n_calls), (long long)cost_ns[n_calls / 2],
+           (long long)cost_ns[(n_calls * 99) / 100]);
+    printf("bus/get_data: %.2f reads, %.2f writes, %.1f bytes\n",
+           (double)reads / n_calls, (double)writes / n_calls, (double)bytes / n_calls);
+    printf("replay: %.0f samples/s (%u emulated conversions)\n",
+           (double)fields / elapsed_s, emu.stats.conversions);
+
+    free(cost_ns);
+    free(replay);
+    return 0;
+}
@@ -0,0 +1,452 @@
+/*
+ * Host stand-in for libalgobsec.a.
+ *
+ * The vendor library only ships for the ESP32, so the Linux build links this
+ * file instead. It implements the parts of bsec_interface.h the pipeline uses
+ * with a simple, deterministic model: IAQ follows the log-ratio of the gas
+ * resistance to a slowly tracked clean-air baseline and accuracy grows with
+ * the number of gas samples seen. The baseline and sample count make up the
+ * serialized state, so a restored stub is calibrated right away. It is meant
+ * for profiling and regression runs, not for judging air quality.
+ *
+ * Both the singleton and the multi-instance (_m) API are provided; the
+ * singleton calls operate on one built-in instance.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "bsec_interface.h"
+#include "bsec_interface_multi.h"
+#include "bsec_datatypes.h"
+
+#define STUB_MAX_SUBSCRIBED     BSEC_NUMBER_OUTPUTS
+#define STUB_HEAT_OFFSET_C      1.5f
+
+/* Settings BSEC asks for in LP/ULP mode (BME68X_OS_* and degC/ms) */
+#define STUB_OS_TEMPERATURE     2       /* 2x */
+#define STUB_OS_PRESSURE        5       /* 16x */
+#define STUB_OS_HUMIDITY        1       /* 1x */
+#define STUB_HEATER_TEMP_C      320
+#define STUB_HEATER_DUR_MS      197
+#define STUB_FORCED_MODE        1
+
+/* Allowed deviation of a sensor_control call from next_call, in 1/16 of the period */
+#define STUB_CALL_TOLERANCE_16  1
+
+/* Serialized state: magic, then the calibration part of the model */
+#define STUB_STATE_MAGIC        0x42555453u     /* "STUB" */
+#define STUB_STATE_LEN          16
+
+#define ACCURACY_1_SAMPLES      30
+#define ACCURACY_2_SAMPLES      300
+#define ACCURACY_3_SAMPLES      1200
+
+typedef struct {
+    uint8_t subscribed[STUB_MAX_SUBSCRIBED];
+    uint8_t n_subscribed;
+    float sample_rate;
+    int64_t next_call;      /* ns, 0 before the first sensor_control */
+
+    float gas_baseline;     /* log(ohm) */
+    uint32_t n_gas_samples;
+    float iaq;
+
+    float temperature;
+    float humidity;
+    float pressure;
+    float gas;
+} bsec_stub_t;
+
+/* Instance behind the singleton API; the _m functions take caller memory */
+static bsec_stub_t default_stub;
+
+/* ===== MODEL ===== */
+static uint8_t iaq_accuracy(const bsec_stub_t *s)
+{
+    if (s->n_gas_samples >= ACCURACY_3_SAMPLES)
+        return 3;
+    if (s->n_gas_samples >= ACCURACY_2_SAMPLES)
+        return 2;
+    if (s->n_gas_samples >= ACCURACY_1_SAMPLES)
+        return 1;
+    return 0;
+}
+
+static void update_gas(bsec_stub_t *s, float gas_ohm)
+{
+    float lg = logf(gas_ohm > 1.0f ? gas_ohm : 1.0f);
+
+    if (s->n_gas_samples == 0) {
+        s->gas_baseline = lg;
+    } else {
+        /* Rise quickly to cleaner air, decay slowly towards polluted air */
+        float rate = (lg > s->gas_baseline) ? 0.1f : 0.001f;
+        s->gas_baseline += (lg - s->gas_baseline) * rate;
+    }
+    s->n_gas_samples++;
+
+    float iaq = 25.0f + (s->gas_baseline - lg) * 250.0f;
+    if (iaq < 0.0f)
+        iaq = 0.0f;
+    if (iaq > 500.0f)
+        iaq = 500.0f;
+
+    /* BSEC reports the neutral value until the baseline has settled */
+    s->iaq = iaq_accuracy(s) ? iaq : 50.0f;
+}
+
+static int output_signal(const bsec_stub_t *s, uint8_t sensor_id, float *signal, uint8_t *accuracy)
+{
+    *accuracy = 0;
+
+    switch (sensor_id) {
+        case BSEC_OUTPUT_IAQ:
+        case BSEC_OUTPUT_STATIC_IAQ:
+            *signal = s->iaq;
+            *accuracy = iaq_accuracy(s);
+            return 1;
+        case BSEC_OUTPUT_CO2_EQUIVALENT:
+            *signal = 400.0f + s->iaq * 8.0f;
+            *accuracy = iaq_accuracy(s);
+            return 1;
+        case BSEC_OUTPUT_BREATH_VOC_EQUIVALENT:
+            *signal = 0.5f + s->iaq * 0.02f;
+            *accuracy = iaq_accuracy(s);
+            return 1;
+        case BSEC_OUTPUT_RAW_TEMPERATURE:
+            *signal = s->temperature;
+            return 1;
+        case BSEC_OUTPUT_RAW_PRESSURE:
+            *signal = s->pressure;
+            return 1;
+        case BSEC_OUTPUT_RAW_HUMIDITY:
+            *signal = s->humidity;
+            return 1;
+        case BSEC_OUTPUT_RAW_GAS:
+            *signal = s->gas;
+            return 1;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE:
+            *signal = s->temperature - STUB_HEAT_OFFSET_C;
+            return 1;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY:
+            /* Same absolute humidity at the lower temperature, ~6.5 %/K */
+            *signal = s->humidity * (1.0f + 0.065f * STUB_HEAT_OFFSET_C);
+            if (*signal > 100.0f)
+                *signal = 100.0f;
+            return 1;
+        case BSEC_OUTPUT_STABILIZATION_STATUS:
+        case BSEC_OUTPUT_RUN_IN_STATUS:
+            *signal = (s->n_gas_samples >= ACCURACY_1_SAMPLES) ? 1.0f : 0.0f;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* ===== BSEC MULTI-INSTANCE INTERFACE ===== */
+size_t bsec_get_instance_size_m(void)
+{
+    return sizeof(bsec_stub_t);
+}
+
+bsec_library_return_t bsec_get_version_m(void *inst, bsec_version_t *bsec_version_p)
+{
+    (void)inst;
+    bsec_version_p->major = 0;
+    bsec_version_p->minor = 0;
+    bsec_version_p->major_bugfix = 0;
+    bsec_version_p->minor_bugfix = 0;
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_init_m(void *inst)
+{
+    bsec_stub_t *s = inst;
+    memset(s, 0, sizeof(*s));
+    s->iaq = 50.0f;
+    s->sample_rate = BSEC_SAMPLE_RATE_DISABLED;
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_update_subscription_m(void *inst, const bsec_sensor_configuration_t * const requested_virtual_sensors,
+    const uint8_t n_requested_virtual_sensors, bsec_sensor_configuration_t * required_sensor_settings,
+    uint8_t * n_required_sensor_settings)
+{
+    bsec_stub_t *s = inst;
+    static const uint8_t physical[] = {
+        BSEC_INPUT_PRESSURE, BSEC_INPUT_HUMIDITY, BSEC_INPUT_TEMPERATURE, BSEC_INPUT_GASRESISTOR,
+    };
+    float rate = BSEC_SAMPLE_RATE_DISABLED;
+
+    for (uint8_t i = 0; i < n_requested_virtual_sensors; i++) {
+        uint8_t id = requested_virtual_sensors[i].sensor_id;
+        float sample_rate = requested_virtual_sensors[i].sample_rate;
+        uint8_t j;
+
+        for (j = 0; j < s->n_subscribed && s->subscribed[j] != id; j++)
+            ;
+
+        if (sample_rate == BSEC_SAMPLE_RATE_DISABLED) {
+            if (j < s->n_subscribed) {
+                s->subscribed[j] = s->subscribed[--s->n_subscribed];
+            }
+            continue;
+        }
+
+        if (j == s->n_subscribed) {
+            if (s->n_subscribed >= STUB_MAX_SUBSCRIBED) {
+                return BSEC_E_SU_GATECOUNTEXCEEDSARRAY;
+            }
+            s->subscribed[s->n_subscribed++] = id;
+        }
+        rate = sample_rate;
+    }
+    s->sample_rate = (s->n_subscribed > 0) ? rate : BSEC_SAMPLE_RATE_DISABLED;
+    s->next_call = 0;
+
+    if (*n_required_sensor_settings < sizeof(physical)) {
+        return BSEC_E_SU_GATECOUNTEXCEEDSARRAY;
+    }
+
+    for (uint8_t i = 0; i < sizeof(physical); i++) {
+        required_sensor_settings[i].sensor_id = physical[i];
+        required_sensor_settings[i].sample_rate = rate;
+    }
+    *n_required_sensor_settings = sizeof(physical);
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_sensor_control_m(void *inst, const int64_t time_stamp, bsec_bme_settings_t *sensor_settings)
+{
+    bsec_stub_t *s = inst;
+    bsec_library_return_t ret = BSEC_OK;
+
+    memset(sensor_settings, 0, sizeof(*sensor_settings));
+
+    if (s->sample_rate == BSEC_SAMPLE_RATE_DISABLED || s->sample_rate <= 0.0f) {
+        sensor_settings->next_call = time_stamp + 1000000000LL;
+        return BSEC_OK;
+    }
+
+    int64_t period = (int64_t)llroundf(1.0f / s->sample_rate) * 1000000000LL;
+    int64_t tolerance = period * STUB_CALL_TOLERANCE_16 / 16;
+
+    if (s->next_call != 0 && time_stamp < s->next_call - tolerance) {
+        /* Too early: nothing to measure yet */
+        sensor_settings->next_call = s->next_call;
+        return BSEC_W_SC_CALL_TIMING_VIOLATION;
+    }
+
+    if (s->next_call != 0 && time_stamp > s->next_call + tolerance) {
+        ret = BSEC_W_SC_CALL_TIMING_VIOLATION;
+    }
+
+    /* Keep the grid of the previous calls unless a whole period was missed */
+    if (s->next_call != 0 && time_stamp - s->next_call < period) {
+        s->next_call += period;
+    } else {
+        s->next_call = time_stamp + period;
+    }
+
+    sensor_settings->next_call = s->next_call;
+    sensor_settings->process_data = BSEC_PROCESS_TEMPERATURE | BSEC_PROCESS_HUMIDITY |
+                                    BSEC_PROCESS_PRESSURE | BSEC_PROCESS_GAS;
+    sensor_settings->heater_temperature = STUB_HEATER_TEMP_C;
+    sensor_settings->heater_duration = STUB_HEATER_DUR_MS;
+    sensor_settings->run_gas = 1;
+    sensor_settings->temperature_oversampling = STUB_OS_TEMPERATURE;
+    sensor_settings->pressure_oversampling = STUB_OS_PRESSURE;
+    sensor_settings->humidity_oversampling = STUB_OS_HUMIDITY;
+    sensor_settings->trigger_measurement = 1;
+    sensor_settings->op_mode = STUB_FORCED_MODE;
+
+    return ret;
+}
+
+bsec_library_return_t bsec_do_steps_m(void *inst, const bsec_input_t * const inputs, const uint8_t n_inputs,
+    bsec_output_t * outputs, uint8_t * n_outputs)
+{
+    bsec_stub_t *s = inst;
+    int64_t time_stamp = 0;
+
+    for (uint8_t i = 0; i < n_inputs; i++) {
+        time_stamp = inputs[i].time_stamp;
+
+        switch (inputs[i].sensor_id) {
+            case BSEC_INPUT_TEMPERATURE:
+                s->temperature = inputs[i].signal;
+                break;
+            case BSEC_INPUT_HUMIDITY:
+                s->humidity = inputs[i].signal;
+                break;
+            case BSEC_INPUT_PRESSURE:
+                s->pressure = inputs[i].signal;
+                break;
+            case BSEC_INPUT_GASRESISTOR:
+                s->gas = inputs[i].signal;
+                update_gas(s, inputs[i].signal);
+                break;
+            default:
+                break;
+        }
+    }
+
+    uint8_t max_outputs = *n_outputs;
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < s->n_subscribed; i++) {
+        float signal;
+        uint8_t accuracy;
+
+        if (!output_signal(s, s->subscribed[i], &signal, &accuracy)) {
+            continue;
+        }
+        if (n >= max_outputs) {
+            *n_outputs = n;
+            return BSEC_W_DOSTEPS_EXCESSOUTPUTS;
+        }
+
+        outputs[n].time_stamp = time_stamp;
+        outputs[n].signal = signal;
+        outputs[n].signal_dimensions = 1;
+        outputs[n].sensor_id = s->subscribed[i];
+        outputs[n].accuracy = accuracy;
+        n++;
+    }
+
+    *n_outputs = n;
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_set_configuration_m(void *inst, const uint8_t * const serialized_settings,
+    const uint32_t n_serialized_settings, uint8_t * work_buffer, const uint32_t n_work_buffer_size)
+{
+    /* The model has no tunables; only reject what the library would */
+    (void)inst;
+    (void)serialized_settings;
+    (void)work_buffer;
+
+    if (n_serialized_settings == 0) {
+        return BSEC_E_CONFIG_EMPTY;
+    }
+    if (n_work_buffer_size < BSEC_MAX_WORKBUFFER_SIZE) {
+        return BSEC_E_CONFIG_INSUFFICIENTWORKBUFFER;
+    }
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_get_state_m(void *inst, const uint8_t state_set_id, uint8_t *serialized_state,
+    const uint32_t n_serialized_state_max, uint8_t *work_buffer, const uint32_t n_work_buffer,
+    uint32_t *n_serialized_state)
+{
+    bsec_stub_t *s = inst;
+    uint32_t magic = STUB_STATE_MAGIC;
+
+    (void)state_set_id;
+    (void)work_buffer;
+    (void)n_work_buffer;
+
+    if (n_serialized_state_max < STUB_STATE_LEN) {
+        return BSEC_E_CONFIG_INSUFFICIENTBUFFER;
+    }
+
+    memcpy(&serialized_state[0], &magic, 4);
+    memcpy(&serialized_state[4], &s->gas_baseline, 4);
+    memcpy(&serialized_state[8], &s->n_gas_samples, 4);
+    memcpy(&serialized_state[12], &s->iaq, 4);
+    *n_serialized_state = STUB_STATE_LEN;
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_set_state_m(void *inst, const uint8_t * const serialized_state, const uint32_t n_serialized_state,
+    uint8_t *work_buffer, const uint32_t n_work_buffer_size)
+{
+    bsec_stub_t *s = inst;
+    uint32_t magic;
+
+    (void)work_buffer;
+    (void)n_work_buffer_size;
+
+    if (n_serialized_state < STUB_STATE_LEN) {
+        return BSEC_E_CONFIG_EMPTY;
+    }
+    memcpy(&magic, serialized_state, 4);
+    if (magic != STUB_STATE_MAGIC || n_serialized_state != STUB_STATE_LEN) {
+        return BSEC_E_CONFIG_VERSIONMISMATCH;
+    }
+
+    memcpy(&s->gas_baseline, &serialized_state[4], 4);
+    memcpy(&s->n_gas_samples, &serialized_state[8], 4);
+    memcpy(&s->iaq, &serialized_state[12], 4);
+
+    return BSEC_OK;
+}
+
+bsec_library_return_t bsec_reset_output_m(void *inst, uint8_t sensor_id)
+{
+    bsec_stub_t *s = inst;
+    if (sensor_id == BSEC_OUTPUT_IAQ) {
+        s->n_gas_samples = 0;
+        s->iaq = 50.0f;
+    }
+    return BSEC_OK;
+}
+
+/* ===== BSEC INTERFACE ===== */
+bsec_library_return_t bsec_get_version(bsec_version_t *bsec_version_p)
+{
+    return bsec_get_version_m(&default_stub, bsec_version_p);
+}
+
+bsec_library_return_t bsec_init(void)
+{
+    return bsec_init_m(&default_stub);
+}
+
+bsec_library_return_t bsec_update_subscription(const bsec_sensor_configuration_t * const requested_virtual_sensors,
+    const uint8_t n_requested_virtual_sensors, bsec_sensor_configuration_t * required_sensor_settings,
+    uint8_t * n_required_sensor_settings)
+{
+    return bsec_update_subscription_m(&default_stub, requested_virtual_sensors, n_requested_virtual_sensors,
+                                      required_sensor_settings, n_required_sensor_settings);
+}
+
+bsec_library_return_t bsec_sensor_control(const int64_t time_stamp, bsec_bme_settings_t *sensor_settings)
+{
+    return bsec_sensor_control_m(&default_stub, time_stamp, sensor_settings);
+}
+
+bsec_library_return_t bsec_do_steps(const bsec_input_t * const inputs, const uint8_t n_inputs,
+    bsec_output_t * outputs, uint8_t * n_outputs)
+{
+    return bsec_do_steps_m(&default_stub, inputs, n_inputs, outputs, n_outputs);
+}
+
+bsec_library_return_t bsec_set_configuration(const uint8_t * const serialized_settings,
+    const uint32_t n_serialized_settings, uint8_t * work_buffer, const uint32_t n_work_buffer_size)
+{
+    return bsec_set_configuration_m(&default_stub, serialized_settings, n_serialized_settings,
+                                    work_buffer, n_work_buffer_size);
+}
+
+bsec_library_return_t bsec_get_state(const uint8_t state_set_id, uint8_t *serialized_state,
+    const uint32_t n_serialized_state_max, uint8_t *work_buffer, const uint32_t n_work_buffer,
+    uint32_t *n_serialized_state)
+{
+    return bsec_get_state_m(&default_stub, state_set_id, serialized_state, n_serialized_state_max,
+                            work_buffer, n_work_buffer, n_serialized_state);
+}
+
+bsec_library_return_t bsec_set_state(const uint8_t * const serialized_state, const uint32_t n_serialized_state,
+    uint8_t *work_buffer, const uint32_t n_work_buffer_size)
+{
+    return bsec_set_state_m(&default_stub, serialized_state, n_serialized_state, work_buffer, n_work_buffer_size);
+}
+
+bsec_library_return_t bsec_reset_output(uint8_t sensor_id)
+{
+    return bsec_reset_output_m(&default_stub, sensor_id);
+}
@@ -0,0 +1,284 @@
+/*
+ * Sample log on an emulated flash region: append cost, bytes per sample in
+ * records and in flash (page headers and unused page tails included) next
+ * to a raw history entry and a telemetry frame, and how long the firmware's
+ * partition holds at one sample per BSEC cycle.
+ *
+ * Halfway through, the log is remounted after a reset, as at boot. At the
+ * end the whole region is exported through log chunk frames, reassembled,
+ * decoded and checked against the samples that went in: every record of
+ * the pages still held, with log time continuing across the reset.
+ *
+ *   sample_log_bench [-n samples] [-p pages] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sample_log.h"
+#include "sensor_hal_host.h"
+#include "telemetry.h"
+
+#define DEFAULT_SAMPLES     100000
+#define DEFAULT_PAGES       240         /* samplelog partition (partitions.csv) */
+#define SAMPLE_PERIOD_MS    3000
+#define FLUSH_MS            60000
+
+typedef struct {
+    int64_t timestamp_ms;
+    int16_t value[SAMPLE_HISTORY_N_METRICS];
+} expected_t;
+
+/* Reassembles exported pages and checks their records against `expected` */
+typedef struct {
+    const expected_t *expected;
+    uint32_t n_expected;
+    uint32_t boot_index;        /* expected record with the boot bit, besides the first */
+
+    uint8_t page[SAMPLE_LOG_PAGE_MAX];
+    uint32_t next_offset;
+    uint32_t next_index;        /* expected record of the next decoded one, once known */
+    int started;
+
+    uint32_t frames;
+    uint64_t frame_bytes;
+    uint32_t pages;
+    uint32_t records;
+    uint32_t mismatches;
+} export_check_t;
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static float noise(float span)
+{
+    return span * ((float)(rng_next() % 2001) - 1000.0f) / 1000.0f;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Indoor air: slow daily drift with sensor noise, like the sim */
+static void make_sample(uint32_t i, int64_t timestamp_us, sensor_sample_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->timestamp_us = timestamp_us;
+    s->temperature = 22.0f + (float)(i % 400) * 0.01f + noise(0.05f);
+    s->humidity = 45.0f + noise(0.5f);
+    s->pressure = 1008.0f + noise(0.2f);
+    s->iaq = 50.0f + (float)((i / 50) % 100) + noise(1.0f);
+    s->pm2_5 = (uint16_t)(20 + (i / 20) % 60 + rng_next() % 5);
+    s->pm1_0 = (uint16_t)(s->pm2_5 * 6 / 10);
+    s->pm10 = (uint16_t)(s->pm2_5 * 16 / 10);
+    s->aqi = (float)s->pm2_5 * 2.0f;
+}
+
+static void check_page(export_check_t *x, uint32_t page_len)
+{
+    sample_log_cursor_t c;
+    sample_log_record_t rec;
+    int ret;
+
+    x->pages++;
+    if (sample_log_page_open(&c, x->page, page_len) != SAMPLE_LOG_OK) {
+        x->mismatches++;
+        return;
+    }
+
+    while ((ret = sample_log_page_next(&c, &rec)) == 1) {
+        /* The oldest page held starts somewhere in the run */
+        if (!x->started) {
+            while (x->next_index < x->n_expected && x->expected[x->next_index].timestamp_ms < rec.timestamp_ms) {
+                x->next_index++;
+            }
+            x->started = 1;
+        }
+
+        uint32_t k = x->next_index++;
+        if (k >= x->n_expected || rec.timestamp_ms != x->expected[k].timestamp_ms ||
+            rec.boot != (k == 0 || k == x->boot_index) ||
+            memcmp(rec.value, x->expected[k].value, sizeof(rec.value)) != 0) {
+            x->mismatches++;
+        }
+        x->records++;
+    }
+    if (ret != 0) {
+        x->mismatches++;
+    }
+}
+
+/* The firmware's emit callback, with the bridge's decoding on the other end */
+static int check_chunk(void *arg, uint32_t seq, uint32_t offset, uint32_t page_len, const uint8_t *data,
+                       uint32_t len)
+{
+    export_check_t *x = arg;
+    telemetry_log_chunk_t chunk = {
+        .page_seq = seq, .offset = (uint16_t)offset, .page_len = (uint16_t)page_len, .len = (uint16_t)len,
+    };
+    telemetry_log_chunk_t decoded;
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    uint16_t frame_seq;
+
+    memcpy(chunk.data, data, len);
+    int frame_len = telemetry_encode_log_chunk(&chunk, (uint16_t)x->frames, frame, sizeof(frame));
+    if (frame_len <= 0 ||
+        telemetry_decode_log_chunk(&frame[1], (size_t)frame_len - 2, &decoded, &frame_seq) != TELEMETRY_OK ||
+        frame_seq != (uint16_t)x->frames || decoded.offset != x->next_offset) {
+        x->mismatches++;
+        return 1;
+    }
+    x->frames++;
+    x->frame_bytes += (uint64_t)frame_len;
+
+    memcpy(&x->page[decoded.offset], decoded.data, decoded.len);
+    x->next_offset = decoded.offset + decoded.len;
+    if (x->next_offset == decoded.page_len) {
+        check_page(x, decoded.page_len);
+        x->next_offset = 0;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n_samples = DEFAULT_SAMPLES;
+    uint32_t n_pages = DEFAULT_PAGES;
+    uint32_t seed = 1;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:p:s:")) != -1) {
+        switch (c) {
+            case 'n':
+                n_samples = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                n_pages = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-p pages] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n_samples < 2 || n_pages < 2) {
+        return 2;
+    }
+    rng_state = seed;
+
+    static host_hal_t host;
+    static sample_log_t log;
+    sensor_hal_t hal;
+
+    host_hal_init(&host, &hal);
+    if (host_hal_set_log(&host, &hal, NULL, n_pages * HOST_HAL_LOG_SECTOR) != SENSOR_HAL_OK ||
+        sample_log_init(&log, &hal, FLUSH_MS) != SAMPLE_LOG_OK) {
+        fprintf(stderr, "log init failed\n");
+        return 1;
+    }
+
+    expected_t *expected = malloc(n_samples * sizeof(*expected));
+    if (expected == NULL) {
+        return 1;
+    }
+
+    uint32_t reset_at = n_samples / 2;
+    int64_t boot_offset_ms = 0;
+    int64_t append_ns = 0;
+    uint64_t telemetry_bytes = 0;
+    uint32_t errors = 0;
+    uint32_t held_at_reset = 0;
+    sample_log_stats_t before_reset = { 0 };
+
+    for (uint32_t i = 0; i < n_samples; i++) {
+        int64_t boot_us = (int64_t)((i < reset_at) ? i : i - reset_at) * SAMPLE_PERIOD_MS * 1000;
+        sensor_sample_t sample;
+        uint8_t frame[TELEMETRY_FRAME_MAX];
+
+        if (i == reset_at) {
+            /* Clean reset: the buffered records are programmed, then the log is found again */
+            sample_log_flush(&log);
+            before_reset = log.stats;
+            held_at_reset = log.seq;
+            host.now_us = 0;
+            if (sample_log_init(&log, &hal, FLUSH_MS) != SAMPLE_LOG_OK) {
+                fprintf(stderr, "remount failed\n");
+                return 1;
+            }
+            boot_offset_ms = log.boot_offset_ms;
+        }
+
+        host.now_us = boot_us;
+        make_sample(i, boot_us, &sample);
+        expected[i].timestamp_ms = boot_offset_ms + boot_us / 1000;
+        sample_history_values(&sample, expected[i].value);
+        telemetry_bytes += (uint64_t)telemetry_encode_sample(&sample, (uint16_t)i, frame, sizeof(frame));
+
+        int64_t t0 = now_ns();
+        if (sample_log_append(&log, &sample) != SAMPLE_LOG_OK) {
+            errors++;
+        }
+        append_ns += now_ns() - t0;
+    }
+
+    /* Both mounts together */
+    sample_log_stats_t st = log.stats;
+    st.records += before_reset.records;
+    st.record_bytes += before_reset.record_bytes;
+    st.flash_bytes += before_reset.flash_bytes;
+    st.flushes += before_reset.flushes;
+    st.erases += before_reset.erases;
+
+    static export_check_t check;
+    sample_log_snapshot_t snap;
+    check.expected = expected;
+    check.n_expected = n_samples;
+    check.boot_index = reset_at;
+
+    sample_log_snapshot(&log, &snap);
+    int64_t t0 = now_ns();
+    uint32_t exported = sample_log_export(&log, &snap, 0, INT64_MAX, TELEMETRY_LOG_CHUNK_MAX, check_chunk, &check);
+    int64_t export_ns = now_ns() - t0;
+
+    /* Every record from the oldest page held to the last sample */
+    if (check.next_index != n_samples || exported != snap.n_pages) {
+        check.mismatches++;
+    }
+
+    double flash_per_sample = (double)st.erases * log.page_size / st.records;
+    double region_samples = (double)log.n_pages * log.page_size / flash_per_sample;
+
+    printf("samples: %u, append mean %.1f ns, %u errors\n", n_samples, (double)append_ns / n_samples,
+           (unsigned)(errors + st.errors));
+    printf("record: %.2f bytes/sample, %.2f bytes/sample programmed, %.2f bytes/sample of flash "
+           "(raw history entry %zu, telemetry frame %.1f)\n",
+           (double)st.record_bytes / st.records, (double)st.flash_bytes / st.records, flash_per_sample,
+           sizeof(sample_history_raw_t), (double)telemetry_bytes / n_samples);
+    printf("flash: %u pages of %u bytes, %u flushes, %u erases (%.2f per sector), holds %.0f samples = %.1f days "
+           "at %u ms\n",
+           (unsigned)log.n_pages, (unsigned)log.page_size, (unsigned)st.flushes, (unsigned)st.erases,
+           (double)st.erases / log.n_pages, region_samples,
+           region_samples * SAMPLE_PERIOD_MS / 86400000.0, SAMPLE_PERIOD_MS);
+    printf("reset after page %u: %u records recovered\n", (unsigned)held_at_reset, (unsigned)log.stats.recovered);
+    printf("export: %u pages, %u records, %u frames, %.1f bytes/record on the link, %.2f ms, %u mismatches\n",
+           (unsigned)exported, (unsigned)check.records, (unsigned)check.frames,
+           check.records ? (double)check.frame_bytes / check.records : 0.0, export_ns / 1e6,
+           (unsigned)check.mismatches);
+
+    host_hal_close_log(&host, &hal);
+    free(expected);
+    return (check.mismatches || errors) ? 1 : 0;
+}
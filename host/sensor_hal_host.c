@@ -0,0 +1,377 @@
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "sensor_hal_host.h"
+
+/* ===== ALLOCATION COUNTER ===== */
+/* Executables linking host_sim get -Wl,--wrap for these (see CMakeLists.txt) */
+static uint32_t heap_alloc_bytes;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    heap_alloc_bytes += (uint32_t)size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    heap_alloc_bytes += (uint32_t)(n * size);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    heap_alloc_bytes += (uint32_t)size;
+    return __real_realloc(ptr, size);
+}
+
+static host_bus_device_t *find_device(host_hal_t *host, uint8_t addr)
+{
+    for (uint8_t i = 0; i < host->n_devices; i++) {
+        if (host->devices[i].addr == addr) {
+            return &host->devices[i];
+        }
+    }
+    return NULL;
+}
+
+/* Time on the wire for `bytes` bytes including the address byte(s) */
+static void bus_time(host_hal_t *host, uint32_t bytes)
+{
+    if (host->i2c_hz != 0) {
+        host->now_us += ((int64_t)bytes * 9 * 1000000 + host->i2c_hz - 1) / host->i2c_hz;
+    }
+}
+
+/* ===== HAL CALLBACKS ===== */
+static int host_bus_read(void *ctx, uint8_t dev_addr, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+    host_bus_device_t *dev = find_device(host, dev_addr);
+
+    host->stats.reads++;
+    if (dev == NULL) {
+        bus_time(host, 1);      /* address NACK */
+        return SENSOR_HAL_E_NODEV;
+    }
+
+    /* Address + register, repeated start with the address, then the data */
+    bus_time(host, 3 + len);
+    host->stats.bytes += len;
+    return dev->read(dev->dev, reg, data, len);
+}
+
+static int host_bus_write(void *ctx, uint8_t dev_addr, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+    host_bus_device_t *dev = find_device(host, dev_addr);
+
+    host->stats.writes++;
+    if (dev == NULL) {
+        bus_time(host, 1);
+        return SENSOR_HAL_E_NODEV;
+    }
+
+    bus_time(host, 2 + len);
+    host->stats.bytes += len;
+    return dev->write(dev->dev, reg, data, len);
+}
+
+static void host_delay_us(void *ctx, uint32_t period)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+
+    host->now_us += period;
+    host->stats.delay_us += period;
+}
+
+static int64_t host_time_us(void *ctx)
+{
+    return ((host_hal_t *)ctx)->now_us;
+}
+
+static uint32_t host_alloc_bytes(void *ctx)
+{
+    (void)ctx;
+    return heap_alloc_bytes;
+}
+
+static int host_adc_read(void *ctx, uint8_t channel, int *raw)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+
+    if (channel >= HOST_HAL_ADC_CHANNELS) {
+        return SENSOR_HAL_E_NODEV;
+    }
+
+    host->now_us += host->adc_read_us;
+    *raw = host->adc_raw[channel];
+    return SENSOR_HAL_OK;
+}
+
+static uint32_t adc_noise(host_hal_t *host)
+{
+    host->adc_noise_state = host->adc_noise_state * 1664525u + 1013904223u;
+    return host->adc_noise_state >> 8;
+}
+
+static int host_adc_sample(void *ctx, uint8_t channel, sensor_hal_adc_sample_t *sample)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+
+    if (channel >= HOST_HAL_ADC_CHANNELS || host->adc_filters[channel].outputs == 0) {
+        return SENSOR_HAL_E_NODEV;
+    }
+
+    /* Ideal line; the board uses the eFuse calibration instead */
+    const adc_filter_t *f = &host->adc_filters[channel];
+    float mv_per_code = (float)HOST_HAL_ADC_FULL_SCALE_MV / 4095.0f;
+
+    sample->raw = (int)lrintf(f->value);
+    sample->mv = (int)lrintf(f->value * mv_per_code);
+    sample->noise_mv = sqrtf(f->variance) * mv_per_code;
+
+    return SENSOR_HAL_OK;
+}
+
+/* Plain syscalls rather than stdio, whose buffers would show up as heap use */
+static int store_path(host_hal_t *host, const char *key, char *path, size_t len)
+{
+    int n = snprintf(path, len, "%s/%s.bin", host->store_dir, key);
+    return (n > 0 && (size_t)n < len) ? SENSOR_HAL_OK : SENSOR_HAL_E_STORE;
+}
+
+static int host_blob_load(void *ctx, const char *key, void *data, uint32_t *len)
+{
+    char path[256];
+
+    if (store_path((host_hal_t *)ctx, key, path, sizeof(path)) != SENSOR_HAL_OK) {
+        return SENSOR_HAL_E_STORE;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return SENSOR_HAL_E_STORE;
+    }
+    ssize_t n = read(fd, data, *len);
+    close(fd);
+
+    if (n < 0) {
+        return SENSOR_HAL_E_STORE;
+    }
+    *len = (uint32_t)n;
+    return SENSOR_HAL_OK;
+}
+
+static int host_blob_save(void *ctx, const char *key, const void *data, uint32_t len)
+{
+    char path[256];
+    char tmp[260];
+
+    if (store_path((host_hal_t *)ctx, key, path, sizeof(path)) != SENSOR_HAL_OK) {
+        return SENSOR_HAL_E_STORE;
+    }
+    snprintf(tmp, sizeof(tmp), "%s.new", path);
+
+    /* Write then rename, so an interrupted save keeps the previous blob */
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return SENSOR_HAL_E_STORE;
+    }
+    ssize_t n = write(fd, data, len);
+    close(fd);
+
+    if (n != (ssize_t)len || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return SENSOR_HAL_E_STORE;
+    }
+    return SENSOR_HAL_OK;
+}
+
+/* ===== LOG FLASH ===== */
+static int host_log_read(void *ctx, uint32_t offset, void *data, uint32_t len)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+
+    if (offset > host->log_size || len > host->log_size - offset) {
+        return SENSOR_HAL_E_STORE;
+    }
+    memcpy(data, host->log_flash + offset, len);
+    return SENSOR_HAL_OK;
+}
+
+static int host_log_write(void *ctx, uint32_t offset, const void *data, uint32_t len)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+    const uint8_t *src = (const uint8_t *)data;
+
+    if (offset > host->log_size || len > host->log_size - offset) {
+        return SENSOR_HAL_E_STORE;
+    }
+    /* Programming only clears bits */
+    for (uint32_t i = 0; i < len; i++) {
+        host->log_flash[offset + i] &= src[i];
+    }
+    host->stats.log_written += len;
+    return SENSOR_HAL_OK;
+}
+
+static int host_log_erase(void *ctx, uint32_t offset)
+{
+    host_hal_t *host = (host_hal_t *)ctx;
+
+    if (offset % HOST_HAL_LOG_SECTOR != 0 || offset >= host->log_size) {
+        return SENSOR_HAL_E_STORE;
+    }
+    memset(host->log_flash + offset, 0xFF, HOST_HAL_LOG_SECTOR);
+    host->stats.log_erases++;
+    return SENSOR_HAL_OK;
+}
+
+/* ===== PUBLIC API ===== */
+void host_hal_init(host_hal_t *host, sensor_hal_t *hal)
+{
+    memset(host, 0, sizeof(*host));
+    host->i2c_hz = HOST_HAL_I2C_HZ;
+    host->adc_read_us = HOST_HAL_ADC_READ_US;
+    host->adc_noise_state = 1;
+    for (int i = 0; i < HOST_HAL_ADC_CHANNELS; i++) {
+        adc_filter_init(&host->adc_filters[i], HOST_HAL_ADC_DECIMATION);
+    }
+
+    hal->bus_read = host_bus_read;
+    hal->bus_write = host_bus_write;
+    hal->delay_us = host_delay_us;
+    hal->time_us = host_time_us;
+    hal->adc_read = host_adc_read;
+    hal->adc_sample = host_adc_sample;
+    hal->alloc_bytes = host_alloc_bytes;
+    hal->lock = NULL;
+    hal->unlock = NULL;
+    hal->blob_load = NULL;
+    hal->blob_save = NULL;
+    hal->log_read = NULL;
+    hal->log_write = NULL;
+    hal->log_erase = NULL;
+    hal->log_size = 0;
+    hal->log_sector_size = 0;
+    hal->ctx = host;
+}
+
+void host_hal_set_store(host_hal_t *host, sensor_hal_t *hal, const char *dir)
+{
+    host->store_dir = dir;
+    hal->blob_load = (dir != NULL) ? host_blob_load : NULL;
+    hal->blob_save = (dir != NULL) ? host_blob_save : NULL;
+}
+
+int host_hal_set_log(host_hal_t *host, sensor_hal_t *hal, const char *path, uint32_t size)
+{
+    uint8_t *flash;
+
+    size -= size % HOST_HAL_LOG_SECTOR;
+    if (size == 0) {
+        return SENSOR_HAL_E_STORE;
+    }
+
+    /* mmap rather than malloc, so the region does not count as heap use */
+    if (path != NULL) {
+        int fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return SENSOR_HAL_E_STORE;
+        }
+        off_t old_size = lseek(fd, 0, SEEK_END);
+        if (old_size < (off_t)size && ftruncate(fd, size) != 0) {
+            close(fd);
+            return SENSOR_HAL_E_STORE;
+        }
+        flash = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (flash == MAP_FAILED) {
+            return SENSOR_HAL_E_STORE;
+        }
+        /* A new or grown file reads as zeros; make that part erased flash */
+        if (old_size < (off_t)size) {
+            off_t start = (old_size > 0) ? old_size : 0;
+            memset(flash + start, 0xFF, size - (size_t)start);
+        }
+    } else {
+        flash = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (flash == MAP_FAILED) {
+            return SENSOR_HAL_E_STORE;
+        }
+        memset(flash, 0xFF, size);
+    }
+
+    host->log_flash = flash;
+    host->log_size = size;
+    hal->log_read = host_log_read;
+    hal->log_write = host_log_write;
+    hal->log_erase = host_log_erase;
+    hal->log_size = size;
+    hal->log_sector_size = HOST_HAL_LOG_SECTOR;
+    return SENSOR_HAL_OK;
+}
+
+void host_hal_close_log(host_hal_t *host, sensor_hal_t *hal)
+{
+    if (host->log_flash != NULL) {
+        munmap(host->log_flash, host->log_size);
+    }
+    host->log_flash = NULL;
+    host->log_size = 0;
+    hal->log_read = NULL;
+    hal->log_write = NULL;
+    hal->log_erase = NULL;
+    hal->log_size = 0;
+    hal->log_sector_size = 0;
+}
+
+int host_hal_attach(host_hal_t *host, uint8_t addr, host_bus_read_fn read, host_bus_write_fn write, void *dev)
+{
+    if (host->n_devices >= HOST_HAL_MAX_DEVICES || find_device(host, addr) != NULL) {
+        return SENSOR_HAL_E_NODEV;
+    }
+
+    host_bus_device_t *slot = &host->devices[host->n_devices++];
+    slot->addr = addr;
+    slot->read = read;
+    slot->write = write;
+    slot->dev = dev;
+
+    return SENSOR_HAL_OK;
+}
+
+void host_hal_adc_window(host_hal_t *host, uint8_t channel)
+{
+    if (channel >= HOST_HAL_ADC_CHANNELS) {
+        return;
+    }
+
+    adc_filter_t *f = &host->adc_filters[channel];
+    for (uint32_t k = 0; k < f->decimation; k++) {
+        float t = (float)k / HOST_HAL_ADC_RATE_HZ;
+        uint32_t r = adc_noise(host);
+        int v = host->adc_raw[channel] + (int)lrintf(25.0f * sinf(2.0f * (float)M_PI * 50.0f * t)) +
+                (int)(r % 25) - 12;
+
+        if (r % 500 == 0) {
+            v = 4095;
+        }
+        adc_filter_push(f, (uint16_t)(v < 0 ? 0 : (v > 4095 ? 4095 : v)));
+    }
+}
+
+void host_hal_advance(host_hal_t *host, int64_t us)
+{
+    host->now_us += us;
+}
@@ -0,0 +1,105 @@
+#ifndef SENSOR_HAL_HOST_H
+#define SENSOR_HAL_HOST_H
+
+#include <stdint.h>
+
+#include "sensor_hal.h"
+#include "adc_filter.h"
+
+/*
+ * Linux backend for sensor_hal_t.
+ *
+ * Bus transactions are routed by address to simulated devices, and time is
+ * virtual: delay_us() advances the clock instead of sleeping, so the pipeline
+ * runs as fast as the CPU allows while devices still see realistic timing.
+ * Bus transfers and ADC reads also advance it by what they take on the board
+ * (9 clocks per byte at i2c_hz, adc_read_us per conversion); set either to 0
+ * for instant transfers.
+ *
+ * adc_sample() returns what host_hal_adc_window() last filtered, the way the
+ * firmware's DMA sampler task works in the background.
+ */
+
+#define HOST_HAL_MAX_DEVICES    4
+#define HOST_HAL_ADC_CHANNELS   8
+
+/* Board defaults: 400 kHz I2C and a one-shot ADC conversion */
+#define HOST_HAL_I2C_HZ         400000
+#define HOST_HAL_ADC_READ_US    40
+
+/* Background sampler: 10 kHz per channel, 100 ms windows, 12 dB attenuation */
+#define HOST_HAL_ADC_RATE_HZ        10000
+#define HOST_HAL_ADC_DECIMATION     1000
+#define HOST_HAL_ADC_FULL_SCALE_MV  3100
+
+/* Flash sector of the emulated log region, as on the ESP32 */
+#define HOST_HAL_LOG_SECTOR     4096
+
+typedef int (*host_bus_read_fn)(void *dev, uint8_t reg, uint8_t *data, uint32_t len);
+typedef int (*host_bus_write_fn)(void *dev, uint8_t reg, const uint8_t *data, uint32_t len);
+
+typedef struct {
+    uint8_t addr;
+    host_bus_read_fn read;
+    host_bus_write_fn write;
+    void *dev;
+} host_bus_device_t;
+
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint64_t bytes;
+    uint64_t delay_us;
+    uint64_t log_written;       /* bytes programmed into the log region */
+    uint32_t log_erases;
+} host_hal_stats_t;
+
+typedef struct {
+    host_bus_device_t devices[HOST_HAL_MAX_DEVICES];
+    uint8_t n_devices;
+
+    int64_t now_us;
+    int adc_raw[HOST_HAL_ADC_CHANNELS];
+
+    uint32_t i2c_hz;
+    uint32_t adc_read_us;
+
+    adc_filter_t adc_filters[HOST_HAL_ADC_CHANNELS];
+    uint32_t adc_noise_state;
+
+    const char *store_dir;      /* blob_load/blob_save files, NULL for no storage */
+
+    uint8_t *log_flash;         /* emulated log region, NULL without one */
+    uint32_t log_size;
+
+    host_hal_stats_t stats;
+} host_hal_t;
+
+void host_hal_init(host_hal_t *host, sensor_hal_t *hal);
+
+/* Route transactions for `addr` to a simulated device; returns SENSOR_HAL_OK or an error */
+int host_hal_attach(host_hal_t *host, uint8_t addr, host_bus_read_fn read, host_bus_write_fn write, void *dev);
+
+/* Persist HAL blobs as `dir`/<key>.bin, like NVS survives a reset on the board */
+void host_hal_set_store(host_hal_t *host, sensor_hal_t *hal, const char *dir);
+
+/*
+ * Emulate a `size` byte NOR flash log region of HOST_HAL_LOG_SECTOR byte
+ * sectors: erase sets 0xFF, writes AND into what is there. With a `path` it
+ * is mapped from that file (created erased), so it survives like the
+ * partition on the board; NULL keeps it in memory. Returns SENSOR_HAL_OK or
+ * SENSOR_HAL_E_STORE.
+ */
+int host_hal_set_log(host_hal_t *host, sensor_hal_t *hal, const char *path, uint32_t size);
+void host_hal_close_log(host_hal_t *host, sensor_hal_t *hal);
+
+/*
+ * Run one filter window of synthetic samples around adc_raw[channel], with
+ * 50 Hz ripple, noise and occasional full-scale spikes, through adc_filter
+ */
+void host_hal_adc_window(host_hal_t *host, uint8_t channel);
+
+/* Move the virtual clock forward without a delay_us() call */
+void host_hal_advance(host_hal_t *host, int64_t us);
+
+#endif
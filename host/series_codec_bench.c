@@ -0,0 +1,554 @@
+/*
+ * Compression of sample series with the codecs of series_codec.h: bytes
+ * per row, ratio against fixed-width rows (u32 time, f32 per column) and
+ * encode/decode MB/s of those rows, for
+ *
+ *   varint      byte aligned zigzag varint deltas (the flash log's records)
+ *   delta       bit level: time order 2, readings order 1 (history frames)
+ *   dod         bit level: time and readings order 2
+ *   gorilla     bit level: time order 2, readings as XOR'd floats
+ *
+ * Every method must give back exactly what went in; special values (range
+ * ends, NaN, infinities, -0) are round-tripped first.
+ *
+ * The dataset is a CSV with a header row: time in the first column
+ * (timestamp_ms, or time_s in seconds) and one reading per further column,
+ * like the output of sample_log.py or the simulator's conditions files. A
+ * "boot" column is skipped. Integer methods see each column in fixed point
+ * at the most decimals it was recorded with. Without -f, a day of 3 s
+ * samples like the simulator's is generated.
+ *
+ *   series_codec_bench [-f samples.csv] [-n rows] [-r repeats] [-s seed]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "series_codec.h"
+
+#define DEFAULT_ROWS        28800       /* a day at one sample per 3 s */
+#define DEFAULT_REPEATS     20
+#define MAX_COLUMNS         16
+#define LINE_LEN            1024
+
+typedef struct {
+    uint32_t n_rows;
+    uint32_t n_cols;
+    char names[MAX_COLUMNS][32];
+    uint32_t decimals[MAX_COLUMNS];
+    uint32_t *time_ms;
+    int32_t *fixed;             /* n_rows x n_cols */
+    float *value;
+} dataset_t;
+
+typedef struct {
+    const char *name;
+    /* Returns the bytes written, or 0 if `cap` was too small */
+    uint32_t (*encode)(const dataset_t *ds, uint8_t *buf, uint32_t cap);
+    /* Fills `out` (a dataset of the same shape); returns 0 or -1 */
+    int (*decode)(const dataset_t *ds, const uint8_t *buf, uint32_t len, dataset_t *out);
+    int floats;                 /* compares value instead of fixed */
+} method_t;
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static float noise(float span)
+{
+    return span * ((float)(rng_next() % 2001) - 1000.0f) / 1000.0f;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ===== DATASETS ===== */
+static int alloc_dataset(dataset_t *ds, uint32_t n_rows, uint32_t n_cols)
+{
+    ds->n_rows = n_rows;
+    ds->n_cols = n_cols;
+    ds->time_ms = calloc(n_rows, sizeof(*ds->time_ms));
+    ds->fixed = calloc((size_t)n_rows * n_cols, sizeof(*ds->fixed));
+    ds->value = calloc((size_t)n_rows * n_cols, sizeof(*ds->value));
+    return (ds->time_ms && ds->fixed && ds->value) ? 0 : -1;
+}
+
+static void free_dataset(dataset_t *ds)
+{
+    free(ds->time_ms);
+    free(ds->fixed);
+    free(ds->value);
+}
+
+/* Fixed point from the floats, at each column's decimals */
+static void fill_fixed(dataset_t *ds)
+{
+    for (uint32_t c = 0; c < ds->n_cols; c++) {
+        double scale = pow(10.0, ds->decimals[c]);
+        for (uint32_t i = 0; i < ds->n_rows; i++) {
+            ds->fixed[i * ds->n_cols + c] = (int32_t)lrint(ds->value[i * ds->n_cols + c] * scale);
+        }
+    }
+}
+
+/* The simulator's indoor air, at the precision of the sample history */
+static int make_dataset(dataset_t *ds, uint32_t n_rows)
+{
+    static const char *const names[] = { "temperature", "humidity", "pressure", "iaq", "pm1_0", "pm2_5", "pm10",
+                                         "aqi" };
+    static const uint32_t decimals[] = { 2, 2, 1, 1, 0, 0, 0, 1 };
+
+    if (alloc_dataset(ds, n_rows, 8) != 0) {
+        return -1;
+    }
+    for (uint32_t c = 0; c < 8; c++) {
+        snprintf(ds->names[c], sizeof(ds->names[c]), "%s", names[c]);
+        ds->decimals[c] = decimals[c];
+    }
+
+    for (uint32_t i = 0; i < n_rows; i++) {
+        float *v = &ds->value[i * 8];
+        float pm2_5 = (float)(20 + (i / 20) % 60 + rng_next() % 5);
+
+        /* BSEC cycles land a few ms either side of the 3 s grid */
+        ds->time_ms[i] = 3000 * i + rng_next() % 4;
+        v[0] = roundf((22.0f + (float)(i % 400) * 0.01f + noise(0.05f)) * 100.0f) / 100.0f;
+        v[1] = roundf((45.0f + noise(0.5f)) * 100.0f) / 100.0f;
+        v[2] = roundf((1008.0f + noise(0.2f)) * 10.0f) / 10.0f;
+        v[3] = roundf((50.0f + (float)((i / 50) % 100) + noise(1.0f)) * 10.0f) / 10.0f;
+        v[4] = floorf(pm2_5 * 0.6f);
+        v[5] = pm2_5;
+        v[6] = floorf(pm2_5 * 1.6f);
+        v[7] = pm2_5 * 2.0f;
+    }
+    fill_fixed(ds);
+    return 0;
+}
+
+static uint32_t count_decimals(const char *field)
+{
+    const char *dot = strchr(field, '.');
+    uint32_t n = 0;
+
+    if (dot == NULL) {
+        return 0;
+    }
+    for (const char *p = dot + 1; *p >= '0' && *p <= '9'; p++) {
+        n++;
+    }
+    return (n > 6) ? 6 : n;
+}
+
+static int load_dataset(dataset_t *ds, const char *path, uint32_t max_rows)
+{
+    char line[LINE_LEN];
+    int use[MAX_COLUMNS + 1] = { 0 };
+    uint32_t n_fields = 0;
+    double time_scale = 1.0;
+    uint32_t rows = 0;
+    FILE *f = fopen(path, "r");
+
+    if (f == NULL) {
+        return -1;
+    }
+
+    /* Header: which fields are columns */
+    while (fgets(line, sizeof(line), f) != NULL && line[0] == '#') {
+    }
+    for (char *tok = strtok(line, ",\r\n"); tok != NULL && n_fields <= MAX_COLUMNS; tok = strtok(NULL, ",\r\n")) {
+        if (n_fields == 0) {
+            time_scale = (strcmp(tok, "time_s") == 0) ? 1000.0 : 1.0;
+        } else if (strcmp(tok, "boot") != 0) {
+            use[n_fields] = 1;
+            snprintf(ds->names[ds->n_cols], sizeof(ds->names[0]), "%s", tok);
+            ds->n_cols++;
+        }
+        n_fields++;
+    }
+    uint32_t n_cols = ds->n_cols;
+
+    /* Rows: count, then read */
+    long start = ftell(f);
+    while (fgets(line, sizeof(line), f) != NULL && rows < max_rows) {
+        rows += (line[0] != '#' && line[0] != '\n');
+    }
+    if (rows == 0 || n_cols == 0 || alloc_dataset(ds, rows, n_cols) != 0) {
+        fclose(f);
+        return -1;
+    }
+    fseek(f, start, SEEK_SET);
+
+    uint32_t i = 0;
+    while (i < rows && fgets(line, sizeof(line), f) != NULL) {
+        uint32_t field = 0;
+        uint32_t c = 0;
+
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        for (char *tok = strtok(line, ",\r\n"); tok != NULL && field < n_fields; tok = strtok(NULL, ",\r\n")) {
+            if (field == 0) {
+                ds->time_ms[i] = (uint32_t)llround(strtod(tok, NULL) * time_scale);
+            } else if (use[field]) {
+                uint32_t d = count_decimals(tok);
+                ds->value[i * n_cols + c] = strtof(tok, NULL);
+                if (d > ds->decimals[c]) {
+                    ds->decimals[c] = d;
+                }
+                c++;
+            }
+            field++;
+        }
+        i++;
+    }
+    fclose(f);
+
+    fill_fixed(ds);
+    return 0;
+}
+
+/* ===== METHODS ===== */
+static uint32_t varint_encode(const dataset_t *ds, uint8_t *buf, uint32_t cap)
+{
+    uint8_t *p = buf;
+    uint32_t prev_t = 0;
+
+    for (uint32_t i = 0; i < ds->n_rows; i++) {
+        /* Worst case: one 5 byte varint per field */
+        if ((uint32_t)(p - buf) + 5 * (1 + ds->n_cols) > cap) {
+            return 0;
+        }
+        p = series_put_varint(p, series_zigzag((int32_t)(ds->time_ms[i] - prev_t)));
+        prev_t = ds->time_ms[i];
+        for (uint32_t c = 0; c < ds->n_cols; c++) {
+            int32_t prev = i ? ds->fixed[(i - 1) * ds->n_cols + c] : 0;
+            p = series_put_varint(p, series_zigzag(ds->fixed[i * ds->n_cols + c] - prev));
+        }
+    }
+    return (uint32_t)(p - buf);
+}
+
+static int varint_decode(const dataset_t *ds, const uint8_t *buf, uint32_t len, dataset_t *out)
+{
+    const uint8_t *p = buf;
+    const uint8_t *end = buf + len;
+    uint32_t t = 0;
+    uint64_t v;
+
+    for (uint32_t i = 0; i < ds->n_rows; i++) {
+        if ((p = series_get_varint(p, end, &v)) == NULL) {
+            return -1;
+        }
+        t += (uint32_t)series_unzigzag((uint32_t)v);
+        out->time_ms[i] = t;
+        for (uint32_t c = 0; c < ds->n_cols; c++) {
+            int32_t prev = i ? out->fixed[(i - 1) * ds->n_cols + c] : 0;
+            if ((p = series_get_varint(p, end, &v)) == NULL) {
+                return -1;
+            }
+            out->fixed[i * ds->n_cols + c] = prev + series_unzigzag((uint32_t)v);
+        }
+    }
+    return 0;
+}
+
+static uint32_t int_encode(const dataset_t *ds, uint8_t *buf, uint32_t cap, uint8_t order)
+{
+    series_writer_t w;
+    series_int_t time_col = { .order = 2 };
+    series_int_t cols[MAX_COLUMNS];
+
+    series_writer_init(&w, buf, cap);
+    for (uint32_t c = 0; c < ds->n_cols; c++) {
+        cols[c] = (series_int_t){ .order = order };
+    }
+    for (uint32_t i = 0; i < ds->n_rows; i++) {
+        if (series_put_int(&w, &time_col, (int32_t)ds->time_ms[i]) != SERIES_OK) {
+            return 0;
+        }
+        for (uint32_t c = 0; c < ds->n_cols; c++) {
+            if (series_put_int(&w, &cols[c], ds->fixed[i * ds->n_cols + c]) != SERIES_OK) {
+                return 0;
+            }
+        }
+    }
+    return series_writer_bytes(&w);
+}
+
+static int int_decode(const dataset_t *ds, const uint8_t *buf, uint32_t len, dataset_t *out, uint8_t order)
+{
+    series_reader_t r;
+    series_int_t time_col = { .order = 2 };
+    series_int_t cols[MAX_COLUMNS];
+    int32_t v;
+
+    series_reader_init(&r, buf, len);
+    for (uint32_t c = 0; c < ds->n_cols; c++) {
+        cols[c] = (series_int_t){ .order = order };
+    }
+    for (uint32_t i = 0; i < ds->n_rows; i++) {
+        if (series_get_int(&r, &time_col, &v) != SERIES_OK) {
+            return -1;
+        }
+        out->time_ms[i] = (uint32_t)v;
+        for (uint32_t c = 0; c < ds->n_cols; c++) {
+            if (series_get_int(&r, &cols[c], &out->fixed[i * ds->n_cols + c]) != SERIES_OK) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static uint32_t delta_encode(const dataset_t *ds, uint8_t *buf, uint32_t cap)
+{
+    return int_encode(ds, buf, cap, 1);
+}
+
+static int delta_decode(const dataset_t *ds, const uint8_t *buf, uint32_t len, dataset_t *out)
+{
+    return int_decode(ds, buf, len, out, 1);
+}
+
+static uint32_t dod_encode(const dataset_t *ds, uint8_t *buf, uint32_t cap)
+{
+    return int_encode(ds, buf, cap, 2);
+}
+
+static int dod_decode(const dataset_t *ds, const uint8_t *buf, uint32_t len, dataset_t *out)
+{
+    return int_decode(ds, buf, len, out, 2);
+}
+
+static uint32_t gorilla_encode(const dataset_t *ds, uint8_t *buf, uint32_t cap)
+{
+    series_writer_t w;
+    series_int_t time_col = { .order = 2 };
+    series_float_t cols[MAX_COLUMNS];
+
+    series_writer_init(&w, buf, cap);
+    memset(cols, 0, sizeof(cols));
+    for (uint32_t i = 0; i < ds->n_rows; i++) {
+        if (series_put_int(&w, &time_col, (int32_t)ds->time_ms[i]) != SERIES_OK) {
+            return 0;
+        }
+        for (uint32_t c = 0; c < ds->n_cols; c++) {
+            if (series_put_float(&w, &cols[c], ds->value[i * ds->n_cols + c]) != SERIES_OK) {
+                return 0;
+            }
+        }
+    }
+    return series_writer_bytes(&w);
+}
+
+static int gorilla_decode(const dataset_t *ds, const uint8_t *buf, uint32_t len, dataset_t *out)
+{
+    series_reader_t r;
+    series_int_t time_col = { .order = 2 };
+    series_float_t cols[MAX_COLUMNS];
+    int32_t t;
+
+    series_reader_init(&r, buf, len);
+    memset(cols, 0, sizeof(cols));
+    for (uint32_t i = 0; i < ds->n_rows; i++) {
+        if (series_get_int(&r, &time_col, &t) != SERIES_OK) {
+            return -1;
+        }
+        out->time_ms[i] = (uint32_t)t;
+        for (uint32_t c = 0; c < ds->n_cols; c++) {
+            if (series_get_float(&r, &cols[c], &out->value[i * ds->n_cols + c]) != SERIES_OK) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static const method_t methods[] = {
+    { "varint", varint_encode, varint_decode, 0 },
+    { "delta", delta_encode, delta_decode, 0 },
+    { "dod", dod_encode, dod_decode, 0 },
+    { "gorilla", gorilla_encode, gorilla_decode, 1 },
+};
+
+static int same_dataset(const dataset_t *a, const dataset_t *b, int floats)
+{
+    size_t cells = (size_t)a->n_rows * a->n_cols;
+
+    if (memcmp(a->time_ms, b->time_ms, a->n_rows * sizeof(*a->time_ms)) != 0) {
+        return 0;
+    }
+    /* Floats bit for bit */
+    return floats ? memcmp(a->value, b->value, cells * sizeof(*a->value)) == 0
+                  : memcmp(a->fixed, b->fixed, cells * sizeof(*a->fixed)) == 0;
+}
+
+/* ===== SPECIAL VALUES ===== */
+static uint32_t check_special_values(void)
+{
+    static const int32_t ints[] = { 0, 0, INT32_MAX, INT32_MIN, INT32_MAX, -1, 1, 63, -64, 64, -65, 255, -256,
+                                    256, -257, 2047, -2048, 2048, -2049, 0, INT32_MIN, INT32_MIN, 7, 7, 7 };
+    const uint32_t float_bits[] = { 0x00000000, 0x80000000, 0x7F800000, 0xFF800000, 0x7FC00001, 0xFFFFFFFF,
+                                    0x00000001, 0x3F800000, 0x3F800001, 0x3F800000, 0x7F7FFFFF, 0x00800000,
+                                    0x00800000, 0xC2C80000 };
+    uint8_t buf[512];
+    uint32_t failures = 0;
+    uint32_t n_ints = sizeof(ints) / sizeof(ints[0]);
+    uint32_t n_floats = sizeof(float_bits) / sizeof(float_bits[0]);
+
+    for (uint8_t order = 1; order <= 2; order++) {
+        series_writer_t w;
+        series_reader_t r;
+        series_int_t enc = { .order = order };
+        series_int_t dec = { .order = order };
+        int32_t v;
+
+        series_writer_init(&w, buf, sizeof(buf));
+        for (uint32_t i = 0; i < n_ints; i++) {
+            failures += series_put_int(&w, &enc, ints[i]) != SERIES_OK;
+        }
+        series_reader_init(&r, buf, series_writer_bytes(&w));
+        for (uint32_t i = 0; i < n_ints; i++) {
+            failures += series_get_int(&r, &dec, &v) != SERIES_OK || v != ints[i];
+        }
+    }
+
+    series_writer_t w;
+    series_reader_t r;
+    series_float_t enc = { 0 };
+    series_float_t dec = { 0 };
+
+    series_writer_init(&w, buf, sizeof(buf));
+    for (uint32_t i = 0; i < n_floats; i++) {
+        float f;
+        memcpy(&f, &float_bits[i], sizeof(f));
+        failures += series_put_float(&w, &enc, f) != SERIES_OK;
+    }
+    series_reader_init(&r, buf, series_writer_bytes(&w));
+    for (uint32_t i = 0; i < n_floats; i++) {
+        float f;
+        uint32_t bits;
+        failures += series_get_float(&r, &dec, &f) != SERIES_OK;
+        memcpy(&bits, &f, sizeof(bits));
+        failures += bits != float_bits[i];
+    }
+
+    /* A full writer refuses without writing; a short stream reports truncation */
+    series_int_t col = { .order = 1 };
+    int32_t v;
+    series_writer_init(&w, buf, 4);
+    failures += series_put_int(&w, &col, 1) != SERIES_E_FULL || w.bits != 0;
+    series_reader_init(&r, (const uint8_t *)"\xF0", 1);
+    col = (series_int_t){ .order = 1 };
+    failures += series_get_int(&r, &col, &v) != SERIES_E_TRUNCATED;
+
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    uint32_t n_rows = DEFAULT_ROWS;
+    uint32_t repeats = DEFAULT_REPEATS;
+    uint32_t seed = 1;
+    int c;
+
+    while ((c = getopt(argc, argv, "f:n:r:s:")) != -1) {
+        switch (c) {
+            case 'f':
+                path = optarg;
+                break;
+            case 'n':
+                n_rows = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                repeats = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-f samples.csv] [-n rows] [-r repeats] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n_rows == 0 || repeats == 0) {
+        return 2;
+    }
+    rng_state = seed;
+
+    uint32_t special_failures = check_special_values();
+    printf("special values: %u failures\n", (unsigned)special_failures);
+
+    static dataset_t ds;
+    static dataset_t out;
+    if ((path != NULL) ? load_dataset(&ds, path, n_rows) != 0 : make_dataset(&ds, n_rows) != 0) {
+        fprintf(stderr, "cannot load %s\n", path);
+        return 1;
+    }
+    if (alloc_dataset(&out, ds.n_rows, ds.n_cols) != 0) {
+        return 1;
+    }
+
+    printf("dataset: %s, %u rows x %u columns:", path ? path : "synthetic", (unsigned)ds.n_rows,
+           (unsigned)ds.n_cols);
+    for (uint32_t col = 0; col < ds.n_cols; col++) {
+        printf(" %s/%u", ds.names[col], (unsigned)ds.decimals[col]);
+    }
+    printf(" (name/decimals)\n");
+
+    /* Fixed width rows, the reference for ratio and throughput */
+    double raw_bytes = (double)ds.n_rows * (4 + 4 * ds.n_cols);
+    uint32_t cap = ds.n_rows * (1 + ds.n_cols) * 6 + 64;
+    uint8_t *buf = malloc(cap);
+    if (buf == NULL) {
+        return 1;
+    }
+
+    uint32_t mismatches = 0;
+    printf("%-8s %10s %8s %12s %12s\n", "method", "bytes/row", "ratio", "encode MB/s", "decode MB/s");
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++) {
+        const method_t *method = &methods[m];
+        uint32_t len = 0;
+
+        int64_t t0 = now_ns();
+        for (uint32_t r = 0; r < repeats; r++) {
+            len = method->encode(&ds, buf, cap);
+        }
+        int64_t encode_ns = now_ns() - t0;
+
+        int ok = len > 0;
+        t0 = now_ns();
+        for (uint32_t r = 0; r < repeats && ok; r++) {
+            ok = method->decode(&ds, buf, len, &out) == 0;
+        }
+        int64_t decode_ns = now_ns() - t0;
+
+        if (!ok || !same_dataset(&ds, &out, method->floats)) {
+            mismatches++;
+        }
+        printf("%-8s %10.2f %8.2f %12.1f %12.1f%s\n", method->name, (double)len / ds.n_rows, raw_bytes / len,
+               raw_bytes * repeats / 1e6 / (encode_ns / 1e9), raw_bytes * repeats / 1e6 / (decode_ns / 1e9),
+               ok && same_dataset(&ds, &out, method->floats) ? "" : "  MISMATCH");
+        memset(out.time_ms, 0, ds.n_rows * sizeof(*out.time_ms));
+        memset(out.fixed, 0, (size_t)ds.n_rows * ds.n_cols * sizeof(*out.fixed));
+        memset(out.value, 0, (size_t)ds.n_rows * ds.n_cols * sizeof(*out.value));
+    }
+
+    free(buf);
+    free_dataset(&out);
+    free_dataset(&ds);
+    return (mismatches || special_failures) ? 1 : 0;
+}
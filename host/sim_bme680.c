@@ -0,0 +1,721 @@
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bme68x_defs.h"
+#include "sensor_hal.h"
+#include "sim_bme680.h"
+
+#define STATUS_MEASURING    0x20
+
+/* Calibration of a typical production part */
+#define CAL_T1      25942
+#define CAL_T2      26406
+#define CAL_T3      3
+#define CAL_P1      36371
+#define CAL_P2      (-10422)
+#define CAL_P3      88
+#define CAL_P4      7283
+#define CAL_P5      (-105)
+#define CAL_P6      30
+#define CAL_P7      42
+#define CAL_P8      (-2655)
+#define CAL_P9      (-2011)
+#define CAL_P10     30
+#define CAL_H1      752
+#define CAL_H2      1017
+#define CAL_H3      0
+#define CAL_H4      45
+#define CAL_H5      20
+#define CAL_H6      120
+#define CAL_H7      (-100)
+#define CAL_GH1     (-30)
+#define CAL_GH2     (-9836)
+#define CAL_GH3     18
+#define CAL_RES_HEAT_VAL    42
+#define CAL_RES_HEAT_RANGE  1
+#define CAL_RANGE_SW_ERR    0
+
+/* Heater model */
+#define HEATER_AMBIENT_C        25
+#define HEATER_REF_TEMP_C       320.0
+#define HEATER_SLOPE_C          100.0   /* gas resistance falls by e per 100 degC */
+#define HEATER_STABLE_US        20000   /* heating time needed for heat_stab */
+
+/* Bound on conversions caught up in one bus access after a long idle gap */
+#define MAX_CATCH_UP            1024
+
+/* ===== CALIBRATION BLOCK ===== */
+
+/* Map an index of the driver's concatenated coefficient array to its register */
+static uint8_t coeff_reg(uint8_t idx)
+{
+    if (idx < BME68X_LEN_COEFF1)
+        return BME68X_REG_COEFF1 + idx;
+    idx -= BME68X_LEN_COEFF1;
+    if (idx < BME68X_LEN_COEFF2)
+        return BME68X_REG_COEFF2 + idx;
+    idx -= BME68X_LEN_COEFF2;
+    return BME68X_REG_COEFF3 + idx;
+}
+
+static void put_coeff(sim_bme680_t *sim, uint8_t idx, uint8_t value)
+{
+    sim->regs[coeff_reg(idx)] = value;
+}
+
+static void put_coeff16(sim_bme680_t *sim, uint8_t lsb_idx, uint8_t msb_idx, int32_t value)
+{
+    put_coeff(sim, lsb_idx, (uint8_t)(value & 0xFF));
+    put_coeff(sim, msb_idx, (uint8_t)((value >> 8) & 0xFF));
+}
+
+static void load_calibration(sim_bme680_t *sim)
+{
+    put_coeff16(sim, BME68X_IDX_T1_LSB, BME68X_IDX_T1_MSB, CAL_T1);
+    put_coeff16(sim, BME68X_IDX_T2_LSB, BME68X_IDX_T2_MSB, CAL_T2);
+    put_coeff(sim, BME68X_IDX_T3, (uint8_t)CAL_T3);
+
+    put_coeff16(sim, BME68X_IDX_P1_LSB, BME68X_IDX_P1_MSB, CAL_P1);
+    put_coeff16(sim, BME68X_IDX_P2_LSB, BME68X_IDX_P2_MSB, CAL_P2);
+    put_coeff(sim, BME68X_IDX_P3, (uint8_t)CAL_P3);
+    put_coeff16(sim, BME68X_IDX_P4_LSB, BME68X_IDX_P4_MSB, CAL_P4);
+    put_coeff16(sim, BME68X_IDX_P5_LSB, BME68X_IDX_P5_MSB, CAL_P5);
+    put_coeff(sim, BME68X_IDX_P6, (uint8_t)CAL_P6);
+    put_coeff(sim, BME68X_IDX_P7, (uint8_t)CAL_P7);
+    put_coeff16(sim, BME68X_IDX_P8_LSB, BME68X_IDX_P8_MSB, CAL_P8);
+    put_coeff16(sim, BME68X_IDX_P9_LSB, BME68X_IDX_P9_MSB, CAL_P9);
+    put_coeff(sim, BME68X_IDX_P10, (uint8_t)CAL_P10);
+
+    /* H1 and H2 are 12 bit and share the nibbles of one register */
+    put_coeff(sim, BME68X_IDX_H1_MSB, (uint8_t)(CAL_H1 >> 4));
+    put_coeff(sim, BME68X_IDX_H2_MSB, (uint8_t)(CAL_H2 >> 4));
+    put_coeff(sim, BME68X_IDX_H1_LSB, (uint8_t)(((CAL_H2 & 0x0F) << 4) | (CAL_H1 & 0x0F)));
+    put_coeff(sim, BME68X_IDX_H3, (uint8_t)CAL_H3);
+    put_coeff(sim, BME68X_IDX_H4, (uint8_t)CAL_H4);
+    put_coeff(sim, BME68X_IDX_H5, (uint8_t)CAL_H5);
+    put_coeff(sim, BME68X_IDX_H6, (uint8_t)CAL_H6);
+    put_coeff(sim, BME68X_IDX_H7, (uint8_t)CAL_H7);
+
+    put_coeff(sim, BME68X_IDX_GH1, (uint8_t)CAL_GH1);
+    put_coeff16(sim, BME68X_IDX_GH2_LSB, BME68X_IDX_GH2_MSB, CAL_GH2);
+    put_coeff(sim, BME68X_IDX_GH3, (uint8_t)CAL_GH3);
+
+    put_coeff(sim, BME68X_IDX_RES_HEAT_VAL, (uint8_t)CAL_RES_HEAT_VAL);
+    put_coeff(sim, BME68X_IDX_RES_HEAT_RANGE, (uint8_t)(CAL_RES_HEAT_RANGE << 4));
+    put_coeff(sim, BME68X_IDX_RANGE_SW_ERR, (uint8_t)(CAL_RANGE_SW_ERR << 4));
+}
+
+static void reset_registers(sim_bme680_t *sim)
+{
+    memset(sim->regs, 0, sizeof(sim->regs));
+    load_calibration(sim);
+
+    sim->regs[BME68X_REG_CHIP_ID] = BME68X_CHIP_ID;
+    sim->regs[BME68X_REG_VARIANT_ID] = sim->variant;
+
+    sim->mode = BME68X_SLEEP_MODE;
+    sim->next_field = 0;
+}
+
+/* ===== COMPENSATION (INVERTED) ===== */
+
+/* Same arithmetic as the driver's float path, in double */
+static double comp_t_fine(uint32_t temp_adc)
+{
+    double var1 = ((temp_adc / 16384.0) - (CAL_T1 / 1024.0)) * CAL_T2;
+    double var2 = ((temp_adc / 131072.0) - (CAL_T1 / 8192.0));
+
+    return var1 + var2 * var2 * (CAL_T3 * 16.0);
+}
+
+static double comp_pressure(uint32_t pres_adc, double t_fine)
+{
+    double var1 = (t_fine / 2.0) - 64000.0;
+    double var2 = var1 * var1 * (CAL_P6 / 131072.0);
+    double var3;
+    double pres;
+
+    var2 = var2 + (var1 * CAL_P5 * 2.0);
+    var2 = (var2 / 4.0) + (CAL_P4 * 65536.0);
+    var1 = (((CAL_P3 * var1 * var1) / 16384.0) + (CAL_P2 * var1)) / 524288.0;
+    var1 = (1.0 + (var1 / 32768.0)) * CAL_P1;
+
+    pres = 1048576.0 - pres_adc;
+    pres = ((pres - (var2 / 4096.0)) * 6250.0) / var1;
+    var1 = (CAL_P9 * pres * pres) / 2147483648.0;
+    var2 = pres * (CAL_P8 / 32768.0);
+    var3 = (pres / 256.0) * (pres / 256.0) * (pres / 256.0) * (CAL_P10 / 131072.0);
+
+    return pres + (var1 + var2 + var3 + (CAL_P7 * 128.0)) / 16.0;
+}
+
+static double comp_humidity(uint32_t hum_adc, double temp_comp)
+{
+    double var1 = hum_adc - ((CAL_H1 * 16.0) + ((CAL_H3 / 2.0) * temp_comp));
+    double var2 = var1 * ((CAL_H2 / 262144.0) *
+                          (1.0 + ((CAL_H4 / 16384.0) * temp_comp) + ((CAL_H5 / 1048576.0) * temp_comp * temp_comp)));
+    double var3 = CAL_H6 / 16384.0;
+    double var4 = CAL_H7 / 2097152.0;
+
+    return var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
+}
+
+static uint8_t comp_res_heat(double temp)
+{
+    double var1 = (CAL_GH1 / 16.0) + 49.0;
+    double var2 = ((CAL_GH2 / 32768.0) * 0.0005) + 0.00235;
+    double var3 = CAL_GH3 / 1024.0;
+    double var4 = var1 * (1.0 + (var2 * temp));
+    double var5 = var4 + (var3 * HEATER_AMBIENT_C);
+
+    return (uint8_t)(3.4 * ((var5 * (4.0 / (4.0 + CAL_RES_HEAT_RANGE)) *
+                             (1.0 / (1.0 + (CAL_RES_HEAT_VAL * 0.002)))) - 25));
+}
+
+/* Largest ADC word in [0, max] for which f(adc) <= target, f increasing */
+#define BISECT(result, max, target, expr)                   \
+    do {                                                    \
+        uint32_t lo_ = 0, hi_ = (max);                      \
+        while (lo_ < hi_) {                                 \
+            uint32_t adc = lo_ + (hi_ - lo_ + 1) / 2;       \
+            if ((expr) <= (target))                         \
+                lo_ = adc;                                  \
+            else                                            \
+                hi_ = adc - 1;                              \
+        }                                                   \
+        (result) = lo_;                                     \
+    } while (0)
+
+static uint32_t temp_to_adc(double temp, double *t_fine)
+{
+    uint32_t adc;
+
+    BISECT(adc, 0xFFFFF, temp * 5120.0, comp_t_fine(adc));
+    *t_fine = comp_t_fine(adc);
+    return adc;
+}
+
+static uint32_t pressure_to_adc(double pressure, double t_fine)
+{
+    uint32_t adc;
+
+    /* Pressure falls as the ADC word rises */
+    BISECT(adc, 0xFFFFF, -pressure, -comp_pressure(adc, t_fine));
+    return adc;
+}
+
+static uint16_t humidity_to_adc(double humidity, double temp_comp)
+{
+    uint32_t adc;
+
+    BISECT(adc, 0xFFFF, humidity, comp_humidity(adc, temp_comp));
+    return (uint16_t)adc;
+}
+
+/* Closed-form inverse of calc_gas_resistance_low(); picks the range nearest mid-scale */
+static void gas_to_adc(double gas, uint16_t *adc_out, uint8_t *range_out)
+{
+    static const double k1[16] = { 0, 0, 0, 0, 0, -1.0, 0, -0.8, 0, 0, -0.2, -0.5, 0, -1.0, 0, 0 };
+    static const double k2[16] = { 0, 0, 0, 0, 0.1, 0.7, 0, -0.8, -0.1, 0, 0, 0, 0, 0, 0, 0 };
+    double best_err = 1e9;
+
+    *adc_out = 512;
+    *range_out = 0;
+
+    for (uint8_t range = 0; range < 16; range++) {
+        double var2 = (1340.0 + 5.0 * CAL_RANGE_SW_ERR) * (1.0 + k1[range] / 100.0);
+        double var3 = 1.0 + k2[range] / 100.0;
+        double adc = ((1.0 / (gas * var3 * 0.000000125 * (double)(1u << range))) - 1.0) * var2 + 512.0;
+
+        if (adc < 0.0 || adc > 1023.0) {
+            continue;
+        }
+        if (fabs(adc - 512.0) < best_err) {
+            best_err = fabs(adc - 512.0);
+            *adc_out = (uint16_t)lround(adc);
+            *range_out = range;
+        }
+    }
+}
+
+/* Inverse of calc_gas_resistance_high() (BME688); same choice of range */
+static void gas_to_adc_high(double gas, uint16_t *adc_out, uint8_t *range_out)
+{
+    double best_err = 1e9;
+
+    *adc_out = 512;
+    *range_out = 0;
+
+    for (uint8_t range = 0; range < 16; range++) {
+        double var1 = (double)(262144u >> range);
+        double adc = (1000000.0 * var1 / gas - 4096.0) / 3.0 + 512.0;
+
+        if (adc < 0.0 || adc > 1023.0) {
+            continue;
+        }
+        if (fabs(adc - 512.0) < best_err) {
+            best_err = fabs(adc - 512.0);
+            *adc_out = (uint16_t)lround(adc);
+            *range_out = range;
+        }
+    }
+}
+
+/* ===== CONDITIONS ===== */
+static void conditions_now(const sim_bme680_t *sim, sim_bme680_conditions_t *out)
+{
+    if (sim->replay == NULL || sim->n_replay == 0) {
+        *out = sim->cond;
+        return;
+    }
+
+    double t = (double)(*sim->now_us - sim->replay_start_us) / 1e6;
+    const sim_bme680_conditions_t *rows = sim->replay;
+    uint32_t n = sim->n_replay;
+
+    if (t <= rows[0].time_s) {
+        *out = rows[0];
+        return;
+    }
+    if (t >= rows[n - 1].time_s) {
+        *out = rows[n - 1];
+        return;
+    }
+
+    uint32_t lo = 0, hi = n - 1;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (rows[mid].time_s <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    double span = rows[hi].time_s - rows[lo].time_s;
+    float w = (span > 0.0) ? (float)((t - rows[lo].time_s) / span) : 0.0f;
+
+    out->time_s = t;
+    out->temperature = rows[lo].temperature + w * (rows[hi].temperature - rows[lo].temperature);
+    out->humidity = rows[lo].humidity + w * (rows[hi].humidity - rows[lo].humidity);
+    out->pressure = rows[lo].pressure + w * (rows[hi].pressure - rows[lo].pressure);
+    out->gas = rows[lo].gas + w * (rows[hi].gas - rows[lo].gas);
+}
+
+/* ===== HEATER AND TIMING ===== */
+static uint32_t os_cycles(uint8_t os)
+{
+    static const uint8_t os_to_meas_cycles[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+    return os_to_meas_cycles[os & 0x07];
+}
+
+static uint32_t tph_dur_us(const sim_bme680_t *sim)
+{
+    uint8_t ctrl_meas = sim->regs[BME68X_REG_CTRL_MEAS];
+    uint8_t ctrl_hum = sim->regs[BME68X_REG_CTRL_HUM];
+    uint32_t cycles = os_cycles(ctrl_meas >> 5) + os_cycles(ctrl_meas >> 2) + os_cycles(ctrl_hum);
+    uint32_t dur = cycles * 1963 + 477 * 4 + 477 * 5;
+
+    if (sim->mode != BME68X_PARALLEL_MODE) {
+        dur += 1000;    /* wake up */
+    }
+    return dur;
+}
+
+static int gas_enabled(const sim_bme680_t *sim)
+{
+    return (sim->regs[BME68X_REG_CTRL_GAS_1] & BME68X_RUN_GAS_MSK) &&
+           !(sim->regs[BME68X_REG_CTRL_GAS_0] & BME68X_HCTRL_MSK);
+}
+
+static uint8_t profile_len(const sim_bme680_t *sim)
+{
+    uint8_t nb_conv = sim->regs[BME68X_REG_CTRL_GAS_1] & BME68X_NBCONV_MSK;
+    return (nb_conv == 0 || nb_conv > SIM_BME680_N_STEPS) ? 1 : nb_conv;
+}
+
+/* gas_wait_x: 6-bit value times 1, 4, 16 or 64 ms */
+static uint32_t gas_wait_us(uint8_t reg)
+{
+    return ((uint32_t)(reg & 0x3F) << (2 * (reg >> 6))) * 1000;
+}
+
+/* Shared heater duration: same encoding in steps of 0.477 ms */
+static uint32_t shared_heatr_us(uint8_t reg)
+{
+    return ((uint32_t)(reg & 0x3F) << (2 * (reg >> 6))) * 477;
+}
+
+static uint32_t odr_standby_us(const sim_bme680_t *sim)
+{
+    static const uint32_t standby[8] = { 590, 62500, 125000, 250000, 500000, 1000000, 10000, 20000 };
+
+    if (sim->regs[BME68X_REG_CTRL_GAS_1] & BME68X_ODR3_MSK) {
+        return 0;
+    }
+    return standby[(sim->regs[BME68X_REG_CONFIG] & BME68X_ODR20_MSK) >> 5];
+}
+
+/* Heater target temperature set by res_heat_x */
+static double heater_temp(uint8_t res_heat)
+{
+    uint32_t temp;
+
+    BISECT(temp, 400, (double)res_heat, (double)comp_res_heat((double)adc));
+    return (double)temp;
+}
+
+/* Duration of the conversion for the current step and mode */
+static uint32_t conversion_dur_us(const sim_bme680_t *sim)
+{
+    uint32_t dur = tph_dur_us(sim);
+
+    if (!gas_enabled(sim)) {
+        return dur;
+    }
+
+    if (sim->mode == BME68X_PARALLEL_MODE) {
+        return dur + shared_heatr_us(sim->regs[BME68X_REG_SHD_HEATR_DUR]);
+    }
+    return dur + gas_wait_us(sim->regs[BME68X_REG_GAS_WAIT0 + sim->step]);
+}
+
+/* ===== FIELD REGISTERS ===== */
+static void latch_field(sim_bme680_t *sim, uint8_t gas_valid, uint8_t heat_stab)
+{
+    uint8_t *f = &sim->regs[BME68X_REG_FIELD0 + sim->next_field * BME68X_LEN_FIELD_OFFSET];
+    uint32_t temp_adc = sim->temp_adc;
+    uint32_t pres_adc = sim->pres_adc;
+    uint16_t hum_adc = sim->hum_adc;
+    uint16_t gas_adc = sim->gas_adc;
+    uint8_t gas_range = sim->gas_range;
+
+    if (!sim->raw_override) {
+        sim_bme680_conditions_t c;
+        double t_fine;
+
+        conditions_now(sim, &c);
+        temp_adc = temp_to_adc(c.temperature, &t_fine);
+        pres_adc = pressure_to_adc(c.pressure, t_fine);
+        hum_adc = humidity_to_adc(c.humidity, t_fine / 5120.0);
+
+        double heat = heater_temp(sim->regs[BME68X_REG_RES_HEAT0 + sim->step]);
+        double gas = c.gas * exp((HEATER_REF_TEMP_C - heat) / HEATER_SLOPE_C);
+        if (sim->variant == BME68X_VARIANT_GAS_HIGH) {
+            gas_to_adc_high(gas, &gas_adc, &gas_range);
+        } else {
+            gas_to_adc(gas, &gas_adc, &gas_range);
+        }
+    }
+
+    /* Skipped channels (oversampling none) read back their reset value */
+    uint8_t ctrl_meas = sim->regs[BME68X_REG_CTRL_MEAS];
+    if (os_cycles(ctrl_meas >> 5) == 0) {
+        temp_adc = 0x80000;
+    }
+    if (os_cycles(ctrl_meas >> 2) == 0) {
+        pres_adc = 0x80000;
+    }
+    if (os_cycles(sim->regs[BME68X_REG_CTRL_HUM]) == 0) {
+        hum_adc = 0x8000;
+    }
+
+    f[0] = BME68X_NEW_DATA_MSK | (sim->step & BME68X_GAS_INDEX_MSK);
+    f[1] = sim->meas_index++;
+    f[2] = (uint8_t)(pres_adc >> 12);
+    f[3] = (uint8_t)(pres_adc >> 4);
+    f[4] = (uint8_t)((pres_adc & 0x0F) << 4);
+    f[5] = (uint8_t)(temp_adc >> 12);
+    f[6] = (uint8_t)(temp_adc >> 4);
+    f[7] = (uint8_t)((temp_adc & 0x0F) << 4);
+    f[8] = (uint8_t)(hum_adc >> 8);
+    f[9] = (uint8_t)(hum_adc & 0xFF);
+    /* The BME688 reports gas two bytes further on */
+    uint8_t *g = (sim->variant == BME68X_VARIANT_GAS_HIGH) ? &f[15] : &f[13];
+    g[0] = (uint8_t)(gas_adc >> 2);
+    g[1] = (uint8_t)(((gas_adc & 0x03) << 6) | (gas_range & BME68X_GAS_RANGE_MSK));
+    if (gas_valid) {
+        g[1] |= BME68X_GASM_VALID_MSK;
+    }
+    if (heat_stab) {
+        g[1] |= BME68X_HEAT_STAB_MSK;
+    }
+
+    sim->stats.conversions++;
+    if (sim->mode != BME68X_FORCED_MODE) {
+        sim->next_field = (uint8_t)((sim->next_field + 1) % SIM_BME680_N_FIELDS);
+    }
+}
+
+/* Latch the finished conversion and schedule the next one */
+static void complete_conversion(sim_bme680_t *sim)
+{
+    int gas = gas_enabled(sim);
+    uint8_t heat_stab = 0;
+    uint8_t gas_valid = 0;
+    int64_t next_start = sim->conv_done_us;
+
+    if (sim->mode == BME68X_PARALLEL_MODE) {
+        /* gas_wait_x counts the TPH cycles the heater stays on step x */
+        uint8_t cycles = sim->regs[BME68X_REG_GAS_WAIT0 + sim->step];
+        uint32_t heated_us;
+
+        if (cycles == 0) {
+            cycles = 1;
+        }
+        sim->step_cycles++;
+        heated_us = sim->step_cycles * shared_heatr_us(sim->regs[BME68X_REG_SHD_HEATR_DUR]);
+        gas_valid = gas && (sim->step_cycles >= cycles);
+        heat_stab = gas_valid && heated_us >= HEATER_STABLE_US;
+        latch_field(sim, gas_valid, heat_stab);
+
+        if (sim->step_cycles >= cycles) {
+            sim->step_cycles = 0;
+            sim->step = (uint8_t)((sim->step + 1) % profile_len(sim));
+        }
+    } else {
+        gas_valid = (uint8_t)gas;
+        heat_stab = gas && gas_wait_us(sim->regs[BME68X_REG_GAS_WAIT0 + sim->step]) >= HEATER_STABLE_US;
+        latch_field(sim, gas_valid, heat_stab);
+
+        if (sim->mode == BME68X_FORCED_MODE) {
+            /* Back to sleep once the forced conversion is done */
+            sim->regs[BME68X_REG_CTRL_MEAS] &= (uint8_t)~BME68X_MODE_MSK;
+            sim->mode = BME68X_SLEEP_MODE;
+            return;
+        }
+
+        sim->step = (uint8_t)((sim->step + 1) % profile_len(sim));
+        if (sim->step == 0) {
+            next_start += odr_standby_us(sim);
+        }
+    }
+
+    sim->conv_done_us = next_start + conversion_dur_us(sim);
+}
+
+static void update(sim_bme680_t *sim)
+{
+    uint32_t n = 0;
+
+    while (sim->mode != BME68X_SLEEP_MODE && *sim->now_us >= sim->conv_done_us) {
+        complete_conversion(sim);
+
+        /* Don't replay hours of conversions after the host clock jumps */
+        if (++n >= MAX_CATCH_UP && sim->mode != BME68X_SLEEP_MODE) {
+            sim->conv_done_us = *sim->now_us + conversion_dur_us(sim);
+            break;
+        }
+    }
+}
+
+static void start_mode(sim_bme680_t *sim, uint8_t mode)
+{
+    sim->mode = mode;
+    sim->step_cycles = 0;
+    sim->stats.triggers++;
+
+    if (mode == BME68X_FORCED_MODE) {
+        /* Forced mode always reports in field 0 using heater step 0 */
+        sim->step = 0;
+        sim->next_field = 0;
+        sim->regs[BME68X_REG_FIELD0] = STATUS_MEASURING;
+    } else {
+        sim->step = 0;
+    }
+
+    sim->conv_done_us = *sim->now_us + conversion_dur_us(sim);
+}
+
+static void write_reg(sim_bme680_t *sim, uint8_t reg, uint8_t value)
+{
+    if (reg == BME68X_REG_SOFT_RESET) {
+        if (value == BME68X_SOFT_RESET_CMD) {
+            reset_registers(sim);
+        }
+        return;
+    }
+
+    /* Field registers are read-only */
+    if (reg >= BME68X_REG_FIELD0 && reg < BME68X_REG_FIELD0 + SIM_BME680_N_FIELDS * BME68X_LEN_FIELD_OFFSET) {
+        return;
+    }
+
+    sim->regs[reg] = value;
+
+    if (reg == BME68X_REG_CTRL_MEAS) {
+        uint8_t mode = value & BME68X_MODE_MSK;
+        if (mode == BME68X_SLEEP_MODE) {
+            sim->mode = BME68X_SLEEP_MODE;
+        } else if (mode != sim->mode) {
+            start_mode(sim, mode);
+        }
+    }
+}
+
+/* ===== BME68X DRIVER BINDING ===== */
+static int8_t bus_read(uint8_t reg, uint8_t *data, uint32_t len, void *intf_ptr)
+{
+    const sim_bme680_bus_t *bus = (const sim_bme680_bus_t *)intf_ptr;
+    int ret = bus->hal->bus_read(bus->hal->ctx, bus->addr, reg, data, len);
+
+    return (ret == SENSOR_HAL_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+}
+
+static int8_t bus_write(uint8_t reg, const uint8_t *data, uint32_t len, void *intf_ptr)
+{
+    const sim_bme680_bus_t *bus = (const sim_bme680_bus_t *)intf_ptr;
+    int ret = bus->hal->bus_write(bus->hal->ctx, bus->addr, reg, data, len);
+
+    return (ret == SENSOR_HAL_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+}
+
+static void bus_delay_us(uint32_t period, void *intf_ptr)
+{
+    const sim_bme680_bus_t *bus = (const sim_bme680_bus_t *)intf_ptr;
+
+    bus->hal->delay_us(bus->hal->ctx, period);
+}
+
+/* ===== PUBLIC API ===== */
+void sim_bme680_init(sim_bme680_t *sim, const int64_t *now_us)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->now_us = now_us;
+    sim->cond.temperature = 25.0f;
+    sim->cond.humidity = 40.0f;
+    sim->cond.pressure = 101325.0f;
+    sim->cond.gas = 100000.0f;
+    sim->variant = BME68X_VARIANT_GAS_LOW;
+    reset_registers(sim);
+}
+
+void sim_bme680_set_variant(sim_bme680_t *sim, uint8_t variant)
+{
+    sim->variant = variant;
+    sim->regs[BME68X_REG_VARIANT_ID] = variant;
+}
+
+void sim_bme680_set_conditions(sim_bme680_t *sim, const sim_bme680_conditions_t *cond)
+{
+    sim->cond = *cond;
+    sim->replay = NULL;
+    sim->n_replay = 0;
+    sim->raw_override = 0;
+}
+
+void sim_bme680_set_replay(sim_bme680_t *sim, const sim_bme680_conditions_t *rows, uint32_t n_rows)
+{
+    sim->replay = rows;
+    sim->n_replay = n_rows;
+    sim->replay_start_us = *sim->now_us;
+    sim->raw_override = 0;
+}
+
+uint32_t sim_bme680_load_csv(const char *path, sim_bme680_conditions_t **rows)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    uint32_t n = 0, cap = 0;
+    sim_bme680_conditions_t *table = NULL;
+
+    *rows = NULL;
+    if (f == NULL) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        sim_bme680_conditions_t row;
+        char *p = line;
+
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '\0' || *p == '#' || isalpha((unsigned char)*p)) {
+            continue;
+        }
+
+        if (sscanf(p, "%lf,%f,%f,%f,%f", &row.time_s, &row.temperature, &row.humidity,
+                   &row.pressure, &row.gas) != 5) {
+            continue;
+        }
+
+        if (n == cap) {
+            uint32_t new_cap = cap ? cap * 2 : 64;
+            sim_bme680_conditions_t *grown = realloc(table, new_cap * sizeof(*table));
+            if (grown == NULL) {
+                free(table);
+                fclose(f);
+                return 0;
+            }
+            table = grown;
+            cap = new_cap;
+        }
+        table[n++] = row;
+    }
+
+    fclose(f);
+    *rows = table;
+    return n;
+}
+
+void sim_bme680_set_raw(sim_bme680_t *sim, uint32_t temp_adc, uint32_t pres_adc, uint16_t hum_adc,
+                        uint16_t gas_adc, uint8_t gas_range)
+{
+    sim->raw_override = 1;
+    sim->temp_adc = temp_adc;
+    sim->pres_adc = pres_adc;
+    sim->hum_adc = hum_adc;
+    sim->gas_adc = gas_adc;
+    sim->gas_range = gas_range;
+}
+
+int sim_bme680_read(void *dev, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    sim_bme680_t *sim = (sim_bme680_t *)dev;
+
+    update(sim);
+    for (uint32_t i = 0; i < len; i++) {
+        data[i] = sim->regs[(uint8_t)(reg + i)];
+    }
+
+    /* Reading a field's status byte consumes its new_data flag */
+    for (uint8_t n = 0; n < SIM_BME680_N_FIELDS; n++) {
+        uint8_t status = (uint8_t)(BME68X_REG_FIELD0 + n * BME68X_LEN_FIELD_OFFSET);
+        if ((uint8_t)(status - reg) < len) {
+            sim->regs[status] &= (uint8_t)~BME68X_NEW_DATA_MSK;
+        }
+    }
+
+    return SENSOR_HAL_OK;
+}
+
+/* The BME680 takes multi-byte I2C writes as address/data pairs */
+int sim_bme680_write(void *dev, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+    sim_bme680_t *sim = (sim_bme680_t *)dev;
+
+    if (len == 0 || (len % 2) == 0) {
+        return SENSOR_HAL_E_BUS;
+    }
+
+    update(sim);
+    write_reg(sim, reg, data[0]);
+    for (uint32_t i = 1; i + 1 < len; i += 2) {
+        write_reg(sim, data[i], data[i + 1]);
+    }
+
+    return SENSOR_HAL_OK;
+}
+
+void sim_bme680_bind(struct bme68x_dev *dev, const sim_bme680_bus_t *bus)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->intf = BME68X_I2C_INTF;
+    dev->intf_ptr = (void *)bus;
+    dev->read = bus_read;
+    dev->write = bus_write;
+    dev->delay_us = bus_delay_us;
+    dev->amb_temp = 25;
+}
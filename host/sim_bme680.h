@@ -0,0 +1,117 @@
+#ifndef SIM_BME680_H
+#define SIM_BME680_H
+
+#include <stdint.h>
+
+#include "sensor_hal.h"
+
+/*
+ * Register-level model of a BME680 on I2C.
+ *
+ * Holds the 256-byte register file and answers burst reads and interleaved
+ * address/data writes the way the chip does. Conversions follow the
+ * datasheet timing on the host clock for forced, parallel and sequential
+ * mode: the TPH oversampling cycles, the heater profile in res_heat_x /
+ * gas_wait_x (or the shared heater duration in parallel mode) and the ODR
+ * standby time between sequential profiles. Results rotate through the three
+ * field registers at BME68X_REG_FIELD0 + n * BME68X_LEN_FIELD_OFFSET; reading
+ * a field's status byte clears its new_data flag.
+ *
+ * Physical conditions come from sim_bme680_set_conditions(), from a CSV
+ * replayed against the clock, or as raw ADC words for cases compensation
+ * cannot express. They are turned into raw ADC words by inverting the
+ * driver's compensation against the emulated calibration block.
+ *
+ * The emulator starts as a BME680; sim_bme680_set_variant() turns it into a
+ * BME688, which reports gas in the high-range registers and formula.
+ */
+
+#define SIM_BME680_N_FIELDS     3
+#define SIM_BME680_N_STEPS      10
+
+typedef struct {
+    double time_s;          /* offset from the start of the replay */
+    float temperature;      /* degC */
+    float humidity;         /* %RH */
+    float pressure;         /* Pa */
+    float gas;              /* ohm at a 320 degC heater */
+} sim_bme680_conditions_t;
+
+typedef struct {
+    uint32_t conversions;   /* fields produced */
+    uint32_t triggers;      /* forced/parallel/sequential mode entries */
+} sim_bme680_stats_t;
+
+typedef struct {
+    uint8_t regs[256];
+    const int64_t *now_us;
+    uint8_t variant;        /* BME68X_VARIANT_GAS_LOW (BME680) or _HIGH (BME688) */
+
+    /* Conversion scheduling */
+    uint8_t mode;
+    uint8_t step;           /* heater profile step of the running conversion */
+    uint8_t step_cycles;    /* parallel mode: TPH cycles spent on `step` */
+    uint8_t next_field;
+    uint8_t meas_index;
+    int64_t conv_done_us;
+
+    /* Input signals */
+    sim_bme680_conditions_t cond;
+    const sim_bme680_conditions_t *replay;
+    uint32_t n_replay;
+    int64_t replay_start_us;
+
+    uint8_t raw_override;
+    uint32_t temp_adc;
+    uint32_t pres_adc;
+    uint16_t hum_adc;
+    uint16_t gas_adc;
+    uint8_t gas_range;
+
+    sim_bme680_stats_t stats;
+} sim_bme680_t;
+
+void sim_bme680_init(sim_bme680_t *sim, const int64_t *now_us);
+
+/* BME68X_VARIANT_GAS_LOW or BME68X_VARIANT_GAS_HIGH, kept across soft resets */
+void sim_bme680_set_variant(sim_bme680_t *sim, uint8_t variant);
+
+/* Constant physical conditions for the following conversions */
+void sim_bme680_set_conditions(sim_bme680_t *sim, const sim_bme680_conditions_t *cond);
+
+/*
+ * Replay a table of conditions sorted by time_s, linearly interpolated and
+ * held after the last row. The table must outlive the emulator.
+ */
+void sim_bme680_set_replay(sim_bme680_t *sim, const sim_bme680_conditions_t *rows, uint32_t n_rows);
+
+/*
+ * Load "time_s,temperature_c,humidity_pct,pressure_pa,gas_ohm" rows from a
+ * CSV file; lines starting with '#' or a letter are skipped. Returns the
+ * number of rows (0 on error) and a malloc'd table in `rows`.
+ */
+uint32_t sim_bme680_load_csv(const char *path, sim_bme680_conditions_t **rows);
+
+/* Raw ADC words for the following conversions, bypassing compensation */
+void sim_bme680_set_raw(sim_bme680_t *sim, uint32_t temp_adc, uint32_t pres_adc, uint16_t hum_adc,
+                        uint16_t gas_adc, uint8_t gas_range);
+
+/* Bus callbacks for host_hal_attach() */
+int sim_bme680_read(void *dev, uint8_t reg, uint8_t *data, uint32_t len);
+int sim_bme680_write(void *dev, uint8_t reg, const uint8_t *data, uint32_t len);
+
+/* A device on a HAL bus, for the bme68x driver's intf_ptr */
+typedef struct {
+    const sensor_hal_t *hal;
+    uint8_t addr;
+} sim_bme680_bus_t;
+
+struct bme68x_dev;
+
+/*
+ * Clear `dev` and bind the bme68x driver to `bus` over I2C, with the bus
+ * transfers and delays going through the HAL; `bus` must outlive `dev`
+ */
+void sim_bme680_bind(struct bme68x_dev *dev, const sim_bme680_bus_t *bus);
+
+#endif
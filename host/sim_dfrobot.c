@@ -0,0 +1,60 @@
+#include <string.h>
+
+#include "sensor_hal.h"
+#include "sim_dfrobot.h"
+
+static void put_word(sim_dfrobot_t *sim, uint8_t reg, uint16_t value)
+{
+    sim->regs[reg] = (uint8_t)(value >> 8);
+    sim->regs[reg + 1] = (uint8_t)(value & 0xFF);
+}
+
+void sim_dfrobot_init(sim_dfrobot_t *sim, uint8_t version)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->regs[SIM_DFROBOT_REG_VERSION] = version;
+}
+
+void sim_dfrobot_set_pm(sim_dfrobot_t *sim, uint16_t pm1_0, uint16_t pm2_5, uint16_t pm10)
+{
+    put_word(sim, SIM_DFROBOT_REG_PM1_0_STANDARD, pm1_0);
+    put_word(sim, SIM_DFROBOT_REG_PM1_0_STANDARD + 2, pm2_5);
+    put_word(sim, SIM_DFROBOT_REG_PM1_0_STANDARD + 4, pm10);
+    put_word(sim, SIM_DFROBOT_REG_PM1_0_ATMOSPHERE, pm1_0);
+    put_word(sim, SIM_DFROBOT_REG_PM1_0_ATMOSPHERE + 2, pm2_5);
+    put_word(sim, SIM_DFROBOT_REG_PM1_0_ATMOSPHERE + 4, pm10);
+}
+
+void sim_dfrobot_set_counts(sim_dfrobot_t *sim, const uint16_t counts[SIM_DFROBOT_N_COUNTS])
+{
+    for (uint8_t i = 0; i < SIM_DFROBOT_N_COUNTS; i++) {
+        put_word(sim, SIM_DFROBOT_REG_COUNT_0_3_UM + 2 * i, counts[i]);
+    }
+}
+
+int sim_dfrobot_read(void *dev, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    sim_dfrobot_t *sim = (sim_dfrobot_t *)dev;
+
+    if ((uint32_t)reg + len > sizeof(sim->regs)) {
+        return SENSOR_HAL_E_BUS;
+    }
+
+    memcpy(data, &sim->regs[reg], len);
+    return SENSOR_HAL_OK;
+}
+
+/* Only the low-power control register is writable; everything else is ignored */
+int sim_dfrobot_write(void *dev, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+    sim_dfrobot_t *sim = (sim_dfrobot_t *)dev;
+
+    if ((uint32_t)reg + len > sizeof(sim->regs)) {
+        return SENSOR_HAL_E_BUS;
+    }
+
+    if (reg == 0x01 && len > 0) {
+        sim->regs[reg] = data[0];
+    }
+    return SENSOR_HAL_OK;
+}
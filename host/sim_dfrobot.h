@@ -0,0 +1,35 @@
+#ifndef SIM_DFROBOT_H
+#define SIM_DFROBOT_H
+
+#include <stdint.h>
+
+/*
+ * Register model of the DFRobot SEN0460 particle sensor.
+ *
+ * Concentrations and particle counts are big-endian words starting at 0x05,
+ * followed by the firmware version at 0x1D, as in the vendor datasheet.
+ */
+
+#define SIM_DFROBOT_REG_PM1_0_STANDARD   0x05
+#define SIM_DFROBOT_REG_PM1_0_ATMOSPHERE 0x0B
+#define SIM_DFROBOT_REG_COUNT_0_3_UM     0x11
+#define SIM_DFROBOT_REG_VERSION          0x1D
+#define SIM_DFROBOT_N_COUNTS             6
+
+typedef struct {
+    uint8_t regs[0x20];
+} sim_dfrobot_t;
+
+void sim_dfrobot_init(sim_dfrobot_t *sim, uint8_t version);
+
+/* Atmospheric PM1.0/PM2.5/PM10 in ug/m3; standard-particle values follow them */
+void sim_dfrobot_set_pm(sim_dfrobot_t *sim, uint16_t pm1_0, uint16_t pm2_5, uint16_t pm10);
+
+/* Particle counts per 0.1 L for >0.3, >0.5, >1.0, >2.5, >5.0 and >10 um */
+void sim_dfrobot_set_counts(sim_dfrobot_t *sim, const uint16_t counts[SIM_DFROBOT_N_COUNTS]);
+
+/* Bus callbacks for host_hal_attach() */
+int sim_dfrobot_read(void *dev, uint8_t reg, uint8_t *data, uint32_t len);
+int sim_dfrobot_write(void *dev, uint8_t reg, const uint8_t *data, uint32_t len);
+
+#endif
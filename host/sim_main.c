@@ -0,0 +1,548 @@
+/*
+ * Linux simulation of the air quality firmware.
+ *
+ * Runs the portable sensor pipeline against simulated BME680 and DFRobot
+ * devices on a virtual clock, prints one JSON line per sample like the
+ * firmware's debug output, and reports the host CPU cost and bus traffic per
+ * sample. With -b it writes binary telemetry frames instead, like the default
+ * firmware output (e.g. to feed telemetry.py).
+ *
+ *   air_quality_sim [-n samples] [-q] [-b] [-1] [-g|-G] [-s seed] [-c conditions.csv] [-S dir] [-H tier]
+ *                   [-L file] [-A scale] [-t hours]
+ *
+ * An exhaust BME680 at 0x77 sees the intake air after the purifier: cleaner
+ * and slightly warmed by the fan motor. -1 leaves it off the bus. With -g it
+ * is a BME688 running the heater profile scan in parallel mode instead of
+ * BSEC, with -G a BME680 scanning in forced mode; each pass is printed as a
+ * gas_scan line (or frame) between the samples.
+ *
+ * With -c, BME680 conditions are replayed from the CSV (see sim_bme680.h)
+ * instead of the built-in slow drift. With -S, the BSEC state is saved to and
+ * restored from `dir` like NVS on the board, so a second run starts warm.
+ *
+ * Every sample also goes into the sample history with the firmware's default
+ * tier sizes. -H prints one tier of it (raw, 1m, 15m or 1h) after the run,
+ * as the firmware answers the history command, as compressed history
+ * frames with -b, each of which must decode back to the entries it took.
+ * After the run every tier is checked to be in time order with its buckets
+ * aligned to their period.
+ *
+ * With -L, every sample is also appended to a sample log in an emulated
+ * flash region of the firmware's partition size, mapped from `file`; a
+ * second run continues the log like a reset board (decode it with
+ * sample_log.py image).
+ *
+ * -A picks the AQI scale like the firmware's Kconfig choice: epa (the
+ * default), epa2012, legacy, caqi or naqi.
+ *
+ * -t starts the virtual clock that many hours after boot, e.g. -t 1192 to
+ * cross the 2^32 ms (49.7 days) at which 32-bit millisecond times wrap.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sample_history.h"
+#include "sample_log.h"
+#include "sensor_pipeline.h"
+#include "sensor_scheduler.h"
+#include "sensor_hal_host.h"
+#include "sim_bme680.h"
+#include "sim_dfrobot.h"
+#include "telemetry.h"
+
+#define OUTPUT_BUF_LEN      768
+#define DEFAULT_SAMPLES     1000
+
+/* Firmware defaults (Kconfig.projbuild) */
+#define HISTORY_RAW_LEN     1024
+#define HISTORY_ROLLUP_LEN  256
+#define LOG_FLUSH_MS        60000
+
+/* samplelog partition (partitions.csv) */
+#define LOG_SIZE            0xF0000
+
+typedef struct {
+    uint32_t n_samples;
+    int quiet;
+    int binary;
+    int single;
+    int scan;               /* 0, or the emulated scan sensor's variant + 1 */
+    uint32_t seed;
+    const char *csv;
+    const char *store_dir;
+    int history_tier;       /* -1, or the tier to print after the run */
+    const char *log_file;
+    int aqi_scale;
+    int64_t start_us;
+} sim_options_t;
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+/* Uniform integer in [-span, span] */
+static int32_t jitter(int32_t span)
+{
+    return (int32_t)(rng_next() % (uint32_t)(2 * span + 1)) - span;
+}
+
+static float jitter_f(float span)
+{
+    return span * (float)jitter(1000) / 1000.0f;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Entries of every tier in time order, rollup buckets on multiples of their period */
+static uint32_t check_history(const sample_history_t *h, uint32_t *entries)
+{
+    uint32_t bad = 0;
+
+    *entries = 0;
+    for (int t = 0; t < SAMPLE_HISTORY_N_TIERS; t++) {
+        const sample_history_ring_t *r = &h->tiers[t];
+        sample_history_point_t point;
+        int64_t from_ms = 0;
+        int64_t prev_ms = -1;
+        uint32_t n = 0;
+
+        while (sample_history_query(h, (sample_history_tier_t)t, from_ms, INT64_MAX, &point, 1) == 1) {
+            bad += (point.timestamp_ms <= prev_ms) ||
+                   (t != SAMPLE_HISTORY_RAW && point.timestamp_ms % sample_history_period_ms[t] != 0);
+            prev_ms = point.timestamp_ms;
+            from_ms = point.timestamp_ms + 1;
+            n++;
+        }
+        /* Paging from 0 reaches every entry held, and a rollup tier's open bucket */
+        bad += (n != r->count + (t != SAMPLE_HISTORY_RAW && r->acc.count > 0));
+        *entries += n;
+    }
+    return bad;
+}
+
+/* Slowly drifting conditions with a little noise */
+static void update_conditions(uint32_t i, const sim_options_t *opt, sim_bme680_t *bme, sim_bme680_t *exhaust,
+                              sim_dfrobot_t *pm, host_hal_t *host)
+{
+    if (opt->csv == NULL) {
+        sim_bme680_conditions_t cond = {
+            .temperature = 22.0f + (float)(i % 400) * 0.01f + jitter_f(0.05f),
+            .humidity = 45.0f + jitter_f(0.5f),
+            .pressure = 100800.0f + jitter_f(20.0f),
+            .gas = 180000.0f - (float)((i / 50) % 100) * 800.0f + jitter_f(500.0f),
+        };
+        sim_bme680_set_conditions(bme, &cond);
+
+        cond.temperature += 0.8f;
+        cond.humidity -= 2.0f;
+        cond.pressure -= 15.0f;
+        /* The filter takes out most of the VOC swings */
+        cond.gas = 250000.0f - (180000.0f - cond.gas) * 0.3f;
+        sim_bme680_set_conditions(exhaust, &cond);
+    }
+
+    uint16_t pm2_5 = (uint16_t)(20 + (i / 20) % 60 + jitter(2));
+    sim_dfrobot_set_pm(pm, (uint16_t)(pm2_5 * 6 / 10), pm2_5, (uint16_t)(pm2_5 * 16 / 10));
+
+    host->adc_raw[6] = 1200 + jitter(100);
+    host->adc_raw[7] = 900 + jitter(100);
+    host_hal_adc_window(host, 6);
+    host_hal_adc_window(host, 7);
+}
+
+static int parse_options(int argc, char **argv, sim_options_t *opt)
+{
+    int c;
+
+    opt->n_samples = DEFAULT_SAMPLES;
+    opt->quiet = 0;
+    opt->binary = 0;
+    opt->single = 0;
+    opt->scan = 0;
+    opt->seed = 1;
+    opt->csv = NULL;
+    opt->store_dir = NULL;
+    opt->history_tier = -1;
+    opt->log_file = NULL;
+    opt->aqi_scale = -1;
+    opt->start_us = 0;
+
+    while ((c = getopt(argc, argv, "n:qb1gGs:c:S:H:L:A:t:")) != -1) {
+        switch (c) {
+            case 'n':
+                opt->n_samples = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'q':
+                opt->quiet = 1;
+                break;
+            case 'b':
+                opt->binary = 1;
+                break;
+            case '1':
+                opt->single = 1;
+                break;
+            case 'g':
+                opt->scan = BME68X_VARIANT_GAS_HIGH + 1;
+                break;
+            case 'G':
+                opt->scan = BME68X_VARIANT_GAS_LOW + 1;
+                break;
+            case 's':
+                opt->seed = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                opt->csv = optarg;
+                break;
+            case 'S':
+                opt->store_dir = optarg;
+                break;
+            case 'H':
+                for (int t = 0; t < SAMPLE_HISTORY_N_TIERS; t++) {
+                    if (strcmp(optarg, sample_history_tier_names[t]) == 0) {
+                        opt->history_tier = t;
+                    }
+                }
+                if (opt->history_tier < 0) {
+                    fprintf(stderr, "unknown history tier %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'L':
+                opt->log_file = optarg;
+                break;
+            case 'A':
+                for (int s = 0; s < AQI_N_SCALES; s++) {
+                    if (strcmp(optarg, aqi_scale_names[s]) == 0) {
+                        opt->aqi_scale = s;
+                    }
+                }
+                if (opt->aqi_scale < 0) {
+                    fprintf(stderr, "unknown AQI scale %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 't':
+                opt->start_us = (int64_t)(strtod(optarg, NULL) * 3600e6);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-q] [-b] [-1] [-g|-G] [-s seed] [-c conditions.csv] [-S dir] "
+                        "[-H tier] [-L file] [-A scale] [-t hours]\n", argv[0]);
+                return -1;
+        }
+    }
+
+    return (opt->n_samples > 0) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    sim_options_t opt;
+    if (parse_options(argc, argv, &opt) != 0) {
+        return 2;
+    }
+    rng_state = opt.seed;
+
+    static host_hal_t host;
+    static sim_bme680_t bme;
+    static sim_bme680_t exhaust;
+    static sim_dfrobot_t pm;
+    sensor_hal_t hal;
+
+    host_hal_init(&host, &hal);
+    host.now_us = opt.start_us;
+    host_hal_set_store(&host, &hal, opt.store_dir);
+    sim_bme680_init(&bme, &host.now_us);
+    sim_bme680_init(&exhaust, &host.now_us);
+    sim_dfrobot_init(&pm, 0x10);
+    if (opt.scan) {
+        sim_bme680_set_variant(&exhaust, (uint8_t)(opt.scan - 1));
+    }
+    host_hal_attach(&host, BME68X_I2C_ADDR_LOW, sim_bme680_read, sim_bme680_write, &bme);
+    if (!opt.single) {
+        host_hal_attach(&host, BME68X_I2C_ADDR_HIGH, sim_bme680_read, sim_bme680_write, &exhaust);
+    }
+    host_hal_attach(&host, 0x19, sim_dfrobot_read, sim_dfrobot_write, &pm);
+
+    sim_bme680_conditions_t *replay = NULL;
+    if (opt.csv != NULL) {
+        uint32_t n_rows = sim_bme680_load_csv(opt.csv, &replay);
+        if (n_rows == 0) {
+            fprintf(stderr, "no conditions in %s\n", opt.csv);
+            return 1;
+        }
+        sim_bme680_set_replay(&bme, replay, n_rows);
+        sim_bme680_set_replay(&exhaust, replay, n_rows);
+    }
+    update_conditions(0, &opt, &bme, &exhaust, &pm, &host);
+
+    sensor_pipeline_config_t config;
+    sensor_pipeline_default_config(&config);
+    if (opt.scan) {
+        config.n_bme = 1;
+        config.scan_addr = BME68X_I2C_ADDR_HIGH;
+    }
+    if (opt.aqi_scale >= 0) {
+        config.aqi_scale = (uint8_t)opt.aqi_scale;
+    }
+
+    static sensor_pipeline_t pipeline;
+    if (sensor_pipeline_init(&pipeline, &hal, &config) != SENSOR_PIPELINE_OK) {
+        fprintf(stderr, "pipeline init failed\n");
+        return 1;
+    }
+
+    int64_t *cost_ns = malloc(opt.n_samples * sizeof(*cost_ns));
+    if (cost_ns == NULL) {
+        return 1;
+    }
+
+    static sensor_scheduler_t scheduler;
+    sensor_scheduler_init(&scheduler, &pipeline);
+
+    static sample_history_raw_t history_raw[HISTORY_RAW_LEN];
+    static sample_history_point_t history_rollup[SAMPLE_HISTORY_N_TIERS][HISTORY_ROLLUP_LEN];
+    sample_history_storage_t history_storage = { .raw = history_raw, .raw_len = HISTORY_RAW_LEN };
+    static sample_history_t history;
+    int64_t history_ns = 0;
+
+    for (int t = SAMPLE_HISTORY_1M; t < SAMPLE_HISTORY_N_TIERS; t++) {
+        history_storage.rollup[t] = history_rollup[t];
+        history_storage.rollup_len[t] = HISTORY_ROLLUP_LEN;
+    }
+    sample_history_init(&history, &history_storage);
+
+    static sample_log_t sample_log;
+    int have_log = 0;
+    if (opt.log_file != NULL) {
+        if (host_hal_set_log(&host, &hal, opt.log_file, LOG_SIZE) != SENSOR_HAL_OK ||
+            sample_log_init(&sample_log, &hal, LOG_FLUSH_MS) != SAMPLE_LOG_OK) {
+            fprintf(stderr, "cannot open sample log %s\n", opt.log_file);
+            return 1;
+        }
+        have_log = 1;
+    }
+
+    host_hal_stats_t start_stats = host.stats;
+    uint32_t failures = 0;
+    char line[OUTPUT_BUF_LEN];
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    int frame_len = 0;
+
+    for (uint32_t i = 0; i < opt.n_samples; i++) {
+        sensor_sample_t sample;
+
+        update_conditions(i, &opt, &bme, &exhaust, &pm, &host);
+
+        /* The scan sensor is read on its own schedule until the next BSEC cycle */
+        while (sensor_pipeline_scan_next_us(&pipeline) <= scheduler.deadline_us) {
+            heater_scan_vector_t vector;
+            int64_t wait = sensor_pipeline_scan_next_us(&pipeline) - host.now_us;
+
+            if (wait > 0) {
+                host_hal_advance(&host, wait);
+            }
+            if (sensor_pipeline_scan_poll(&pipeline, &vector) != 1 || opt.quiet) {
+                continue;
+            }
+            if (opt.binary) {
+                frame_len = telemetry_encode_scan(&vector, frame, sizeof(frame));
+                fwrite(frame, 1, (size_t)frame_len, stdout);
+            } else {
+                sensor_pipeline_format_scan_json(&vector, line, sizeof(line));
+                printf("%s\n", line);
+            }
+        }
+
+        int64_t t0 = now_ns();
+        int ret = sensor_scheduler_run(&scheduler, &sample);
+        if (ret == SENSOR_PIPELINE_OK && opt.binary) {
+            frame_len = telemetry_encode_sample(&sample, (uint16_t)i, frame, sizeof(frame));
+        } else if (ret == SENSOR_PIPELINE_OK) {
+            sensor_pipeline_format_json(&sample, line, sizeof(line));
+        }
+        cost_ns[i] = now_ns() - t0;
+
+        if (ret == SENSOR_PIPELINE_OK) {
+            t0 = now_ns();
+            sample_history_append(&history, &sample);
+            history_ns += now_ns() - t0;
+            if (have_log) {
+                sample_log_append(&sample_log, &sample);
+            }
+        }
+
+        if (ret != SENSOR_PIPELINE_OK) {
+            failures++;
+        } else if (opt.quiet) {
+            continue;
+        } else if (opt.binary) {
+            fwrite(frame, 1, (size_t)frame_len, stdout);
+        } else {
+            printf("%s\n", line);
+        }
+    }
+
+    qsort(cost_ns, opt.n_samples, sizeof(*cost_ns), cmp_i64);
+
+    int64_t total = 0;
+    for (uint32_t i = 0; i < opt.n_samples; i++) {
+        total += cost_ns[i];
+    }
+
+    uint32_t reads = host.stats.reads - start_stats.reads;
+    uint32_t writes = host.stats.writes - start_stats.writes;
+    uint64_t bytes = host.stats.bytes - start_stats.bytes;
+
+    fprintf(stderr, "samples: %u (failed %u)\n", opt.n_samples, failures);
+    fprintf(stderr, "cpu/sample: mean %lld ns, p50 %lld ns, p99 %lld ns\n",
+            (long long)(total / opt.n_samples),
+            (long long)cost_ns[opt.n_samples / 2],
+            (long long)cost_ns[(opt.n_samples * 99) / 100]);
+    fprintf(stderr, "bus/sample: %.2f reads, %.2f writes, %.1f bytes\n",
+            (double)reads / opt.n_samples, (double)writes / opt.n_samples,
+            (double)bytes / opt.n_samples);
+    fprintf(stderr, "heap/sample: %.1f bytes\n",
+            (double)pipeline.stats.alloc_bytes_total / pipeline.stats.samples);
+
+    const bsec_state_t *intake_state = &pipeline.channels[SENSOR_CHANNEL_INTAKE].bsec_state;
+    if (pipeline.stats.accuracy3_us >= 0) {
+        fprintf(stderr, "iaq accuracy 3 after: %.0f s (%s start)\n",
+                pipeline.stats.accuracy3_us / 1e6, intake_state->restored ? "warm" : "cold");
+    } else {
+        fprintf(stderr, "iaq accuracy 3 after: not reached in %.0f s (%s start)\n",
+                (host.now_us - pipeline.stats.first_sample_us) / 1e6,
+                intake_state->restored ? "warm" : "cold");
+    }
+    for (uint8_t c = 0; c < pipeline.n_channels; c++) {
+        const sensor_channel_t *ch = &pipeline.channels[c];
+        fprintf(stderr, "bme680 0x%02X: iaq %.1f (accuracy %u), bsec state %u saves, %u unchanged, %u failures\n",
+                ch->addr, ch->iaq, ch->iaq_accuracy, (unsigned)ch->bsec_state.stats.saves,
+                (unsigned)ch->bsec_state.stats.unchanged, (unsigned)ch->bsec_state.stats.failures);
+    }
+
+    if (pipeline.scanning) {
+        const heater_scan_stats_t *st = &pipeline.scan.stats;
+        fprintf(stderr, "gas scan 0x%02X (%s): %u passes, %u fields, %u incomplete, %u errors, %.2f s per pass\n",
+                pipeline.scan_channel.addr, (pipeline.scan.op_mode == BME68X_PARALLEL_MODE) ? "parallel" : "forced",
+                (unsigned)st->vectors, (unsigned)st->fields, (unsigned)st->incomplete, (unsigned)st->errors,
+                heater_scan_pass_us(&pipeline.scan) / 1e6);
+    }
+
+    fprintf(stderr, "history: %u bytes, append mean %lld ns, held",
+            (unsigned)sample_history_bytes(&history),
+            (long long)(history.appended ? history_ns / history.appended : 0));
+    for (int t = 0; t < SAMPLE_HISTORY_N_TIERS; t++) {
+        fprintf(stderr, " %s %u/%u", sample_history_tier_names[t], (unsigned)history.tiers[t].count,
+                (unsigned)sample_history_capacity(&history, t));
+    }
+    fprintf(stderr, "\n");
+
+    uint32_t history_entries;
+    uint32_t history_bad = check_history(&history, &history_entries);
+    fprintf(stderr, "history order: %u entries, %u out of order or misaligned\n", (unsigned)history_entries,
+            (unsigned)history_bad);
+
+    if (opt.history_tier >= 0 && opt.binary) {
+        static sample_history_point_t points[HISTORY_RAW_LEN];
+        static sample_history_point_t decoded[TELEMETRY_HISTORY_POINTS_MAX];
+        uint32_t n = sample_history_query(&history, opt.history_tier, 0, INT64_MAX, points, HISTORY_RAW_LEN);
+        uint64_t history_bytes = 0;
+        uint32_t frame_bad = 0;
+        uint32_t sent = 0;
+        uint16_t frame_seq = 0;
+
+        /* Compressed history frames, as the firmware answers in binary mode; it stops at a frame that fails */
+        for (uint32_t i = 0, taken; i < n; i += taken) {
+            sample_history_tier_t tier;
+            uint32_t got;
+            uint16_t seq;
+
+            frame_len = telemetry_encode_history(opt.history_tier, &points[i], n - i, &taken, frame_seq, frame,
+                                                 sizeof(frame));
+            if (frame_len <= 0 || taken == 0) {
+                break;
+            }
+            fwrite(frame, 1, (size_t)frame_len, stdout);
+            history_bytes += (uint64_t)frame_len;
+            sent += taken;
+            frame_seq++;
+
+            /* Back through the decoder, without the delimiters */
+            if (telemetry_decode_history(&frame[1], (size_t)frame_len - 2, &tier, decoded,
+                                         TELEMETRY_HISTORY_POINTS_MAX, &got, &seq) != TELEMETRY_OK ||
+                tier != (sample_history_tier_t)opt.history_tier || got != taken ||
+                seq != (uint16_t)(frame_seq - 1)) {
+                frame_bad += taken;
+                continue;
+            }
+            for (uint32_t j = 0; j < got; j++) {
+                const sample_history_point_t *a = &points[i + j], *b = &decoded[j];
+                int same = (uint32_t)a->timestamp_ms == (uint32_t)b->timestamp_ms &&
+                           (tier == SAMPLE_HISTORY_RAW || a->count == b->count);
+
+                for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+                    same &= a->mean[m] == b->mean[m] &&
+                            (tier == SAMPLE_HISTORY_RAW || (a->min[m] == b->min[m] && a->max[m] == b->max[m]));
+                }
+                frame_bad += !same;
+            }
+        }
+        fprintf(stderr, "history frames: %u of %u entries in %u frames, %.1f bytes/entry, %u not decoded back\n",
+                (unsigned)sent, (unsigned)n, (unsigned)frame_seq, sent ? (double)history_bytes / sent : 0.0,
+                (unsigned)frame_bad);
+        history_bad += frame_bad + (n - sent);
+    } else if (opt.history_tier >= 0) {
+        sample_history_point_t point;
+        int64_t from_ms = 0;
+
+        /* Paged one entry at a time, as a client would */
+        while (sample_history_query(&history, opt.history_tier, from_ms, INT64_MAX, &point, 1) == 1) {
+            sample_history_format_json(opt.history_tier, &point, line, sizeof(line));
+            printf("%s\n", line);
+            from_ms = point.timestamp_ms + 1;
+        }
+    }
+
+    if (have_log) {
+        const sample_log_stats_t *st = &sample_log.stats;
+
+        sample_log_flush(&sample_log);
+        fprintf(stderr, "sample log: %u records (%u recovered), %.1f bytes/record, %.1f flash bytes/record, "
+                "%u flushes, %u erases, %u errors, page seq %u, %u pages\n",
+                (unsigned)st->records, (unsigned)st->recovered,
+                st->records ? (double)st->record_bytes / st->records : 0.0,
+                st->records ? (double)st->flash_bytes / st->records : 0.0,
+                (unsigned)st->flushes, (unsigned)st->erases, (unsigned)st->errors, (unsigned)sample_log.seq,
+                (unsigned)sample_log.n_pages);
+        host_hal_close_log(&host, &hal);
+    }
+
+    sensor_scheduler_log_stats(&scheduler);
+    sensor_pipeline_log_timing(&pipeline);
+
+    free(cost_ns);
+    free(replay);
+    sensor_pipeline_deinit(&pipeline);
+
+    return (failures || history_bad) ? 1 : 0;
+}
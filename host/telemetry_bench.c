@@ -0,0 +1,271 @@
+/*
+ * Compares the two firmware output formats: framed binary telemetry and the
+ * JSON debug lines. Reports bytes and encode time per sample for each, and
+ * checks that every binary frame decodes back to the values the JSON shows.
+ * Samples cycle through the optional blocks (exhaust channel, calibrated
+ * gas sensor voltages, dominant AQI pollutant, rolling AQI and PM
+ * averages with some of them not yet known), so every frame layout is
+ * covered. Heater scan passes of every length get the same treatment.
+ *
+ *   telemetry_bench [-n samples] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sensor_pipeline.h"
+#include "telemetry.h"
+
+#define DEFAULT_SAMPLES     100000
+#define OUTPUT_BUF_LEN      768
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static float uniform(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)(rng_next() & 0xFFFF) / 65535.0f;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static float optional_average(uint32_t i, float lo, float hi)
+{
+    return ((i & 8) && (rng_next() & 1)) ? uniform(lo, hi) : -1.0f;
+}
+
+/* Samples spread over the ranges the firmware reports */
+static void make_sample(uint32_t i, sensor_sample_t *s)
+{
+    s->timestamp_us = (int64_t)i * 3000000;
+    s->temperature = uniform(-20.0f, 60.0f);
+    s->humidity = uniform(0.0f, 100.0f);
+    s->pressure = uniform(850.0f, 1100.0f);
+    s->iaq = uniform(0.0f, 500.0f);
+    s->h2s_raw = (int)(rng_next() % 4096);
+    s->odor_raw = (int)(rng_next() % 4096);
+    s->pm2_5 = (uint16_t)(rng_next() % 500);
+    s->pm1_0 = (uint16_t)(s->pm2_5 * 6 / 10);
+    s->pm10 = (uint16_t)(s->pm2_5 * 16 / 10);
+    s->aqi = uniform(0.0f, 500.0f);
+    s->aqi_level = telemetry_aqi_levels[rng_next() % TELEMETRY_N_AQI_LEVELS];
+    s->aqi_pollutant = (i & 4) ? (uint8_t)(rng_next() % AQI_N_POLLUTANTS) : AQI_N_POLLUTANTS;
+
+    /* Rolling values: none, or each there or not yet */
+    s->aqi_nowcast = optional_average(i, 0.0f, 500.0f);
+    s->aqi_1h = optional_average(i, 0.0f, 500.0f);
+    s->aqi_24h = optional_average(i, 0.0f, 500.0f);
+    for (int p = 0; p < AQI_N_POLLUTANTS; p++) {
+        s->pm_average.nowcast[p] = optional_average(i, 0.0f, 1000.0f);
+        s->pm_average.mean_1h[p] = optional_average(i, 0.0f, 1000.0f);
+        s->pm_average.mean_24h[p] = optional_average(i, 0.0f, 1000.0f);
+    }
+
+    sensor_channel_sample_t *x = &s->channels[SENSOR_CHANNEL_EXHAUST];
+    s->n_channels = (i & 1) ? 2 : 1;
+    x->temperature = uniform(-20.0f, 60.0f);
+    x->humidity = uniform(0.0f, 100.0f);
+    x->pressure = uniform(850.0f, 1100.0f);
+    x->iaq = uniform(0.0f, 500.0f);
+
+    s->h2s_mv = (i & 2) ? (int)(rng_next() % 3300) : -1;
+    s->odor_mv = (i & 2) ? (int)(rng_next() % 3300) : -1;
+    s->h2s_noise_mv = uniform(0.0f, 20.0f);
+    s->odor_noise_mv = uniform(0.0f, 20.0f);
+}
+
+/* True when both values print the same at `decimals` (-0.00 equals 0.00) */
+static int same_printed(float a, float b, int decimals)
+{
+    char x[32], y[32];
+    snprintf(x, sizeof(x), "%.*f", decimals, a);
+    snprintf(y, sizeof(y), "%.*f", decimals, b);
+    return strtod(x, NULL) == strtod(y, NULL);
+}
+
+/* Heater scan passes of every length over the same ranges */
+static void make_scan(uint32_t i, heater_scan_vector_t *v)
+{
+    v->timestamp_us = (int64_t)i * 140000;
+    v->seq = i & 0xFFFF;
+    v->temperature = uniform(-20.0f, 60.0f);
+    v->humidity = uniform(0.0f, 100.0f);
+    v->pressure = uniform(850.0f, 1100.0f);
+    v->n_steps = (uint8_t)(1 + i % HEATER_SCAN_MAX_STEPS);
+    v->stable_mask = (uint16_t)(rng_next() & ((1u << v->n_steps) - 1));
+    for (uint8_t k = 0; k < v->n_steps; k++) {
+        v->gas_ohm[k] = (float)(rng_next() % 5000000);
+    }
+}
+
+/* The decoded pass must carry the values its JSON line shows */
+static int check_scan_round_trip(const heater_scan_vector_t *v, const uint8_t *frame, int len)
+{
+    heater_scan_vector_t d;
+
+    if (telemetry_decode_scan(&frame[1], (size_t)len - 2, &d) != TELEMETRY_OK) {
+        return -1;
+    }
+
+    int same = d.seq == v->seq && d.timestamp_us == v->timestamp_us &&
+               same_printed(d.temperature, v->temperature, 2) &&
+               same_printed(d.humidity, v->humidity, 2) &&
+               same_printed(d.pressure, v->pressure, 2) &&
+               d.stable_mask == v->stable_mask && d.n_steps == v->n_steps;
+
+    for (uint8_t k = 0; same && k < v->n_steps; k++) {
+        same = same_printed(d.gas_ohm[k], v->gas_ohm[k], 0);
+    }
+    return same ? 0 : -1;
+}
+
+/* The decoded sample must carry the values the JSON line shows */
+static int check_round_trip(const sensor_sample_t *s, const uint8_t *frame, int len, uint16_t seq)
+{
+    sensor_sample_t d;
+    uint16_t decoded_seq;
+
+    if (frame[0] != 0 || frame[len - 1] != 0 || memchr(&frame[1], 0, (size_t)len - 2) != NULL) {
+        return -1;
+    }
+    if (telemetry_decode_sample(&frame[1], (size_t)len - 2, &d, &decoded_seq) != TELEMETRY_OK) {
+        return -1;
+    }
+
+    int same = decoded_seq == seq && d.timestamp_us == s->timestamp_us &&
+               same_printed(d.temperature, s->temperature, 2) &&
+               same_printed(d.humidity, s->humidity, 2) &&
+               same_printed(d.pressure, s->pressure, 2) &&
+               same_printed(d.iaq, s->iaq, 1) &&
+               same_printed(d.aqi, s->aqi, 1) &&
+               d.h2s_raw == s->h2s_raw && d.odor_raw == s->odor_raw &&
+               d.pm1_0 == s->pm1_0 && d.pm2_5 == s->pm2_5 && d.pm10 == s->pm10 &&
+               strcmp(d.aqi_level, s->aqi_level) == 0 && d.aqi_pollutant == s->aqi_pollutant &&
+               d.n_channels == s->n_channels;
+
+    if (same && s->n_channels > SENSOR_CHANNEL_EXHAUST) {
+        const sensor_channel_sample_t *x = &s->channels[SENSOR_CHANNEL_EXHAUST];
+        const sensor_channel_sample_t *y = &d.channels[SENSOR_CHANNEL_EXHAUST];
+
+        same = same_printed(y->temperature, x->temperature, 2) &&
+               same_printed(y->humidity, x->humidity, 2) &&
+               same_printed(y->pressure, x->pressure, 2) &&
+               same_printed(y->iaq, x->iaq, 1);
+    }
+    if (same) {
+        same = same_printed(d.aqi_nowcast, s->aqi_nowcast, 1) && same_printed(d.aqi_1h, s->aqi_1h, 1) &&
+               same_printed(d.aqi_24h, s->aqi_24h, 1);
+        for (int p = 0; same && p < AQI_N_POLLUTANTS; p++) {
+            same = same_printed(d.pm_average.nowcast[p], s->pm_average.nowcast[p], 1) &&
+                   same_printed(d.pm_average.mean_1h[p], s->pm_average.mean_1h[p], 1) &&
+                   same_printed(d.pm_average.mean_24h[p], s->pm_average.mean_24h[p], 1);
+        }
+    }
+    if (same) {
+        same = d.h2s_mv == s->h2s_mv && d.odor_mv == s->odor_mv;
+    }
+    if (same && s->h2s_mv >= 0) {
+        same = same_printed(d.h2s_noise_mv, s->h2s_noise_mv, 2) &&
+               same_printed(d.odor_noise_mv, s->odor_noise_mv, 2);
+    }
+    return same ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n_samples = DEFAULT_SAMPLES;
+    uint32_t seed = 1;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:")) != -1) {
+        switch (c) {
+            case 'n':
+                n_samples = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n_samples == 0) {
+        return 2;
+    }
+    rng_state = seed;
+
+    sensor_sample_t *samples = malloc(n_samples * sizeof(*samples));
+    if (samples == NULL) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n_samples; i++) {
+        make_sample(i, &samples[i]);
+    }
+
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    char line[OUTPUT_BUF_LEN];
+    uint64_t binary_bytes = 0, json_bytes = 0;
+    uint32_t mismatches = 0;
+
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < n_samples; i++) {
+        binary_bytes += (uint64_t)telemetry_encode_sample(&samples[i], (uint16_t)i, frame, sizeof(frame));
+    }
+    int64_t binary_ns = now_ns() - t0;
+
+    t0 = now_ns();
+    for (uint32_t i = 0; i < n_samples; i++) {
+        /* + newline, as written by the firmware */
+        json_bytes += (uint64_t)sensor_pipeline_format_json(&samples[i], line, sizeof(line)) + 1;
+    }
+    int64_t json_ns = now_ns() - t0;
+
+    for (uint32_t i = 0; i < n_samples; i++) {
+        int len = telemetry_encode_sample(&samples[i], (uint16_t)i, frame, sizeof(frame));
+        if (len <= 0 || check_round_trip(&samples[i], frame, len, (uint16_t)i) != 0) {
+            mismatches++;
+        }
+    }
+
+    uint64_t scan_binary_bytes = 0, scan_json_bytes = 0;
+    uint32_t scan_mismatches = 0;
+    for (uint32_t i = 0; i < n_samples; i++) {
+        heater_scan_vector_t v;
+
+        make_scan(i, &v);
+        int len = telemetry_encode_scan(&v, frame, sizeof(frame));
+        scan_binary_bytes += (uint64_t)(len > 0 ? len : 0);
+        scan_json_bytes += (uint64_t)sensor_pipeline_format_scan_json(&v, line, sizeof(line)) + 1;
+        if (len <= 0 || check_scan_round_trip(&v, frame, len) != 0) {
+            scan_mismatches++;
+        }
+    }
+
+    printf("samples: %u, round-trip mismatches: %u\n", n_samples, mismatches);
+    printf("binary: %.1f bytes/sample, %.1f ns/sample\n",
+           (double)binary_bytes / n_samples, (double)binary_ns / n_samples);
+    printf("json:   %.1f bytes/sample, %.1f ns/sample\n",
+           (double)json_bytes / n_samples, (double)json_ns / n_samples);
+    printf("at 115200 baud: binary %.2f ms/sample, json %.2f ms/sample\n",
+           (double)binary_bytes / n_samples * 10.0 / 115.2, (double)json_bytes / n_samples * 10.0 / 115.2);
+
+    printf("gas scans: %u, round-trip mismatches: %u, binary %.1f bytes/scan, json %.1f bytes/scan\n",
+           n_samples, scan_mismatches, (double)scan_binary_bytes / n_samples, (double)scan_json_bytes / n_samples);
+
+    free(samples);
+    return (mismatches || scan_mismatches) ? 1 : 0;
+}
@@ -4,33 +4,26 @@
 
 static const char *TAG = "DFRobot_AQS";
 
-#define SENSOR_VERSION_REG      0x00
-#define PM1_0_ATMOS_REG         0x03
-#define PM2_5_ATMOS_REG         0x04
-#define PM10_ATMOS_REG          0x05
+/* Register map from the SEN0460 datasheet; each value is a big-endian word */
+#define PM1_0_STANDARD_REG      0x05
+#define PM1_0_ATMOS_REG         0x0B
+#define PM2_5_ATMOS_REG         0x0D
+#define PM10_ATMOS_REG          0x0F
+#define PARTICLE_COUNT_REG      0x11
+#define SENSOR_VERSION_REG      0x1D
+
+/* Standard PM, atmospheric PM and particle counts are contiguous */
+#define MEASUREMENT_BLOCK_LEN   (SENSOR_VERSION_REG - PM1_0_STANDARD_REG)
 
 static int8_t i2c_read_bytes(DFRobot_AirQualitySensor* sensor, uint8_t reg, uint8_t* data, uint32_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (sensor->i2c_addr << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (sensor->i2c_addr << 1) | I2C_MASTER_READ, true);
-    
-    if (len > 1)
-        i2c_master_read(cmd, data, len - 1, I2C_MASTER_ACK);
-    
-    i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    
-    esp_err_t ret = i2c_master_cmd_begin(sensor->i2c_port, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    
-    return (ret == ESP_OK) ? 0 : -1;
+    const sensor_hal_t *hal = sensor->bus.hal;
+    int ret = hal->bus_read(hal->ctx, sensor->bus.addr, reg, data, len);
+
+    return (ret == SENSOR_HAL_OK) ? 0 : -1;
 }
 
-DFRobot_AirQualitySensor* dfrobot_create(i2c_port_t port, uint8_t addr)
+DFRobot_AirQualitySensor* dfrobot_create(const sensor_hal_t *hal, uint8_t addr)
 {
     DFRobot_AirQualitySensor* sensor = (DFRobot_AirQualitySensor*)malloc(sizeof(DFRobot_AirQualitySensor));
     if (sensor == NULL) {
@@ -38,8 +31,8 @@ DFRobot_AirQualitySensor* dfrobot_create(i2c_port_t port, uint8_t addr)
         return NULL;
     }
     
-    sensor->i2c_port = port;
-    sensor->i2c_addr = addr;
+    sensor->bus.hal = hal;
+    sensor->bus.addr = addr;
     
     return sensor;
 }
@@ -48,7 +41,7 @@ int dfrobot_begin(DFRobot_AirQualitySensor* sensor)
 {
     uint8_t version = 0;
     if (i2c_read_bytes(sensor, SENSOR_VERSION_REG, &version, 1) != 0) {
-        ESP_LOGE(TAG, "Sensor not found at address 0x%02X", sensor->i2c_addr);
+        ESP_LOGE(TAG, "Sensor not found at address 0x%02X", sensor->bus.addr);
         return 0;
     }
     
@@ -77,6 +70,32 @@ uint16_t dfrobot_gainParticleConcentration_ugm3(DFRobot_AirQualitySensor* sensor
     return value;
 }
 
+static uint16_t be16(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+int dfrobot_read_all(DFRobot_AirQualitySensor* sensor, DFRobot_AirQualityData* data)
+{
+    uint8_t block[MEASUREMENT_BLOCK_LEN];
+    if (i2c_read_bytes(sensor, PM1_0_STANDARD_REG, block, sizeof(block)) != 0) {
+        ESP_LOGE(TAG, "Failed to read measurement block");
+        return 0;
+    }
+
+    data->pm1_0_standard = be16(&block[0]);
+    data->pm2_5_standard = be16(&block[2]);
+    data->pm10_standard = be16(&block[4]);
+    data->pm1_0_atmosphere = be16(&block[PM1_0_ATMOS_REG - PM1_0_STANDARD_REG]);
+    data->pm2_5_atmosphere = be16(&block[PM2_5_ATMOS_REG - PM1_0_STANDARD_REG]);
+    data->pm10_atmosphere = be16(&block[PM10_ATMOS_REG - PM1_0_STANDARD_REG]);
+    for (int i = 0; i < PARTICLE_N_COUNTS; i++) {
+        data->counts[i] = be16(&block[PARTICLE_COUNT_REG - PM1_0_STANDARD_REG + 2 * i]);
+    }
+
+    return 1;
+}
+
 uint8_t dfrobot_gainVersion(DFRobot_AirQualitySensor* sensor)
 {
     uint8_t version = 0;
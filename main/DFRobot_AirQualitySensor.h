@@ -2,21 +2,34 @@
 #define DFROBOT_AirQualitySensor_H
 
 #include <stdint.h>
-#include "driver/i2c.h"
+#include "sensor_hal.h"
 
 #define PARTICLE_PM1_0_ATMOSPHERE 3
 #define PARTICLE_PM2_5_ATMOSPHERE 4
 #define PARTICLE_PM10_ATMOSPHERE  5
 
 typedef struct {
-    i2c_port_t i2c_port;
-    uint8_t i2c_addr;
+    sensor_hal_dev_t bus;
 } DFRobot_AirQualitySensor;
 
+#define PARTICLE_N_COUNTS 6
+
+/* One coherent snapshot of the measurement registers */
+typedef struct {
+    uint16_t pm1_0_standard;    // ug/m3, standard particle
+    uint16_t pm2_5_standard;
+    uint16_t pm10_standard;
+    uint16_t pm1_0_atmosphere;  // ug/m3, atmospheric environment
+    uint16_t pm2_5_atmosphere;
+    uint16_t pm10_atmosphere;
+    uint16_t counts[PARTICLE_N_COUNTS]; // per 0.1 L: >0.3, >0.5, >1.0, >2.5, >5.0, >10 um
+} DFRobot_AirQualityData;
+
 // Function declarations
-DFRobot_AirQualitySensor* dfrobot_create(i2c_port_t port, uint8_t addr);
+DFRobot_AirQualitySensor* dfrobot_create(const sensor_hal_t *hal, uint8_t addr);
 int dfrobot_begin(DFRobot_AirQualitySensor* sensor);
 uint16_t dfrobot_gainParticleConcentration_ugm3(DFRobot_AirQualitySensor* sensor, uint8_t type);
+int dfrobot_read_all(DFRobot_AirQualitySensor* sensor, DFRobot_AirQualityData* data);
 uint8_t dfrobot_gainVersion(DFRobot_AirQualitySensor* sensor);
 void dfrobot_delete(DFRobot_AirQualitySensor* sensor);
 
@@ -0,0 +1,53 @@
+#include <string.h>
+
+#include "adc_filter.h"
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+    if (a > b) {
+        uint16_t t = a;
+        a = b;
+        b = t;
+    }
+    /* a <= b */
+    if (c <= a) {
+        return a;
+    }
+    return (c < b) ? c : b;
+}
+
+void adc_filter_init(adc_filter_t *f, uint32_t decimation)
+{
+    memset(f, 0, sizeof(*f));
+    f->decimation = (decimation > 0) ? decimation : 1;
+}
+
+int adc_filter_push(adc_filter_t *f, uint16_t raw)
+{
+    /* The first two inputs pass through until there is a full median window */
+    uint16_t m = (f->n_prev < 2) ? raw : median3(f->prev[0], f->prev[1], raw);
+
+    f->prev[0] = f->prev[1];
+    f->prev[1] = raw;
+    if (f->n_prev < 2) {
+        f->n_prev++;
+    }
+
+    f->sum += m;
+    f->sum_sq += (uint64_t)m * m;
+    if (++f->n < f->decimation) {
+        return 0;
+    }
+
+    double mean = (double)f->sum / f->n;
+    double var = (double)f->sum_sq / f->n - mean * mean;
+
+    f->value = (float)mean;
+    f->variance = (var > 0.0) ? (float)var : 0.0f;
+    f->outputs++;
+    f->n = 0;
+    f->sum = 0;
+    f->sum_sq = 0;
+
+    return 1;
+}
@@ -0,0 +1,37 @@
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#include <stdint.h>
+
+/*
+ * Decimating filter for one slowly varying ADC channel (the H2S and odor
+ * sensor outputs).
+ *
+ * Each input goes through a median of three, which removes single-sample
+ * spikes, and then a boxcar FIR that averages `decimation` medians into one
+ * output. The boxcar has nulls at multiples of rate/decimation, so a window
+ * of a whole number of mains periods also rejects 50/60 Hz pickup. With each
+ * output the variance of the medians in its window is kept as a noise figure.
+ *
+ * Push and read run in different tasks on the ESP32; callers serialize them.
+ */
+
+typedef struct {
+    uint32_t decimation;
+    uint32_t n;             /* medians in the current window */
+    uint16_t prev[2];       /* last two inputs, for the median */
+    uint8_t n_prev;
+    uint64_t sum;
+    uint64_t sum_sq;
+
+    float value;            /* mean of the last complete window, ADC codes */
+    float variance;         /* of the medians in that window, codes^2 */
+    uint32_t outputs;
+} adc_filter_t;
+
+void adc_filter_init(adc_filter_t *f, uint32_t decimation);
+
+/* Feed one ADC code; returns 1 when it completed a window and updated value/variance */
+int adc_filter_push(adc_filter_t *f, uint16_t raw);
+
+#endif
@@ -0,0 +1,245 @@
+#include <stddef.h>
+
+#include "aqi.h"
+
+typedef struct {
+    float c_lo;             /* ug/m3 at the bottom of the segment */
+    float c_hi;             /* above it the next segment applies */
+    float i_lo;             /* index at c_lo */
+    float slope;            /* index per ug/m3 */
+    uint8_t level;
+} aqi_segment_t;
+
+typedef struct {
+    const aqi_segment_t *seg;
+    uint8_t n;              /* 0: the scale does not use the pollutant */
+    float per_unit;         /* concentrations are truncated to 1 / per_unit first; 0 keeps them */
+} aqi_table_t;
+
+typedef struct {
+    aqi_table_t table[AQI_N_POLLUTANTS];
+    const char *const *levels;
+    uint8_t n_levels;
+} aqi_scale_def_t;
+
+/* Index range [i_lo, i_hi] over [c_lo, c_hi], the slope folded by the compiler */
+#define SEG(c_lo, c_hi, i_lo, i_hi, level) \
+    { (float)(c_lo), (float)(c_hi), (float)(i_lo), (float)(((i_hi) - (i_lo)) / ((c_hi) - (c_lo))), (level) }
+
+#define TABLE(seg, per_unit) { (seg), (uint8_t)(sizeof(seg) / sizeof((seg)[0])), (per_unit) }
+#define LEVELS(names) (names), (uint8_t)(sizeof(names) / sizeof((names)[0]))
+
+const char *const aqi_scale_names[AQI_N_SCALES] = {
+    "epa", "epa2012", "legacy", "caqi", "naqi",
+};
+
+const char *const aqi_pollutant_names[AQI_N_POLLUTANTS] = {
+    "pm2_5", "pm10",
+};
+
+static const char *const unknown_level = "Unknown";
+
+/* ===== US EPA ===== */
+static const char *const epa_levels[] = {
+    "Good",
+    "Moderate",
+    "Unhealthy for Sensitive Groups",
+    "Unhealthy",
+    "Very Unhealthy",
+    "Hazardous",
+};
+
+/* 2024 revision: Good ends at 9.0, one Hazardous segment */
+static const aqi_segment_t epa_pm2_5[] = {
+    SEG(0.0, 9.0, 0.0, 50.0, 0),
+    SEG(9.1, 35.4, 51.0, 100.0, 1),
+    SEG(35.5, 55.4, 101.0, 150.0, 2),
+    SEG(55.5, 125.4, 151.0, 200.0, 3),
+    SEG(125.5, 225.4, 201.0, 300.0, 4),
+    SEG(225.5, 325.4, 301.0, 500.0, 5),
+};
+
+static const aqi_segment_t epa_pm10[] = {
+    SEG(0.0, 54.0, 0.0, 50.0, 0),
+    SEG(55.0, 154.0, 51.0, 100.0, 1),
+    SEG(155.0, 254.0, 101.0, 150.0, 2),
+    SEG(255.0, 354.0, 151.0, 200.0, 3),
+    SEG(355.0, 424.0, 201.0, 300.0, 4),
+    SEG(425.0, 604.0, 301.0, 500.0, 5),
+};
+
+static const aqi_segment_t epa_2012_pm2_5[] = {
+    SEG(0.0, 12.0, 0.0, 50.0, 0),
+    SEG(12.1, 35.4, 51.0, 100.0, 1),
+    SEG(35.5, 55.4, 101.0, 150.0, 2),
+    SEG(55.5, 150.4, 151.0, 200.0, 3),
+    SEG(150.5, 250.4, 201.0, 300.0, 4),
+    SEG(250.5, 350.4, 301.0, 400.0, 5),
+    SEG(350.5, 500.4, 401.0, 500.0, 5),
+};
+
+static const aqi_segment_t epa_2012_pm10[] = {
+    SEG(0.0, 54.0, 0.0, 50.0, 0),
+    SEG(55.0, 154.0, 51.0, 100.0, 1),
+    SEG(155.0, 254.0, 101.0, 150.0, 2),
+    SEG(255.0, 354.0, 151.0, 200.0, 3),
+    SEG(355.0, 424.0, 201.0, 300.0, 4),
+    SEG(425.0, 504.0, 301.0, 400.0, 5),
+    SEG(505.0, 604.0, 401.0, 500.0, 5),
+};
+
+/* Each segment starts where the last one ended; flat at 300 above 250.4 */
+static const aqi_segment_t legacy_pm2_5[] = {
+    SEG(0.0, 12.0, 0.0, 50.0, 0),
+    SEG(12.0, 35.4, 50.0, 100.0, 1),
+    SEG(35.4, 55.4, 100.0, 150.0, 2),
+    SEG(55.4, 150.4, 150.0, 200.0, 3),
+    SEG(150.4, 250.4, 200.0, 300.0, 4),
+    SEG(250.4, 500.4, 300.0, 300.0, 5),
+};
+
+/* ===== EU CAQI ===== */
+static const char *const caqi_levels[] = {
+    "Very Low",
+    "Low",
+    "Medium",
+    "High",
+    "Very High",
+};
+
+/* Very High is open ended (> 100); it carries on at the High slope */
+static const aqi_segment_t caqi_pm2_5[] = {
+    SEG(0.0, 15.0, 0.0, 25.0, 0),
+    SEG(15.0, 30.0, 25.0, 50.0, 1),
+    SEG(30.0, 55.0, 50.0, 75.0, 2),
+    SEG(55.0, 110.0, 75.0, 100.0, 3),
+    SEG(110.0, 165.0, 100.0, 125.0, 4),
+};
+
+static const aqi_segment_t caqi_pm10[] = {
+    SEG(0.0, 25.0, 0.0, 25.0, 0),
+    SEG(25.0, 50.0, 25.0, 50.0, 1),
+    SEG(50.0, 90.0, 50.0, 75.0, 2),
+    SEG(90.0, 180.0, 75.0, 100.0, 3),
+    SEG(180.0, 270.0, 100.0, 125.0, 4),
+};
+
+/* ===== INDIA NAQI ===== */
+static const char *const naqi_levels[] = {
+    "Good",
+    "Satisfactory",
+    "Moderately Polluted",
+    "Poor",
+    "Very Poor",
+    "Severe",
+};
+
+/* Severe is open ended; closed at 380 and 510 here so the index keeps rising to 500 */
+static const aqi_segment_t naqi_pm2_5[] = {
+    SEG(0.0, 30.0, 0.0, 50.0, 0),
+    SEG(31.0, 60.0, 51.0, 100.0, 1),
+    SEG(61.0, 90.0, 101.0, 200.0, 2),
+    SEG(91.0, 120.0, 201.0, 300.0, 3),
+    SEG(121.0, 250.0, 301.0, 400.0, 4),
+    SEG(251.0, 380.0, 401.0, 500.0, 5),
+};
+
+static const aqi_segment_t naqi_pm10[] = {
+    SEG(0.0, 50.0, 0.0, 50.0, 0),
+    SEG(51.0, 100.0, 51.0, 100.0, 1),
+    SEG(101.0, 250.0, 101.0, 200.0, 2),
+    SEG(251.0, 350.0, 201.0, 300.0, 3),
+    SEG(351.0, 430.0, 301.0, 400.0, 4),
+    SEG(431.0, 510.0, 401.0, 500.0, 5),
+};
+
+/* ===== SCALES ===== */
+/* EPA truncates PM2.5 to 0.1 and PM10 to whole ug/m3, NAQI both to whole ug/m3 */
+static const aqi_scale_def_t scales[AQI_N_SCALES] = {
+    [AQI_SCALE_EPA] = {
+        { TABLE(epa_pm2_5, 10.0f), TABLE(epa_pm10, 1.0f) }, LEVELS(epa_levels),
+    },
+    [AQI_SCALE_EPA_2012] = {
+        { TABLE(epa_2012_pm2_5, 10.0f), TABLE(epa_2012_pm10, 1.0f) }, LEVELS(epa_levels),
+    },
+    [AQI_SCALE_LEGACY] = {
+        { TABLE(legacy_pm2_5, 0.0f), { NULL, 0, 0.0f } }, LEVELS(epa_levels),
+    },
+    [AQI_SCALE_CAQI] = {
+        { TABLE(caqi_pm2_5, 0.0f), TABLE(caqi_pm10, 0.0f) }, LEVELS(caqi_levels),
+    },
+    [AQI_SCALE_NAQI] = {
+        { TABLE(naqi_pm2_5, 1.0f), TABLE(naqi_pm10, 1.0f) }, LEVELS(naqi_levels),
+    },
+};
+
+/* ===== LOOKUP ===== */
+static float table_index(const aqi_table_t *t, float c, uint8_t *level)
+{
+    if (t->per_unit > 0.0f) {
+        /* c >= 0, so the conversion truncates; the margin keeps 35.4 from becoming 35.3 */
+        c = (float)(int32_t)(c * t->per_unit + 1e-3f) / t->per_unit;
+    }
+
+    /* Segments are in order, so the count of tops below c is its segment */
+    uint32_t k = 0;
+    for (uint32_t i = 0; i + 1 < t->n; i++) {
+        k += (c > t->seg[i].c_hi);
+    }
+
+    const aqi_segment_t *s = &t->seg[k];
+    *level = s->level;
+    return s->i_lo + (c - s->c_lo) * s->slope;
+}
+
+const char *const *aqi_scale_levels(uint8_t scale, uint8_t *n)
+{
+    if (scale >= AQI_N_SCALES) {
+        *n = 0;
+        return NULL;
+    }
+    *n = scales[scale].n_levels;
+    return scales[scale].levels;
+}
+
+float aqi_sub_index(uint8_t scale, uint8_t pollutant, float c, uint8_t *level)
+{
+    if (scale >= AQI_N_SCALES || pollutant >= AQI_N_POLLUTANTS || !(c >= 0.0f)) {
+        return -1.0f;
+    }
+
+    const aqi_table_t *t = &scales[scale].table[pollutant];
+    if (t->n == 0) {
+        return -1.0f;
+    }
+    return table_index(t, c, level);
+}
+
+void aqi_compute(uint8_t scale, const float c[AQI_N_POLLUTANTS], aqi_result_t *r)
+{
+    float best = -1.0f;
+    uint8_t dominant = AQI_N_POLLUTANTS;
+    uint8_t level = 0;
+
+    /* Selects rather than branches: which pollutant dominates is a coin toss
+     * in mixed dust. Ties go to the first one, PM2.5 */
+    for (uint8_t p = 0; p < AQI_N_POLLUTANTS; p++) {
+        uint8_t l = 0;
+        float sub = aqi_sub_index(scale, p, c[p], &l);
+        int higher = sub > best;
+
+        r->sub_index[p] = sub;
+        best = higher ? sub : best;
+        dominant = higher ? p : dominant;
+        level = higher ? l : level;
+    }
+
+    r->dominant = dominant;
+    if (dominant < AQI_N_POLLUTANTS) {
+        r->index = best;
+        r->level = scales[scale].levels[level];
+    } else {
+        r->index = 0.0f;
+        r->level = unknown_level;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef AQI_H
+#define AQI_H
+
+#include <stdint.h>
+
+/*
+ * Table driven air quality index over the PM readings.
+ *
+ * Each scale has a breakpoint table per pollutant: concentration segments,
+ * each mapped linearly onto an index range and a level. A concentration
+ * picks its segment by counting the segment tops below it, with no branch
+ * per segment, and the index is one multiply-add from there. The tables are
+ * const initializers with the slopes folded at compile time, so they stay
+ * in flash.
+ *
+ * The index of a scale is the highest of its pollutant sub-indices, and
+ * that pollutant is reported as the dominant one.
+ *
+ *   AQI_SCALE_EPA       US EPA, PM2.5 breakpoints of the 2024 revision, PM10
+ *   AQI_SCALE_EPA_2012  US EPA before 2024
+ *   AQI_SCALE_LEGACY    the original firmware ladder: PM2.5 only, the 2012
+ *                       breakpoints joined without the 0.1 gaps, 300 above
+ *                       250.4
+ *   AQI_SCALE_CAQI      European CAQI, hourly background grid
+ *   AQI_SCALE_NAQI      India National AQI
+ *
+ * The published indices are defined on averages (24 h for EPA and NAQI, 1 h
+ * for CAQI); fed with the instantaneous readings they give the same scale
+ * for the current air, and pm_average.h keeps the averages themselves.
+ * Above the top of a table, the top segment's slope carries on rather than
+ * saturating.
+ */
+
+#define AQI_SCALE_EPA           0
+#define AQI_SCALE_EPA_2012      1
+#define AQI_SCALE_LEGACY        2
+#define AQI_SCALE_CAQI          3
+#define AQI_SCALE_NAQI          4
+#define AQI_N_SCALES            5
+
+#define AQI_POLLUTANT_PM2_5     0
+#define AQI_POLLUTANT_PM10      1
+#define AQI_N_POLLUTANTS        2   /* also "none" for the dominant pollutant */
+
+/* Most segments in one breakpoint table */
+#define AQI_SEGMENTS_MAX        8
+
+/* Short names ("epa", "caqi", ...) */
+extern const char *const aqi_scale_names[AQI_N_SCALES];
+
+/* JSON keys of the readings ("pm2_5", "pm10") */
+extern const char *const aqi_pollutant_names[AQI_N_POLLUTANTS];
+
+typedef struct {
+    float index;
+    const char *level;      /* the scale's level name, "Unknown" without readings */
+    uint8_t dominant;       /* AQI_POLLUTANT_*, AQI_N_POLLUTANTS without readings */
+    float sub_index[AQI_N_POLLUTANTS];      /* -1 for pollutants not taken into account */
+} aqi_result_t;
+
+/* Level names of a scale, best first; sets *n */
+const char *const *aqi_scale_levels(uint8_t scale, uint8_t *n);
+
+/*
+ * Sub-index of one pollutant at concentration `c` (ug/m3) and its level
+ * (index into aqi_scale_levels()); -1 if the scale does not use the
+ * pollutant or c is negative or NaN
+ */
+float aqi_sub_index(uint8_t scale, uint8_t pollutant, float c, uint8_t *level);
+
+/*
+ * Index of `scale` over the concentrations `c`, indexed by AQI_POLLUTANT_*;
+ * a negative concentration means no reading of that pollutant
+ */
+void aqi_compute(uint8_t scale, const float c[AQI_N_POLLUTANTS], aqi_result_t *r);
+
+#endif
@@ -1,181 +1,341 @@
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
+#include "esp_attr.h"
 #include "esp_log.h"
-#include "driver/i2c.h"
-#include "esp_adc/adc_oneshot.h"
-#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "driver/uart.h"
+#include "driver/uart_vfs.h"
 
-#include "bme68x.h"
-#include "bme68x_defs.h"
+#include "sample_history.h"
+#include "sample_log.h"
+#include "sensor_hal.h"
+#include "sensor_hal_esp32.h"
+#include "sensor_pipeline.h"
+#include "sensor_scheduler.h"
+#include "sensor_tasks.h"
+#include "telemetry.h"
 
-#include "bsec_interface.h"
-#include "bsec_datatypes.h"
+#define OUTPUT_BUF_LEN       768
+#define STATS_EVERY_SAMPLES  100
 
-#include "DFRobot_AirQualitySensor.h"
+#if CONFIG_AIR_QUALITY_TELEMETRY_JSON
+#define BINARY_OUTPUT        0
+#else
+#define BINARY_OUTPUT        1
+#endif
 
-/* I2C CONFIG */
-#define I2C_MASTER_NUM       I2C_NUM_0
-#define I2C_MASTER_SDA_IO    21
-#define I2C_MASTER_SCL_IO    22
-#define I2C_MASTER_FREQ_HZ   400000
-
-#define BME68X_I2C_ADDR      BME68X_I2C_ADDR_LOW  // 0x76
-#define PM_SENSOR_I2C_ADDR   0x19
-
-/* SENSOR PINS */
-#define H2S_SENSOR_PIN       34
-#define ODOR_SENSOR_PIN      35
+#define COMMAND_STACK_SIZE   4096
+#define COMMAND_PRIORITY     2
+#define COMMAND_CORE         0
+#define COMMAND_LINE_LEN     64
+#define HISTORY_CHUNK        32     /* entries copied per hold of the history lock */
 
 static const char *TAG = "AIR_QUALITY";
 
 /* GLOBAL STATE */
-static struct bme68x_dev bme_dev;
-static uint8_t bme_addr = BME68X_I2C_ADDR;
-static adc_oneshot_unit_handle_t adc_handle = NULL;
-static DFRobot_AirQualitySensor* pm_sensor = NULL;
-
-/* SENSOR VALUES */
-static float temperature = 0;
-static float humidity = 0;
-static float pressure = 0;
-static float iaq = 0;
-static int h2s_raw = 0;
-static int odor_raw = 0;
-static uint16_t pm1_0 = 0;
-static uint16_t pm2_5 = 0;
-static uint16_t pm10 = 0;
-static float aqi = 0;
-static char aqi_level[32] = "Unknown";
-
-/* ===== I2C FUNCTIONS ===== */
-static int8_t i2c_read(uint8_t reg, uint8_t *data, uint32_t len, void *intf_ptr)
+static sensor_hal_t hal;
+static sensor_pipeline_t pipeline;
+static sensor_scheduler_t scheduler;
+
+/* Sample history, in PSRAM when the build allows .bss there */
+static EXT_RAM_BSS_ATTR sample_history_raw_t history_raw[CONFIG_AIR_QUALITY_HISTORY_RAW_LEN];
+static EXT_RAM_BSS_ATTR sample_history_point_t history_1m[CONFIG_AIR_QUALITY_HISTORY_1M_LEN];
+static EXT_RAM_BSS_ATTR sample_history_point_t history_15m[CONFIG_AIR_QUALITY_HISTORY_15M_LEN];
+static EXT_RAM_BSS_ATTR sample_history_point_t history_1h[CONFIG_AIR_QUALITY_HISTORY_1H_LEN];
+static sample_history_t history;
+static SemaphoreHandle_t history_lock;
+static StaticSemaphore_t history_lock_buf;
+
+/* Flash sample log, when the partition table has its partition */
+static sample_log_t sample_log;
+static bool have_log;
+static SemaphoreHandle_t log_lock;
+static StaticSemaphore_t log_lock_buf;
+
+static StaticTask_t command_tcb;
+static StackType_t command_stack[COMMAND_STACK_SIZE];
+
+/* ===== DELAY INSTRUMENTATION ===== */
+static void log_delay_stats(void)
 {
-    uint8_t dev_addr = *(uint8_t *)intf_ptr;
-    
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (dev_addr << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (dev_addr << 1) | I2C_MASTER_READ, true);
-    
-    if (len > 1)
-        i2c_master_read(cmd, data, len - 1, I2C_MASTER_ACK);
-    
-    i2c_master_read_byte(cmd, data + len - 1, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    
-    return (ret == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+    sensor_hal_delay_stats_t stats;
+    sensor_hal_esp32_delay_stats(&stats);
+
+    uint32_t calls = stats.spins + stats.sleeps;
+    if (calls == 0) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "delay_us: %u spins, %u sleeps, requested %llu us, actual %llu us, "
+             "mean overshoot %llu us, max %u us",
+             (unsigned)stats.spins, (unsigned)stats.sleeps,
+             (unsigned long long)stats.requested_us, (unsigned long long)stats.actual_us,
+             (unsigned long long)((stats.actual_us - stats.requested_us) / calls),
+             (unsigned)stats.max_overshoot_us);
 }
 
-static int8_t i2c_write(uint8_t reg, const uint8_t *data, uint32_t len, void *intf_ptr)
+/* ===== OUTPUT SENSOR DATA ===== */
+/* Runs on the output task for every processed sample */
+static void print_sensor_data(const sensor_sample_t *sample)
 {
-    uint8_t dev_addr = *(uint8_t *)intf_ptr;
-    
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (dev_addr << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_write(cmd, (uint8_t *)data, len, true);
-    i2c_master_stop(cmd);
-    
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    
-    return (ret == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+    static uint32_t n_printed;
+    static uint32_t alloc_mark;
+
+    xSemaphoreTake(history_lock, portMAX_DELAY);
+    sample_history_append(&history, sample);
+    xSemaphoreGive(history_lock);
+
+    if (have_log) {
+        xSemaphoreTake(log_lock, portMAX_DELAY);
+        sample_log_append(&sample_log, sample);
+        xSemaphoreGive(log_lock);
+    }
+
+#if CONFIG_AIR_QUALITY_TELEMETRY_JSON
+    static char line[OUTPUT_BUF_LEN];
+    sensor_pipeline_format_json(sample, line, sizeof(line));
+    printf("%s\n", line);
+#else
+    static uint8_t frame[TELEMETRY_FRAME_MAX];
+    int len = telemetry_encode_sample(sample, (uint16_t)n_printed, frame, sizeof(frame));
+    if (len > 0) {
+        fwrite(frame, 1, (size_t)len, stdout);
+        fflush(stdout);
+    }
+#endif
+
+    if (++n_printed % STATS_EVERY_SAMPLES == 0) {
+        uint32_t alloc_now = hal.alloc_bytes(hal.ctx);
+        if (alloc_now != alloc_mark) {
+            ESP_LOGW(TAG, "%u heap bytes allocated over the last %u samples",
+                     (unsigned)(alloc_now - alloc_mark), STATS_EVERY_SAMPLES);
+        }
+        alloc_mark = alloc_now;
+
+        log_delay_stats();
+        sensor_scheduler_log_stats(&scheduler);
+        sensor_tasks_log_stats();
+        sensor_pipeline_log_timing(&pipeline);
+    }
 }
 
-static void delay_us(uint32_t period, void *intf_ptr)
+/* Runs on the output task for every heater scan pass */
+static void print_scan_data(const heater_scan_vector_t *vector)
 {
-    vTaskDelay(pdMS_TO_TICKS(period / 1000));
+#if CONFIG_AIR_QUALITY_TELEMETRY_JSON
+    static char line[OUTPUT_BUF_LEN];
+    sensor_pipeline_format_scan_json(vector, line, sizeof(line));
+    printf("%s\n", line);
+#else
+    static uint8_t frame[TELEMETRY_FRAME_MAX];
+    int len = telemetry_encode_scan(vector, frame, sizeof(frame));
+    if (len > 0) {
+        fwrite(frame, 1, (size_t)len, stdout);
+        fflush(stdout);
+    }
+#endif
 }
 
-/* ===== ADC SETUP ===== */
-static void adc_init(void)
+/* ===== HISTORY BACKFILL ===== */
+/*
+ * Write the entries of `tier` in [from_ms, to_ms), then a history_end line.
+ * Entries are JSON lines, or compressed history frames in binary output
+ * mode.
+ */
+static void send_history(sample_history_tier_t tier, int64_t from_ms, int64_t to_ms)
 {
-    adc_oneshot_unit_init_cfg_t init_config = {
-        .unit_id = ADC_UNIT_1,
-    };
-    ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config, &adc_handle));
-    
-    adc_oneshot_chan_cfg_t config = {
-        .bitwidth = ADC_BITWIDTH_DEFAULT,
-        .atten = ADC_ATTEN_DB_12,
-    };
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_handle, ADC_CHANNEL_6, &config));
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_handle, ADC_CHANNEL_7, &config));
+    static sample_history_point_t points[HISTORY_CHUNK];
+    static char line[OUTPUT_BUF_LEN];
+    static uint8_t frame[TELEMETRY_FRAME_MAX];
+    uint16_t frame_seq = 0;
+    uint32_t sent = 0;
+    bool failed = false;
+    uint32_t n;
+
+    /* The output task appends under the same lock, so hold it only for a chunk */
+    do {
+        xSemaphoreTake(history_lock, portMAX_DELAY);
+        n = sample_history_query(&history, tier, from_ms, to_ms, points, HISTORY_CHUNK);
+        xSemaphoreGive(history_lock);
+
+        if (BINARY_OUTPUT) {
+            /* Entries after a frame that does not encode are not sent, and neither is the rest of the range */
+            for (uint32_t i = 0, taken; i < n && !failed; i += taken) {
+                int frame_len = telemetry_encode_history(tier, &points[i], n - i, &taken, frame_seq, frame,
+                                                         sizeof(frame));
+                failed = (frame_len <= 0 || taken == 0);
+                if (!failed) {
+                    fwrite(frame, 1, (size_t)frame_len, stdout);
+                    frame_seq++;
+                    sent += taken;
+                }
+            }
+        } else {
+            for (uint32_t i = 0; i < n; i++) {
+                sample_history_format_json(tier, &points[i], line, sizeof(line));
+                printf("%s\n", line);
+            }
+            sent += n;
+        }
+        if (n > 0) {
+            from_ms = points[n - 1].timestamp_ms + 1;
+        }
+    } while (n == HISTORY_CHUNK && !failed);
+
+    printf("{\"history_end\":{\"tier\":\"%s\",\"count\":%u}}\n", sample_history_tier_names[tier],
+           (unsigned)sent);
+    fflush(stdout);
 }
 
-/* ===== AQI CALCULATION ===== */
-static void calculate_aqi(void)
+static void history_command(const char *line)
 {
-    // AQI calculation based on PM2.5 (US EPA standard)
-    // This uses the breakpoint concentrations
-    float pm25_concentration = pm2_5;
-    
-    if (pm25_concentration <= 12.0) {
-        aqi = pm25_concentration * (50.0 / 12.0);
-        strcpy(aqi_level, "Good");
-    }
-    else if (pm25_concentration <= 35.4) {
-        aqi = 50.0 + (pm25_concentration - 12.0) * ((100.0 - 50.0) / (35.4 - 12.0));
-        strcpy(aqi_level, "Moderate");
-    }
-    else if (pm25_concentration <= 55.4) {
-        aqi = 100.0 + (pm25_concentration - 35.4) * ((150.0 - 100.0) / (55.4 - 35.4));
-        strcpy(aqi_level, "Unhealthy for Sensitive Groups");
+    char tier_name[8];
+    long long from_ms = 0;
+    long long to_ms = INT64_MAX;
+
+    if (sscanf(line, "history %7s %lld %lld", tier_name, &from_ms, &to_ms) < 1) {
+        return;
     }
-    else if (pm25_concentration <= 150.4) {
-        aqi = 150.0 + (pm25_concentration - 55.4) * ((200.0 - 150.0) / (150.4 - 55.4));
-        strcpy(aqi_level, "Unhealthy");
+
+    int tier = SAMPLE_HISTORY_N_TIERS;
+    if (strcmp(tier_name, "auto") == 0) {
+        xSemaphoreTake(history_lock, portMAX_DELAY);
+        tier = sample_history_tier_for(&history, from_ms);
+        xSemaphoreGive(history_lock);
     }
-    else if (pm25_concentration <= 250.4) {
-        aqi = 200.0 + (pm25_concentration - 150.4) * ((300.0 - 200.0) / (250.4 - 150.4));
-        strcpy(aqi_level, "Very Unhealthy");
+    for (int t = 0; t < SAMPLE_HISTORY_N_TIERS && tier == SAMPLE_HISTORY_N_TIERS; t++) {
+        if (strcmp(tier_name, sample_history_tier_names[t]) == 0) {
+            tier = t;
+        }
     }
-    else {
-        aqi = 300.0;
-        strcpy(aqi_level, "Hazardous");
+    if (tier == SAMPLE_HISTORY_N_TIERS) {
+        ESP_LOGW(TAG, "Unknown history tier %s", tier_name);
+        return;
     }
+
+    send_history((sample_history_tier_t)tier, from_ms, to_ms);
 }
 
-static void read_pm_sensor(void)
+/* ===== LOG EXPORT ===== */
+/* One telemetry frame per piece of a page, so the sample frames can interleave */
+static int send_log_chunk(void *arg, uint32_t seq, uint32_t offset, uint32_t page_len, const uint8_t *data,
+                          uint32_t len)
 {
-    if (pm_sensor != NULL) {
-        pm1_0 = dfrobot_gainParticleConcentration_ugm3(pm_sensor, PARTICLE_PM1_0_ATMOSPHERE);
-        pm2_5 = dfrobot_gainParticleConcentration_ugm3(pm_sensor, PARTICLE_PM2_5_ATMOSPHERE);
-        pm10 = dfrobot_gainParticleConcentration_ugm3(pm_sensor, PARTICLE_PM10_ATMOSPHERE);
-        calculate_aqi();
+    static telemetry_log_chunk_t chunk;
+    static uint8_t frame[TELEMETRY_FRAME_MAX];
+    uint32_t *n_chunks = (uint32_t *)arg;
+
+    chunk.page_seq = seq;
+    chunk.offset = (uint16_t)offset;
+    chunk.page_len = (uint16_t)page_len;
+    chunk.len = (uint16_t)len;
+    memcpy(chunk.data, data, len);
+
+    int frame_len = telemetry_encode_log_chunk(&chunk, (uint16_t)(*n_chunks)++, frame, sizeof(frame));
+    if (frame_len > 0) {
+        fwrite(frame, 1, (size_t)frame_len, stdout);
     }
+    return 0;
 }
 
-static void read_h2s(void)
+static void log_command(const char *line)
 {
-    int adc_raw;
-    adc_oneshot_read(adc_handle, ADC_CHANNEL_6, &adc_raw);
-    h2s_raw = adc_raw;
+    long long from_ms = 0;
+    long long to_ms = INT64_MAX;
+    sample_log_snapshot_t snap;
+    uint32_t n_chunks = 0;
+
+    if (!have_log) {
+        ESP_LOGW(TAG, "No sample log");
+        return;
+    }
+    sscanf(line, "log %lld %lld", &from_ms, &to_ms);
+
+    /* Only the snapshot needs the lock; the pages are then read from flash */
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    sample_log_snapshot(&sample_log, &snap);
+    int64_t now_ms = sample_log_now_ms(&sample_log);
+    xSemaphoreGive(log_lock);
+
+    uint32_t pages = sample_log_export(&sample_log, &snap, from_ms, to_ms, TELEMETRY_LOG_CHUNK_MAX,
+                                       send_log_chunk, &n_chunks);
+
+    printf("{\"log_end\":{\"pages\":%u,\"chunks\":%u,\"now_ms\":%lld}}\n", (unsigned)pages,
+           (unsigned)n_chunks, (long long)now_ms);
+    fflush(stdout);
 }
 
-static void read_odor(void)
+/*
+ * Reads commands from the console UART:
+ *
+ *   history <raw|1m|15m|1h|auto> [from_ms [to_ms]]
+ *   log [from_ms [to_ms]]
+ *
+ * history answers from the RAM history with JSON lines, or history frames
+ * in binary output mode, then a history_end JSON line; auto picks the
+ * finest tier that still reaches back to from_ms. log sends the flash log
+ * pages covering the range (in log time) as log chunk frames, in either
+ * output mode, then a log_end JSON line.
+ */
+static void command_task(void *arg)
 {
-    int adc_raw;
-    adc_oneshot_read(adc_handle, ADC_CHANNEL_7, &adc_raw);
-    odor_raw = adc_raw;
+    char line[COMMAND_LINE_LEN];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        if (strncmp(line, "history", 7) == 0) {
+            history_command(line);
+        } else if (strncmp(line, "log", 3) == 0) {
+            log_command(line);
+        }
+    }
+
+    ESP_LOGE(TAG, "Console input closed");
+    vTaskDelete(NULL);
 }
 
-/* ===== OUTPUT SENSOR DATA ===== */
-static void print_sensor_data(void)
+static esp_err_t history_start(void)
 {
-    printf("{\"temperature\":%.2f,\"humidity\":%.2f,\"pressure\":%.2f,\"iaq\":%.1f,\"h2s\":%d,\"odor\":%d,\"pm1_0\":%u,\"pm2_5\":%u,\"pm10\":%u,\"aqi\":%.1f,\"aqi_level\":\"%s\"}\n",
-           temperature, humidity, pressure, iaq, h2s_raw, odor_raw, pm1_0, pm2_5, pm10, aqi, aqi_level);
+    const sample_history_storage_t storage = {
+        .raw = history_raw,
+        .raw_len = CONFIG_AIR_QUALITY_HISTORY_RAW_LEN,
+        .rollup = { [SAMPLE_HISTORY_1M] = history_1m, [SAMPLE_HISTORY_15M] = history_15m,
+                    [SAMPLE_HISTORY_1H] = history_1h },
+        .rollup_len = { [SAMPLE_HISTORY_1M] = CONFIG_AIR_QUALITY_HISTORY_1M_LEN,
+                        [SAMPLE_HISTORY_15M] = CONFIG_AIR_QUALITY_HISTORY_15M_LEN,
+                        [SAMPLE_HISTORY_1H] = CONFIG_AIR_QUALITY_HISTORY_1H_LEN },
+    };
+
+    if (sample_history_init(&history, &storage) != 0) {
+        ESP_LOGE(TAG, "History lengths must be powers of two");
+        return ESP_ERR_INVALID_ARG;
+    }
+    history_lock = xSemaphoreCreateMutexStatic(&history_lock_buf);
+    ESP_LOGI(TAG, "History: %u bytes", (unsigned)sample_history_bytes(&history));
+
+    log_lock = xSemaphoreCreateMutexStatic(&log_lock_buf);
+    have_log = (sample_log_init(&sample_log, &hal, CONFIG_AIR_QUALITY_LOG_FLUSH_S * 1000LL) == SAMPLE_LOG_OK);
+    if (have_log) {
+        ESP_LOGI(TAG, "Sample log: %u pages, continuing page %u with %u records",
+                 (unsigned)sample_log.n_pages, (unsigned)sample_log.seq, (unsigned)sample_log.stats.recovered);
+    }
+
+    /* Blocking reads on the console UART need its driver */
+    ESP_ERROR_CHECK(uart_driver_install(CONFIG_ESP_CONSOLE_UART_NUM, 256, 0, 0, NULL, 0));
+    uart_vfs_dev_use_driver(CONFIG_ESP_CONSOLE_UART_NUM);
+    setvbuf(stdin, NULL, _IONBF, 0);
+
+    if (xTaskCreateStaticPinnedToCore(command_task, "command", COMMAND_STACK_SIZE, NULL, COMMAND_PRIORITY,
+                                      command_stack, &command_tcb, COMMAND_CORE) == NULL) {
+        ESP_LOGE(TAG, "Failed to create command task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
 }
 
 /* ===== MAIN TASK ===== */
@@ -183,172 +343,36 @@ void app_main(void)
 {
     ESP_LOGI(TAG, "Starting Air Quality Monitor");
     
-    /* ===== I2C INIT ===== */
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ
-    };
-    
-    ESP_ERROR_CHECK(i2c_param_config(I2C_MASTER_NUM, &conf));
-    ESP_ERROR_CHECK(i2c_driver_install(I2C_MASTER_NUM, conf.mode, 0, 0, 0));
-    
-    /* ===== ADC INIT ===== */
-    adc_init();
-    
-    /* ===== PM SENSOR INIT ===== */
-    pm_sensor = dfrobot_create(I2C_MASTER_NUM, PM_SENSOR_I2C_ADDR);
-    if (pm_sensor == NULL) {
-        ESP_LOGE(TAG, "Failed to create PM sensor");
-    } else {
-        vTaskDelay(pdMS_TO_TICKS(100));  // Wait for sensor to be ready
-        if (!dfrobot_begin(pm_sensor)) {
-            ESP_LOGW(TAG, "PM sensor not found at address 0x%02X", PM_SENSOR_I2C_ADDR);
-            dfrobot_delete(pm_sensor);
-            pm_sensor = NULL;
-        } else {
-            uint8_t version = dfrobot_gainVersion(pm_sensor);
-            ESP_LOGI(TAG, "PM Sensor initialized. Version: 0x%02X", version);
-        }
-    }
-    
-    /* ===== BME680 INIT ===== */
-    memset(&bme_dev, 0, sizeof(bme_dev));
-    
-    bme_dev.intf = BME68X_I2C_INTF;
-    bme_dev.intf_ptr = &bme_addr;
-    bme_dev.read = i2c_read;
-    bme_dev.write = i2c_write;
-    bme_dev.delay_us = delay_us;
-    bme_dev.amb_temp = 25;
-    
-    int8_t status = bme68x_init(&bme_dev);
-    if (status != BME68X_OK) {
-        ESP_LOGE(TAG, "BME680 init failed: %d", status);
-        return;
-    }
-    
-    ESP_LOGI(TAG, "BME680 initialized. Chip ID: 0x%02X", bme_dev.chip_id);
-    
-    /* ===== SENSOR CONFIG ===== */
-    struct bme68x_conf conf_sensor;
-    conf_sensor.os_hum  = BME68X_OS_2X;
-    conf_sensor.os_pres = BME68X_OS_4X;
-    conf_sensor.os_temp = BME68X_OS_8X;
-    conf_sensor.filter  = BME68X_FILTER_SIZE_3;
-    
-    bme68x_set_conf(&conf_sensor, &bme_dev);
-    
-    struct bme68x_heatr_conf heatr_conf;
-    heatr_conf.enable = BME68X_ENABLE;
-    heatr_conf.heatr_temp = 320;
-    heatr_conf.heatr_dur = 150;
+    /* ===== I2C / ADC INIT ===== */
+    ESP_ERROR_CHECK(sensor_hal_esp32_init(&hal));
+
+#if !CONFIG_AIR_QUALITY_TELEMETRY_JSON
+    /* Binary frames must reach the UART without LF -> CRLF translation */
+    uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#endif
     
-    bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &bme_dev);
+    /* ===== SENSOR PIPELINE INIT ===== */
+    sensor_pipeline_config_t config;
+    sensor_pipeline_default_config(&config);
+    config.aqi_scale = CONFIG_AIR_QUALITY_AQI_SCALE;
+#if CONFIG_AIR_QUALITY_HEATER_SCAN
+    /* The exhaust sensor scans its heater profile instead of running BSEC */
+    config.scan_addr = config.bme_addr[SENSOR_CHANNEL_EXHAUST];
+    config.n_bme = 1;
+#endif
     
-    /* ===== BSEC INIT ===== */
-    bsec_library_return_t bsec_status = bsec_init();
-    if (bsec_status != BSEC_OK) {
-        ESP_LOGE(TAG, "BSEC init failed!");
+    if (sensor_pipeline_init(&pipeline, &hal, &config) != SENSOR_PIPELINE_OK) {
+        ESP_LOGE(TAG, "Sensor pipeline init failed");
         return;
     }
     
-    bsec_sensor_configuration_t virtual_sensors[10];
-    bsec_virtual_sensor_t sensor_list[] = {
-        BSEC_OUTPUT_IAQ,
-        BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE,
-        BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY,
-        BSEC_OUTPUT_RAW_PRESSURE,
-    };
-    
-    uint8_t n_sensors = sizeof(sensor_list) / sizeof(sensor_list[0]);
-    for (uint8_t i = 0; i < n_sensors; i++) {
-        virtual_sensors[i].sensor_id = sensor_list[i];
-        virtual_sensors[i].sample_rate = BSEC_SAMPLE_RATE_LP;
-    }
-    
-    bsec_sensor_configuration_t required_settings[BSEC_MAX_PHYSICAL_SENSOR];
-    uint8_t n_required = BSEC_MAX_PHYSICAL_SENSOR;
-    
-    bsec_update_subscription(virtual_sensors, n_sensors, required_settings, &n_required);
-    
-    ESP_LOGI(TAG, "Entering measurement loop...");
+    /* ===== SAMPLE HISTORY ===== */
+    ESP_ERROR_CHECK(history_start());
+
+    ESP_LOGI(TAG, "Starting measurement tasks...");
+    sensor_scheduler_init(&scheduler, &pipeline);
     
-    /* ===== MAIN LOOP ===== */
-    while (1) {
-        struct bme68x_data data;
-        uint8_t n_fields = 0;
-        
-        bme68x_set_op_mode(BME68X_FORCED_MODE, &bme_dev);
-        
-        uint32_t meas_dur = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf_sensor, &bme_dev);
-        vTaskDelay(pdMS_TO_TICKS((meas_dur / 1000) + 10));
-        
-        bsec_status = bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &bme_dev);
-        if (bsec_status != BME68X_OK || n_fields == 0) {
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            continue;
-        }
-        
-        /* BSEC Processing */
-        bsec_input_t inputs[4];
-        uint8_t n_inputs = 0;
-        
-        int64_t timestamp_ns = esp_timer_get_time() * 1000LL;
-        
-        inputs[n_inputs].sensor_id = BSEC_INPUT_TEMPERATURE;
-        inputs[n_inputs].signal = data.temperature;
-        inputs[n_inputs].time_stamp = timestamp_ns;
-        n_inputs++;
-        
-        inputs[n_inputs].sensor_id = BSEC_INPUT_HUMIDITY;
-        inputs[n_inputs].signal = data.humidity;
-        inputs[n_inputs].time_stamp = timestamp_ns;
-        n_inputs++;
-        
-        inputs[n_inputs].sensor_id = BSEC_INPUT_PRESSURE;
-        inputs[n_inputs].signal = data.pressure * 100.0f;
-        inputs[n_inputs].time_stamp = timestamp_ns;
-        n_inputs++;
-        
-        bool gas_valid = (data.status & BME68X_GASM_VALID_MSK) && (data.status & BME68X_HEAT_STAB_MSK);
-        if (gas_valid) {
-            inputs[n_inputs].sensor_id = BSEC_INPUT_GASRESISTOR;
-            inputs[n_inputs].signal = (float)data.gas_resistance;
-            inputs[n_inputs].time_stamp = timestamp_ns;
-            n_inputs++;
-        }
-        
-        bsec_output_t outputs[BSEC_NUMBER_OUTPUTS];
-        uint8_t n_outputs = BSEC_NUMBER_OUTPUTS;
-        
-        bsec_do_steps(inputs, n_inputs, outputs, &n_outputs);
-        
-        /* Extract IAQ from BSEC outputs */
-        for (int i = 0; i < n_outputs; i++) {
-            if (outputs[i].sensor_id == BSEC_OUTPUT_IAQ) {
-                iaq = outputs[i].signal;
-            }
-        }
-        
-        /* Store basic BME680 readings */
-        temperature = data.temperature;
-        humidity = data.humidity;
-        pressure = data.pressure / 100.0f;
-        
-        /* Read PM sensor */
-        read_pm_sensor();
-        
-        /* Read gas sensors */
-        read_h2s();
-        read_odor();
-        
-        /* Output JSON */
-        print_sensor_data();
-        
-        vTaskDelay(pdMS_TO_TICKS(3000));
-    }
+    /* ===== PIPELINE TASKS ===== */
+    /* Acquisition, processing and output run as separate tasks; app_main returns */
+    ESP_ERROR_CHECK(sensor_tasks_start(&pipeline, &scheduler, print_sensor_data, print_scan_data));
 }
@@ -48,46 +48,68 @@ static int8_t read_variant_id(struct bme68x_dev *dev);
 /* This internal API is used to calculate the gas wait */
 static uint8_t calc_gas_wait(uint16_t dur);
 
-#ifndef BME68X_USE_FPU
-
-/* This internal API is used to calculate the temperature in integer */
-static int16_t calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev);
-
-/* This internal API is used to calculate the pressure in integer */
-static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev);
-
-/* This internal API is used to calculate the humidity in integer */
-static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev);
-
-/* This internal API is used to calculate the gas resistance high */
-static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range);
-
-/* This internal API is used to calculate the gas resistance low */
-static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev);
-
-/* This internal API is used to calculate the heater resistance using integer */
+/* Raw ADC values of one data field */
+struct field_adc
+{
+    uint32_t temp;
+    uint32_t pres;
+    uint16_t hum;
+    uint16_t gas;
+    uint8_t gas_range;
+};
+
+/* Raw ADC values of up to BME68X_BATCH_BLOCK fields, one array per quantity */
+struct field_block
+{
+    uint32_t temp[BME68X_BATCH_BLOCK];
+    uint32_t pres[BME68X_BATCH_BLOCK];
+    uint16_t hum[BME68X_BATCH_BLOCK];
+    uint16_t gas[BME68X_BATCH_BLOCK];
+    uint8_t gas_range[BME68X_BATCH_BLOCK];
+};
+
+/* This internal API is used to calculate the heater resistance */
 static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev);
 
-#else
-
-/* This internal API is used to calculate the temperature value in float */
-static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev);
+/* This internal API is used to compensate one field with the integer formulas */
+static void comp_field_int(const struct field_adc *adc,
+                           uint8_t variant_id,
+                           const struct bme68x_comp_ctx *ctx,
+                           struct bme68x_data *data);
 
-/* This internal API is used to calculate the pressure value in float */
-static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev);
-
-/* This internal API is used to calculate the humidity value in float */
-static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev);
+#ifdef BME68X_USE_FPU
 
-/* This internal API is used to calculate the gas resistance high value in float */
-static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range);
-
-/* This internal API is used to calculate the gas resistance low value in float */
-static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev);
-
-/* This internal API is used to calculate the heater resistance value using float */
-static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev);
+/* This internal API is used to compensate one field with the float formulas */
+static void comp_field_float(const struct field_adc *adc,
+                             uint8_t variant_id,
+                             const struct bme68x_comp_ctx *ctx,
+                             struct bme68x_data *data);
+#endif
 
+/* This internal API is used to unpack the status and ADC values of a field */
+static void parse_field(const uint8_t *buff, uint8_t variant_id, struct bme68x_data *data, struct field_adc *adc);
+
+/* This internal API is used to compensate a parsed field */
+static void compensate_field(const struct field_adc *adc,
+                             uint8_t variant_id,
+                             const struct bme68x_comp_ctx *ctx,
+                             struct bme68x_data *data);
+
+/* This internal API is used to compensate a block of unpacked fields with the integer formulas */
+static void comp_block_int(const struct field_block *blk,
+                           uint32_t n,
+                           uint8_t variant_id,
+                           const struct bme68x_comp_ctx *ctx,
+                           const struct bme68x_data_soa *out);
+
+#ifdef BME68X_USE_FPU
+
+/* This internal API is used to compensate a block of unpacked fields with the float formulas */
+static void comp_block_float(const struct field_block *blk,
+                             uint32_t n,
+                             uint8_t variant_id,
+                             const struct bme68x_comp_ctx *ctx,
+                             const struct bme68x_data_soa *out);
 #endif
 
 /* This internal API is used to read a single data of the sensor */
@@ -96,6 +118,9 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
 /* This internal API is used to read all data fields of the sensor */
 static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme68x_dev *dev);
 
+/* This internal API is used to cache the heater set-point registers */
+static int8_t read_heatr_set(struct bme68x_dev *dev);
+
 /* This internal API is used to switch between SPI memory pages */
 static int8_t set_mem_page(uint8_t reg_addr, struct bme68x_dev *dev);
 
@@ -145,6 +170,7 @@ int8_t bme68x_init(struct bme68x_dev *dev)
 {
     int8_t rslt;
 
+    dev->heatr_set_valid = 0;
     (void) bme68x_soft_reset(dev);
 
     rslt = bme68x_get_regs(BME68X_REG_CHIP_ID, &dev->chip_id, 1, dev);
@@ -202,6 +228,13 @@ int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
                     tmp_buff[(2 * index)] = reg_addr[index];
                 }
 
+                /* Direct writes to the heater set-points make the cache stale */
+                if ((reg_addr[index] >= BME68X_REG_IDAC_HEAT0) &&
+                    (reg_addr[index] < BME68X_REG_IDAC_HEAT0 + BME68X_LEN_HEATR_SET))
+                {
+                    dev->heatr_set_valid = 0;
+                }
+
                 tmp_buff[(2 * index) + 1] = reg_data[index];
             }
 
@@ -290,6 +323,8 @@ int8_t bme68x_soft_reset(struct bme68x_dev *dev)
 
             if (rslt == BME68X_OK)
             {
+                dev->heatr_set_valid = 0;
+
                 /* Wait for 5ms */
                 dev->delay_us(BME68X_PERIOD_RESET, dev->intf_ptr);
 
@@ -672,6 +707,12 @@ int8_t bme68x_set_heatr_conf(uint8_t op_mode, const struct bme68x_heatr_conf *co
                 rslt = bme68x_set_regs(ctrl_gas_addr, ctrl_gas_data, 2, dev);
             }
         }
+
+        /* Read the set-points back once so data reads need no extra transactions */
+        if (rslt == BME68X_OK)
+        {
+            rslt = read_heatr_set(dev);
+        }
     }
     else
     {
@@ -828,53 +869,345 @@ int8_t bme68x_selftest_check(const struct bme68x_dev *dev)
     return rslt;
 }
 
+/*
+ * @brief This API derives the compensation constants from the calibration
+ * coefficients
+ */
+int8_t bme68x_calc_comp_ctx(const struct bme68x_calib_data *calib, uint8_t comp_mode, struct bme68x_comp_ctx *ctx)
+{
+    int8_t rslt = BME68X_OK;
+    uint8_t i;
+    const uint32_t lookup_table1[16] = {
+        UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
+        UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
+        UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
+        UINT32_C(2147483647)
+    };
+    const uint32_t lookup_table2[16] = {
+        UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
+        UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000), UINT32_C(
+            4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
+    };
+
+#ifdef BME68X_USE_FPU
+    const float lookup_k1_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
+    };
+    const float lookup_k2_range[16] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+    };
+    float var1;
+    float var3;
+#endif
+
+    if ((calib == NULL) || (ctx == NULL))
+    {
+        return BME68X_E_NULL_PTR;
+    }
+
+#ifdef BME68X_USE_FPU
+    if ((comp_mode != BME68X_COMP_FLOAT) && (comp_mode != BME68X_COMP_INT))
+#else
+    if (comp_mode != BME68X_COMP_INT)
+#endif
+    {
+        return BME68X_E_COMP_MODE;
+    }
+
+    ctx->mode = comp_mode;
+
+    /* Integer path, scaled as in the integer formulas */
+    ctx->t1_x2 = (int32_t)calib->par_t1 * 2;
+    ctx->t2 = calib->par_t2;
+    ctx->t3_x16 = (int32_t)calib->par_t3 * 16;
+    ctx->p1 = calib->par_p1;
+    ctx->p2 = calib->par_p2;
+    ctx->p3_x32 = (int32_t)calib->par_p3 * 32;
+    ctx->p4_x65536 = (int32_t)calib->par_p4 * 65536;
+    ctx->p5 = calib->par_p5;
+    ctx->p6 = calib->par_p6;
+    ctx->p7_x128 = (int32_t)calib->par_p7 * 128;
+    ctx->p8 = calib->par_p8;
+    ctx->p9 = calib->par_p9;
+    ctx->p10 = calib->par_p10;
+    ctx->h1_x16 = (int32_t)calib->par_h1 * 16;
+    ctx->h2 = calib->par_h2;
+    ctx->h3 = calib->par_h3;
+    ctx->h4 = calib->par_h4;
+    ctx->h5 = calib->par_h5;
+    ctx->h6_x128 = (int32_t)calib->par_h6 * 128;
+    ctx->h7 = calib->par_h7;
+
+    for (i = 0; i < 16; i++)
+    {
+        /*lint -save -e704 */
+        ctx->gas_l_var1[i] = (int64_t)((1340 + (5 * (int64_t)calib->range_sw_err)) * ((int64_t)lookup_table1[i])) >> 16;
+        ctx->gas_l_var3[i] = (((int64_t)lookup_table2[i] * ctx->gas_l_var1[i]) >> 9);
+
+        /*lint -restore */
+        ctx->gas_h_num[i] = UINT32_C(10000) * (UINT32_C(262144) >> i);
+    }
+
+#ifdef BME68X_USE_FPU
+
+    /* Float path: the same subexpressions the float formulas evaluate per sample */
+    ctx->ft1_1024 = (float)calib->par_t1 / 1024.0f;
+    ctx->ft1_8192 = (float)calib->par_t1 / 8192.0f;
+    ctx->ft2 = (float)calib->par_t2;
+    ctx->ft3_x16 = (float)calib->par_t3 * 16.0f;
+    ctx->fp1 = (float)calib->par_p1;
+    ctx->fp2 = (float)calib->par_p2;
+    ctx->fp3 = (float)calib->par_p3;
+    ctx->fp4_x65536 = (float)calib->par_p4 * 65536.0f;
+    ctx->fp5 = (float)calib->par_p5;
+    ctx->fp6_131072 = (float)calib->par_p6 / 131072.0f;
+    ctx->fp7_x128 = (float)calib->par_p7 * 128.0f;
+    ctx->fp8_32768 = (float)calib->par_p8 / 32768.0f;
+    ctx->fp9 = (float)calib->par_p9;
+    ctx->fp10_131072 = calib->par_p10 / 131072.0f;
+    ctx->fh1_x16 = (float)calib->par_h1 * 16.0f;
+    ctx->fh2_262144 = (float)calib->par_h2 / 262144.0f;
+    ctx->fh3_2 = (float)calib->par_h3 / 2.0f;
+    ctx->fh4_16384 = (float)calib->par_h4 / 16384.0f;
+    ctx->fh5_1048576 = (float)calib->par_h5 / 1048576.0f;
+    ctx->fh6_16384 = (float)calib->par_h6 / 16384.0f;
+    ctx->fh7_2097152 = (float)calib->par_h7 / 2097152.0f;
+
+    var1 = (1340.0f + (5.0f * calib->range_sw_err));
+    for (i = 0; i < 16; i++)
+    {
+        var3 = 1.0f + (lookup_k2_range[i] / 100.0f);
+        ctx->fgas_l_var2[i] = (var1) * (1.0f + lookup_k1_range[i] / 100.0f);
+        ctx->fgas_l_scale[i] = var3 * (0.000000125f) * (float)(1U << i);
+        ctx->fgas_h_num[i] = 1000000.0f * (float)(UINT32_C(262144) >> i);
+    }
+#endif
+
+    return rslt;
+}
+
+/*
+ * @brief This API selects the float or integer compensation formulas
+ */
+int8_t bme68x_set_comp_mode(uint8_t comp_mode, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    rslt = null_ptr_check(dev);
+    if (rslt == BME68X_OK)
+    {
+#ifdef BME68X_USE_FPU
+        if ((comp_mode != BME68X_COMP_FLOAT) && (comp_mode != BME68X_COMP_INT))
+#else
+        if (comp_mode != BME68X_COMP_INT)
+#endif
+        {
+            rslt = BME68X_E_COMP_MODE;
+        }
+        else
+        {
+            dev->comp.mode = comp_mode;
+        }
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API compensates one raw data field without any bus access
+ */
+int8_t bme68x_compensate_field(const uint8_t *field,
+                               uint8_t variant_id,
+                               const struct bme68x_comp_ctx *ctx,
+                               struct bme68x_data *data)
+{
+    struct field_adc adc;
+
+    if ((field == NULL) || (ctx == NULL) || (data == NULL))
+    {
+        return BME68X_E_NULL_PTR;
+    }
+
+    parse_field(field, variant_id, data, &adc);
+    data->idac = 0;
+    data->res_heat = 0;
+    data->gas_wait = 0;
+    compensate_field(&adc, variant_id, ctx, data);
+
+    return BME68X_OK;
+}
+
+/*
+ * @brief This API compensates an array of raw data fields into one array
+ * per quantity, without any bus access
+ */
+int8_t bme68x_compensate_batch(const uint8_t *fields,
+                               uint32_t n_fields,
+                               uint8_t variant_id,
+                               const struct bme68x_comp_ctx *ctx,
+                               const struct bme68x_data_soa *out)
+{
+    struct field_block blk;
+    struct field_adc adc;
+    struct bme68x_data hdr;
+    struct bme68x_data_soa part;
+    uint32_t base;
+    uint32_t n;
+    uint32_t i;
+
+    if ((fields == NULL) || (ctx == NULL) || (out == NULL) || (out->temperature == NULL) ||
+        (out->pressure == NULL) || (out->humidity == NULL) || (out->gas_resistance == NULL))
+    {
+        return BME68X_E_NULL_PTR;
+    }
+
+    for (base = 0; base < n_fields; base += n)
+    {
+        n = n_fields - base;
+        if (n > BME68X_BATCH_BLOCK)
+        {
+            n = BME68X_BATCH_BLOCK;
+        }
+
+        /* Unpack the block, then compensate it one quantity at a time */
+        for (i = 0; i < n; i++)
+        {
+            parse_field(&fields[(base + i) * BME68X_LEN_FIELD], variant_id, &hdr, &adc);
+            blk.temp[i] = adc.temp;
+            blk.pres[i] = adc.pres;
+            blk.hum[i] = adc.hum;
+            blk.gas[i] = adc.gas;
+            blk.gas_range[i] = adc.gas_range;
+            if (out->status != NULL)
+            {
+                out->status[base + i] = hdr.status;
+            }
+
+            if (out->gas_index != NULL)
+            {
+                out->gas_index[base + i] = hdr.gas_index;
+            }
+        }
+
+        part.temperature = &out->temperature[base];
+        part.pressure = &out->pressure[base];
+        part.humidity = &out->humidity[base];
+        part.gas_resistance = &out->gas_resistance[base];
+#ifdef BME68X_USE_FPU
+        if (ctx->mode == BME68X_COMP_FLOAT)
+        {
+            comp_block_float(&blk, n, variant_id, ctx, &part);
+        }
+        else
+#endif
+        {
+            comp_block_int(&blk, n, variant_id, ctx, &part);
+        }
+    }
+
+    return BME68X_OK;
+}
+
 /*****************************INTERNAL APIs***********************************************/
 #ifndef BME68X_USE_FPU
 
-/* @brief This internal API is used to calculate the temperature value. */
-static int16_t calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
+/* This internal API is used to calculate the heater resistance value using integer */
+static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
+{
+    uint8_t heatr_res;
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    int32_t heatr_res_x100;
+
+    if (temp > 400) /* Cap temperature */
+    {
+        temp = 400;
+    }
+
+    var1 = (((int32_t)dev->amb_temp * dev->calib.par_gh3) / 1000) * 256;
+    var2 = (dev->calib.par_gh1 + 784) * (((((dev->calib.par_gh2 + 154009) * temp * 5) / 100) + 3276800) / 10);
+    var3 = var1 + (var2 / 2);
+    var4 = (var3 / (dev->calib.res_heat_range + 4));
+    var5 = (131 * dev->calib.res_heat_val) + 65536;
+    heatr_res_x100 = (int32_t)(((var4 / var5) - 250) * 34);
+    heatr_res = (uint8_t)((heatr_res_x100 + 50) / 100);
+
+    return heatr_res;
+}
+
+#else
+
+/* This internal API is used to calculate the heater resistance value using float */
+static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
+{
+    float var1;
+    float var2;
+    float var3;
+    float var4;
+    float var5;
+    uint8_t res_heat;
+
+    if (temp > 400) /* Cap temperature */
+    {
+        temp = 400;
+    }
+
+    var1 = (((float)dev->calib.par_gh1 / (16.0f)) + 49.0f);
+    var2 = ((((float)dev->calib.par_gh2 / (32768.0f)) * (0.0005f)) + 0.00235f);
+    var3 = ((float)dev->calib.par_gh3 / (1024.0f));
+    var4 = (var1 * (1.0f + (var2 * (float)temp)));
+    var5 = (var4 + (var3 * (float)dev->amb_temp));
+    res_heat =
+        (uint8_t)(3.4f *
+                  ((var5 * (4 / (4 + (float)dev->calib.res_heat_range)) *
+                    (1 / (1 + ((float)dev->calib.res_heat_val * 0.002f)))) -
+                   25));
+
+    return res_heat;
+}
+
+#endif
+
+/* This internal API is used to calculate the temperature in integer */
+static int16_t comp_temperature_int(uint32_t temp_adc, const struct bme68x_comp_ctx *ctx, int32_t *t_fine)
 {
     int64_t var1;
     int64_t var2;
     int64_t var3;
-    int16_t calc_temp;
 
     /*lint -save -e701 -e702 -e704 */
-    var1 = ((int32_t)temp_adc >> 3) - ((int32_t)dev->calib.par_t1 << 1);
-    var2 = (var1 * (int32_t)dev->calib.par_t2) >> 11;
+    var1 = ((int32_t)temp_adc >> 3) - ctx->t1_x2;
+    var2 = (var1 * ctx->t2) >> 11;
     var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
-    var3 = ((var3) * ((int32_t)dev->calib.par_t3 << 4)) >> 14;
-    dev->calib.t_fine = (int32_t)(var2 + var3);
-    calc_temp = (int16_t)(((dev->calib.t_fine * 5) + 128) >> 8);
+    var3 = ((var3) * ctx->t3_x16) >> 14;
+    *t_fine = (int32_t)(var2 + var3);
 
     /*lint -restore */
-    return calc_temp;
+    return (int16_t)(((*t_fine * 5) + 128) >> 8);
 }
 
-/* @brief This internal API is used to calculate the pressure value. */
-static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
+/* This internal API is used to calculate the pressure in integer */
+static uint32_t comp_pressure_int(uint32_t pres_adc, int32_t t_fine, const struct bme68x_comp_ctx *ctx)
 {
     int32_t var1;
     int32_t var2;
     int32_t var3;
     int32_t pressure_comp;
 
-    /* This value is used to check precedence to multiplication or division
-     * in the pressure compensation equation to achieve least loss of precision and
-     * avoiding overflows.
-     * i.e Comparing value, pres_ovf_check = (1 << 31) >> 1
-     */
+    /* Same overflow guard as the vendor formula: (1 << 31) >> 1 */
     const int32_t pres_ovf_check = INT32_C(0x40000000);
 
     /*lint -save -e701 -e702 -e713 */
-    var1 = (((int32_t)dev->calib.t_fine) >> 1) - 64000;
-    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)dev->calib.par_p6) >> 2;
-    var2 = var2 + ((var1 * (int32_t)dev->calib.par_p5) << 1);
-    var2 = (var2 >> 2) + ((int32_t)dev->calib.par_p4 << 16);
-    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)dev->calib.par_p3 << 5)) >> 3) +
-           (((int32_t)dev->calib.par_p2 * var1) >> 1);
+    var1 = (t_fine >> 1) - 64000;
+    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * ctx->p6) >> 2;
+    var2 = var2 + ((var1 * ctx->p5) << 1);
+    var2 = (var2 >> 2) + ctx->p4_x65536;
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ctx->p3_x32) >> 3) + ((ctx->p2 * var1) >> 1);
     var1 = var1 >> 18;
-    var1 = ((32768 + var1) * (int32_t)dev->calib.par_p1) >> 15;
+    var1 = ((32768 + var1) * ctx->p1) >> 15;
     pressure_comp = 1048576 - pres_adc;
     pressure_comp = (int32_t)((pressure_comp - (var2 >> 12)) * ((uint32_t)3125));
     if (pressure_comp >= pres_ovf_check)
@@ -886,19 +1219,19 @@ static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
         pressure_comp = ((pressure_comp << 1) / var1);
     }
 
-    var1 = ((int32_t)dev->calib.par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
-    var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)dev->calib.par_p8) >> 13;
+    var1 = (ctx->p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(pressure_comp >> 2) * ctx->p8) >> 13;
     var3 =
         ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
-         (int32_t)dev->calib.par_p10) >> 17;
-    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)dev->calib.par_p7 << 7)) >> 4);
+         ctx->p10) >> 17;
+    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ctx->p7_x128) >> 4);
 
     /*lint -restore */
     return (uint32_t)pressure_comp;
 }
 
 /* This internal API is used to calculate the humidity in integer */
-static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
+static uint32_t comp_humidity_int(uint16_t hum_adc, int32_t t_fine, const struct bme68x_comp_ctx *ctx)
 {
     int32_t var1;
     int32_t var2;
@@ -910,17 +1243,15 @@ static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
     int32_t calc_hum;
 
     /*lint -save -e702 -e704 */
-    temp_scaled = (((int32_t)dev->calib.t_fine * 5) + 128) >> 8;
-    var1 = (int32_t)(hum_adc - ((int32_t)((int32_t)dev->calib.par_h1 * 16))) -
-           (((temp_scaled * (int32_t)dev->calib.par_h3) / ((int32_t)100)) >> 1);
+    temp_scaled = ((t_fine * 5) + 128) >> 8;
+    var1 = (int32_t)(hum_adc - ctx->h1_x16) - (((temp_scaled * ctx->h3) / ((int32_t)100)) >> 1);
     var2 =
-        ((int32_t)dev->calib.par_h2 *
-         (((temp_scaled * (int32_t)dev->calib.par_h4) / ((int32_t)100)) +
-          (((temp_scaled * ((temp_scaled * (int32_t)dev->calib.par_h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
+        (ctx->h2 *
+         (((temp_scaled * ctx->h4) / ((int32_t)100)) +
+          (((temp_scaled * ((temp_scaled * ctx->h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
           (int32_t)(1 << 14))) >> 10;
     var3 = var1 * var2;
-    var4 = (int32_t)dev->calib.par_h6 << 7;
-    var4 = ((var4) + ((temp_scaled * (int32_t)dev->calib.par_h7) / ((int32_t)100))) >> 4;
+    var4 = ((ctx->h6_x128) + ((temp_scaled * ctx->h7) / ((int32_t)100))) >> 4;
     var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
     var6 = (var4 * var5) >> 1;
     calc_hum = (((var3 + var6) >> 10) * ((int32_t)1000)) >> 12;
@@ -937,129 +1268,103 @@ static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
     return (uint32_t)calc_hum;
 }
 
-/* This internal API is used to calculate the gas resistance low */
-static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
-{
-    int64_t var1;
-    uint64_t var2;
-    int64_t var3;
-    uint32_t calc_gas_res;
-    uint32_t lookup_table1[16] = {
-        UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
-        UINT32_C(2147483647)
-    };
-    uint32_t lookup_table2[16] = {
-        UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
-        UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000), UINT32_C(
-            4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
-    };
-
-    /*lint -save -e704 */
-    var1 = (int64_t)((1340 + (5 * (int64_t)dev->calib.range_sw_err)) * ((int64_t)lookup_table1[gas_range])) >> 16;
-    var2 = (((int64_t)((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + var1);
-    var3 = (((int64_t)lookup_table2[gas_range] * (int64_t)var1) >> 9);
-    calc_gas_res = (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
-
-    /*lint -restore */
-    return calc_gas_res;
-}
-
-/* This internal API is used to calculate the gas resistance */
-static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
+/* This internal API is used to calculate the gas resistance in integer */
+static uint32_t comp_gas_int(uint16_t gas_res_adc,
+                             uint8_t gas_range,
+                             uint8_t variant_id,
+                             const struct bme68x_comp_ctx *ctx)
 {
-    uint32_t calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
-    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
-
-    var2 *= INT32_C(3);
-    var2 = INT32_C(4096) + var2;
+    if (variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        int32_t var2 = INT32_C(4096) + ((int32_t)gas_res_adc - INT32_C(512)) * INT32_C(3);
 
-    /* multiplying 10000 then dividing then multiplying by 100 instead of multiplying by 1000000 to prevent overflow */
-    calc_gas_res = (UINT32_C(10000) * var1) / (uint32_t)var2;
-    calc_gas_res = calc_gas_res * 100;
+        /* multiplying 10000 then dividing then multiplying by 100 instead of multiplying by 1000000 to prevent overflow */
+        return (ctx->gas_h_num[gas_range] / (uint32_t)var2) * 100;
+    }
+    else
+    {
+        /*lint -save -e704 */
+        int64_t var2 = (((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + ctx->gas_l_var1[gas_range];
 
-    return calc_gas_res;
+        /*lint -restore */
+        return (uint32_t)((ctx->gas_l_var3[gas_range] + (var2 >> 1)) / var2);
+    }
 }
 
-/* This internal API is used to calculate the heater resistance value using integer */
-static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
+/* This internal API is used to compensate one field with the integer formulas */
+static void comp_field_int(const struct field_adc *adc,
+                           uint8_t variant_id,
+                           const struct bme68x_comp_ctx *ctx,
+                           struct bme68x_data *data)
 {
-    uint8_t heatr_res;
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t var4;
-    int32_t var5;
-    int32_t heatr_res_x100;
-
-    if (temp > 400) /* Cap temperature */
-    {
-        temp = 400;
-    }
-
-    var1 = (((int32_t)dev->amb_temp * dev->calib.par_gh3) / 1000) * 256;
-    var2 = (dev->calib.par_gh1 + 784) * (((((dev->calib.par_gh2 + 154009) * temp * 5) / 100) + 3276800) / 10);
-    var3 = var1 + (var2 / 2);
-    var4 = (var3 / (dev->calib.res_heat_range + 4));
-    var5 = (131 * dev->calib.res_heat_val) + 65536;
-    heatr_res_x100 = (int32_t)(((var4 / var5) - 250) * 34);
-    heatr_res = (uint8_t)((heatr_res_x100 + 50) / 100);
-
-    return heatr_res;
+    int32_t t_fine;
+    int16_t temperature = comp_temperature_int(adc->temp, ctx, &t_fine);
+    uint32_t pressure = comp_pressure_int(adc->pres, t_fine, ctx);
+    uint32_t humidity = comp_humidity_int(adc->hum, t_fine, ctx);
+    uint32_t gas_resistance = comp_gas_int(adc->gas, adc->gas_range, variant_id, ctx);
+
+#ifdef BME68X_USE_FPU
+
+    /* Report in the same units as the float path */
+    data->temperature = (float)temperature / 100.0f;
+    data->pressure = (float)pressure;
+    data->humidity = (float)humidity / 1000.0f;
+    data->gas_resistance = (float)gas_resistance;
+#else
+    data->temperature = temperature;
+    data->pressure = pressure;
+    data->humidity = humidity;
+    data->gas_resistance = gas_resistance;
+#endif
 }
 
-#else
+#ifdef BME68X_USE_FPU
 
-/* @brief This internal API is used to calculate the temperature value. */
-static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
+/* This internal API is used to calculate the temperature value in float */
+static float comp_temperature_float(uint32_t temp_adc, const struct bme68x_comp_ctx *ctx, float *t_fine)
 {
     float var1;
     float var2;
-    float calc_temp;
 
     /* calculate var1 data */
-    var1 = ((((float)temp_adc / 16384.0f) - ((float)dev->calib.par_t1 / 1024.0f)) * ((float)dev->calib.par_t2));
+    var1 = ((((float)temp_adc / 16384.0f) - ctx->ft1_1024) * ctx->ft2);
 
     /* calculate var2 data */
     var2 =
-        (((((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f)) *
-          (((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f))) * ((float)dev->calib.par_t3 * 16.0f));
+        (((((float)temp_adc / 131072.0f) - ctx->ft1_8192) *
+          (((float)temp_adc / 131072.0f) - ctx->ft1_8192)) * ctx->ft3_x16);
 
     /* t_fine value*/
-    dev->calib.t_fine = (var1 + var2);
+    *t_fine = (var1 + var2);
 
     /* compensated temperature data*/
-    calc_temp = ((dev->calib.t_fine) / 5120.0f);
-
-    return calc_temp;
+    return (*t_fine / 5120.0f);
 }
 
-/* @brief This internal API is used to calculate the pressure value. */
-static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
+/* This internal API is used to calculate the pressure value in float */
+static float comp_pressure_float(uint32_t pres_adc, float t_fine, const struct bme68x_comp_ctx *ctx)
 {
     float var1;
     float var2;
     float var3;
     float calc_pres;
 
-    var1 = (((float)dev->calib.t_fine / 2.0f) - 64000.0f);
-    var2 = var1 * var1 * (((float)dev->calib.par_p6) / (131072.0f));
-    var2 = var2 + (var1 * ((float)dev->calib.par_p5) * 2.0f);
-    var2 = (var2 / 4.0f) + (((float)dev->calib.par_p4) * 65536.0f);
-    var1 = (((((float)dev->calib.par_p3 * var1 * var1) / 16384.0f) + ((float)dev->calib.par_p2 * var1)) / 524288.0f);
-    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)dev->calib.par_p1));
+    var1 = ((t_fine / 2.0f) - 64000.0f);
+    var2 = var1 * var1 * ctx->fp6_131072;
+    var2 = var2 + (var1 * ctx->fp5 * 2.0f);
+    var2 = (var2 / 4.0f) + ctx->fp4_x65536;
+    var1 = ((((ctx->fp3 * var1 * var1) / 16384.0f) + (ctx->fp2 * var1)) / 524288.0f);
+    var1 = ((1.0f + (var1 / 32768.0f)) * ctx->fp1);
     calc_pres = (1048576.0f - ((float)pres_adc));
 
     /* Avoid exception caused by division by zero */
     if ((int)var1 != 0)
     {
         calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
-        var1 = (((float)dev->calib.par_p9) * calc_pres * calc_pres) / 2147483648.0f;
-        var2 = calc_pres * (((float)dev->calib.par_p8) / 32768.0f);
-        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (dev->calib.par_p10 / 131072.0f));
-        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)dev->calib.par_p7 * 128.0f)) / 16.0f);
+        var1 = (ctx->fp9 * calc_pres * calc_pres) / 2147483648.0f;
+        var2 = calc_pres * ctx->fp8_32768;
+        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * ctx->fp10_131072);
+        calc_pres = (calc_pres + (var1 + var2 + var3 + ctx->fp7_x128) / 16.0f);
     }
     else
     {
@@ -1069,27 +1374,18 @@ static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
     return calc_pres;
 }
 
-/* This internal API is used to calculate the humidity in integer */
-static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
+/* This internal API is used to calculate the humidity value in float */
+static float comp_humidity_float(uint16_t hum_adc, float temp_comp, const struct bme68x_comp_ctx *ctx)
 {
     float calc_hum;
     float var1;
     float var2;
-    float var3;
-    float var4;
-    float temp_comp;
 
-    /* compensated temperature data*/
-    temp_comp = ((dev->calib.t_fine) / 5120.0f);
-    var1 = (float)((float)hum_adc) -
-           (((float)dev->calib.par_h1 * 16.0f) + (((float)dev->calib.par_h3 / 2.0f) * temp_comp));
+    var1 = (float)hum_adc - (ctx->fh1_x16 + (ctx->fh3_2 * temp_comp));
     var2 = var1 *
-           ((float)(((float)dev->calib.par_h2 / 262144.0f) *
-                    (1.0f + (((float)dev->calib.par_h4 / 16384.0f) * temp_comp) +
-                     (((float)dev->calib.par_h5 / 1048576.0f) * temp_comp * temp_comp))));
-    var3 = (float)dev->calib.par_h6 / 16384.0f;
-    var4 = (float)dev->calib.par_h7 / 2097152.0f;
-    calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
+           (ctx->fh2_262144 *
+            (1.0f + (ctx->fh4_16384 * temp_comp) + (ctx->fh5_1048576 * temp_comp * temp_comp)));
+    calc_hum = var2 + ((ctx->fh6_16384 + (ctx->fh7_2097152 * temp_comp)) * var2 * var2);
     if (calc_hum > 100.0f)
     {
         calc_hum = 100.0f;
@@ -1102,74 +1398,153 @@ static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
     return calc_hum;
 }
 
-/* This internal API is used to calculate the gas resistance low value in float */
-static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
+/* This internal API is used to calculate the gas resistance value in float */
+static float comp_gas_float(uint16_t gas_res_adc,
+                            uint8_t gas_range,
+                            uint8_t variant_id,
+                            const struct bme68x_comp_ctx *ctx)
 {
-    float calc_gas_res;
-    float var1;
-    float var2;
-    float var3;
-    float gas_res_f = gas_res_adc;
-    float gas_range_f = (1U << gas_range); /*lint !e790 / Suspicious truncation, integral to float */
-    const float lookup_k1_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
-    };
-    const float lookup_k2_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
-    };
+    if (variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        int32_t var2 = INT32_C(4096) + ((int32_t)gas_res_adc - INT32_C(512)) * INT32_C(3);
 
-    var1 = (1340.0f + (5.0f * dev->calib.range_sw_err));
-    var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
-    var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
-    calc_gas_res = 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
+        return ctx->fgas_h_num[gas_range] / (float)var2;
+    }
+    else
+    {
+        float gas_res_f = gas_res_adc;
 
-    return calc_gas_res;
+        return 1.0f / (float)(ctx->fgas_l_scale[gas_range] * (((gas_res_f - 512.0f) / ctx->fgas_l_var2[gas_range]) + 1.0f));
+    }
 }
 
-/* This internal API is used to calculate the gas resistance value in float */
-static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
+/* This internal API is used to compensate one field with the float formulas */
+static void comp_field_float(const struct field_adc *adc,
+                             uint8_t variant_id,
+                             const struct bme68x_comp_ctx *ctx,
+                             struct bme68x_data *data)
 {
-    float calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
-    int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
+    float t_fine;
 
-    var2 *= INT32_C(3);
-    var2 = INT32_C(4096) + var2;
+    data->temperature = comp_temperature_float(adc->temp, ctx, &t_fine);
+    data->pressure = comp_pressure_float(adc->pres, t_fine, ctx);
+    data->humidity = comp_humidity_float(adc->hum, data->temperature, ctx);
+    data->gas_resistance = comp_gas_float(adc->gas, adc->gas_range, variant_id, ctx);
+}
+#endif
 
-    calc_gas_res = 1000000.0f * (float)var1 / (float)var2;
+/* This internal API is used to unpack the status and ADC values of a field */
+static void parse_field(const uint8_t *buff, uint8_t variant_id, struct bme68x_data *data, struct field_adc *adc)
+{
+    /* The BME688 reports gas in the second pair of gas registers */
+    uint8_t gas = (variant_id == BME68X_VARIANT_GAS_HIGH) ? 15 : 13;
+
+    data->status = buff[0] & BME68X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+    data->status |= buff[gas + 1] & BME68X_GASM_VALID_MSK;
+    data->status |= buff[gas + 1] & BME68X_HEAT_STAB_MSK;
+
+    /* read the raw data from the sensor */
+    adc->pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
+    adc->temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
+    adc->hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
+    adc->gas = (uint16_t)((uint32_t)buff[gas] * 4 | (((uint32_t)buff[gas + 1]) / 64));
+    adc->gas_range = buff[gas + 1] & BME68X_GAS_RANGE_MSK;
+}
 
-    return calc_gas_res;
+/* This internal API is used to compensate a parsed field */
+static void compensate_field(const struct field_adc *adc,
+                             uint8_t variant_id,
+                             const struct bme68x_comp_ctx *ctx,
+                             struct bme68x_data *data)
+{
+#ifdef BME68X_USE_FPU
+    if (ctx->mode == BME68X_COMP_FLOAT)
+    {
+        comp_field_float(adc, variant_id, ctx, data);
+
+        return;
+    }
+
+#endif
+    comp_field_int(adc, variant_id, ctx, data);
 }
 
-/* This internal API is used to calculate the heater resistance value using float */
-static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
+/* This internal API is used to compensate a block of unpacked fields with the integer formulas */
+static void comp_block_int(const struct field_block *blk,
+                           uint32_t n,
+                           uint8_t variant_id,
+                           const struct bme68x_comp_ctx *ctx,
+                           const struct bme68x_data_soa *out)
 {
-    float var1;
-    float var2;
-    float var3;
-    float var4;
-    float var5;
-    uint8_t res_heat;
+    int32_t t_fine[BME68X_BATCH_BLOCK];
+    uint32_t i;
 
-    if (temp > 400) /* Cap temperature */
+    /* One loop per quantity, so each runs over contiguous inputs and outputs */
+    for (i = 0; i < n; i++)
     {
-        temp = 400;
+#ifdef BME68X_USE_FPU
+        out->temperature[i] = (float)comp_temperature_int(blk->temp[i], ctx, &t_fine[i]) / 100.0f;
+#else
+        out->temperature[i] = comp_temperature_int(blk->temp[i], ctx, &t_fine[i]);
+#endif
     }
 
-    var1 = (((float)dev->calib.par_gh1 / (16.0f)) + 49.0f);
-    var2 = ((((float)dev->calib.par_gh2 / (32768.0f)) * (0.0005f)) + 0.00235f);
-    var3 = ((float)dev->calib.par_gh3 / (1024.0f));
-    var4 = (var1 * (1.0f + (var2 * (float)temp)));
-    var5 = (var4 + (var3 * (float)dev->amb_temp));
-    res_heat =
-        (uint8_t)(3.4f *
-                  ((var5 * (4 / (4 + (float)dev->calib.res_heat_range)) *
-                    (1 / (1 + ((float)dev->calib.res_heat_val * 0.002f)))) -
-                   25));
+    for (i = 0; i < n; i++)
+    {
+#ifdef BME68X_USE_FPU
+        out->pressure[i] = (float)comp_pressure_int(blk->pres[i], t_fine[i], ctx);
+        out->humidity[i] = (float)comp_humidity_int(blk->hum[i], t_fine[i], ctx) / 1000.0f;
+#else
+        out->pressure[i] = comp_pressure_int(blk->pres[i], t_fine[i], ctx);
+        out->humidity[i] = comp_humidity_int(blk->hum[i], t_fine[i], ctx);
+#endif
+    }
 
-    return res_heat;
+    for (i = 0; i < n; i++)
+    {
+#ifdef BME68X_USE_FPU
+        out->gas_resistance[i] = (float)comp_gas_int(blk->gas[i], blk->gas_range[i], variant_id, ctx);
+#else
+        out->gas_resistance[i] = comp_gas_int(blk->gas[i], blk->gas_range[i], variant_id, ctx);
+#endif
+    }
 }
 
+#ifdef BME68X_USE_FPU
+
+/* This internal API is used to compensate a block of unpacked fields with the float formulas */
+static void comp_block_float(const struct field_block *blk,
+                             uint32_t n,
+                             uint8_t variant_id,
+                             const struct bme68x_comp_ctx *ctx,
+                             const struct bme68x_data_soa *out)
+{
+    float t_fine[BME68X_BATCH_BLOCK];
+    uint32_t i;
+
+    /* One loop per quantity, so each runs over contiguous inputs and outputs */
+    for (i = 0; i < n; i++)
+    {
+        out->temperature[i] = comp_temperature_float(blk->temp[i], ctx, &t_fine[i]);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        out->pressure[i] = comp_pressure_float(blk->pres[i], t_fine[i], ctx);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        out->humidity[i] = comp_humidity_float(blk->hum[i], out->temperature[i], ctx);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        out->gas_resistance[i] = comp_gas_float(blk->gas[i], blk->gas_range[i], variant_id, ctx);
+    }
+}
 #endif
 
 /* This internal API is used to calculate the gas wait */
@@ -1201,11 +1576,7 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
 {
     int8_t rslt = BME68X_OK;
     uint8_t buff[BME68X_LEN_FIELD] = { 0 };
-    uint8_t gas_range_l, gas_range_h;
-    uint32_t adc_temp;
-    uint32_t adc_pres;
-    uint16_t adc_hum;
-    uint16_t adc_gas_res_low, adc_gas_res_high;
+    struct field_adc adc;
     uint8_t tries = 5;
 
     while ((tries) && (rslt == BME68X_OK))
@@ -1220,55 +1591,34 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
             break;
         }
 
-        data->status = buff[0] & BME68X_NEW_DATA_MSK;
-        data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
-        data->meas_index = buff[1];
-
-        /* read the raw data from the sensor */
-        adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
-        adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
-        adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
-        adc_gas_res_low = (uint16_t)((uint32_t)buff[13] * 4 | (((uint32_t)buff[14]) / 64));
-        adc_gas_res_high = (uint16_t)((uint32_t)buff[15] * 4 | (((uint32_t)buff[16]) / 64));
-        gas_range_l = buff[14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-        {
-            data->status |= buff[16] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[16] & BME68X_HEAT_STAB_MSK;
-        }
-        else
-        {
-            data->status |= buff[14] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[14] & BME68X_HEAT_STAB_MSK;
-        }
+        parse_field(buff, (uint8_t)dev->variant_id, data, &adc);
 
         if ((data->status & BME68X_NEW_DATA_MSK) && (rslt == BME68X_OK))
         {
-            rslt = bme68x_get_regs(BME68X_REG_RES_HEAT0 + data->gas_index, &data->res_heat, 1, dev);
-            if (rslt == BME68X_OK)
-            {
-                rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0 + data->gas_index, &data->idac, 1, dev);
-            }
-
-            if (rslt == BME68X_OK)
+            if (dev->heatr_set_valid)
             {
-                rslt = bme68x_get_regs(BME68X_REG_GAS_WAIT0 + data->gas_index, &data->gas_wait, 1, dev);
+                /* Fast path: set-points cached at configuration time */
+                data->idac = dev->heatr_set[data->gas_index];
+                data->res_heat = dev->heatr_set[10 + data->gas_index];
+                data->gas_wait = dev->heatr_set[20 + data->gas_index];
             }
-
-            if (rslt == BME68X_OK)
+            else
             {
-                data->temperature = calc_temperature(adc_temp, dev);
-                data->pressure = calc_pressure(adc_pres, dev);
-                data->humidity = calc_humidity(adc_hum, dev);
-                if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+                rslt = bme68x_get_regs(BME68X_REG_RES_HEAT0 + data->gas_index, &data->res_heat, 1, dev);
+                if (rslt == BME68X_OK)
                 {
-                    data->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+                    rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0 + data->gas_index, &data->idac, 1, dev);
                 }
-                else
+
+                if (rslt == BME68X_OK)
                 {
-                    data->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
+                    rslt = bme68x_get_regs(BME68X_REG_GAS_WAIT0 + data->gas_index, &data->gas_wait, 1, dev);
                 }
+            }
+
+            if (rslt == BME68X_OK)
+            {
+                compensate_field(&adc, (uint8_t)dev->variant_id, &dev->comp, data);
 
                 break;
             }
@@ -1290,13 +1640,9 @@ static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme6
 {
     int8_t rslt = BME68X_OK;
     uint8_t buff[BME68X_LEN_FIELD * 3] = { 0 };
-    uint8_t gas_range_l, gas_range_h;
-    uint32_t adc_temp;
-    uint32_t adc_pres;
-    uint16_t adc_hum;
-    uint16_t adc_gas_res_low, adc_gas_res_high;
-    uint8_t off;
-    uint8_t set_val[30] = { 0 }; /* idac, res_heat, gas_wait */
+    struct field_adc adc;
+    uint8_t set_val[BME68X_LEN_HEATR_SET] = { 0 }; /* idac, res_heat, gas_wait */
+    const uint8_t *set_ptr = set_val;
     uint8_t i;
 
     if (!data[0] && !data[1] && !data[2])
@@ -1309,55 +1655,37 @@ static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme6
         rslt = bme68x_get_regs(BME68X_REG_FIELD0, buff, (uint32_t) BME68X_LEN_FIELD * 3, dev);
     }
 
-    if (rslt == BME68X_OK)
+    if (dev->heatr_set_valid)
+    {
+        set_ptr = dev->heatr_set;
+    }
+    else if (rslt == BME68X_OK)
     {
-        rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, set_val, 30, dev);
+        rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, set_val, BME68X_LEN_HEATR_SET, dev);
     }
 
     for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
     {
-        off = (uint8_t)(i * BME68X_LEN_FIELD);
-        data[i]->status = buff[off] & BME68X_NEW_DATA_MSK;
-        data[i]->gas_index = buff[off] & BME68X_GAS_INDEX_MSK;
-        data[i]->meas_index = buff[off + 1];
-
-        /* read the raw data from the sensor */
-        adc_pres =
-            (uint32_t) (((uint32_t) buff[off + 2] * 4096) | ((uint32_t) buff[off + 3] * 16) |
-                        ((uint32_t) buff[off + 4] / 16));
-        adc_temp =
-            (uint32_t) (((uint32_t) buff[off + 5] * 4096) | ((uint32_t) buff[off + 6] * 16) |
-                        ((uint32_t) buff[off + 7] / 16));
-        adc_hum = (uint16_t) (((uint32_t) buff[off + 8] * 256) | (uint32_t) buff[off + 9]);
-        adc_gas_res_low = (uint16_t) ((uint32_t) buff[off + 13] * 4 | (((uint32_t) buff[off + 14]) / 64));
-        adc_gas_res_high = (uint16_t) ((uint32_t) buff[off + 15] * 4 | (((uint32_t) buff[off + 16]) / 64));
-        gas_range_l = buff[off + 14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[off + 16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-        {
-            data[i]->status |= buff[off + 16] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 16] & BME68X_HEAT_STAB_MSK;
-        }
-        else
-        {
-            data[i]->status |= buff[off + 14] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 14] & BME68X_HEAT_STAB_MSK;
-        }
+        parse_field(&buff[i * BME68X_LEN_FIELD], (uint8_t)dev->variant_id, data[i], &adc);
+        data[i]->idac = set_ptr[data[i]->gas_index];
+        data[i]->res_heat = set_ptr[10 + data[i]->gas_index];
+        data[i]->gas_wait = set_ptr[20 + data[i]->gas_index];
+        compensate_field(&adc, (uint8_t)dev->variant_id, &dev->comp, data[i]);
+    }
 
-        data[i]->idac = set_val[data[i]->gas_index];
-        data[i]->res_heat = set_val[10 + data[i]->gas_index];
-        data[i]->gas_wait = set_val[20 + data[i]->gas_index];
-        data[i]->temperature = calc_temperature(adc_temp, dev);
-        data[i]->pressure = calc_pressure(adc_pres, dev);
-        data[i]->humidity = calc_humidity(adc_hum, dev);
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-        {
-            data[i]->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
-        }
-        else
-        {
-            data[i]->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
-        }
+    return rslt;
+}
+
+/* This internal API is used to cache the heater set-point registers */
+static int8_t read_heatr_set(struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    dev->heatr_set_valid = 0;
+    rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, dev->heatr_set, BME68X_LEN_HEATR_SET, dev);
+    if (rslt == BME68X_OK)
+    {
+        dev->heatr_set_valid = 1;
     }
 
     return rslt;
@@ -1834,6 +2162,12 @@ static int8_t get_calib_data(struct bme68x_dev *dev)
         dev->calib.res_heat_range = ((coeff_array[BME68X_IDX_RES_HEAT_RANGE] & BME68X_RHRANGE_MSK) / 16);
         dev->calib.res_heat_val = (int8_t)coeff_array[BME68X_IDX_RES_HEAT_VAL];
         dev->calib.range_sw_err = ((int8_t)(coeff_array[BME68X_IDX_RANGE_SW_ERR] & BME68X_RSERROR_MSK)) / 16;
+
+        /* Derive the compensation constants once; a mode set before a re-init is kept */
+        if (bme68x_calc_comp_ctx(&dev->calib, dev->comp.mode, &dev->comp) != BME68X_OK)
+        {
+            (void)bme68x_calc_comp_ctx(&dev->calib, BME68X_COMP_DEFAULT, &dev->comp);
+        }
     }
 
     return rslt;
@@ -225,6 +225,97 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
  */
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_calc_comp_ctx bme68x_calc_comp_ctx
+ * \code
+ * int8_t bme68x_calc_comp_ctx(const struct bme68x_calib_data *calib, uint8_t comp_mode, struct bme68x_comp_ctx *ctx);
+ * \endcode
+ * @details This API derives the compensation constants from the calibration
+ * coefficients. bme68x_init() does this for bme68x_dev.comp; call it directly
+ * to compensate logged fields with bme68x_compensate_field().
+ *
+ * @param[in]  calib     : Calibration coefficients of the sensor.
+ * @param[in]  comp_mode : BME68X_COMP_FLOAT or BME68X_COMP_INT.
+ * @param[out] ctx       : Compensation constants.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail (BME68X_E_COMP_MODE: float path not built)
+ */
+int8_t bme68x_calc_comp_ctx(const struct bme68x_calib_data *calib, uint8_t comp_mode, struct bme68x_comp_ctx *ctx);
+
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_set_comp_mode bme68x_set_comp_mode
+ * \code
+ * int8_t bme68x_set_comp_mode(uint8_t comp_mode, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API selects the float or integer compensation formulas for
+ * bme68x_get_data(). The integer path gives the BME68X_DO_NOT_USE_FPU
+ * results, converted to the float units of bme68x_data.
+ *
+ * @param[in]  comp_mode : BME68X_COMP_FLOAT or BME68X_COMP_INT.
+ * @param[in,out] dev    : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail (BME68X_E_COMP_MODE: float path not built)
+ */
+int8_t bme68x_set_comp_mode(uint8_t comp_mode, struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_compensate_field bme68x_compensate_field
+ * \code
+ * int8_t bme68x_compensate_field(const uint8_t *field, uint8_t variant_id, const struct bme68x_comp_ctx *ctx, struct bme68x_data *data);
+ * \endcode
+ * @details This API compensates one raw data field, as read from
+ * BME68X_REG_FIELD0, without any bus access. The heater set-points in
+ * data are cleared.
+ *
+ * @param[in]  field      : BME68X_LEN_FIELD bytes of field registers.
+ * @param[in]  variant_id : BME68X_VARIANT_GAS_LOW or BME68X_VARIANT_GAS_HIGH.
+ * @param[in]  ctx        : Compensation constants of the sensor.
+ * @param[out] data       : Structure instance to hold the data.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_compensate_field(const uint8_t *field,
+                               uint8_t variant_id,
+                               const struct bme68x_comp_ctx *ctx,
+                               struct bme68x_data *data);
+
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_compensate_batch bme68x_compensate_batch
+ * \code
+ * int8_t bme68x_compensate_batch(const uint8_t *fields, uint32_t n_fields, uint8_t variant_id, const struct bme68x_comp_ctx *ctx, const struct bme68x_data_soa *out);
+ * \endcode
+ * @details This API compensates n_fields raw data fields stored back to back
+ * (BME68X_LEN_FIELD bytes each) with the same arithmetic as bme68x_get_data(),
+ * without any bus access. Results go to one array per quantity, which keeps
+ * the inner loops contiguous for the compiler to vectorize. Separate calls on
+ * disjoint ranges may run concurrently with the same ctx.
+ *
+ * @param[in]  fields     : Raw field records.
+ * @param[in]  n_fields   : Number of records; each out array holds as many.
+ * @param[in]  variant_id : BME68X_VARIANT_GAS_LOW or BME68X_VARIANT_GAS_HIGH.
+ * @param[in]  ctx        : Compensation constants of the sensor.
+ * @param[out] out        : Output arrays; status and gas_index may be NULL.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_compensate_batch(const uint8_t *fields,
+                               uint32_t n_fields,
+                               uint8_t variant_id,
+                               const struct bme68x_comp_ctx *ctx,
+                               const struct bme68x_data_soa *out);
+
 /**
  * \ingroup bme68x
  * \defgroup bme68xApiConfig Configuration
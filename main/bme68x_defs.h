@@ -132,6 +132,9 @@
 /* Self test fail error */
 #define BME68X_E_SELF_TEST                        INT8_C(-5)
 
+/* Compensation mode not available in this build */
+#define BME68X_E_COMP_MODE                        INT8_C(-6)
+
 /* Warnings */
 /* Define a valid operation mode */
 #define BME68X_W_DEFINE_OP_MODE                   INT8_C(1)
@@ -291,6 +294,26 @@
 /* No standby time */
 #define BME68X_ODR_NONE                           UINT8_C(8)
 
+/* Compensation mode macros */
+
+/* Floating point compensation (requires BME68X_USE_FPU) */
+#define BME68X_COMP_FLOAT                         UINT8_C(0)
+
+/* Integer compensation, as in BME68X_DO_NOT_USE_FPU builds */
+#define BME68X_COMP_INT                           UINT8_C(1)
+
+/* Compensation used until bme68x_set_comp_mode() selects another */
+#ifdef BME68X_USE_FPU
+#define BME68X_COMP_DEFAULT                       BME68X_COMP_FLOAT
+#else
+#define BME68X_COMP_DEFAULT                       BME68X_COMP_INT
+#endif
+
+/* Fields unpacked per pass of bme68x_compensate_batch() */
+#ifndef BME68X_BATCH_BLOCK
+#define BME68X_BATCH_BLOCK                        UINT32_C(32)
+#endif
+
 /* Operating mode macros */
 
 /* Sleep operation mode */
@@ -339,6 +362,9 @@
 /* Length of the interleaved buffer */
 #define BME68X_LEN_INTERLEAVE_BUFF                UINT8_C(20)
 
+/* Length of the heater set-point block (idac, res_heat, gas_wait) */
+#define BME68X_LEN_HEATR_SET                      UINT8_C(30)
+
 /* Coefficient index macros */
 
 /* Coefficient T2 LSB position */
@@ -765,6 +791,46 @@ struct bme68x_data
 
 };
 
+/*
+ * @brief Compensated data of many fields, one array per quantity.
+ * Used by bme68x_compensate_batch(); status and gas_index may be NULL.
+ */
+struct bme68x_data_soa
+{
+    /*! Contains new_data, gasm_valid & heat_stab, per field */
+    uint8_t *status;
+
+    /*! The index of the heater profile used, per field */
+    uint8_t *gas_index;
+#ifndef BME68X_USE_FPU
+
+    /*! Temperature in degree celsius x100 */
+    int16_t *temperature;
+
+    /*! Pressure in Pascal */
+    uint32_t *pressure;
+
+    /*! Humidity in % relative humidity x1000 */
+    uint32_t *humidity;
+
+    /*! Gas resistance in Ohms */
+    uint32_t *gas_resistance;
+#else
+
+    /*! Temperature in degree celsius */
+    float *temperature;
+
+    /*! Pressure in Pascal */
+    float *pressure;
+
+    /*! Humidity in % relative humidity */
+    float *humidity;
+
+    /*! Gas resistance in Ohms */
+    float *gas_resistance;
+#endif
+};
+
 /*
  * @brief Structure to hold the calibration coefficients
  */
@@ -858,6 +924,86 @@ struct bme68x_calib_data
     int8_t range_sw_err;
 };
 
+/*
+ * @brief Compensation constants derived once from the calibration
+ * coefficients, so that compensating a sample only does the arithmetic
+ * that depends on the ADC values
+ */
+struct bme68x_comp_ctx
+{
+    /*! Compensation path. Refer BME68X_COMP_FLOAT / BME68X_COMP_INT */
+    uint8_t mode;
+
+    /*! Integer temperature: par_t1 * 2, par_t2, par_t3 * 16 */
+    int32_t t1_x2;
+    int32_t t2;
+    int32_t t3_x16;
+
+    /*! Integer pressure: par_p3 * 32, par_p4 * 65536, par_p7 * 128, the rest as is */
+    int32_t p1;
+    int32_t p2;
+    int32_t p3_x32;
+    int32_t p4_x65536;
+    int32_t p5;
+    int32_t p6;
+    int32_t p7_x128;
+    int32_t p8;
+    int32_t p9;
+    int32_t p10;
+
+    /*! Integer humidity: par_h1 * 16, par_h6 * 128, the rest as is */
+    int32_t h1_x16;
+    int32_t h2;
+    int32_t h3;
+    int32_t h4;
+    int32_t h5;
+    int32_t h6_x128;
+    int32_t h7;
+
+    /*! Integer gas resistance (low variant): var1 and var3 per gas range */
+    int64_t gas_l_var1[16];
+    int64_t gas_l_var3[16];
+
+    /*! Integer gas resistance (high variant): 10000 * (262144 >> range) */
+    uint32_t gas_h_num[16];
+#ifdef BME68X_USE_FPU
+
+    /*! Float temperature: par_t1 / 1024, par_t1 / 8192, par_t2, par_t3 * 16 */
+    float ft1_1024;
+    float ft1_8192;
+    float ft2;
+    float ft3_x16;
+
+    /*! Float pressure coefficients with their constant scaling applied */
+    float fp1;
+    float fp2;
+    float fp3;
+    float fp4_x65536;
+    float fp5;
+    float fp6_131072;
+    float fp7_x128;
+    float fp8_32768;
+    float fp9;
+    float fp10_131072;
+
+    /*! Float humidity coefficients with their constant scaling applied */
+    float fh1_x16;
+    float fh2_262144;
+    float fh3_2;
+    float fh4_16384;
+    float fh5_1048576;
+    float fh6_16384;
+    float fh7_2097152;
+
+    /*! Float gas resistance (low variant): var2 and var3 * 0.000000125 * 2^range per gas range */
+    float fgas_l_var2[16];
+    float fgas_l_scale[16];
+
+    /*! Float gas resistance (high variant): 1000000 * (262144 >> range) */
+    float fgas_h_num[16];
+#endif
+};
+
 /*
  * @brief BME68X sensor settings structure which comprises of ODR,
  * over-sampling and filter settings.
@@ -952,6 +1098,9 @@ struct bme68x_dev
     /*! Sensor calibration data */
     struct bme68x_calib_data calib;
 
+    /*! Compensation constants derived from calib */
+    struct bme68x_comp_ctx comp;
+
     /*! Read function pointer */
     bme68x_read_fptr_t read;
 
@@ -966,6 +1115,12 @@ struct bme68x_dev
 
     /*! Store the info messages */
     uint8_t info_msg;
+
+    /*! Heater set-points (idac, res_heat, gas_wait) read back by bme68x_set_heatr_conf() */
+    uint8_t heatr_set[BME68X_LEN_HEATR_SET];
+
+    /*! Non-zero while heatr_set matches the sensor registers */
+    uint8_t heatr_set_valid;
 };
 
 #endif /* BME68X_DEFS_H_ */
@@ -0,0 +1,159 @@
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "bsec_interface_multi.h"
+#include "bsec_datatypes.h"
+#include "bsec_config.h"
+
+#include "bsec_state.h"
+
+static const char *TAG = "BSEC_STATE";
+
+#define STATE_MAGIC     0x54534542u     /* "BEST" */
+#define STATE_FORMAT    1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t len;                       /* BSEC blob bytes after the header */
+    uint8_t bsec_version[4];            /* major, minor, major_bugfix, minor_bugfix */
+    uint32_t crc;                       /* CRC-32 of the BSEC blob */
+} state_header_t;
+
+/* Only used under the BSEC lock, so one is enough */
+static uint8_t record[sizeof(state_header_t) + BSEC_MAX_STATE_BLOB_SIZE];
+
+/* ===== HELPERS ===== */
+static uint32_t crc32(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+
+    return ~crc;
+}
+
+static void fill_version(void *inst, uint8_t version[4])
+{
+    bsec_version_t v;
+
+    memset(version, 0, 4);
+    if (bsec_get_version_m(inst, &v) == BSEC_OK) {
+        version[0] = v.major;
+        version[1] = v.minor;
+        version[2] = v.major_bugfix;
+        version[3] = v.minor_bugfix;
+    }
+}
+
+/* ===== API ===== */
+void bsec_state_init(bsec_state_t *st, const sensor_hal_t *hal, void *inst, const char *key, int64_t period_us)
+{
+    memset(st, 0, sizeof(*st));
+    st->hal = hal;
+    st->inst = inst;
+    st->key = key;
+    st->period_us = period_us;
+    st->last_save_us = -1;
+}
+
+int bsec_state_restore(bsec_state_t *st, int64_t now_us)
+{
+    const sensor_hal_t *hal = st->hal;
+    state_header_t header;
+    uint8_t version[4];
+    uint32_t len = sizeof(record);
+
+    if (st->period_us == 0 || hal->blob_load == NULL) {
+        return 0;
+    }
+    if (hal->blob_load(hal->ctx, st->key, record, &len) != SENSOR_HAL_OK) {
+        ESP_LOGI(TAG, "No stored %s, starting calibration from scratch", st->key);
+        return 0;
+    }
+
+    memcpy(&header, record, sizeof(header));
+    const uint8_t *blob = &record[sizeof(header)];
+    fill_version(st->inst, version);
+
+    if (len < sizeof(header) || header.magic != STATE_MAGIC || header.format != STATE_FORMAT ||
+        header.len > BSEC_MAX_STATE_BLOB_SIZE || len != sizeof(header) + header.len) {
+        ESP_LOGW(TAG, "Stored state has an unknown layout, ignoring it");
+        return 0;
+    }
+    if (memcmp(header.bsec_version, version, sizeof(version)) != 0) {
+        ESP_LOGW(TAG, "Stored state is from BSEC %u.%u.%u.%u, ignoring it",
+                 header.bsec_version[0], header.bsec_version[1], header.bsec_version[2], header.bsec_version[3]);
+        return 0;
+    }
+    if (crc32(blob, header.len) != header.crc) {
+        ESP_LOGW(TAG, "Stored state is corrupted, ignoring it");
+        return 0;
+    }
+
+    bsec_library_return_t status = bsec_set_state_m(st->inst, blob, header.len, bsec_work_buffer, sizeof(bsec_work_buffer));
+    if (status != BSEC_OK) {
+        ESP_LOGW(TAG, "bsec_set_state failed: %d", status);
+        return 0;
+    }
+
+    st->restored = 1;
+    st->last_crc = header.crc;
+    st->last_save_us = now_us;
+    ESP_LOGI(TAG, "Restored %u byte %s", (unsigned)header.len, st->key);
+
+    return 1;
+}
+
+int bsec_state_maybe_save(bsec_state_t *st, int64_t now_us, uint8_t iaq_accuracy)
+{
+    const sensor_hal_t *hal = st->hal;
+    state_header_t header;
+    uint32_t n_state = 0;
+
+    if (st->period_us == 0 || hal->blob_save == NULL || iaq_accuracy < 3) {
+        return 0;
+    }
+    if (st->last_save_us >= 0 && now_us - st->last_save_us < st->period_us) {
+        return 0;
+    }
+    st->last_save_us = now_us;
+
+    uint8_t *blob = &record[sizeof(header)];
+    bsec_library_return_t status = bsec_get_state_m(st->inst, 0, blob, BSEC_MAX_STATE_BLOB_SIZE,
+                                                    bsec_work_buffer, sizeof(bsec_work_buffer), &n_state);
+    if (status != BSEC_OK || n_state == 0 || n_state > BSEC_MAX_STATE_BLOB_SIZE) {
+        ESP_LOGW(TAG, "bsec_get_state failed: %d", status);
+        st->stats.failures++;
+        return 0;
+    }
+
+    header.magic = STATE_MAGIC;
+    header.format = STATE_FORMAT;
+    header.len = (uint16_t)n_state;
+    fill_version(st->inst, header.bsec_version);
+    header.crc = crc32(blob, n_state);
+
+    if (st->stats.saves + st->restored > 0 && header.crc == st->last_crc) {
+        st->stats.unchanged++;
+        return 0;
+    }
+
+    memcpy(record, &header, sizeof(header));
+    if (hal->blob_save(hal->ctx, st->key, record, sizeof(header) + n_state) != SENSOR_HAL_OK) {
+        st->stats.failures++;
+        return 0;
+    }
+
+    st->last_crc = header.crc;
+    st->stats.saves++;
+    ESP_LOGI(TAG, "Saved %u byte %s", (unsigned)n_state, st->key);
+
+    return 1;
+}
@@ -0,0 +1,56 @@
+#ifndef BSEC_STATE_H
+#define BSEC_STATE_H
+
+#include <stdint.h>
+
+#include "sensor_hal.h"
+
+/*
+ * Persistence of the BSEC calibration state across resets.
+ *
+ * The blob from bsec_get_state() is kept in the HAL's blob storage behind a
+ * header with a magic, a format version, the BSEC version it came from, its
+ * length and a CRC-32. Saving is wear-aware: nothing is written before IAQ
+ * accuracy reaches 3, then at most once per save period, and a due save is
+ * dropped when the blob is unchanged since the last one.
+ *
+ * Each BSEC instance has its own record under its own key. BSEC is not
+ * reentrant; call these with the pipeline's BSEC lock held.
+ */
+
+/* Key of the first instance; NVS keys are limited to 15 characters */
+#define BSEC_STATE_KEY              "bsec_state"
+
+/* ~6 writes a day: a default 24 KB NVS partition sees a sector erase every
+ * couple of weeks, while a reset loses at most 4 h of calibration */
+#define BSEC_STATE_SAVE_PERIOD_US   (4LL * 3600 * 1000000)
+
+typedef struct {
+    uint32_t saves;
+    uint32_t unchanged;     /* due saves skipped because the blob matched the stored one */
+    uint32_t failures;      /* BSEC or storage errors on save */
+} bsec_state_stats_t;
+
+typedef struct {
+    const sensor_hal_t *hal;
+    void *inst;             /* BSEC instance (bsec_interface_multi.h) */
+    const char *key;
+    int64_t period_us;      /* 0 disables persistence */
+    int64_t last_save_us;   /* -1 until the first save or restore */
+    uint32_t last_crc;
+    uint8_t restored;
+    bsec_state_stats_t stats;
+} bsec_state_t;
+
+void bsec_state_init(bsec_state_t *st, const sensor_hal_t *hal, void *inst, const char *key, int64_t period_us);
+
+/*
+ * Load and apply the stored state. Call after bsec_init_m() and before the
+ * first bsec_do_steps_m(). Returns 1 when a state was applied, 0 otherwise.
+ */
+int bsec_state_restore(bsec_state_t *st, int64_t now_us);
+
+/* Save the current state if due; returns 1 when it was written */
+int bsec_state_maybe_save(bsec_state_t *st, int64_t now_us, uint8_t iaq_accuracy);
+
+#endif
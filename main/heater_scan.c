@@ -0,0 +1,209 @@
+#include <string.h>
+
+#include "bme68x_defs.h"
+
+#include "heater_scan.h"
+
+/* Longest heating time gas_wait_0 can encode (see calc_gas_wait) */
+#define FORCED_MAX_HEATR_MS     4032
+
+/* Forced mode: recheck this soon when a conversion is not done yet */
+#define FORCED_RETRY_US         2000
+
+/* Parallel mode: gas_wait_x holds cycles per step; keep within its 6-bit count */
+#define PARALLEL_MAX_CYCLES     63
+
+const heater_profile_t heater_scan_default_profile = {
+    .temp_c = { 320, 100, 100, 100, 200, 200, 200, 320, 320, 320 },
+    .dur_ms = { 700, 280, 1400, 4200, 700, 700, 700, 700, 700, 700 },
+    .len = 10,
+    .base_ms = 140,
+};
+
+static uint16_t forced_dur_ms(const heater_scan_t *s, uint8_t step)
+{
+    uint16_t dur = s->profile.dur_ms[step];
+    return (dur > FORCED_MAX_HEATR_MS) ? FORCED_MAX_HEATR_MS : dur;
+}
+
+/* Forced mode: set the step's heater and start its conversion */
+static int trigger_step(heater_scan_t *s, int64_t now_us)
+{
+    s->heatr_conf.heatr_temp = s->profile.temp_c[s->step];
+    s->heatr_conf.heatr_dur = forced_dur_ms(s, s->step);
+
+    if (bme68x_set_heatr_conf(BME68X_FORCED_MODE, &s->heatr_conf, s->dev) != BME68X_OK ||
+        bme68x_set_op_mode(BME68X_FORCED_MODE, s->dev) != BME68X_OK) {
+        s->stats.errors++;
+        s->next_poll_us = now_us + FORCED_RETRY_US;
+        return HEATER_SCAN_E_BME;
+    }
+
+    s->next_poll_us = now_us + s->meas_us + (int64_t)s->heatr_conf.heatr_dur * 1000;
+    return HEATER_SCAN_OK;
+}
+
+/* Add one field to the current pass; returns 1 when it completed the pass */
+static int take_field(heater_scan_t *s, const struct bme68x_data *d, uint8_t step, int64_t now_us,
+                      heater_scan_vector_t *vector)
+{
+    heater_scan_vector_t *v = &s->vector;
+    uint16_t bit = (uint16_t)(1u << step);
+
+    s->stats.fields++;
+
+    /* Parallel mode converts every cycle; gas is only measured on a step's last one */
+    if (!(d->status & BME68X_GASM_VALID_MSK) || step >= s->profile.len) {
+        return 0;
+    }
+
+    /* Back at the start, or a step seen twice: the previous pass lost a step */
+    if (step == 0 || (s->seen_mask & bit)) {
+        if (s->seen_mask != 0) {
+            s->stats.incomplete++;
+        }
+        s->seen_mask = 0;
+        v->stable_mask = 0;
+    }
+
+    v->gas_ohm[step] = d->gas_resistance;
+    v->temperature = d->temperature;
+    v->humidity = d->humidity;
+    v->pressure = d->pressure / 100.0f;
+    s->seen_mask |= bit;
+    if (d->status & BME68X_HEAT_STAB_MSK) {
+        v->stable_mask |= bit;
+    }
+
+    if (step != s->profile.len - 1) {
+        return 0;
+    }
+
+    int done = (s->seen_mask == (uint16_t)((1u << s->profile.len) - 1));
+    if (done) {
+        v->timestamp_us = now_us;
+        v->seq = s->stats.vectors++;
+        v->n_steps = s->profile.len;
+        *vector = *v;
+    } else {
+        s->stats.incomplete++;
+    }
+    s->seen_mask = 0;
+    v->stable_mask = 0;
+
+    return done;
+}
+
+int heater_scan_start(heater_scan_t *s, struct bme68x_dev *dev, struct bme68x_conf *conf,
+                      const heater_profile_t *profile, int64_t now_us)
+{
+    if (profile->len == 0 || profile->len > HEATER_SCAN_MAX_STEPS) {
+        return HEATER_SCAN_E_PROFILE;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->dev = dev;
+    s->profile = *profile;
+    s->op_mode = (dev->variant_id == BME68X_VARIANT_GAS_HIGH) ? BME68X_PARALLEL_MODE : BME68X_FORCED_MODE;
+
+    conf->odr = BME68X_ODR_NONE;
+    if (bme68x_set_conf(conf, dev) != BME68X_OK) {
+        return HEATER_SCAN_E_BME;
+    }
+    s->meas_us = bme68x_get_meas_dur(s->op_mode, conf, dev);
+
+    s->heatr_conf.enable = BME68X_ENABLE;
+    s->heatr_conf.heatr_temp_prof = s->temp_prof;
+    s->heatr_conf.heatr_dur_prof = s->dur_prof;
+    s->heatr_conf.profile_len = profile->len;
+    memcpy(s->temp_prof, profile->temp_c, sizeof(s->temp_prof));
+
+    if (s->op_mode == BME68X_FORCED_MODE) {
+        return trigger_step(s, now_us);
+    }
+
+    /* Each cycle is the TPH conversion plus the shared heating time */
+    uint32_t base_us = (uint32_t)profile->base_ms * 1000;
+    if (base_us <= s->meas_us + 1000) {
+        return HEATER_SCAN_E_PROFILE;
+    }
+    s->heatr_conf.shared_heatr_dur = (uint16_t)((base_us - s->meas_us) / 1000);
+
+    for (uint8_t i = 0; i < profile->len; i++) {
+        uint32_t cycles = ((uint32_t)profile->dur_ms[i] + profile->base_ms / 2) / profile->base_ms;
+        s->dur_prof[i] = (uint16_t)((cycles < 1) ? 1 : (cycles > PARALLEL_MAX_CYCLES ? PARALLEL_MAX_CYCLES : cycles));
+    }
+
+    if (bme68x_set_heatr_conf(BME68X_PARALLEL_MODE, &s->heatr_conf, dev) != BME68X_OK ||
+        bme68x_set_op_mode(BME68X_PARALLEL_MODE, dev) != BME68X_OK) {
+        return HEATER_SCAN_E_BME;
+    }
+
+    s->next_poll_us = now_us + base_us;
+    return HEATER_SCAN_OK;
+}
+
+int heater_scan_poll(heater_scan_t *s, int64_t now_us, heater_scan_vector_t *vector)
+{
+    int done = 0;
+
+    if (s->op_mode == BME68X_PARALLEL_MODE) {
+        struct bme68x_data data[3];
+        uint8_t n = 0;
+        int64_t base_us = (int64_t)s->profile.base_ms * 1000;
+
+        /* Up to three fields are buffered, so a late poll loses nothing */
+        if (bme68x_get_data(BME68X_PARALLEL_MODE, data, &n, s->dev) < 0) {
+            s->stats.errors++;
+        }
+        for (uint8_t i = 0; i < n; i++) {
+            done |= take_field(s, &data[i], data[i].gas_index, now_us, vector);
+        }
+
+        s->next_poll_us += base_us;
+        if (s->next_poll_us <= now_us) {
+            s->next_poll_us = now_us + base_us;
+        }
+        return done;
+    }
+
+    struct bme68x_data data;
+    uint8_t n = 0;
+    int8_t rslt = bme68x_get_data(BME68X_FORCED_MODE, &data, &n, s->dev);
+
+    if (rslt < 0) {
+        s->stats.errors++;
+        trigger_step(s, now_us);
+        return HEATER_SCAN_E_BME;
+    }
+    if (n == 0) {
+        s->next_poll_us = now_us + FORCED_RETRY_US;
+        return 0;
+    }
+
+    /* Forced conversions always use heater slot 0, so the step is ours to track */
+    done = take_field(s, &data, s->step, now_us, vector);
+    s->step = (uint8_t)((s->step + 1) % s->profile.len);
+    trigger_step(s, now_us);
+
+    return done;
+}
+
+int64_t heater_scan_next_us(const heater_scan_t *s)
+{
+    return s->next_poll_us;
+}
+
+uint32_t heater_scan_pass_us(const heater_scan_t *s)
+{
+    uint32_t total = 0;
+
+    for (uint8_t i = 0; i < s->profile.len; i++) {
+        if (s->op_mode == BME68X_PARALLEL_MODE) {
+            total += s->dur_prof[i] * (uint32_t)s->profile.base_ms * 1000;
+        } else {
+            total += s->meas_us + (uint32_t)forced_dur_ms(s, i) * 1000;
+        }
+    }
+    return total;
+}
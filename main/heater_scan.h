@@ -0,0 +1,96 @@
+#ifndef HEATER_SCAN_H
+#define HEATER_SCAN_H
+
+#include <stdint.h>
+
+#include "bme68x.h"
+
+/*
+ * Heater profile scanner for one BME68x.
+ *
+ * Instead of BSEC's single forced reading per cycle, the sensor steps its
+ * hot plate through a table of temperatures and reports the gas resistance
+ * at each one. A full pass gives a vector of readings, a fingerprint of the
+ * VOC mix that a single temperature cannot tell apart.
+ *
+ * A BME688 runs the profile by itself in parallel mode: one TPH + gas
+ * conversion every base_ms, with the heater held on each step for a whole
+ * number of those cycles, and the results rotating through its three field
+ * registers. A BME680 has no parallel mode, so the scanner triggers one
+ * forced conversion per step instead.
+ *
+ * heater_scan_poll() reads whatever fields are ready. Call it at
+ * heater_scan_next_us(); it never waits on the sensor.
+ */
+
+#define HEATER_SCAN_MAX_STEPS   10
+
+#define HEATER_SCAN_OK          0
+#define HEATER_SCAN_E_BME      -1
+#define HEATER_SCAN_E_PROFILE  -2
+
+typedef struct {
+    uint16_t temp_c[HEATER_SCAN_MAX_STEPS];
+    uint16_t dur_ms[HEATER_SCAN_MAX_STEPS];     /* time at each temperature */
+    uint8_t len;
+    uint16_t base_ms;       /* parallel mode: one conversion every base_ms */
+} heater_profile_t;
+
+/* One pass through the profile */
+typedef struct {
+    int64_t timestamp_us;   /* when the last step was read */
+    uint32_t seq;
+    float temperature;      /* degC, from the last step */
+    float humidity;         /* %RH */
+    float pressure;         /* hPa */
+    uint8_t n_steps;
+    uint16_t stable_mask;   /* steps whose heater reached its target (heat_stab) */
+    float gas_ohm[HEATER_SCAN_MAX_STEPS];
+} heater_scan_vector_t;
+
+typedef struct {
+    uint32_t vectors;
+    uint32_t fields;        /* TPH conversions read, with or without gas */
+    uint32_t incomplete;    /* passes missing a step, dropped */
+    uint32_t errors;        /* bus errors */
+} heater_scan_stats_t;
+
+typedef struct {
+    struct bme68x_dev *dev;
+    heater_profile_t profile;
+    uint8_t op_mode;        /* BME68X_PARALLEL_MODE or BME68X_FORCED_MODE */
+
+    /* Driver heater tables: temperatures and, in parallel mode, cycles per step */
+    uint16_t temp_prof[HEATER_SCAN_MAX_STEPS];
+    uint16_t dur_prof[HEATER_SCAN_MAX_STEPS];
+    struct bme68x_heatr_conf heatr_conf;
+    uint32_t meas_us;       /* TPH part of a conversion */
+
+    uint8_t step;           /* forced mode: step being converted */
+    uint16_t seen_mask;     /* steps of the current pass read so far */
+    int64_t next_poll_us;
+
+    heater_scan_vector_t vector;
+    heater_scan_stats_t stats;
+} heater_scan_t;
+
+/* The driver example profile (HP-354): 10 steps, about 11 s per pass */
+extern const heater_profile_t heater_scan_default_profile;
+
+/*
+ * Configure `dev` (already initialized by bme68x_init) with `conf` and start
+ * the profile. Parallel mode is used when the sensor is a BME688.
+ */
+int heater_scan_start(heater_scan_t *s, struct bme68x_dev *dev, struct bme68x_conf *conf,
+                      const heater_profile_t *profile, int64_t now_us);
+
+/* Read the finished steps; returns 1 and fills `vector` when a pass completed, else 0 or an error */
+int heater_scan_poll(heater_scan_t *s, int64_t now_us, heater_scan_vector_t *vector);
+
+/* When the next step is due to be read */
+int64_t heater_scan_next_us(const heater_scan_t *s);
+
+/* Expected time for one pass, from the profile and the TPH settings */
+uint32_t heater_scan_pass_us(const heater_scan_t *s);
+
+#endif
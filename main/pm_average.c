@@ -0,0 +1,159 @@
+#include <string.h>
+
+#include "pm_average.h"
+
+#define US_PER_MINUTE   60000000LL
+#define HOUR_SLOTS      (PM_AVERAGE_HOURS + 1)
+
+static pm_average_bucket_t *hour_bucket(pm_average_t *a, int64_t hour)
+{
+    return &a->hour[((hour % HOUR_SLOTS) + HOUR_SLOTS) % HOUR_SLOTS];
+}
+
+void pm_average_init(pm_average_t *a)
+{
+    memset(a, 0, sizeof(*a));
+    a->minute_now = -1;
+    a->hour_now = -1;
+
+    for (int p = 0; p < AQI_N_POLLUTANTS; p++) {
+        a->values.mean_1h[p] = -1.0f;
+        a->values.mean_24h[p] = -1.0f;
+        a->values.nowcast[p] = -1.0f;
+    }
+}
+
+/* ===== HOURLY VALUES ===== */
+/* Average of the hour `ago` hours before the current one; 0 if it has too little data */
+static int hourly_average(pm_average_t *a, int64_t ago, uint8_t pollutant, float *avg)
+{
+    const pm_average_bucket_t *b = hour_bucket(a, a->hour_now - ago);
+
+    if (ago > a->hour_now || b->minutes < PM_AVERAGE_MIN_MINUTES) {
+        return 0;
+    }
+    *avg = (float)b->sum[pollutant] / (float)b->count;
+    return 1;
+}
+
+static float nowcast(pm_average_t *a, uint8_t pollutant)
+{
+    float c[PM_AVERAGE_NOWCAST_HOURS];
+    uint8_t valid[PM_AVERAGE_NOWCAST_HOURS];
+    float lo = 0.0f, hi = 0.0f;
+    int recent = 0;
+    int any = 0;
+
+    for (int i = 0; i < PM_AVERAGE_NOWCAST_HOURS; i++) {
+        valid[i] = (uint8_t)hourly_average(a, i + 1, pollutant, &c[i]);
+        if (!valid[i]) {
+            continue;
+        }
+        recent += (i < 3);
+        lo = (!any || c[i] < lo) ? c[i] : lo;
+        hi = (!any || c[i] > hi) ? c[i] : hi;
+        any = 1;
+    }
+    if (recent < PM_AVERAGE_NOWCAST_RECENT) {
+        return -1.0f;
+    }
+
+    float w = (hi > 0.0f) ? lo / hi : 1.0f;
+    w = (w < 0.5f) ? 0.5f : w;
+
+    float weight = 1.0f, num = 0.0f, den = 0.0f;
+    for (int i = 0; i < PM_AVERAGE_NOWCAST_HOURS; i++) {
+        if (valid[i]) {
+            num += weight * c[i];
+            den += weight;
+        }
+        weight *= w;
+    }
+    return num / den;
+}
+
+static float mean_24h(pm_average_t *a, uint8_t pollutant)
+{
+    float sum = 0.0f;
+    int hours = 0;
+
+    for (int i = 1; i <= PM_AVERAGE_HOURS; i++) {
+        float c;
+        if (hourly_average(a, i, pollutant, &c)) {
+            sum += c;
+            hours++;
+        }
+    }
+    return (hours >= PM_AVERAGE_MIN_HOURS) ? sum / (float)hours : -1.0f;
+}
+
+/* ===== WINDOWS ===== */
+static void drop_minute(pm_average_t *a, pm_average_bucket_t *b)
+{
+    for (int p = 0; p < AQI_N_POLLUTANTS; p++) {
+        a->window_sum[p] -= b->sum[p];
+    }
+    a->window_count -= b->count;
+    a->window_minutes -= (b->count > 0);
+    memset(b, 0, sizeof(*b));
+}
+
+static void advance(pm_average_t *a, int64_t minute)
+{
+    if (a->minute_now < 0) {
+        a->minute_now = minute;
+        a->hour_now = minute / 60;
+        return;
+    }
+    if (minute <= a->minute_now) {
+        return;
+    }
+
+    /* After a gap of an hour or more every bucket is dropped once */
+    for (int64_t m = a->minute_now + 1; m <= minute && m <= a->minute_now + PM_AVERAGE_MINUTES; m++) {
+        drop_minute(a, &a->minute[m % PM_AVERAGE_MINUTES]);
+    }
+    a->minute_now = minute;
+
+    int64_t hour = minute / 60;
+    if (hour == a->hour_now) {
+        return;
+    }
+    for (int64_t h = a->hour_now + 1; h <= hour && h <= a->hour_now + HOUR_SLOTS; h++) {
+        memset(hour_bucket(a, h), 0, sizeof(pm_average_bucket_t));
+    }
+    a->hour_now = hour;
+
+    for (uint8_t p = 0; p < AQI_N_POLLUTANTS; p++) {
+        a->values.mean_24h[p] = mean_24h(a, p);
+        a->values.nowcast[p] = nowcast(a, p);
+    }
+}
+
+void pm_average_update(pm_average_t *a, int64_t timestamp_us, const uint16_t pm[AQI_N_POLLUTANTS])
+{
+    advance(a, timestamp_us / US_PER_MINUTE);
+
+    if (pm != NULL) {
+        pm_average_bucket_t *m = &a->minute[a->minute_now % PM_AVERAGE_MINUTES];
+        pm_average_bucket_t *h = hour_bucket(a, a->hour_now);
+
+        if (m->count == 0) {
+            a->window_minutes++;
+            h->minutes++;
+        }
+        for (int p = 0; p < AQI_N_POLLUTANTS; p++) {
+            m->sum[p] += pm[p];
+            h->sum[p] += pm[p];
+            a->window_sum[p] += pm[p];
+        }
+        m->count++;
+        h->count++;
+        a->window_count++;
+    }
+
+    for (int p = 0; p < AQI_N_POLLUTANTS; p++) {
+        a->values.mean_1h[p] = (a->window_minutes >= PM_AVERAGE_MIN_MINUTES) ?
+                               (float)a->window_sum[p] / (float)a->window_count : -1.0f;
+    }
+}
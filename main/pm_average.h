@@ -0,0 +1,78 @@
+#ifndef PM_AVERAGE_H
+#define PM_AVERAGE_H
+
+#include <stdint.h>
+
+#include "aqi.h"
+
+/*
+ * Rolling PM averages for the AQI: a 1 hour mean, a 24 hour mean and the
+ * EPA NowCast, kept up to date from each reading.
+ *
+ * Readings are summed into per-minute and per-hour buckets on the sample
+ * timestamps; nothing is rescanned per sample. The 1 hour mean keeps
+ * running totals over the last 60 minute buckets, the current one
+ * included, and subtracts a bucket as it falls out. The 24 hour mean and
+ * the NowCast only change when an hour completes, so they are worked out
+ * from the hourly averages then and held until the next hour. A reading
+ * costs a few additions; a minute rollover one bucket, an hour rollover a
+ * pass over 24 hourly averages.
+ *
+ * As in the EPA rules, an hour counts with readings in at least 45 of its
+ * minutes, the 1 hour mean needs 45 of the last 60 minutes, the 24 hour
+ * mean 18 of the last 24 completed hours, and the NowCast 2 of the last 3.
+ *
+ * NowCast (PM): of the last 12 completed hourly averages c1 (newest) to
+ * c12, w = max(min / max, 0.5), and NowCast = sum(w^(i-1) ci) / sum(w^(i-1))
+ * over the hours with data. Steady air weighs all 12 hours alike; when the
+ * air changes, the weight shifts to the last few.
+ *
+ * The buckets are on the boot clock and start empty, so after a reset the
+ * means are back after 45 minutes and 2 hours.
+ */
+
+#define PM_AVERAGE_MINUTES          60
+#define PM_AVERAGE_HOURS            24
+#define PM_AVERAGE_NOWCAST_HOURS    12
+
+#define PM_AVERAGE_MIN_MINUTES      45  /* of an hour, or of the last 60 minutes */
+#define PM_AVERAGE_MIN_HOURS        18  /* of the last 24 */
+#define PM_AVERAGE_NOWCAST_RECENT   2   /* of the last 3 hours */
+
+/* ug/m3 per pollutant (AQI_POLLUTANT_*), -1 without enough data */
+typedef struct {
+    float mean_1h[AQI_N_POLLUTANTS];
+    float mean_24h[AQI_N_POLLUTANTS];
+    float nowcast[AQI_N_POLLUTANTS];
+} pm_average_values_t;
+
+typedef struct {
+    uint32_t sum[AQI_N_POLLUTANTS];
+    uint32_t count;
+    uint32_t minutes;       /* hour buckets: minutes with readings */
+} pm_average_bucket_t;
+
+typedef struct {
+    pm_average_bucket_t minute[PM_AVERAGE_MINUTES];
+    pm_average_bucket_t hour[PM_AVERAGE_HOURS + 1];     /* the completed hours and the current one */
+    int64_t minute_now;     /* minutes since boot of the current bucket, -1 before the first update */
+    int64_t hour_now;
+
+    /* Totals over the minute buckets */
+    uint32_t window_sum[AQI_N_POLLUTANTS];
+    uint32_t window_count;
+    uint32_t window_minutes;
+
+    pm_average_values_t values;
+} pm_average_t;
+
+void pm_average_init(pm_average_t *a);
+
+/*
+ * Move the windows to `timestamp_us` and add the reading `pm`, indexed by
+ * AQI_POLLUTANT_* (NULL: none this time, the windows only move on). A
+ * timestamp before the last one counts as the last one.
+ */
+void pm_average_update(pm_average_t *a, int64_t timestamp_us, const uint16_t pm[AQI_N_POLLUTANTS]);
+
+#endif
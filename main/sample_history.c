@@ -0,0 +1,271 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sample_history.h"
+
+const char *const sample_history_metric_names[SAMPLE_HISTORY_N_METRICS] = {
+    "temperature", "humidity", "pressure", "iaq", "pm1_0", "pm2_5", "pm10", "aqi",
+};
+
+const char *const sample_history_tier_names[SAMPLE_HISTORY_N_TIERS] = {
+    "raw", "1m", "15m", "1h",
+};
+
+const float sample_history_scale[SAMPLE_HISTORY_N_METRICS] = {
+    100.0f, 100.0f, 10.0f, 10.0f, 1.0f, 1.0f, 1.0f, 10.0f,
+};
+
+const uint32_t sample_history_period_ms[SAMPLE_HISTORY_N_TIERS] = {
+    0, 60000, 15 * 60000, 60 * 60000,
+};
+
+/* ===== HELPERS ===== */
+static int16_t to_fixed(float value, sample_history_metric_t m)
+{
+    float v = roundf(value * sample_history_scale[m]);
+
+    if (!(v > INT16_MIN)) {     /* also NaN */
+        return INT16_MIN;
+    }
+    return (v < INT16_MAX) ? (int16_t)v : INT16_MAX;
+}
+
+void sample_history_values(const sensor_sample_t *s, int16_t value[SAMPLE_HISTORY_N_METRICS])
+{
+    value[SAMPLE_HISTORY_TEMPERATURE] = to_fixed(s->temperature, SAMPLE_HISTORY_TEMPERATURE);
+    value[SAMPLE_HISTORY_HUMIDITY] = to_fixed(s->humidity, SAMPLE_HISTORY_HUMIDITY);
+    value[SAMPLE_HISTORY_PRESSURE] = to_fixed(s->pressure, SAMPLE_HISTORY_PRESSURE);
+    value[SAMPLE_HISTORY_IAQ] = to_fixed(s->iaq, SAMPLE_HISTORY_IAQ);
+    value[SAMPLE_HISTORY_PM1_0] = to_fixed(s->pm1_0, SAMPLE_HISTORY_PM1_0);
+    value[SAMPLE_HISTORY_PM2_5] = to_fixed(s->pm2_5, SAMPLE_HISTORY_PM2_5);
+    value[SAMPLE_HISTORY_PM10] = to_fixed(s->pm10, SAMPLE_HISTORY_PM10);
+    value[SAMPLE_HISTORY_AQI] = to_fixed(s->aqi, SAMPLE_HISTORY_AQI);
+}
+
+static int is_pow2(uint32_t n)
+{
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+static uint32_t ring_slot(const sample_history_ring_t *r, uint32_t i)
+{
+    /* i-th entry held, 0 is the oldest */
+    return (r->head - r->count + i) & r->mask;
+}
+
+static void raw_to_point(const sample_history_raw_t *raw, sample_history_point_t *point)
+{
+    point->timestamp_ms = raw->timestamp_ms;
+    point->count = 1;
+    memcpy(point->min, raw->value, sizeof(point->min));
+    memcpy(point->mean, raw->value, sizeof(point->mean));
+    memcpy(point->max, raw->value, sizeof(point->max));
+}
+
+static void acc_to_point(const sample_history_acc_t *acc, uint32_t period_ms, sample_history_point_t *point)
+{
+    point->timestamp_ms = acc->index * (int64_t)period_ms;
+    point->count = acc->count;
+    for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+        /* Rounded to nearest, halves away from zero */
+        int32_t half = (acc->sum[m] < 0) ? -(acc->count / 2) : acc->count / 2;
+        point->min[m] = acc->min[m];
+        point->mean[m] = (int16_t)((acc->sum[m] + half) / acc->count);
+        point->max[m] = acc->max[m];
+    }
+}
+
+static int64_t entry_time(const sample_history_ring_t *r, sample_history_tier_t tier, uint32_t i)
+{
+    uint32_t slot = ring_slot(r, i);
+
+    if (tier == SAMPLE_HISTORY_RAW) {
+        return ((const sample_history_raw_t *)r->storage)[slot].timestamp_ms;
+    }
+    return ((const sample_history_point_t *)r->storage)[slot].timestamp_ms;
+}
+
+/* First entry at or after t_ms; entries are in time order */
+static uint32_t lower_bound(const sample_history_ring_t *r, sample_history_tier_t tier, int64_t t_ms)
+{
+    uint32_t lo = 0;
+    uint32_t hi = r->count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (entry_time(r, tier, mid) < t_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* ===== APPEND ===== */
+static void rollup_add(sample_history_ring_t *r, uint32_t period_ms, int64_t t_ms,
+                       const int16_t value[SAMPLE_HISTORY_N_METRICS])
+{
+    sample_history_acc_t *acc = &r->acc;
+    int64_t index = t_ms / period_ms;
+
+    if (acc->count > 0 && (index != acc->index || acc->count == UINT16_MAX)) {
+        sample_history_point_t *slot = (sample_history_point_t *)r->storage + (r->head & r->mask);
+        acc_to_point(acc, period_ms, slot);
+        r->head++;
+        if (r->count <= r->mask) {
+            r->count++;
+        }
+        acc->count = 0;
+    }
+
+    if (acc->count == 0) {
+        acc->index = index;
+        for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+            acc->min[m] = value[m];
+            acc->max[m] = value[m];
+            acc->sum[m] = value[m];
+        }
+        acc->count = 1;
+        return;
+    }
+
+    for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+        if (value[m] < acc->min[m]) {
+            acc->min[m] = value[m];
+        }
+        if (value[m] > acc->max[m]) {
+            acc->max[m] = value[m];
+        }
+        acc->sum[m] += value[m];
+    }
+    acc->count++;
+}
+
+/* ===== PUBLIC API ===== */
+int sample_history_init(sample_history_t *h, const sample_history_storage_t *storage)
+{
+    memset(h, 0, sizeof(*h));
+
+    if (!is_pow2(storage->raw_len)) {
+        return -1;
+    }
+    h->tiers[SAMPLE_HISTORY_RAW].storage = storage->raw;
+    h->tiers[SAMPLE_HISTORY_RAW].mask = storage->raw_len - 1;
+
+    for (int t = SAMPLE_HISTORY_1M; t < SAMPLE_HISTORY_N_TIERS; t++) {
+        if (!is_pow2(storage->rollup_len[t])) {
+            return -1;
+        }
+        h->tiers[t].storage = storage->rollup[t];
+        h->tiers[t].mask = storage->rollup_len[t] - 1;
+    }
+
+    return 0;
+}
+
+void sample_history_append(sample_history_t *h, const sensor_sample_t *sample)
+{
+    sample_history_ring_t *raw_ring = &h->tiers[SAMPLE_HISTORY_RAW];
+    sample_history_raw_t *raw = (sample_history_raw_t *)raw_ring->storage + (raw_ring->head & raw_ring->mask);
+    int64_t t_ms = sample->timestamp_us / 1000;
+
+    raw->timestamp_ms = t_ms;
+    sample_history_values(sample, raw->value);
+    raw_ring->head++;
+    if (raw_ring->count <= raw_ring->mask) {
+        raw_ring->count++;
+    }
+
+    for (int t = SAMPLE_HISTORY_1M; t < SAMPLE_HISTORY_N_TIERS; t++) {
+        rollup_add(&h->tiers[t], sample_history_period_ms[t], t_ms, raw->value);
+    }
+    h->appended++;
+}
+
+uint32_t sample_history_query(const sample_history_t *h, sample_history_tier_t tier, int64_t from_ms,
+                              int64_t to_ms, sample_history_point_t *out, uint32_t max)
+{
+    const sample_history_ring_t *r = &h->tiers[tier];
+    uint32_t n = 0;
+
+    for (uint32_t i = lower_bound(r, tier, from_ms); i < r->count && n < max; i++) {
+        uint32_t slot = ring_slot(r, i);
+
+        if (entry_time(r, tier, i) >= to_ms) {
+            return n;
+        }
+        if (tier == SAMPLE_HISTORY_RAW) {
+            raw_to_point((const sample_history_raw_t *)r->storage + slot, &out[n]);
+        } else {
+            out[n] = ((const sample_history_point_t *)r->storage)[slot];
+        }
+        n++;
+    }
+
+    if (tier != SAMPLE_HISTORY_RAW && r->acc.count > 0 && n < max) {
+        int64_t start = r->acc.index * (int64_t)sample_history_period_ms[tier];
+        if (start >= from_ms && start < to_ms) {
+            acc_to_point(&r->acc, sample_history_period_ms[tier], &out[n++]);
+        }
+    }
+
+    return n;
+}
+
+sample_history_tier_t sample_history_tier_for(const sample_history_t *h, int64_t from_ms)
+{
+    for (int t = SAMPLE_HISTORY_RAW; t < SAMPLE_HISTORY_1H; t++) {
+        const sample_history_ring_t *r = &h->tiers[t];
+        /* A ring that has not wrapped yet holds everything since boot */
+        if (r->count == r->head || (r->count > 0 && entry_time(r, t, 0) <= from_ms)) {
+            return (sample_history_tier_t)t;
+        }
+    }
+    return SAMPLE_HISTORY_1H;
+}
+
+uint32_t sample_history_capacity(const sample_history_t *h, sample_history_tier_t tier)
+{
+    return h->tiers[tier].mask + 1;
+}
+
+size_t sample_history_bytes(const sample_history_t *h)
+{
+    size_t bytes = (size_t)sample_history_capacity(h, SAMPLE_HISTORY_RAW) * sizeof(sample_history_raw_t);
+
+    for (int t = SAMPLE_HISTORY_1M; t < SAMPLE_HISTORY_N_TIERS; t++) {
+        bytes += (size_t)sample_history_capacity(h, t) * sizeof(sample_history_point_t);
+    }
+    return bytes;
+}
+
+/* ===== OUTPUT ===== */
+int sample_history_format_json(sample_history_tier_t tier, const sample_history_point_t *p, char *buf, size_t len)
+{
+    int n = snprintf(buf, len, "{\"history\":{\"tier\":\"%s\",\"timestamp_ms\":%lld,\"count\":%u",
+                     sample_history_tier_names[tier], (long long)p->timestamp_ms, (unsigned)p->count);
+
+    for (int m = 0; m < SAMPLE_HISTORY_N_METRICS && n >= 0; m++) {
+        size_t used = ((size_t)n < len) ? (size_t)n : len;
+        float scale = sample_history_scale[m];
+        int r;
+
+        if (tier == SAMPLE_HISTORY_RAW) {
+            r = snprintf(buf + used, len - used, ",\"%s\":%g", sample_history_metric_names[m], p->mean[m] / scale);
+        } else {
+            /* [min, mean, max] */
+            r = snprintf(buf + used, len - used, ",\"%s\":[%g,%g,%g]", sample_history_metric_names[m],
+                         p->min[m] / scale, p->mean[m] / scale, p->max[m] / scale);
+        }
+        n = (r < 0) ? r : n + r;
+    }
+
+    if (n >= 0) {
+        size_t used = ((size_t)n < len) ? (size_t)n : len;
+        int r = snprintf(buf + used, len - used, "}}");
+        n = (r < 0) ? r : n + r;
+    }
+    return n;
+}
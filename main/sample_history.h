@@ -0,0 +1,140 @@
+#ifndef SAMPLE_HISTORY_H
+#define SAMPLE_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sensor_pipeline.h"
+
+/*
+ * Fixed-memory history of the processed samples, so a client that was
+ * disconnected can backfill its charts instead of starting blank.
+ *
+ * Four tiers of power-of-two rings in caller-provided storage:
+ *
+ *   SAMPLE_HISTORY_RAW   every sample (one per BSEC cycle, 3 s)
+ *   SAMPLE_HISTORY_1M    1 minute buckets
+ *   SAMPLE_HISTORY_15M   15 minute buckets
+ *   SAMPLE_HISTORY_1H    1 hour buckets
+ *
+ * Each bucket keeps min, mean and max of every metric. All rollup tiers
+ * accumulate straight from the samples into an open bucket that is pushed
+ * to its ring when a sample falls into the next period, so an append is a
+ * constant amount of work and nothing is allocated. When a ring is full the
+ * oldest entry is overwritten.
+ *
+ * Values are fixed point (see sample_history_scale) and timestamps are
+ * milliseconds since boot, in 64 bits like the sample log's, so the rings
+ * stay in time order past the 49.7 days at which the 32-bit telemetry
+ * timestamp_ms wraps; buckets are aligned to multiples of their period on
+ * that clock.
+ *
+ * Appends and queries run in different tasks on the ESP32; callers
+ * serialize them.
+ */
+
+typedef enum {
+    SAMPLE_HISTORY_TEMPERATURE,     /* 0.01 degC */
+    SAMPLE_HISTORY_HUMIDITY,        /* 0.01 %RH */
+    SAMPLE_HISTORY_PRESSURE,        /* 0.1 hPa */
+    SAMPLE_HISTORY_IAQ,             /* 0.1 */
+    SAMPLE_HISTORY_PM1_0,           /* ug/m3 */
+    SAMPLE_HISTORY_PM2_5,
+    SAMPLE_HISTORY_PM10,
+    SAMPLE_HISTORY_AQI,             /* 0.1 */
+    SAMPLE_HISTORY_N_METRICS
+} sample_history_metric_t;
+
+typedef enum {
+    SAMPLE_HISTORY_RAW,
+    SAMPLE_HISTORY_1M,
+    SAMPLE_HISTORY_15M,
+    SAMPLE_HISTORY_1H,
+    SAMPLE_HISTORY_N_TIERS
+} sample_history_tier_t;
+
+/* Metric names as in the sample JSON, and tier names ("raw", "1m", ...) */
+extern const char *const sample_history_metric_names[SAMPLE_HISTORY_N_METRICS];
+extern const char *const sample_history_tier_names[SAMPLE_HISTORY_N_TIERS];
+
+/* Fixed point units per unit of the sensor_sample_t field */
+extern const float sample_history_scale[SAMPLE_HISTORY_N_METRICS];
+
+/* Bucket length of each tier; 0 for the raw tier */
+extern const uint32_t sample_history_period_ms[SAMPLE_HISTORY_N_TIERS];
+
+/* The metrics of a sample in fixed point, saturated to int16 */
+void sample_history_values(const sensor_sample_t *sample, int16_t value[SAMPLE_HISTORY_N_METRICS]);
+
+/* Raw tier entry */
+typedef struct {
+    int64_t timestamp_ms;
+    int16_t value[SAMPLE_HISTORY_N_METRICS];
+} sample_history_raw_t;
+
+/* Rollup tier entry, and what a query returns for any tier */
+typedef struct {
+    int64_t timestamp_ms;   /* bucket start; sample time in the raw tier */
+    uint16_t count;         /* samples in the bucket, 1 in the raw tier */
+    int16_t min[SAMPLE_HISTORY_N_METRICS];
+    int16_t mean[SAMPLE_HISTORY_N_METRICS];
+    int16_t max[SAMPLE_HISTORY_N_METRICS];
+} sample_history_point_t;
+
+/* Bucket being filled */
+typedef struct {
+    int64_t index;          /* timestamp_ms / period of the bucket */
+    uint16_t count;         /* 0 while no bucket is open */
+    int16_t min[SAMPLE_HISTORY_N_METRICS];
+    int16_t max[SAMPLE_HISTORY_N_METRICS];
+    int32_t sum[SAMPLE_HISTORY_N_METRICS];
+} sample_history_acc_t;
+
+typedef struct {
+    void *storage;          /* sample_history_raw_t for the raw tier, else sample_history_point_t */
+    uint32_t mask;
+    uint32_t head;          /* entries ever written; wraps */
+    uint32_t count;         /* entries held, up to mask + 1 */
+    sample_history_acc_t acc;
+} sample_history_ring_t;
+
+typedef struct {
+    sample_history_ring_t tiers[SAMPLE_HISTORY_N_TIERS];
+    uint32_t appended;
+} sample_history_t;
+
+/* Storage of one ring; capacities must be powers of two */
+typedef struct {
+    sample_history_raw_t *raw;
+    uint32_t raw_len;
+    sample_history_point_t *rollup[SAMPLE_HISTORY_N_TIERS];   /* [SAMPLE_HISTORY_RAW] unused */
+    uint32_t rollup_len[SAMPLE_HISTORY_N_TIERS];
+} sample_history_storage_t;
+
+/* Returns 0, or -1 if a capacity is not a power of two */
+int sample_history_init(sample_history_t *h, const sample_history_storage_t *storage);
+
+/* Add one processed sample; timestamps must not go backwards */
+void sample_history_append(sample_history_t *h, const sensor_sample_t *sample);
+
+/*
+ * Copy the entries of `tier` with from_ms <= timestamp_ms < to_ms to `out`,
+ * oldest first, up to `max` of them; returns how many. A rollup tier's open
+ * bucket is included as its newest entry, with the samples it has so far.
+ * To page through a range, repeat from the last timestamp_ms + 1.
+ */
+uint32_t sample_history_query(const sample_history_t *h, sample_history_tier_t tier, int64_t from_ms,
+                              int64_t to_ms, sample_history_point_t *out, uint32_t max);
+
+/* Finest tier that still reaches back to from_ms, else the coarsest */
+sample_history_tier_t sample_history_tier_for(const sample_history_t *h, int64_t from_ms);
+
+/* Entries `tier` can hold, and the bytes of all tiers' storage */
+uint32_t sample_history_capacity(const sample_history_t *h, sample_history_tier_t tier);
+size_t sample_history_bytes(const sample_history_t *h);
+
+/* Serialize one entry as one JSON line (without newline); returns snprintf length */
+int sample_history_format_json(sample_history_tier_t tier, const sample_history_point_t *point, char *buf,
+                               size_t len);
+
+#endif
@@ -0,0 +1,358 @@
+#include <string.h>
+
+#include "sample_log.h"
+#include "series_codec.h"
+#include "telemetry.h"
+
+#define EXPORT_CHUNK_MAX    256
+
+/* ===== HELPERS ===== */
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static void build_header(uint8_t *h, uint32_t seq, int64_t base_ms)
+{
+    put_u32(h, SAMPLE_LOG_MAGIC);
+    h[4] = SAMPLE_LOG_FORMAT;
+    h[5] = SAMPLE_HISTORY_N_METRICS;
+    put_u16(h + 6, 0xFFFF);
+    put_u32(h + 8, seq);
+    put_u32(h + 12, (uint32_t)base_ms);
+    put_u32(h + 16, (uint32_t)((uint64_t)base_ms >> 32));
+    put_u16(h + 20, telemetry_crc16(h, 20));
+    put_u16(h + 22, 0xFFFF);
+}
+
+static int64_t uptime_ms(const sample_log_t *log)
+{
+    return log->hal->time_us(log->hal->ctx) / 1000;
+}
+
+/* ===== PAGE DECODING ===== */
+int sample_log_page_open(sample_log_cursor_t *c, const uint8_t *page, uint32_t len)
+{
+    if (len < SAMPLE_LOG_HEADER_LEN || get_u32(page) != SAMPLE_LOG_MAGIC || page[4] != SAMPLE_LOG_FORMAT ||
+        page[5] != SAMPLE_HISTORY_N_METRICS || telemetry_crc16(page, 20) != get_u16(page + 20)) {
+        return SAMPLE_LOG_E_CORRUPT;
+    }
+
+    c->page = page;
+    c->len = len;
+    c->pos = SAMPLE_LOG_HEADER_LEN;
+    c->seq = get_u32(page + 8);
+    memset(&c->prev, 0, sizeof(c->prev));
+    c->prev.timestamp_ms = (int64_t)((uint64_t)get_u32(page + 12) | ((uint64_t)get_u32(page + 16) << 32));
+
+    return SAMPLE_LOG_OK;
+}
+
+int sample_log_page_next(sample_log_cursor_t *c, sample_log_record_t *rec)
+{
+    if (c->pos >= c->len || c->page[c->pos] == 0xFF) {
+        return 0;
+    }
+
+    const uint8_t *p = &c->page[c->pos];
+    uint32_t body_len = p[0];
+    if (body_len == 0 || c->pos + 3 + body_len > c->len ||
+        telemetry_crc16(p, 1 + body_len) != get_u16(p + 1 + body_len)) {
+        return SAMPLE_LOG_E_CORRUPT;
+    }
+
+    const uint8_t *end = p + 1 + body_len;
+    uint64_t v;
+
+    p = series_get_varint(p + 1, end, &v);
+    if (p == NULL) {
+        return SAMPLE_LOG_E_CORRUPT;
+    }
+    rec->timestamp_ms = c->prev.timestamp_ms + (int64_t)(v >> 1);
+    rec->boot = (uint8_t)(v & 1);
+
+    for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+        p = series_get_varint(p, end, &v);
+        if (p == NULL) {
+            return SAMPLE_LOG_E_CORRUPT;
+        }
+        rec->value[m] = (int16_t)(c->prev.value[m] + series_unzigzag((uint32_t)v));
+    }
+    if (p != end) {
+        return SAMPLE_LOG_E_CORRUPT;
+    }
+
+    c->prev = *rec;
+    c->pos += 3 + body_len;
+    return 1;
+}
+
+/* ===== WRITING ===== */
+int sample_log_flush(sample_log_t *log)
+{
+    if (log->used <= log->flushed) {
+        return SAMPLE_LOG_OK;
+    }
+
+    const sensor_hal_t *hal = log->hal;
+    uint32_t n = log->used - log->flushed;
+
+    if (hal->log_write(hal->ctx, log->page * log->page_size + log->flushed, &log->buf[log->flushed], n) !=
+        SENSOR_HAL_OK) {
+        log->stats.errors++;
+        return SAMPLE_LOG_E_FLASH;
+    }
+
+    log->flushed = log->used;
+    log->stats.flash_bytes += n;
+    log->stats.flushes++;
+    return SAMPLE_LOG_OK;
+}
+
+/* Erase the next sector and start a page there whose first record is at t_ms */
+static int open_page(sample_log_t *log, int64_t t_ms)
+{
+    const sensor_hal_t *hal = log->hal;
+    uint32_t page = (log->page + 1) % log->n_pages;
+
+    if (sample_log_flush(log) != SAMPLE_LOG_OK) {
+        return SAMPLE_LOG_E_FLASH;
+    }
+
+    if (hal->log_erase(hal->ctx, page * log->page_size) != SENSOR_HAL_OK) {
+        log->stats.errors++;
+        return SAMPLE_LOG_E_FLASH;
+    }
+    log->stats.erases++;
+
+    log->page = page;
+    log->seq++;
+    build_header(log->buf, log->seq, t_ms);
+    log->used = SAMPLE_LOG_HEADER_LEN;
+    log->flushed = 0;
+    log->pending_ms = t_ms;
+
+    memset(&log->last, 0, sizeof(log->last));
+    log->last.timestamp_ms = t_ms;
+    return SAMPLE_LOG_OK;
+}
+
+int sample_log_append(sample_log_t *log, const sensor_sample_t *sample)
+{
+    int64_t t_ms = log->boot_offset_ms + sample->timestamp_us / 1000;
+    int16_t value[SAMPLE_HISTORY_N_METRICS];
+
+    if (t_ms < log->last.timestamp_ms) {
+        t_ms = log->last.timestamp_ms;
+    }
+    if (log->used == 0 || log->used + SAMPLE_LOG_RECORD_MAX > log->page_size) {
+        if (open_page(log, t_ms) != SAMPLE_LOG_OK) {
+            return SAMPLE_LOG_E_FLASH;
+        }
+    }
+    sample_history_values(sample, value);
+
+    uint8_t *rec = &log->buf[log->used];
+    uint8_t *p = series_put_varint(rec + 1, (uint64_t)(t_ms - log->last.timestamp_ms) << 1 | log->boot);
+    for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+        p = series_put_varint(p, series_zigzag((int32_t)value[m] - log->last.value[m]));
+    }
+    rec[0] = (uint8_t)(p - rec - 1);
+    put_u16(p, telemetry_crc16(rec, (size_t)(p - rec)));
+    p += 2;
+
+    if (log->flushed == log->used) {
+        log->pending_ms = t_ms;
+    }
+    log->used += (uint32_t)(p - rec);
+    log->last.timestamp_ms = t_ms;
+    memcpy(log->last.value, value, sizeof(value));
+    log->boot = 0;
+    log->stats.records++;
+    log->stats.record_bytes += (uint64_t)(p - rec);
+
+    if (t_ms - log->pending_ms >= log->flush_ms) {
+        return sample_log_flush(log);
+    }
+    return SAMPLE_LOG_OK;
+}
+
+/* ===== INIT ===== */
+/* Continue after the last good record of the newest page */
+static void recover_page(sample_log_t *log, uint32_t page)
+{
+    const sensor_hal_t *hal = log->hal;
+    sample_log_cursor_t c;
+    sample_log_record_t rec;
+    int ret;
+
+    /* Unreadable: leave it closed and start the next one */
+    log->page = page;
+    log->used = log->page_size;
+    log->flushed = log->page_size;
+    if (hal->log_read(hal->ctx, page * log->page_size, log->buf, log->page_size) != SENSOR_HAL_OK ||
+        sample_log_page_open(&c, log->buf, log->page_size) != SAMPLE_LOG_OK) {
+        return;
+    }
+
+    while ((ret = sample_log_page_next(&c, &rec)) == 1) {
+        log->stats.recovered++;
+    }
+
+    log->last = c.prev;
+    log->used = c.pos;
+
+    /* Appending is only possible onto erased flash; a record torn by the
+     * power loss leaves the page closed and the next one is started */
+    for (uint32_t i = c.pos; i < log->page_size && ret == 0; i++) {
+        if (log->buf[i] != 0xFF) {
+            ret = SAMPLE_LOG_E_CORRUPT;
+        }
+    }
+    if (ret != 0) {
+        log->used = log->page_size;
+    }
+    log->flushed = log->used;
+}
+
+int sample_log_init(sample_log_t *log, const sensor_hal_t *hal, int64_t flush_ms)
+{
+    memset(log, 0, sizeof(*log));
+    log->hal = hal;
+    log->flush_ms = flush_ms;
+    log->boot = 1;
+
+    if (hal->log_read == NULL || hal->log_write == NULL || hal->log_erase == NULL ||
+        hal->log_sector_size < SAMPLE_LOG_HEADER_LEN + SAMPLE_LOG_RECORD_MAX ||
+        hal->log_sector_size > SAMPLE_LOG_PAGE_MAX || hal->log_size / hal->log_sector_size < 2) {
+        return SAMPLE_LOG_E_NODEV;
+    }
+    log->page_size = hal->log_sector_size;
+    log->n_pages = hal->log_size / hal->log_sector_size;
+    log->page = log->n_pages - 1;     /* the first page opened is page 0 */
+
+    /* Newest page: the valid header with the highest seq */
+    uint8_t header[SAMPLE_LOG_HEADER_LEN];
+    uint32_t newest = 0;
+    uint32_t newest_seq = 0;
+
+    for (uint32_t i = 0; i < log->n_pages; i++) {
+        sample_log_cursor_t c;
+
+        if (hal->log_read(hal->ctx, i * log->page_size, header, sizeof(header)) != SENSOR_HAL_OK) {
+            return SAMPLE_LOG_E_FLASH;
+        }
+        if (sample_log_page_open(&c, header, sizeof(header)) == SAMPLE_LOG_OK && c.seq >= newest_seq) {
+            newest = i;
+            newest_seq = c.seq;
+        }
+    }
+
+    if (newest_seq > 0) {
+        log->seq = newest_seq;
+        recover_page(log, newest);
+    }
+
+    /* Log time resumes just after the last record */
+    log->boot_offset_ms = (log->seq > 0) ? log->last.timestamp_ms + 1 - uptime_ms(log) : 0;
+    return SAMPLE_LOG_OK;
+}
+
+int64_t sample_log_now_ms(const sample_log_t *log)
+{
+    return log->boot_offset_ms + uptime_ms(log);
+}
+
+/* ===== EXPORT ===== */
+void sample_log_snapshot(sample_log_t *log, sample_log_snapshot_t *snap)
+{
+    sample_log_flush(log);
+
+    snap->newest_page = log->page;
+    snap->newest_seq = log->seq;
+    snap->newest_len = log->flushed;
+    snap->n_pages = (log->seq < log->n_pages) ? log->seq : log->n_pages;
+}
+
+/* Pass one page to `emit` in pieces; returns nonzero when emit asked to stop */
+static int export_page(const sample_log_t *log, uint32_t page, uint32_t seq, uint32_t len, uint32_t chunk,
+                       sample_log_chunk_fn emit, void *arg)
+{
+    const sensor_hal_t *hal = log->hal;
+    uint8_t data[EXPORT_CHUNK_MAX];
+
+    for (uint32_t offset = 0; offset < len; offset += chunk) {
+        uint32_t n = (len - offset < chunk) ? len - offset : chunk;
+
+        if (hal->log_read(hal->ctx, page * log->page_size + offset, data, n) != SENSOR_HAL_OK) {
+            return 0;
+        }
+        if (emit(arg, seq, offset, len, data, n) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint32_t sample_log_export(const sample_log_t *log, const sample_log_snapshot_t *snap, int64_t from_ms,
+                           int64_t to_ms, uint32_t chunk, sample_log_chunk_fn emit, void *arg)
+{
+    const sensor_hal_t *hal = log->hal;
+    uint32_t sent = 0;
+    int have_prev = 0;
+    uint32_t prev_page = 0;
+    uint32_t prev_seq = 0;
+    int64_t prev_base = 0;
+
+    if (chunk == 0 || chunk > EXPORT_CHUNK_MAX) {
+        chunk = EXPORT_CHUNK_MAX;
+    }
+
+    /* A page spans from its base_ms to the next page's, so each is sent once the next header is known */
+    for (uint32_t k = snap->n_pages; k-- > 0;) {
+        uint32_t page = (snap->newest_page + log->n_pages - k) % log->n_pages;
+        uint8_t header[SAMPLE_LOG_HEADER_LEN];
+        sample_log_cursor_t c;
+
+        if (hal->log_read(hal->ctx, page * log->page_size, header, sizeof(header)) != SENSOR_HAL_OK ||
+            sample_log_page_open(&c, header, sizeof(header)) != SAMPLE_LOG_OK || c.seq != snap->newest_seq - k) {
+            continue;
+        }
+
+        if (have_prev && prev_base < to_ms && c.prev.timestamp_ms >= from_ms) {
+            if (export_page(log, prev_page, prev_seq, log->page_size, chunk, emit, arg) != 0) {
+                return sent;
+            }
+            sent++;
+        }
+        have_prev = 1;
+        prev_page = page;
+        prev_seq = c.seq;
+        prev_base = c.prev.timestamp_ms;
+    }
+
+    if (have_prev && prev_base < to_ms) {
+        uint32_t len = (prev_seq == snap->newest_seq) ? snap->newest_len : log->page_size;
+        if (export_page(log, prev_page, prev_seq, len, chunk, emit, arg) == 0) {
+            sent++;
+        }
+    }
+    return sent;
+}
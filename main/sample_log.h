@@ -0,0 +1,147 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include <stdint.h>
+
+#include "sample_history.h"
+#include "sensor_hal.h"
+
+/*
+ * Append-only sample log in the HAL's raw flash region, so days of samples
+ * survive a power loss.
+ *
+ * The region is a ring of pages, one flash sector each. A page starts with
+ * a header and is filled with records in time order; when it is full the
+ * next sector is erased and becomes the new page, overwriting the oldest.
+ * Every sector is erased once per trip around the ring, which spreads the
+ * wear evenly without a separate wear levelling layer.
+ *
+ * Page header (little-endian):
+ *
+ *   u32 magic "SLOG", u8 format version, u8 n_metrics, u16 0xFFFF,
+ *   u32 seq (consecutive per page), u64 base_ms (time of its first record),
+ *   u16 CRC-16/CCITT-FALSE of the header before it, u16 0xFFFF
+ *
+ * Record:
+ *
+ *   u8 len, len bytes of body, u16 CRC-16/CCITT-FALSE of len and body
+ *
+ * The body is LEB128 varints: (dt_ms << 1 | boot), then for each metric the
+ * zigzag difference from the previous record, in the fixed point of the
+ * sample history. dt and the differences start from base_ms and zeros in
+ * each page, so every page decodes on its own. An erased byte (0xFF) where
+ * a len is due ends the page.
+ *
+ * Timestamps are log time: milliseconds that continue across resets from
+ * the last record on flash, since there is no wall clock. The first record
+ * after a reset has the boot bit set; the time the board was off is lost.
+ *
+ * Records are built in a RAM copy of the current page and programmed in
+ * batches: when the page is full, or at most flush_ms after the oldest
+ * unprogrammed record. A power loss costs at most that window.
+ */
+
+#define SAMPLE_LOG_OK           0
+#define SAMPLE_LOG_E_NODEV     -1   /* no log region, or its sectors are too large */
+#define SAMPLE_LOG_E_FLASH     -2
+#define SAMPLE_LOG_E_CORRUPT   -3
+
+#define SAMPLE_LOG_MAGIC        0x474F4C53u     /* "SLOG" */
+#define SAMPLE_LOG_FORMAT       1
+#define SAMPLE_LOG_HEADER_LEN   24
+#define SAMPLE_LOG_PAGE_MAX     4096
+/* len, dt varint, one varint per metric, CRC */
+#define SAMPLE_LOG_RECORD_MAX   (1 + 10 + 3 * SAMPLE_HISTORY_N_METRICS + 2)
+
+typedef struct {
+    int64_t timestamp_ms;   /* log time */
+    uint8_t boot;           /* first record after a reset */
+    int16_t value[SAMPLE_HISTORY_N_METRICS];
+} sample_log_record_t;
+
+/* Reads the records of one page in order */
+typedef struct {
+    const uint8_t *page;
+    uint32_t len;
+    uint32_t pos;
+    uint32_t seq;
+    sample_log_record_t prev;
+} sample_log_cursor_t;
+
+typedef struct {
+    uint32_t records;
+    uint64_t record_bytes;      /* encoded records, without page headers */
+    uint64_t flash_bytes;       /* programmed, headers included */
+    uint32_t flushes;
+    uint32_t erases;
+    uint32_t errors;            /* failed flash operations */
+    uint32_t recovered;         /* records found in the newest page at init */
+} sample_log_stats_t;
+
+typedef struct {
+    const sensor_hal_t *hal;
+    uint32_t page_size;
+    uint32_t n_pages;
+    int64_t flush_ms;
+
+    uint32_t page;              /* index of the page being filled */
+    uint32_t seq;               /* its sequence number, 0 before the first page */
+    uint32_t used;              /* bytes of the page image in use, 0 when no page is open */
+    uint32_t flushed;           /* of those, bytes already programmed */
+    int64_t pending_ms;         /* log time of the oldest unprogrammed record */
+
+    int64_t boot_offset_ms;     /* log time minus time since boot */
+    uint8_t boot;               /* no record written since the reset */
+    sample_log_record_t last;   /* previous record of the page */
+
+    sample_log_stats_t stats;
+    uint8_t buf[SAMPLE_LOG_PAGE_MAX];
+} sample_log_t;
+
+/* Pages of a log at one point in time, for an export that runs alongside appends */
+typedef struct {
+    uint32_t newest_page;
+    uint32_t newest_seq;
+    uint32_t newest_len;        /* programmed bytes of the newest page */
+    uint32_t n_pages;           /* held, counting back from the newest */
+} sample_log_snapshot_t;
+
+/* Called with consecutive pieces of a page; return nonzero to stop the export */
+typedef int (*sample_log_chunk_fn)(void *arg, uint32_t seq, uint32_t offset, uint32_t page_len,
+                                   const uint8_t *data, uint32_t len);
+
+/*
+ * Find the newest page in the region and continue after its last record;
+ * log time picks up 1 ms after it. Returns SAMPLE_LOG_OK or an error.
+ */
+int sample_log_init(sample_log_t *log, const sensor_hal_t *hal, int64_t flush_ms);
+
+/* Add one sample; returns SAMPLE_LOG_OK or SAMPLE_LOG_E_FLASH */
+int sample_log_append(sample_log_t *log, const sensor_sample_t *sample);
+
+/* Program all buffered records now */
+int sample_log_flush(sample_log_t *log);
+
+/* Current log time */
+int64_t sample_log_now_ms(const sample_log_t *log);
+
+/* Flush and record the pages to export; call with appends serialized */
+void sample_log_snapshot(sample_log_t *log, sample_log_snapshot_t *snap);
+
+/*
+ * Pass the raw bytes of every page in `snap` that may hold records with
+ * from_ms <= timestamp_ms < to_ms to `emit`, oldest first, in pieces of up
+ * to `chunk` bytes. Only reads flash, so it can run without holding off
+ * appends; a page recycled meanwhile fails its header check on decoding.
+ * Returns the number of pages sent.
+ */
+uint32_t sample_log_export(const sample_log_t *log, const sample_log_snapshot_t *snap, int64_t from_ms,
+                           int64_t to_ms, uint32_t chunk, sample_log_chunk_fn emit, void *arg);
+
+/* Check a page header; returns SAMPLE_LOG_OK and positions the cursor before the first record */
+int sample_log_page_open(sample_log_cursor_t *c, const uint8_t *page, uint32_t len);
+
+/* Next record of the page: 1 with `rec` filled, 0 at the end, SAMPLE_LOG_E_CORRUPT on a bad record */
+int sample_log_page_next(sample_log_cursor_t *c, sample_log_record_t *rec);
+
+#endif
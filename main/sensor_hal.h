@@ -0,0 +1,79 @@
+#ifndef SENSOR_HAL_H
+#define SENSOR_HAL_H
+
+#include <stdint.h>
+
+/*
+ * Hardware abstraction used by the portable sensor pipeline.
+ *
+ * Everything the pipeline and the sensor drivers need from the platform goes
+ * through this table, so the same code runs on the ESP32 (sensor_hal_esp32.c)
+ * and on a Linux host against simulated devices (host/sensor_hal_host.c).
+ */
+
+#define SENSOR_HAL_OK       0
+#define SENSOR_HAL_E_BUS   -1
+#define SENSOR_HAL_E_NODEV -2
+#define SENSOR_HAL_E_STORE -3
+
+/* Filtered, calibrated reading of an analog channel */
+typedef struct {
+    int raw;                /* filtered ADC code */
+    int mv;                 /* input voltage from the chip's calibration */
+    float noise_mv;         /* input standard deviation over the filter window */
+} sensor_hal_adc_sample_t;
+
+typedef struct {
+    /* Write `reg`, repeated start, then read `len` bytes from `dev_addr` */
+    int (*bus_read)(void *ctx, uint8_t dev_addr, uint8_t reg, uint8_t *data, uint32_t len);
+
+    /* Write `reg` followed by `len` payload bytes to `dev_addr` */
+    int (*bus_write)(void *ctx, uint8_t dev_addr, uint8_t reg, const uint8_t *data, uint32_t len);
+
+    /* Block for at least `period_us` microseconds */
+    void (*delay_us)(void *ctx, uint32_t period_us);
+
+    /* Monotonic time since boot in microseconds */
+    int64_t (*time_us)(void *ctx);
+
+    /* Raw ADC sample of `channel`; may be NULL when there is no analog front-end */
+    int (*adc_read)(void *ctx, uint8_t channel, int *raw);
+
+    /* Latest reading of `channel` from a background sampler, without
+     * blocking; NULL when only adc_read is available */
+    int (*adc_sample)(void *ctx, uint8_t channel, sensor_hal_adc_sample_t *sample);
+
+    /* Running total of heap bytes allocated (wraps; compare differences); may be NULL */
+    uint32_t (*alloc_bytes)(void *ctx);
+
+    /* Guard for library state shared between pipeline stages running in
+     * different tasks (BSEC is not reentrant); both NULL when single-threaded */
+    void (*lock)(void *ctx);
+    void (*unlock)(void *ctx);
+
+    /* Small persistent blobs that survive a reset (NVS on the ESP32); both
+     * NULL without storage. load reads up to *len bytes and sets *len to the
+     * stored size; SENSOR_HAL_E_STORE when `key` is missing or unreadable */
+    int (*blob_load)(void *ctx, const char *key, void *data, uint32_t *len);
+    int (*blob_save)(void *ctx, const char *key, const void *data, uint32_t len);
+
+    /* Raw flash region for the sample log (a data partition on the ESP32);
+     * all NULL and log_size 0 without one. Offsets are within the region.
+     * Erase sets one log_sector_size sector to 0xFF; as on NOR flash, a
+     * write can only clear bits */
+    int (*log_read)(void *ctx, uint32_t offset, void *data, uint32_t len);
+    int (*log_write)(void *ctx, uint32_t offset, const void *data, uint32_t len);
+    int (*log_erase)(void *ctx, uint32_t offset);
+    uint32_t log_size;
+    uint32_t log_sector_size;
+
+    void *ctx;
+} sensor_hal_t;
+
+/* Binds a HAL to one device address so drivers can keep a single intf_ptr */
+typedef struct {
+    const sensor_hal_t *hal;
+    uint8_t addr;
+} sensor_hal_dev_t;
+
+#endif
@@ -0,0 +1,589 @@
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "driver/i2c_master.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_partition.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+#include "adc_filter.h"
+#include "sensor_hal_esp32.h"
+
+/* I2C CONFIG */
+#define I2C_MASTER_NUM       I2C_NUM_0
+#define I2C_MASTER_SDA_IO    21
+#define I2C_MASTER_SCL_IO    22
+#define I2C_MASTER_FREQ_HZ   400000
+#define I2C_TIMEOUT_MS       1000
+#define I2C_MAX_DEVICES      4
+#define I2C_MAX_WRITE_LEN    32
+
+/* ADC CONFIG */
+#define ADC_FIRST_CHANNEL    ADC_CHANNEL_6
+#define ADC_N_CHANNELS       2
+#define ADC_FRAME_BYTES      256
+#define ADC_STORE_BYTES      1024
+#define ADC_TASK_CORE        0
+#define ADC_TASK_PRIORITY    7
+#define ADC_TASK_STACK_SIZE  3072
+
+/* NVS CONFIG */
+#define NVS_NAMESPACE        "air_quality"
+
+/* Sample log data partition (partitions.csv) */
+#define LOG_PARTITION_LABEL  "samplelog"
+
+/* DELAY CONFIG */
+#define DELAY_SPIN_THRESHOLD_US  1000
+#define DELAY_TIMER_SLOTS        4
+
+static const char *TAG = "HAL_ESP32";
+
+static adc_continuous_handle_t adc_handle = NULL;
+static adc_cali_handle_t adc_cali = NULL;
+static TaskHandle_t adc_task_handle = NULL;
+static StaticTask_t adc_tcb;
+static StackType_t adc_stack[ADC_TASK_STACK_SIZE];
+static uint8_t adc_frame[ADC_FRAME_BYTES];
+static adc_filter_t adc_filters[ADC_N_CHANNELS];    /* sampler task only */
+static struct {
+    float value;
+    float variance;
+    uint32_t outputs;
+} adc_latest[ADC_N_CHANNELS];
+static portMUX_TYPE adc_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Bus and per-address device handles; devices are added on first access */
+static i2c_master_bus_handle_t bus_handle = NULL;
+static struct {
+    uint8_t addr;
+    i2c_master_dev_handle_t handle;
+} i2c_devices[I2C_MAX_DEVICES];
+static volatile int n_i2c_devices = 0;
+static SemaphoreHandle_t i2c_devices_lock = NULL;
+static StaticSemaphore_t i2c_devices_lock_buf;
+
+static const esp_partition_t *log_partition = NULL;
+
+/* Serializes BSEC calls between the acquisition and processing tasks */
+static SemaphoreHandle_t stage_lock = NULL;
+static StaticSemaphore_t stage_lock_buf;
+
+/* One-shot timers for delays above the spin threshold, one per waiting task */
+typedef struct {
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+} delay_slot_t;
+
+static delay_slot_t delay_slots[DELAY_TIMER_SLOTS];
+static portMUX_TYPE delay_lock = portMUX_INITIALIZER_UNLOCKED;
+static sensor_hal_delay_stats_t delay_stats;
+
+/* Heap bytes handed out since boot, counted by the CONFIG_HEAP_USE_HOOKS hook */
+static volatile uint32_t heap_alloc_bytes = 0;
+
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    (void)ptr;
+    (void)caps;
+    __atomic_fetch_add(&heap_alloc_bytes, (uint32_t)size, __ATOMIC_RELAXED);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr)
+{
+    (void)ptr;
+}
+
+/* ===== I2C FUNCTIONS ===== */
+static i2c_master_dev_handle_t i2c_device(uint8_t dev_addr)
+{
+    i2c_master_dev_handle_t handle = NULL;
+
+    for (int i = 0; i < n_i2c_devices; i++) {
+        if (i2c_devices[i].addr == dev_addr) {
+            return i2c_devices[i].handle;
+        }
+    }
+
+    xSemaphoreTake(i2c_devices_lock, portMAX_DELAY);
+    for (int i = 0; i < n_i2c_devices; i++) {
+        if (i2c_devices[i].addr == dev_addr) {
+            handle = i2c_devices[i].handle;
+        }
+    }
+
+    if (handle == NULL && n_i2c_devices < I2C_MAX_DEVICES) {
+        i2c_device_config_t dev_cfg = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = dev_addr,
+            .scl_speed_hz = I2C_MASTER_FREQ_HZ,
+        };
+        if (i2c_master_bus_add_device(bus_handle, &dev_cfg, &handle) == ESP_OK) {
+            i2c_devices[n_i2c_devices].addr = dev_addr;
+            i2c_devices[n_i2c_devices].handle = handle;
+            n_i2c_devices++;
+        } else {
+            ESP_LOGE(TAG, "Failed to add I2C device 0x%02X", dev_addr);
+            handle = NULL;
+        }
+    }
+    xSemaphoreGive(i2c_devices_lock);
+
+    return handle;
+}
+
+static int esp32_bus_read(void *ctx, uint8_t dev_addr, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    i2c_master_dev_handle_t dev = i2c_device(dev_addr);
+    if (dev == NULL) {
+        return SENSOR_HAL_E_NODEV;
+    }
+
+    esp_err_t ret = i2c_master_transmit_receive(dev, &reg, 1, data, len, I2C_TIMEOUT_MS);
+
+    return (ret == ESP_OK) ? SENSOR_HAL_OK : SENSOR_HAL_E_BUS;
+}
+
+static int esp32_bus_write(void *ctx, uint8_t dev_addr, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+    uint8_t buf[1 + I2C_MAX_WRITE_LEN];
+
+    i2c_master_dev_handle_t dev = i2c_device(dev_addr);
+    if (dev == NULL) {
+        return SENSOR_HAL_E_NODEV;
+    }
+    if (len > I2C_MAX_WRITE_LEN) {
+        return SENSOR_HAL_E_BUS;
+    }
+
+    /* Register address and payload go out as one transfer */
+    buf[0] = reg;
+    memcpy(&buf[1], data, len);
+    esp_err_t ret = i2c_master_transmit(dev, buf, len + 1, I2C_TIMEOUT_MS);
+
+    return (ret == ESP_OK) ? SENSOR_HAL_OK : SENSOR_HAL_E_BUS;
+}
+
+/* ===== DELAY ===== */
+static void delay_timer_cb(void *arg)
+{
+    delay_slot_t *slot = (delay_slot_t *)arg;
+    TaskHandle_t task;
+
+    /* The waiter may have released the slot if stop() raced the expiry */
+    portENTER_CRITICAL(&delay_lock);
+    task = slot->task;
+    portEXIT_CRITICAL(&delay_lock);
+
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+static delay_slot_t *delay_slot_claim(void)
+{
+    delay_slot_t *slot = NULL;
+
+    portENTER_CRITICAL(&delay_lock);
+    for (int i = 0; i < DELAY_TIMER_SLOTS; i++) {
+        if (delay_slots[i].timer != NULL && delay_slots[i].task == NULL) {
+            slot = &delay_slots[i];
+            slot->task = xTaskGetCurrentTaskHandle();
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&delay_lock);
+
+    return slot;
+}
+
+static void delay_slot_release(delay_slot_t *slot)
+{
+    portENTER_CRITICAL(&delay_lock);
+    slot->task = NULL;
+    portEXIT_CRITICAL(&delay_lock);
+}
+
+/*
+ * Short waits spin on esp_rom_delay_us; longer ones block on a one-shot
+ * esp_timer so they are not rounded to the 10 ms FreeRTOS tick. The task
+ * notification is only a wake-up hint: the deadline is checked against
+ * esp_timer_get_time() and any remainder is spun off.
+ */
+static void esp32_delay_us(void *ctx, uint32_t period)
+{
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = start + period;
+    delay_slot_t *slot = NULL;
+
+    if (period >= DELAY_SPIN_THRESHOLD_US) {
+        slot = delay_slot_claim();
+    }
+
+    if (slot != NULL) {
+        ulTaskNotifyTake(pdTRUE, 0);
+        if (esp_timer_start_once(slot->timer, period) == ESP_OK) {
+            TickType_t timeout = pdMS_TO_TICKS(period / 1000) + 2;
+            while (esp_timer_get_time() < deadline) {
+                if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+                    break;
+                }
+            }
+            esp_timer_stop(slot->timer);
+        }
+        delay_slot_release(slot);
+    } else if (period >= DELAY_SPIN_THRESHOLD_US) {
+        /* All timers busy: sleep whole ticks and spin the rest */
+        vTaskDelay(period / 1000 / portTICK_PERIOD_MS);
+    }
+
+    int64_t remaining = deadline - esp_timer_get_time();
+    if (remaining > 0) {
+        esp_rom_delay_us((uint32_t)remaining);
+    }
+
+    uint32_t actual = (uint32_t)(esp_timer_get_time() - start);
+
+    portENTER_CRITICAL(&delay_lock);
+    if (period >= DELAY_SPIN_THRESHOLD_US) {
+        delay_stats.sleeps++;
+    } else {
+        delay_stats.spins++;
+    }
+    delay_stats.requested_us += period;
+    delay_stats.actual_us += actual;
+    if (actual - period > delay_stats.max_overshoot_us) {
+        delay_stats.max_overshoot_us = actual - period;
+    }
+    portEXIT_CRITICAL(&delay_lock);
+}
+
+static esp_err_t delay_init(void)
+{
+    for (int i = 0; i < DELAY_TIMER_SLOTS; i++) {
+        esp_timer_create_args_t args = {
+            .callback = delay_timer_cb,
+            .arg = &delay_slots[i],
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "hal_delay",
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&args, &delay_slots[i].timer), TAG, "Delay timer create failed");
+    }
+
+    return ESP_OK;
+}
+
+void sensor_hal_esp32_delay_stats(sensor_hal_delay_stats_t *stats)
+{
+    portENTER_CRITICAL(&delay_lock);
+    *stats = delay_stats;
+    portEXIT_CRITICAL(&delay_lock);
+}
+
+static int64_t esp32_time_us(void *ctx)
+{
+    return esp_timer_get_time();
+}
+
+static uint32_t esp32_alloc_bytes(void *ctx)
+{
+    return heap_alloc_bytes;
+}
+
+static void esp32_lock(void *ctx)
+{
+    xSemaphoreTake(stage_lock, portMAX_DELAY);
+}
+
+static void esp32_unlock(void *ctx)
+{
+    xSemaphoreGive(stage_lock);
+}
+
+/* ===== ADC ===== */
+/*
+ * ADC1 channels 6 and 7 are sampled continuously by the DMA controller at
+ * CONFIG_AIR_QUALITY_ADC_SAMPLE_RATE_HZ. A sampler task drains each DMA
+ * frame through adc_filter and publishes the latest window, so readers
+ * never wait for a conversion.
+ */
+static bool IRAM_ATTR adc_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                       void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+
+    vTaskNotifyGiveFromISR(adc_task_handle, &woken);
+    return woken == pdTRUE;
+}
+
+static void adc_task(void *arg)
+{
+    uint32_t len;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (adc_continuous_read(adc_handle, adc_frame, sizeof(adc_frame), &len, 0) == ESP_OK) {
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t *d = (const adc_digi_output_data_t *)&adc_frame[i];
+                int index = (int)d->type1.channel - ADC_FIRST_CHANNEL;
+
+                if (index < 0 || index >= ADC_N_CHANNELS) {
+                    continue;
+                }
+
+                adc_filter_t *f = &adc_filters[index];
+                if (adc_filter_push(f, d->type1.data)) {
+                    portENTER_CRITICAL(&adc_lock);
+                    adc_latest[index].value = f->value;
+                    adc_latest[index].variance = f->variance;
+                    adc_latest[index].outputs = f->outputs;
+                    portEXIT_CRITICAL(&adc_lock);
+                }
+            }
+        }
+    }
+}
+
+static int adc_latest_get(uint8_t channel, float *value, float *variance)
+{
+    int index = (int)channel - ADC_FIRST_CHANNEL;
+    uint32_t outputs;
+
+    if (index < 0 || index >= ADC_N_CHANNELS) {
+        return SENSOR_HAL_E_NODEV;
+    }
+
+    portENTER_CRITICAL(&adc_lock);
+    *value = adc_latest[index].value;
+    *variance = adc_latest[index].variance;
+    outputs = adc_latest[index].outputs;
+    portEXIT_CRITICAL(&adc_lock);
+
+    /* Nothing until the first window completes */
+    return (outputs > 0) ? SENSOR_HAL_OK : SENSOR_HAL_E_NODEV;
+}
+
+static int esp32_adc_read(void *ctx, uint8_t channel, int *raw)
+{
+    float value, variance;
+    int ret = adc_latest_get(channel, &value, &variance);
+
+    if (ret == SENSOR_HAL_OK) {
+        *raw = (int)lrintf(value);
+    }
+    return ret;
+}
+
+static int esp32_adc_sample(void *ctx, uint8_t channel, sensor_hal_adc_sample_t *sample)
+{
+    float value, variance;
+    int ret = adc_latest_get(channel, &value, &variance);
+
+    if (ret != SENSOR_HAL_OK) {
+        return ret;
+    }
+
+    /* Local slope of the calibration curve turns code noise into mV */
+    int code = (int)lrintf(value);
+    int mv = 0, mv_hi = 0;
+    if (adc_cali_raw_to_voltage(adc_cali, code, &mv) != ESP_OK ||
+        adc_cali_raw_to_voltage(adc_cali, code + 64, &mv_hi) != ESP_OK) {
+        return SENSOR_HAL_E_BUS;
+    }
+
+    sample->raw = code;
+    sample->mv = mv;
+    sample->noise_mv = sqrtf(variance) * (float)(mv_hi - mv) / 64.0f;
+
+    return SENSOR_HAL_OK;
+}
+
+static esp_err_t adc_init(void)
+{
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = ADC_STORE_BYTES,
+        .conv_frame_size = ADC_FRAME_BYTES,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_new_handle(&handle_config, &adc_handle), TAG, "ADC handle init failed");
+
+    adc_digi_pattern_config_t pattern[ADC_N_CHANNELS];
+    for (int i = 0; i < ADC_N_CHANNELS; i++) {
+        pattern[i] = (adc_digi_pattern_config_t) {
+            .atten = ADC_ATTEN_DB_12,
+            .channel = ADC_FIRST_CHANNEL + i,
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+        adc_filter_init(&adc_filters[i], CONFIG_AIR_QUALITY_ADC_DECIMATION);
+    }
+
+    /* The pattern alternates channels, so each one sees half the rate */
+    adc_continuous_config_t config = {
+        .pattern_num = ADC_N_CHANNELS,
+        .adc_pattern = pattern,
+        .sample_freq_hz = CONFIG_AIR_QUALITY_ADC_SAMPLE_RATE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_config(adc_handle, &config), TAG, "ADC pattern config failed");
+
+    /* Line fitting uses the reference voltage burned into eFuse */
+    adc_cali_line_fitting_config_t cali_config = {
+        .unit_id = ADC_UNIT_1,
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    ESP_RETURN_ON_ERROR(adc_cali_create_scheme_line_fitting(&cali_config, &adc_cali), TAG, "ADC calibration failed");
+
+    adc_task_handle = xTaskCreateStaticPinnedToCore(adc_task, "adc", ADC_TASK_STACK_SIZE, NULL,
+                                                    ADC_TASK_PRIORITY, adc_stack, &adc_tcb, ADC_TASK_CORE);
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = adc_conv_done_cb,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_register_event_callbacks(adc_handle, &cbs, NULL), TAG, "ADC callback failed");
+    ESP_RETURN_ON_ERROR(adc_continuous_start(adc_handle), TAG, "ADC start failed");
+
+    ESP_LOGI(TAG, "ADC sampling at %d Hz, %d samples per window", CONFIG_AIR_QUALITY_ADC_SAMPLE_RATE_HZ,
+             CONFIG_AIR_QUALITY_ADC_DECIMATION);
+    return ESP_OK;
+}
+
+/* ===== NVS ===== */
+static int esp32_blob_load(void *ctx, const char *key, void *data, uint32_t *len)
+{
+    nvs_handle_t nvs;
+    size_t size = *len;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return SENSOR_HAL_E_STORE;
+    }
+    esp_err_t ret = nvs_get_blob(nvs, key, data, &size);
+    nvs_close(nvs);
+
+    *len = (uint32_t)size;
+    return (ret == ESP_OK) ? SENSOR_HAL_OK : SENSOR_HAL_E_STORE;
+}
+
+static int esp32_blob_save(void *ctx, const char *key, const void *data, uint32_t len)
+{
+    nvs_handle_t nvs;
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return SENSOR_HAL_E_STORE;
+    }
+    esp_err_t ret = nvs_set_blob(nvs, key, data, len);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS save of %s failed: %s", key, esp_err_to_name(ret));
+    }
+    return (ret == ESP_OK) ? SENSOR_HAL_OK : SENSOR_HAL_E_STORE;
+}
+
+/* ===== SAMPLE LOG PARTITION ===== */
+static int esp32_log_read(void *ctx, uint32_t offset, void *data, uint32_t len)
+{
+    return (esp_partition_read(log_partition, offset, data, len) == ESP_OK) ? SENSOR_HAL_OK : SENSOR_HAL_E_STORE;
+}
+
+static int esp32_log_write(void *ctx, uint32_t offset, const void *data, uint32_t len)
+{
+    return (esp_partition_write(log_partition, offset, data, len) == ESP_OK) ? SENSOR_HAL_OK : SENSOR_HAL_E_STORE;
+}
+
+static int esp32_log_erase(void *ctx, uint32_t offset)
+{
+    esp_err_t ret = esp_partition_erase_range(log_partition, offset, log_partition->erase_size);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Sample log erase at 0x%lx failed: %s", (unsigned long)offset, esp_err_to_name(ret));
+    }
+    return (ret == ESP_OK) ? SENSOR_HAL_OK : SENSOR_HAL_E_STORE;
+}
+
+static esp_err_t nvs_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        /* Partition is full or from a newer layout: start over */
+        ESP_LOGW(TAG, "Erasing NVS partition: %s", esp_err_to_name(ret));
+        ESP_RETURN_ON_ERROR(nvs_flash_erase(), TAG, "NVS erase failed");
+        ret = nvs_flash_init();
+    }
+    return ret;
+}
+
+/* ===== INIT ===== */
+esp_err_t sensor_hal_esp32_init(sensor_hal_t *hal)
+{
+    i2c_master_bus_config_t bus_cfg = {
+        .i2c_port = I2C_MASTER_NUM,
+        .sda_io_num = I2C_MASTER_SDA_IO,
+        .scl_io_num = I2C_MASTER_SCL_IO,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+
+    i2c_devices_lock = xSemaphoreCreateMutexStatic(&i2c_devices_lock_buf);
+    stage_lock = xSemaphoreCreateMutexStatic(&stage_lock_buf);
+    ESP_RETURN_ON_ERROR(i2c_new_master_bus(&bus_cfg, &bus_handle), TAG, "I2C bus init failed");
+    ESP_RETURN_ON_ERROR(delay_init(), TAG, "Delay init failed");
+
+    /* Without the analog front-end the pipeline reports zeros for H2S and odor */
+    bool have_adc = (adc_init() == ESP_OK);
+    if (!have_adc) {
+        ESP_LOGW(TAG, "ADC unavailable, H2S and odor will not be read");
+    }
+
+    /* Persistent storage is optional: run without it if NVS is unusable */
+    bool have_nvs = (nvs_init() == ESP_OK);
+    if (!have_nvs) {
+        ESP_LOGW(TAG, "NVS unavailable, BSEC state will not persist");
+    }
+
+    hal->bus_read = esp32_bus_read;
+    hal->bus_write = esp32_bus_write;
+    hal->delay_us = esp32_delay_us;
+    hal->time_us = esp32_time_us;
+    hal->adc_read = have_adc ? esp32_adc_read : NULL;
+    hal->adc_sample = have_adc ? esp32_adc_sample : NULL;
+    hal->alloc_bytes = esp32_alloc_bytes;
+    hal->lock = esp32_lock;
+    hal->unlock = esp32_unlock;
+    hal->blob_load = have_nvs ? esp32_blob_load : NULL;
+    hal->blob_save = have_nvs ? esp32_blob_save : NULL;
+
+    /* The sample log is optional too: older partition tables have no room for it */
+    log_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, LOG_PARTITION_LABEL);
+    if (log_partition == NULL) {
+        ESP_LOGW(TAG, "No %s partition, samples will not be logged to flash", LOG_PARTITION_LABEL);
+    }
+    hal->log_read = log_partition ? esp32_log_read : NULL;
+    hal->log_write = log_partition ? esp32_log_write : NULL;
+    hal->log_erase = log_partition ? esp32_log_erase : NULL;
+    hal->log_size = log_partition ? log_partition->size : 0;
+    hal->log_sector_size = log_partition ? log_partition->erase_size : 0;
+    hal->ctx = NULL;
+
+    return ESP_OK;
+}
@@ -0,0 +1,24 @@
+#ifndef SENSOR_HAL_ESP32_H
+#define SENSOR_HAL_ESP32_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sensor_hal.h"
+
+/* Requested versus measured delay_us() time since boot */
+typedef struct {
+    uint32_t spins;             /* calls below the spin threshold */
+    uint32_t sleeps;            /* calls that blocked on a one-shot timer */
+    uint64_t requested_us;
+    uint64_t actual_us;
+    uint32_t max_overshoot_us;
+} sensor_hal_delay_stats_t;
+
+/* Install the I2C master and ADC drivers, bring up NVS, find the sample log
+ * partition and fill `hal` with the ESP32 backend */
+esp_err_t sensor_hal_esp32_init(sensor_hal_t *hal);
+
+void sensor_hal_esp32_delay_stats(sensor_hal_delay_stats_t *stats);
+
+#endif
@@ -0,0 +1,784 @@
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "bme68x.h"
+#include "bme68x_defs.h"
+
+#include "bsec_interface_multi.h"
+#include "bsec_datatypes.h"
+#include "bsec_config.h"
+
+#include "sensor_pipeline.h"
+
+static const char *TAG = "PIPELINE";
+
+#define BME680_INTAKE_ADDR      BME68X_I2C_ADDR_LOW   // 0x76
+#define BME680_EXHAUST_ADDR     BME68X_I2C_ADDR_HIGH  // 0x77
+#define PM_SENSOR_DEFAULT_ADDR  0x19
+#define H2S_ADC_CHANNEL         6   // GPIO 34
+#define ODOR_ADC_CHANNEL        7   // GPIO 35
+
+#define PM_SENSOR_STARTUP_US    100000
+
+/* Slack after the computed conversion time; a late field is caught by the
+ * driver's BME68X_PERIOD_POLL retry */
+#define ACQUIRE_MARGIN_US       1000
+
+/* ===== BME68X BUS GLUE ===== */
+static int8_t bme_read(uint8_t reg, uint8_t *data, uint32_t len, void *intf_ptr)
+{
+    sensor_hal_dev_t *bus = (sensor_hal_dev_t *)intf_ptr;
+    int ret = bus->hal->bus_read(bus->hal->ctx, bus->addr, reg, data, len);
+
+    return (ret == SENSOR_HAL_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+}
+
+static int8_t bme_write(uint8_t reg, const uint8_t *data, uint32_t len, void *intf_ptr)
+{
+    sensor_hal_dev_t *bus = (sensor_hal_dev_t *)intf_ptr;
+    int ret = bus->hal->bus_write(bus->hal->ctx, bus->addr, reg, data, len);
+
+    return (ret == SENSOR_HAL_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+}
+
+static void bme_delay_us(uint32_t period, void *intf_ptr)
+{
+    sensor_hal_dev_t *bus = (sensor_hal_dev_t *)intf_ptr;
+    bus->hal->delay_us(bus->hal->ctx, period);
+}
+
+/* ===== INIT ===== */
+/* The intake keeps the key of the single-sensor firmware, so its calibration carries over */
+static const char *const bsec_state_keys[SENSOR_PIPELINE_MAX_CHANNELS] = {
+    BSEC_STATE_KEY,
+    BSEC_STATE_KEY "1",
+};
+
+void sensor_pipeline_default_config(sensor_pipeline_config_t *config)
+{
+    config->bme_addr[SENSOR_CHANNEL_INTAKE] = BME680_INTAKE_ADDR;
+    config->bme_addr[SENSOR_CHANNEL_EXHAUST] = BME680_EXHAUST_ADDR;
+    config->n_bme = SENSOR_PIPELINE_MAX_CHANNELS;
+    config->pm_addr = PM_SENSOR_DEFAULT_ADDR;
+    config->h2s_channel = H2S_ADC_CHANNEL;
+    config->odor_channel = ODOR_ADC_CHANNEL;
+    config->state_save_period_us = BSEC_STATE_SAVE_PERIOD_US;
+    config->scan_addr = 0;
+    config->scan_profile = heater_scan_default_profile;
+    config->aqi_scale = AQI_SCALE_EPA;
+}
+
+static void pm_sensor_init(sensor_pipeline_t *p)
+{
+    if (p->config.pm_addr == 0) {
+        return;
+    }
+
+    p->pm_sensor = dfrobot_create(p->hal, p->config.pm_addr);
+    if (p->pm_sensor == NULL) {
+        ESP_LOGE(TAG, "Failed to create PM sensor");
+        return;
+    }
+
+    p->hal->delay_us(p->hal->ctx, PM_SENSOR_STARTUP_US);  // Wait for sensor to be ready
+    if (!dfrobot_begin(p->pm_sensor)) {
+        ESP_LOGW(TAG, "PM sensor not found at address 0x%02X", p->config.pm_addr);
+        dfrobot_delete(p->pm_sensor);
+        p->pm_sensor = NULL;
+    } else {
+        uint8_t version = dfrobot_gainVersion(p->pm_sensor);
+        ESP_LOGI(TAG, "PM Sensor initialized. Version: 0x%02X", version);
+    }
+}
+
+static int bme_init(sensor_pipeline_t *p, sensor_channel_t *c)
+{
+    memset(&c->bme_dev, 0, sizeof(c->bme_dev));
+
+    c->bme_bus.hal = p->hal;
+    c->bme_bus.addr = c->addr;
+
+    c->bme_dev.intf = BME68X_I2C_INTF;
+    c->bme_dev.intf_ptr = &c->bme_bus;
+    c->bme_dev.read = bme_read;
+    c->bme_dev.write = bme_write;
+    c->bme_dev.delay_us = bme_delay_us;
+    c->bme_dev.amb_temp = 25;
+
+    int8_t status = bme68x_init(&c->bme_dev);
+    if (status != BME68X_OK) {
+        return SENSOR_PIPELINE_E_BME;
+    }
+
+    ESP_LOGI(TAG, "BME680 at 0x%02X initialized. Chip ID: 0x%02X", c->addr, c->bme_dev.chip_id);
+
+    c->bme_conf.os_hum  = BME68X_OS_2X;
+    c->bme_conf.os_pres = BME68X_OS_4X;
+    c->bme_conf.os_temp = BME68X_OS_8X;
+    c->bme_conf.filter  = BME68X_FILTER_SIZE_3;
+    c->bme_conf.odr     = BME68X_ODR_NONE;
+
+    bme68x_set_conf(&c->bme_conf, &c->bme_dev);
+
+    memset(&c->heatr_conf, 0, sizeof(c->heatr_conf));
+    c->heatr_conf.enable = BME68X_ENABLE;
+    c->heatr_conf.heatr_temp = 320;
+    c->heatr_conf.heatr_dur = 150;
+
+    bme68x_set_heatr_conf(BME68X_FORCED_MODE, &c->heatr_conf, &c->bme_dev);
+
+    return SENSOR_PIPELINE_OK;
+}
+
+/* Self-heating model and sample rate for the board; BSEC keeps its 1.8 V defaults without one */
+static void bsec_apply_config(void *inst)
+{
+    const uint8_t *blob;
+    uint32_t len = bsec_config_blob(&blob);
+
+    if (len == 0) {
+        ESP_LOGW(TAG, "No BSEC configuration (%s) linked, using library defaults", bsec_config_name());
+        return;
+    }
+
+    bsec_library_return_t status = bsec_set_configuration_m(inst, blob, len, bsec_work_buffer, sizeof(bsec_work_buffer));
+    if (status != BSEC_OK) {
+        ESP_LOGE(TAG, "bsec_set_configuration(%s) failed: %d", bsec_config_name(), status);
+    } else {
+        ESP_LOGI(TAG, "BSEC configuration %s applied (%u bytes)", bsec_config_name(), (unsigned)len);
+    }
+}
+
+static int bsec_setup(sensor_pipeline_t *p, uint8_t index)
+{
+    sensor_channel_t *c = &p->channels[index];
+
+    c->bsec = p->bsec_arena[index];
+    bsec_library_return_t bsec_status = bsec_init_m(c->bsec);
+    if (bsec_status != BSEC_OK) {
+        ESP_LOGE(TAG, "BSEC init failed!");
+        return SENSOR_PIPELINE_E_BSEC;
+    }
+
+    /* Configuration, then state, both before the subscription and the first bsec_do_steps_m() */
+    bsec_apply_config(c->bsec);
+    bsec_state_init(&c->bsec_state, p->hal, c->bsec, bsec_state_keys[index], p->config.state_save_period_us);
+    bsec_state_restore(&c->bsec_state, p->hal->time_us(p->hal->ctx));
+
+    bsec_sensor_configuration_t virtual_sensors[10];
+    bsec_virtual_sensor_t sensor_list[] = {
+        BSEC_OUTPUT_IAQ,
+        BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE,
+        BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY,
+        BSEC_OUTPUT_RAW_PRESSURE,
+    };
+
+    uint8_t n_sensors = sizeof(sensor_list) / sizeof(sensor_list[0]);
+    for (uint8_t i = 0; i < n_sensors; i++) {
+        virtual_sensors[i].sensor_id = sensor_list[i];
+        virtual_sensors[i].sample_rate = BSEC_SAMPLE_RATE_LP;
+    }
+
+    bsec_sensor_configuration_t required_settings[BSEC_MAX_PHYSICAL_SENSOR];
+    uint8_t n_required = BSEC_MAX_PHYSICAL_SENSOR;
+
+    bsec_update_subscription_m(c->bsec, virtual_sensors, n_sensors, required_settings, &n_required);
+
+    return SENSOR_PIPELINE_OK;
+}
+
+/* The scan sensor is optional; without it the pipeline runs as before */
+static void scan_init(sensor_pipeline_t *p)
+{
+    sensor_channel_t *c = &p->scan_channel;
+
+    c->addr = p->config.scan_addr;
+    if (bme_init(p, c) != SENSOR_PIPELINE_OK) {
+        ESP_LOGW(TAG, "No BME68x at 0x%02X, heater scan disabled", c->addr);
+        return;
+    }
+
+    int ret = heater_scan_start(&p->scan, &c->bme_dev, &c->bme_conf, &p->config.scan_profile,
+                                p->hal->time_us(p->hal->ctx));
+    if (ret != HEATER_SCAN_OK) {
+        ESP_LOGE(TAG, "Heater scan start at 0x%02X failed: %d", c->addr, ret);
+        return;
+    }
+
+    p->scanning = 1;
+    ESP_LOGI(TAG, "Heater scan at 0x%02X: %u steps in %s mode, %u ms per pass", c->addr,
+             p->scan.profile.len, (p->scan.op_mode == BME68X_PARALLEL_MODE) ? "parallel" : "forced",
+             (unsigned)(heater_scan_pass_us(&p->scan) / 1000));
+}
+
+int sensor_pipeline_init(sensor_pipeline_t *p, const sensor_hal_t *hal, const sensor_pipeline_config_t *config)
+{
+    memset(p, 0, sizeof(*p));
+    p->hal = hal;
+    p->config = *config;
+    p->stats.accuracy3_us = -1;
+    pm_average_init(&p->pm_average);
+
+    size_t instance_size = bsec_get_instance_size_m();
+    if (instance_size > SENSOR_PIPELINE_BSEC_INSTANCE_MAX) {
+        ESP_LOGE(TAG, "BSEC instance needs %u bytes, arena slots hold %u",
+                 (unsigned)instance_size, (unsigned)SENSOR_PIPELINE_BSEC_INSTANCE_MAX);
+        return SENSOR_PIPELINE_E_BSEC;
+    }
+
+    pm_sensor_init(p);
+
+    uint8_t n_bme = (config->n_bme < SENSOR_PIPELINE_MAX_CHANNELS) ? config->n_bme : SENSOR_PIPELINE_MAX_CHANNELS;
+    for (uint8_t i = 0; i < n_bme; i++) {
+        sensor_channel_t *c = &p->channels[i];
+
+        c->addr = config->bme_addr[i];
+        if (bme_init(p, c) != SENSOR_PIPELINE_OK) {
+            if (i == SENSOR_CHANNEL_INTAKE) {
+                ESP_LOGE(TAG, "BME680 init failed at 0x%02X", c->addr);
+                return SENSOR_PIPELINE_E_BME;
+            }
+            /* Channels keep their index, so nothing after a missing sensor is used */
+            ESP_LOGW(TAG, "No BME680 at 0x%02X, continuing with %u channel(s)", c->addr, i);
+            break;
+        }
+
+        int ret = bsec_setup(p, i);
+        if (ret != SENSOR_PIPELINE_OK) {
+            return ret;
+        }
+        p->n_channels = i + 1;
+    }
+
+    ESP_LOGI(TAG, "%u BME680 channel(s), %u byte BSEC instances", p->n_channels, (unsigned)instance_size);
+
+    if (config->scan_addr != 0) {
+        scan_init(p);
+    }
+
+    return SENSOR_PIPELINE_OK;
+}
+
+void sensor_pipeline_log_timing(const sensor_pipeline_t *p)
+{
+    const sensor_acquire_timing_t *t = &p->stats.acquire;
+
+    if (t->cycles == 0) {
+        return;
+    }
+
+    uint64_t conversion = t->conversion_us / t->cycles;
+    uint64_t pm = t->pm_us / t->cycles;
+    uint64_t adc = t->adc_us / t->cycles;
+    uint64_t read = t->read_us / t->cycles;
+    uint64_t critical = t->critical_us / t->cycles;
+    /* The same steps one after the other, as before the reads were overlapped */
+    uint64_t sequential = conversion + ACQUIRE_MARGIN_US + read + pm + adc;
+
+    ESP_LOGI(TAG, "acquire n=%u: conversion %llu us, pm %llu us, adc %llu us, readout %llu us",
+             (unsigned)t->cycles, (unsigned long long)conversion, (unsigned long long)pm,
+             (unsigned long long)adc, (unsigned long long)read);
+    ESP_LOGI(TAG, "acquire critical path mean %llu us, max %u us; in sequence %llu us (saved %lld us)",
+             (unsigned long long)critical, (unsigned)t->max_critical_us, (unsigned long long)sequential,
+             (long long)(sequential - critical));
+}
+
+void sensor_pipeline_deinit(sensor_pipeline_t *p)
+{
+    if (p->pm_sensor != NULL) {
+        dfrobot_delete(p->pm_sensor);
+        p->pm_sensor = NULL;
+    }
+}
+
+/* ===== HEATER SCAN ===== */
+int64_t sensor_pipeline_scan_next_us(const sensor_pipeline_t *p)
+{
+    return p->scanning ? heater_scan_next_us(&p->scan) : INT64_MAX;
+}
+
+int sensor_pipeline_scan_poll(sensor_pipeline_t *p, heater_scan_vector_t *vector)
+{
+    if (!p->scanning) {
+        return 0;
+    }
+    return heater_scan_poll(&p->scan, p->hal->time_us(p->hal->ctx), vector);
+}
+
+/* ===== ACQUIRE ===== */
+static void read_pm_sensor(sensor_pipeline_t *p, sensor_raw_t *raw)
+{
+    DFRobot_AirQualityData pm;
+
+    raw->pm_valid = 0;
+    if (p->pm_sensor != NULL && dfrobot_read_all(p->pm_sensor, &pm)) {
+        raw->pm1_0 = pm.pm1_0_atmosphere;
+        raw->pm2_5 = pm.pm2_5_atmosphere;
+        raw->pm10 = pm.pm10_atmosphere;
+        raw->pm_valid = 1;
+    }
+}
+
+static void read_adc_channels(sensor_pipeline_t *p, sensor_raw_t *raw)
+{
+    const sensor_hal_t *hal = p->hal;
+
+    /* Prefer the filtered, calibrated readings of a background sampler */
+    if (hal->adc_sample != NULL &&
+        hal->adc_sample(hal->ctx, p->config.h2s_channel, &raw->h2s) == SENSOR_HAL_OK &&
+        hal->adc_sample(hal->ctx, p->config.odor_channel, &raw->odor) == SENSOR_HAL_OK) {
+        raw->h2s_raw = raw->h2s.raw;
+        raw->odor_raw = raw->odor.raw;
+        raw->adc_calibrated = 1;
+    } else if (hal->adc_read != NULL) {
+        hal->adc_read(hal->ctx, p->config.h2s_channel, &raw->h2s_raw);
+        hal->adc_read(hal->ctx, p->config.odor_channel, &raw->odor_raw);
+    }
+}
+
+/* BSEC is called from both the acquire and the process stage */
+static void bsec_lock(const sensor_hal_t *hal)
+{
+    if (hal->lock != NULL) {
+        hal->lock(hal->ctx);
+    }
+}
+
+static void bsec_unlock(const sensor_hal_t *hal)
+{
+    if (hal->unlock != NULL) {
+        hal->unlock(hal->ctx);
+    }
+}
+
+/* Fetch BSEC's settings for a measurement at now_us and its next deadline */
+static void bsec_control(sensor_pipeline_t *p, sensor_channel_t *c, int64_t now_us)
+{
+    bsec_lock(p->hal);
+    bsec_library_return_t status = bsec_sensor_control_m(c->bsec, now_us * 1000LL, &c->bsec_settings);
+    bsec_unlock(p->hal);
+
+    if (status < BSEC_OK || c->bsec_settings.next_call <= now_us * 1000LL) {
+        ESP_LOGW(TAG, "bsec_sensor_control(0x%02X) failed: %d", c->addr, status);
+        c->next_call_us = now_us + SENSOR_PIPELINE_PERIOD_US;
+    } else {
+        if (status != BSEC_OK) {
+            ESP_LOGD(TAG, "bsec_sensor_control(0x%02X) warning: %d", c->addr, status);
+        }
+        c->next_call_us = c->bsec_settings.next_call / 1000LL;
+    }
+}
+
+/*
+ * Bring oversampling and heater in line with BSEC's request. Only settings
+ * that changed are written, so a steady LP schedule costs no extra bus
+ * traffic. BSEC's parallel-mode profiles are not driven here; such a
+ * request runs as a forced measurement with the single heater step.
+ */
+static int apply_bsec_settings(sensor_channel_t *c)
+{
+    const bsec_bme_settings_t *s = &c->bsec_settings;
+    struct bme68x_conf conf = c->bme_conf;
+    struct bme68x_heatr_conf heatr = c->heatr_conf;
+
+    conf.os_temp = s->temperature_oversampling;
+    conf.os_pres = s->pressure_oversampling;
+    conf.os_hum = s->humidity_oversampling;
+    conf.filter = BME68X_FILTER_OFF;
+    conf.odr = BME68X_ODR_NONE;
+
+    if (conf.os_temp != c->bme_conf.os_temp || conf.os_pres != c->bme_conf.os_pres ||
+        conf.os_hum != c->bme_conf.os_hum || conf.filter != c->bme_conf.filter ||
+        conf.odr != c->bme_conf.odr) {
+        if (bme68x_set_conf(&conf, &c->bme_dev) != BME68X_OK) {
+            return SENSOR_PIPELINE_E_BME;
+        }
+        c->bme_conf = conf;
+    }
+
+    heatr.enable = s->run_gas ? BME68X_ENABLE : BME68X_DISABLE;
+    heatr.heatr_temp = s->heater_temperature;
+    heatr.heatr_dur = s->heater_duration;
+
+    if (heatr.enable != c->heatr_conf.enable || heatr.heatr_temp != c->heatr_conf.heatr_temp ||
+        heatr.heatr_dur != c->heatr_conf.heatr_dur) {
+        if (bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr, &c->bme_dev) != BME68X_OK) {
+            return SENSOR_PIPELINE_E_BME;
+        }
+        c->heatr_conf = heatr;
+    }
+
+    return SENSOR_PIPELINE_OK;
+}
+
+/*
+ * Start a forced measurement on one channel if its BSEC instance wants one.
+ * Does not wait; *ready_us is when the conversion will have finished.
+ */
+static int trigger_channel(sensor_pipeline_t *p, sensor_channel_t *c, sensor_raw_channel_t *rc, int64_t *ready_us)
+{
+    const sensor_hal_t *hal = p->hal;
+
+    /* BSEC wants the time the measurement was triggered */
+    rc->timestamp_us = hal->time_us(hal->ctx);
+    bsec_control(p, c, rc->timestamp_us);
+
+    if (!c->bsec_settings.trigger_measurement) {
+        return SENSOR_PIPELINE_E_SKIPPED;
+    }
+    rc->process_data = c->bsec_settings.process_data;
+
+    int ret = apply_bsec_settings(c);
+    if (ret != SENSOR_PIPELINE_OK) {
+        return ret;
+    }
+
+    if (bme68x_set_op_mode(BME68X_FORCED_MODE, &c->bme_dev) != BME68X_OK) {
+        return SENSOR_PIPELINE_E_BME;
+    }
+
+    /* TPH conversion plus the heater-on time of the gas measurement */
+    uint32_t meas_dur = bme68x_get_meas_dur(BME68X_FORCED_MODE, &c->bme_conf, &c->bme_dev);
+    if (c->heatr_conf.enable) {
+        meas_dur += (uint32_t)c->heatr_conf.heatr_dur * 1000;
+    }
+    *ready_us = hal->time_us(hal->ctx) + meas_dur;
+
+    return SENSOR_PIPELINE_OK;
+}
+
+int sensor_pipeline_acquire(sensor_pipeline_t *p, sensor_raw_t *raw)
+{
+    const sensor_hal_t *hal = p->hal;
+    uint8_t triggered[SENSOR_PIPELINE_MAX_CHANNELS] = { 0 };
+    uint8_t n_triggered = 0;
+    uint8_t n_valid = 0;
+    int64_t ready_us = 0;
+    int ret = SENSOR_PIPELINE_E_SKIPPED;
+
+    memset(raw, 0, sizeof(*raw));
+    raw->timestamp_us = hal->time_us(hal->ctx);
+
+    /* Start every conversion before waiting for any, so they run concurrently */
+    for (uint8_t i = 0; i < p->n_channels; i++) {
+        int64_t channel_ready_us = 0;
+        int status = trigger_channel(p, &p->channels[i], &raw->channels[i], &channel_ready_us);
+
+        if (status == SENSOR_PIPELINE_OK) {
+            triggered[i] = 1;
+            n_triggered++;
+            if (channel_ready_us > ready_us) {
+                ready_us = channel_ready_us;
+            }
+        } else if (status != SENSOR_PIPELINE_E_SKIPPED) {
+            ret = status;
+        }
+
+        if (i == 0 || p->channels[i].next_call_us < p->next_call_us) {
+            p->next_call_us = p->channels[i].next_call_us;
+        }
+    }
+
+    if (n_triggered == 0) {
+        return ret;
+    }
+
+    /* The BME680s convert on their own; use the window for the other sensors */
+    int64_t pm_start_us = hal->time_us(hal->ctx);
+    read_pm_sensor(p, raw);
+    int64_t adc_start_us = hal->time_us(hal->ctx);
+    read_adc_channels(p, raw);
+    int64_t adc_end_us = hal->time_us(hal->ctx);
+
+    int64_t wait_us = ready_us + ACQUIRE_MARGIN_US - adc_end_us;
+    if (wait_us > 0) {
+        hal->delay_us(hal->ctx, (uint32_t)wait_us);
+    }
+    int64_t read_start_us = hal->time_us(hal->ctx);
+
+    for (uint8_t i = 0; i < p->n_channels; i++) {
+        sensor_raw_channel_t *rc = &raw->channels[i];
+        uint8_t n_fields = 0;
+
+        if (!triggered[i]) {
+            continue;
+        }
+        int8_t status = bme68x_get_data(BME68X_FORCED_MODE, &rc->bme, &n_fields, &p->channels[i].bme_dev);
+        rc->valid = (status == BME68X_OK && n_fields > 0);
+        n_valid += rc->valid;
+    }
+
+    sensor_acquire_timing_t *t = &p->stats.acquire;
+    int64_t read_end_us = hal->time_us(hal->ctx);
+    int64_t critical_us = read_end_us - raw->timestamp_us;
+
+    t->cycles++;
+    t->conversion_us += (uint64_t)(ready_us - raw->timestamp_us);
+    t->pm_us += (uint64_t)(adc_start_us - pm_start_us);
+    t->adc_us += (uint64_t)(adc_end_us - adc_start_us);
+    t->read_us += (uint64_t)(read_end_us - read_start_us);
+    t->critical_us += (uint64_t)critical_us;
+    if ((uint32_t)critical_us > t->max_critical_us) {
+        t->max_critical_us = (uint32_t)critical_us;
+    }
+
+    return (n_valid > 0) ? SENSOR_PIPELINE_OK : SENSOR_PIPELINE_E_NO_DATA;
+}
+
+/* ===== PROCESS ===== */
+/* Time to full IAQ accuracy, the figure a restored state should shorten */
+static void track_accuracy(sensor_pipeline_t *p, int64_t timestamp_us)
+{
+    const sensor_channel_t *intake = &p->channels[SENSOR_CHANNEL_INTAKE];
+
+    if (p->stats.first_sample_us == 0) {
+        p->stats.first_sample_us = timestamp_us;
+    }
+
+    if (p->stats.accuracy3_us < 0 && intake->iaq_accuracy >= 3) {
+        p->stats.accuracy3_us = timestamp_us - p->stats.first_sample_us;
+        ESP_LOGI(TAG, "IAQ accuracy 3 after %lld s (%s start)",
+                 (long long)(p->stats.accuracy3_us / 1000000),
+                 intake->bsec_state.restored ? "warm" : "cold");
+    }
+}
+
+/* Run one channel's reading through its BSEC instance */
+static void process_channel(sensor_pipeline_t *p, sensor_channel_t *c, const sensor_raw_channel_t *rc)
+{
+    const struct bme68x_data *data = &rc->bme;
+    bsec_input_t inputs[4];
+    uint8_t n_inputs = 0;
+
+    int64_t timestamp_ns = rc->timestamp_us * 1000LL;
+
+    /* Only pass what BSEC asked for; skipped channels hold their last value */
+    if (rc->process_data & BSEC_PROCESS_TEMPERATURE) {
+        inputs[n_inputs].sensor_id = BSEC_INPUT_TEMPERATURE;
+        inputs[n_inputs].signal = data->temperature;
+        inputs[n_inputs].time_stamp = timestamp_ns;
+        n_inputs++;
+        c->temperature = data->temperature;
+    }
+
+    if (rc->process_data & BSEC_PROCESS_HUMIDITY) {
+        inputs[n_inputs].sensor_id = BSEC_INPUT_HUMIDITY;
+        inputs[n_inputs].signal = data->humidity;
+        inputs[n_inputs].time_stamp = timestamp_ns;
+        n_inputs++;
+        c->humidity = data->humidity;
+    }
+
+    /* bme68x reports pressure in Pa, which is what BSEC expects */
+    if (rc->process_data & BSEC_PROCESS_PRESSURE) {
+        inputs[n_inputs].sensor_id = BSEC_INPUT_PRESSURE;
+        inputs[n_inputs].signal = data->pressure;
+        inputs[n_inputs].time_stamp = timestamp_ns;
+        n_inputs++;
+        c->pressure = data->pressure;
+    }
+
+    bool gas_valid = (data->status & BME68X_GASM_VALID_MSK) && (data->status & BME68X_HEAT_STAB_MSK);
+    if ((rc->process_data & BSEC_PROCESS_GAS) && gas_valid) {
+        inputs[n_inputs].sensor_id = BSEC_INPUT_GASRESISTOR;
+        inputs[n_inputs].signal = (float)data->gas_resistance;
+        inputs[n_inputs].time_stamp = timestamp_ns;
+        n_inputs++;
+    }
+
+    bsec_output_t outputs[BSEC_NUMBER_OUTPUTS];
+    uint8_t n_outputs = BSEC_NUMBER_OUTPUTS;
+
+    bsec_lock(p->hal);
+    bsec_do_steps_m(c->bsec, inputs, n_inputs, outputs, &n_outputs);
+
+    /* Extract IAQ from BSEC outputs */
+    for (int i = 0; i < n_outputs; i++) {
+        if (outputs[i].sensor_id == BSEC_OUTPUT_IAQ) {
+            c->iaq = outputs[i].signal;
+            c->iaq_accuracy = outputs[i].accuracy;
+        }
+    }
+
+    bsec_state_maybe_save(&c->bsec_state, rc->timestamp_us, c->iaq_accuracy);
+    bsec_unlock(p->hal);
+}
+
+/* AQI of rolling means, -1 while there are none */
+static float average_aqi(const sensor_pipeline_t *p, const float pm[AQI_N_POLLUTANTS])
+{
+    aqi_result_t aqi;
+
+    aqi_compute(p->config.aqi_scale, pm, &aqi);
+    return (aqi.dominant < AQI_N_POLLUTANTS) ? aqi.index : -1.0f;
+}
+
+int sensor_pipeline_process(sensor_pipeline_t *p, const sensor_raw_t *raw, sensor_sample_t *sample)
+{
+    for (uint8_t i = 0; i < p->n_channels; i++) {
+        if (raw->channels[i].valid) {
+            process_channel(p, &p->channels[i], &raw->channels[i]);
+        }
+    }
+
+    track_accuracy(p, raw->timestamp_us);
+
+    sample->n_channels = p->n_channels;
+    for (uint8_t i = 0; i < p->n_channels; i++) {
+        const sensor_channel_t *c = &p->channels[i];
+
+        sample->channels[i].temperature = c->temperature;
+        sample->channels[i].humidity = c->humidity;
+        sample->channels[i].pressure = c->pressure / 100.0f;
+        sample->channels[i].iaq = c->iaq;
+    }
+
+    const sensor_channel_sample_t *intake = &sample->channels[SENSOR_CHANNEL_INTAKE];
+
+    sample->timestamp_us = raw->timestamp_us;
+    sample->temperature = intake->temperature;
+    sample->humidity = intake->humidity;
+    sample->pressure = intake->pressure;
+    sample->iaq = intake->iaq;
+    sample->h2s_raw = raw->h2s_raw;
+    sample->odor_raw = raw->odor_raw;
+    sample->h2s_mv = raw->adc_calibrated ? raw->h2s.mv : -1;
+    sample->odor_mv = raw->adc_calibrated ? raw->odor.mv : -1;
+    sample->h2s_noise_mv = raw->adc_calibrated ? raw->h2s.noise_mv : 0.0f;
+    sample->odor_noise_mv = raw->adc_calibrated ? raw->odor.noise_mv : 0.0f;
+    sample->pm1_0 = raw->pm1_0;
+    sample->pm2_5 = raw->pm2_5;
+    sample->pm10 = raw->pm10;
+
+    /* Without a PM reading the engine reports 0, "Unknown" and no pollutant */
+    float pm[AQI_N_POLLUTANTS] = { -1.0f, -1.0f };
+    if (raw->pm_valid) {
+        pm[AQI_POLLUTANT_PM2_5] = raw->pm2_5;
+        pm[AQI_POLLUTANT_PM10] = raw->pm10;
+    }
+
+    aqi_result_t aqi;
+    aqi_compute(p->config.aqi_scale, pm, &aqi);
+    sample->aqi = aqi.index;
+    sample->aqi_level = aqi.level;
+    sample->aqi_pollutant = aqi.dominant;
+
+    /* Rolling means move on with or without a reading */
+    const uint16_t reading[AQI_N_POLLUTANTS] = { raw->pm2_5, raw->pm10 };
+    pm_average_update(&p->pm_average, raw->timestamp_us, raw->pm_valid ? reading : NULL);
+    sample->pm_average = p->pm_average.values;
+    sample->aqi_1h = average_aqi(p, sample->pm_average.mean_1h);
+    sample->aqi_24h = average_aqi(p, sample->pm_average.mean_24h);
+    sample->aqi_nowcast = average_aqi(p, sample->pm_average.nowcast);
+
+    return SENSOR_PIPELINE_OK;
+}
+
+int sensor_pipeline_sample(sensor_pipeline_t *p, sensor_sample_t *sample)
+{
+    const sensor_hal_t *hal = p->hal;
+    sensor_raw_t raw;
+    uint32_t alloc_start = (hal->alloc_bytes != NULL) ? hal->alloc_bytes(hal->ctx) : 0;
+
+    int ret = sensor_pipeline_acquire(p, &raw);
+    if (ret == SENSOR_PIPELINE_OK) {
+        ret = sensor_pipeline_process(p, &raw, sample);
+    }
+
+    if (hal->alloc_bytes != NULL) {
+        p->stats.alloc_bytes = hal->alloc_bytes(hal->ctx) - alloc_start;
+        p->stats.alloc_bytes_total += p->stats.alloc_bytes;
+    }
+    p->stats.samples++;
+
+    return ret;
+}
+
+/* ===== OUTPUT ===== */
+/* snprintf at the end of what is already in buf, with snprintf's return convention overall */
+static void json_append(char *buf, size_t len, int *n, const char *fmt, ...)
+{
+    size_t used = ((size_t)*n < len) ? (size_t)*n : len;
+    va_list ap;
+
+    if (*n < 0) {
+        return;
+    }
+    va_start(ap, fmt);
+    int r = vsnprintf(buf + used, len - used, fmt, ap);
+    va_end(ap);
+    *n = (r < 0) ? r : *n + r;
+}
+
+int sensor_pipeline_format_json(const sensor_sample_t *s, char *buf, size_t len)
+{
+    int n = 0;
+
+    json_append(buf, len, &n,
+                "{\"temperature\":%.2f,\"humidity\":%.2f,\"pressure\":%.2f,\"iaq\":%.1f,\"h2s\":%d,\"odor\":%d,\"pm1_0\":%u,\"pm2_5\":%u,\"pm10\":%u,\"aqi\":%.1f,\"aqi_level\":\"%s\"",
+                s->temperature, s->humidity, s->pressure, s->iaq, s->h2s_raw, s->odor_raw,
+                s->pm1_0, s->pm2_5, s->pm10, s->aqi, s->aqi_level);
+
+    if (s->aqi_pollutant < AQI_N_POLLUTANTS) {
+        json_append(buf, len, &n, ",\"aqi_pollutant\":\"%s\"", aqi_pollutant_names[s->aqi_pollutant]);
+    }
+
+    /* Rolling values once there is enough data for them */
+    const struct {
+        const char *key;
+        float value;
+    } averages[] = {
+        { "aqi_nowcast", s->aqi_nowcast },
+        { "aqi_1h", s->aqi_1h },
+        { "aqi_24h", s->aqi_24h },
+        { "pm2_5_nowcast", s->pm_average.nowcast[AQI_POLLUTANT_PM2_5] },
+        { "pm2_5_1h", s->pm_average.mean_1h[AQI_POLLUTANT_PM2_5] },
+        { "pm2_5_24h", s->pm_average.mean_24h[AQI_POLLUTANT_PM2_5] },
+        { "pm10_nowcast", s->pm_average.nowcast[AQI_POLLUTANT_PM10] },
+        { "pm10_1h", s->pm_average.mean_1h[AQI_POLLUTANT_PM10] },
+        { "pm10_24h", s->pm_average.mean_24h[AQI_POLLUTANT_PM10] },
+    };
+    for (size_t i = 0; i < sizeof(averages) / sizeof(averages[0]); i++) {
+        if (averages[i].value >= 0.0f) {
+            json_append(buf, len, &n, ",\"%s\":%.1f", averages[i].key, averages[i].value);
+        }
+    }
+
+    if (s->h2s_mv >= 0 && s->odor_mv >= 0) {
+        json_append(buf, len, &n,
+                    ",\"h2s_voltage\":%.3f,\"odor_voltage\":%.3f,\"h2s_noise_mv\":%.2f,\"odor_noise_mv\":%.2f",
+                    s->h2s_mv / 1000.0, s->odor_mv / 1000.0, s->h2s_noise_mv, s->odor_noise_mv);
+    }
+
+    if (s->n_channels > SENSOR_CHANNEL_EXHAUST) {
+        const sensor_channel_sample_t *x = &s->channels[SENSOR_CHANNEL_EXHAUST];
+
+        json_append(buf, len, &n,
+                    ",\"exhaust\":{\"temperature\":%.2f,\"humidity\":%.2f,\"pressure\":%.2f,\"iaq\":%.1f}",
+                    x->temperature, x->humidity, x->pressure, x->iaq);
+    }
+
+    json_append(buf, len, &n, "}");
+    return n;
+}
+
+int sensor_pipeline_format_scan_json(const heater_scan_vector_t *v, char *buf, size_t len)
+{
+    int n = 0;
+
+    json_append(buf, len, &n,
+                "{\"gas_scan\":{\"seq\":%u,\"timestamp_ms\":%u,\"temperature\":%.2f,\"humidity\":%.2f,\"pressure\":%.2f,\"stable\":%u,\"gas\":[",
+                (unsigned)v->seq, (unsigned)(v->timestamp_us / 1000), v->temperature, v->humidity, v->pressure,
+                (unsigned)v->stable_mask);
+
+    for (uint8_t i = 0; i < v->n_steps; i++) {
+        json_append(buf, len, &n, (i == 0) ? "%.0f" : ",%.0f", v->gas_ohm[i]);
+    }
+
+    json_append(buf, len, &n, "]}}");
+    return n;
+}
@@ -0,0 +1,236 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sensor_hal.h"
+#include "aqi.h"
+#include "bme68x.h"
+#include "bsec_datatypes.h"
+#include "DFRobot_AirQualitySensor.h"
+#include "bsec_state.h"
+#include "heater_scan.h"
+#include "pm_average.h"
+
+/*
+ * Portable acquisition -> BSEC -> AQI -> output pipeline.
+ *
+ * The pipeline owns the BME680 driver state and the PM sensor handle and only
+ * talks to the platform through a sensor_hal_t, so it builds unchanged for the
+ * ESP32 firmware and for the Linux simulation in host/.
+ *
+ * Up to SENSOR_PIPELINE_MAX_CHANNELS BME680s share the bus, each with its own
+ * BSEC instance carved from a fixed arena in the pipeline. Their forced
+ * measurements are triggered back to back so the conversions overlap and a
+ * cycle takes as long as the slowest sensor rather than the sum.
+ *
+ * Optionally one more BME68x runs a heater profile scan (heater_scan.h)
+ * instead of BSEC. It is polled on its own schedule with
+ * sensor_pipeline_scan_poll() and yields one gas vector per profile pass.
+ *
+ * One cycle is split into stages so callers can run them back to back
+ * (sensor_pipeline_sample) or schedule them separately:
+ *   acquire -> raw readings from the bus and ADC
+ *   process -> BSEC, AQI and rolling PM means (pm_average.h) on a raw reading
+ *   format  -> serialized output of a processed sample
+ */
+
+#define SENSOR_PIPELINE_OK          0
+#define SENSOR_PIPELINE_E_BME      -1
+#define SENSOR_PIPELINE_E_BSEC     -2
+#define SENSOR_PIPELINE_E_NO_DATA  -3
+#define SENSOR_PIPELINE_E_SKIPPED  -4   /* BSEC did not request a measurement */
+
+/* Cycle period used when BSEC cannot provide one (LP mode spacing) */
+#define SENSOR_PIPELINE_PERIOD_US   3000000
+
+/* BME680 channels: the intake sensor is required, the exhaust one optional */
+#define SENSOR_PIPELINE_MAX_CHANNELS    2
+#define SENSOR_CHANNEL_INTAKE           0
+#define SENSOR_CHANNEL_EXHAUST          1
+
+/* Arena slot per BSEC instance; init fails if bsec_get_instance_size_m() exceeds it */
+#define SENSOR_PIPELINE_BSEC_INSTANCE_MAX   4096
+
+typedef struct {
+    uint8_t bme_addr[SENSOR_PIPELINE_MAX_CHANNELS];
+    uint8_t n_bme;
+    uint8_t pm_addr;        /* 0 disables the PM sensor */
+    uint8_t h2s_channel;
+    uint8_t odor_channel;
+    int64_t state_save_period_us;   /* BSEC state persistence, 0 disables it */
+    uint8_t scan_addr;      /* BME68x for the heater profile scan, 0 disables it */
+    heater_profile_t scan_profile;
+    uint8_t aqi_scale;      /* AQI_SCALE_* */
+} sensor_pipeline_config_t;
+
+/* One BME680 reading of the acquire stage */
+typedef struct {
+    struct bme68x_data bme;
+    int64_t timestamp_us;   /* trigger time, what BSEC is given */
+    uint32_t process_data;  /* BSEC_PROCESS_* channels BSEC asked for */
+    uint8_t valid;
+} sensor_raw_channel_t;
+
+/* Output of the acquire stage */
+typedef struct {
+    sensor_raw_channel_t channels[SENSOR_PIPELINE_MAX_CHANNELS];
+    int64_t timestamp_us;
+    uint16_t pm1_0;
+    uint16_t pm2_5;
+    uint16_t pm10;
+    uint8_t pm_valid;
+    int h2s_raw;
+    int odor_raw;
+    sensor_hal_adc_sample_t h2s;    /* filtered and calibrated, when adc_calibrated */
+    sensor_hal_adc_sample_t odor;
+    uint8_t adc_calibrated;
+} sensor_raw_t;
+
+/* Processed values of one BME680 */
+typedef struct {
+    float temperature;      /* degC */
+    float humidity;         /* %RH */
+    float pressure;         /* hPa */
+    float iaq;
+} sensor_channel_sample_t;
+
+/* Output of the process stage; the top-level BME680 values are the intake channel's */
+typedef struct {
+    int64_t timestamp_us;
+    float temperature;      /* degC */
+    float humidity;         /* %RH */
+    float pressure;         /* hPa */
+    float iaq;
+    int h2s_raw;
+    int odor_raw;
+    int h2s_mv;             /* -1 without a calibrated background sampler */
+    int odor_mv;
+    float h2s_noise_mv;
+    float odor_noise_mv;
+    uint16_t pm1_0;
+    uint16_t pm2_5;
+    uint16_t pm10;
+    float aqi;
+    const char *aqi_level;
+    uint8_t aqi_pollutant;  /* dominant, AQI_POLLUTANT_*; AQI_N_POLLUTANTS without PM readings */
+    float aqi_nowcast;      /* AQI of the rolling means below, -1 while there are none */
+    float aqi_1h;
+    float aqi_24h;
+    pm_average_values_t pm_average;
+    uint8_t n_channels;
+    sensor_channel_sample_t channels[SENSOR_PIPELINE_MAX_CHANNELS];
+} sensor_sample_t;
+
+/* Where the acquire stage's time goes; the PM and ADC reads overlap the conversion */
+typedef struct {
+    uint32_t cycles;
+    uint64_t conversion_us;     /* cycle start until the slowest conversion is done */
+    uint64_t pm_us;
+    uint64_t adc_us;
+    uint64_t read_us;           /* BME680 field readout after the conversion */
+    uint64_t critical_us;       /* cycle start until the last field is read */
+    uint32_t max_critical_us;
+} sensor_acquire_timing_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t alloc_bytes;       /* heap bytes allocated by the last sensor_pipeline_sample() */
+    uint64_t alloc_bytes_total;
+    int64_t first_sample_us;    /* timestamp of the first processed sample */
+    int64_t accuracy3_us;       /* from the first sample to intake IAQ accuracy 3, -1 until then */
+    sensor_acquire_timing_t acquire;
+} sensor_pipeline_stats_t;
+
+typedef struct {
+    uint8_t addr;
+    void *bsec;             /* BSEC instance in the pipeline's arena */
+
+    struct bme68x_dev bme_dev;
+    struct bme68x_conf bme_conf;
+    struct bme68x_heatr_conf heatr_conf;
+    sensor_hal_dev_t bme_bus;
+
+    /* Last IAQ reported by BSEC, kept across cycles without an IAQ output */
+    float iaq;
+    uint8_t iaq_accuracy;
+
+    bsec_state_t bsec_state;
+
+    /* Last measured values, kept across cycles where BSEC skips a channel */
+    float temperature;
+    float humidity;
+    float pressure;         /* Pa */
+
+    /* Settings from the last bsec_sensor_control_m() and when BSEC wants the next cycle */
+    bsec_bme_settings_t bsec_settings;
+    int64_t next_call_us;
+} sensor_channel_t;
+
+typedef struct {
+    const sensor_hal_t *hal;
+    sensor_pipeline_config_t config;
+
+    sensor_channel_t channels[SENSOR_PIPELINE_MAX_CHANNELS];
+    uint8_t n_channels;
+
+    DFRobot_AirQualitySensor *pm_sensor;
+    pm_average_t pm_average;
+
+    /* Earliest next_call_us of the channels */
+    int64_t next_call_us;
+
+    /* Heater profile scan, when config.scan_addr is set and the sensor answered */
+    sensor_channel_t scan_channel;
+    heater_scan_t scan;
+    uint8_t scanning;
+
+    sensor_pipeline_stats_t stats;
+
+    /* BSEC instance memory; the pipeline is statically allocated, so this stays off the heap */
+    uint8_t bsec_arena[SENSOR_PIPELINE_MAX_CHANNELS][SENSOR_PIPELINE_BSEC_INSTANCE_MAX] __attribute__((aligned(8)));
+} sensor_pipeline_t;
+
+/* Default configuration matching the reference board wiring */
+void sensor_pipeline_default_config(sensor_pipeline_config_t *config);
+
+/*
+ * Bring up the BME680s, the optional PM sensor and one BSEC instance per
+ * BME680, restoring their stored states. Only the first BME680 is required.
+ */
+int sensor_pipeline_init(sensor_pipeline_t *p, const sensor_hal_t *hal, const sensor_pipeline_config_t *config);
+
+/*
+ * Ask each BSEC instance for the cycle's settings, apply them and trigger the
+ * forced measurements, read the PM and ADC channels while they convert, then
+ * wait for the slowest and read the results.
+ * Returns SENSOR_PIPELINE_E_SKIPPED when no instance asked for a measurement.
+ * Updates p->next_call_us either way.
+ */
+int sensor_pipeline_acquire(sensor_pipeline_t *p, sensor_raw_t *raw);
+
+/* Run BSEC and the AQI calculation on one raw reading */
+int sensor_pipeline_process(sensor_pipeline_t *p, const sensor_raw_t *raw, sensor_sample_t *sample);
+
+/* acquire + process */
+int sensor_pipeline_sample(sensor_pipeline_t *p, sensor_sample_t *sample);
+
+/* Serialize a sample as one JSON line (without newline); returns snprintf length */
+int sensor_pipeline_format_json(const sensor_sample_t *sample, char *buf, size_t len);
+
+/* When the heater scan next has a step to read; INT64_MAX without one */
+int64_t sensor_pipeline_scan_next_us(const sensor_pipeline_t *p);
+
+/* Read the scan's finished steps; returns 1 and fills `vector` when a pass completed */
+int sensor_pipeline_scan_poll(sensor_pipeline_t *p, heater_scan_vector_t *vector);
+
+/* Serialize a scan vector as one JSON line (without newline); returns snprintf length */
+int sensor_pipeline_format_scan_json(const heater_scan_vector_t *vector, char *buf, size_t len);
+
+/* Log the acquire timing: critical path against the sum of its parts */
+void sensor_pipeline_log_timing(const sensor_pipeline_t *p);
+
+void sensor_pipeline_deinit(sensor_pipeline_t *p);
+
+#endif
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "sensor_scheduler.h"
+
+static const char *TAG = "SCHED";
+
+const uint32_t sensor_sched_hist_edges_us[SENSOR_SCHED_HIST_BUCKETS - 1] = {
+    10, 50, 100, 250, 500, 1000, 5000, 10000,
+};
+
+static void hist_add(uint32_t *hist, int64_t us)
+{
+    int i;
+
+    if (us < 0) {
+        us = -us;
+    }
+    for (i = 0; i < SENSOR_SCHED_HIST_BUCKETS - 1; i++) {
+        if (us < sensor_sched_hist_edges_us[i]) {
+            break;
+        }
+    }
+    hist[i]++;
+}
+
+void sensor_scheduler_init(sensor_scheduler_t *s, sensor_pipeline_t *pipeline)
+{
+    memset(s, 0, sizeof(*s));
+    s->pipeline = pipeline;
+}
+
+/* Sleep until the deadline and record how late the wake-up was */
+static void wait_deadline(sensor_scheduler_t *s)
+{
+    const sensor_hal_t *hal = s->pipeline->hal;
+    int64_t now = hal->time_us(hal->ctx);
+
+    if (s->deadline_us == 0) {
+        s->deadline_us = now;
+    } else if (now < s->deadline_us) {
+        hal->delay_us(hal->ctx, (uint32_t)(s->deadline_us - now));
+        now = hal->time_us(hal->ctx);
+    } else {
+        s->stats.overruns++;
+    }
+
+    int64_t late = now - s->deadline_us;
+    s->stats.cycles++;
+    s->stats.total_late_us += late;
+    if (late > s->stats.max_late_us) {
+        s->stats.max_late_us = late;
+    }
+    hist_add(s->stats.late_hist, late);
+    if (s->stats.cycles > 1) {
+        hist_add(s->stats.period_hist, (now - s->last_wake_us) - (s->deadline_us - s->last_deadline_us));
+    }
+    s->last_wake_us = now;
+    s->last_deadline_us = s->deadline_us;
+}
+
+static void advance_deadline(sensor_scheduler_t *s)
+{
+    /* A non-advancing next_call would spin; fall back to the nominal period */
+    if (s->pipeline->next_call_us > s->deadline_us) {
+        s->deadline_us = s->pipeline->next_call_us;
+    } else {
+        s->deadline_us += SENSOR_PIPELINE_PERIOD_US;
+    }
+}
+
+int sensor_scheduler_run(sensor_scheduler_t *s, sensor_sample_t *sample)
+{
+    wait_deadline(s);
+    int ret = sensor_pipeline_sample(s->pipeline, sample);
+    advance_deadline(s);
+
+    return ret;
+}
+
+int sensor_scheduler_acquire(sensor_scheduler_t *s, sensor_raw_t *raw)
+{
+    wait_deadline(s);
+    int ret = sensor_pipeline_acquire(s->pipeline, raw);
+    advance_deadline(s);
+
+    return ret;
+}
+
+static void log_hist(const char *name, const uint32_t *hist)
+{
+    char line[160];
+    int len = 0;
+
+    for (int i = 0; i < SENSOR_SCHED_HIST_BUCKETS && len < (int)sizeof(line); i++) {
+        if (i < SENSOR_SCHED_HIST_BUCKETS - 1) {
+            len += snprintf(line + len, sizeof(line) - len, " <%uus:%u",
+                            (unsigned)sensor_sched_hist_edges_us[i], (unsigned)hist[i]);
+        } else {
+            len += snprintf(line + len, sizeof(line) - len, " more:%u", (unsigned)hist[i]);
+        }
+    }
+    ESP_LOGI(TAG, "%s%s", name, line);
+}
+
+void sensor_scheduler_log_stats(const sensor_scheduler_t *s)
+{
+    if (s->stats.cycles == 0) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "cycles %u, overruns %u, mean late %lld us, max late %lld us",
+             (unsigned)s->stats.cycles, (unsigned)s->stats.overruns,
+             (long long)(s->stats.total_late_us / s->stats.cycles), (long long)s->stats.max_late_us);
+    log_hist("late:  ", s->stats.late_hist);
+    log_hist("period:", s->stats.period_hist);
+}
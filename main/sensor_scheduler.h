@@ -0,0 +1,53 @@
+#ifndef SENSOR_SCHEDULER_H
+#define SENSOR_SCHEDULER_H
+
+#include <stdint.h>
+
+#include "sensor_pipeline.h"
+
+/*
+ * Deadline-driven measurement loop.
+ *
+ * Each cycle starts at the next_call BSEC returned from the previous
+ * bsec_sensor_control(), so the period does not stretch by the time spent
+ * measuring and processing. The wait goes through the HAL delay, which on
+ * the ESP32 sleeps on a one-shot esp_timer with microsecond resolution.
+ *
+ * Wake-up lateness and the error of each period against BSEC's spacing are
+ * kept as histograms with bucket edges in sensor_sched_hist_edges_us.
+ */
+
+#define SENSOR_SCHED_HIST_BUCKETS   9
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t overruns;          /* deadline had already passed when the wait started */
+    int64_t max_late_us;
+    int64_t total_late_us;
+    uint32_t late_hist[SENSOR_SCHED_HIST_BUCKETS];    /* wake-up time - deadline */
+    uint32_t period_hist[SENSOR_SCHED_HIST_BUCKETS];  /* |actual period - BSEC period| */
+} sensor_sched_stats_t;
+
+typedef struct {
+    sensor_pipeline_t *pipeline;
+    int64_t deadline_us;        /* 0 runs the first cycle immediately */
+    int64_t last_wake_us;
+    int64_t last_deadline_us;
+    sensor_sched_stats_t stats;
+} sensor_scheduler_t;
+
+/* Upper bounds of all but the last (open-ended) histogram bucket */
+extern const uint32_t sensor_sched_hist_edges_us[SENSOR_SCHED_HIST_BUCKETS - 1];
+
+void sensor_scheduler_init(sensor_scheduler_t *s, sensor_pipeline_t *pipeline);
+
+/* Sleep until the next deadline and run one pipeline cycle; returns its status */
+int sensor_scheduler_run(sensor_scheduler_t *s, sensor_sample_t *sample);
+
+/* Same, but only the acquire stage, for callers that process elsewhere */
+int sensor_scheduler_acquire(sensor_scheduler_t *s, sensor_raw_t *raw);
+
+/* Log the counters and both histograms */
+void sensor_scheduler_log_stats(const sensor_scheduler_t *s);
+
+#endif
@@ -0,0 +1,228 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "spsc_ring.h"
+#include "sensor_tasks.h"
+
+static const char *TAG = "TASKS";
+
+#define ACQUIRE_CORE            1
+#define PROCESS_CORE            0
+#define OUTPUT_CORE             0
+#define SCAN_CORE               1
+
+#define ACQUIRE_PRIORITY        6
+#define PROCESS_PRIORITY        5
+#define OUTPUT_PRIORITY         4
+#define SCAN_PRIORITY           5
+
+#define ACQUIRE_STACK_SIZE      4096
+#define PROCESS_STACK_SIZE      8192
+#define OUTPUT_STACK_SIZE       4096
+#define SCAN_STACK_SIZE         4096
+
+#define RAW_RING_LEN            4
+#define SAMPLE_RING_LEN         8
+#define SCAN_RING_LEN           4
+
+typedef struct {
+    sensor_raw_t raw;
+    int64_t ready_us;
+} raw_item_t;
+
+typedef struct {
+    sensor_sample_t sample;
+    int64_t ready_us;
+} sample_item_t;
+
+static sensor_pipeline_t *pipeline;
+static sensor_scheduler_t *scheduler;
+static sensor_output_fn output_fn;
+static sensor_scan_output_fn scan_output_fn;
+
+static raw_item_t raw_storage[RAW_RING_LEN];
+static sample_item_t sample_storage[SAMPLE_RING_LEN];
+static heater_scan_vector_t scan_storage[SCAN_RING_LEN];
+static spsc_ring_t raw_ring;
+static spsc_ring_t sample_ring;
+static spsc_ring_t scan_ring;
+
+static TaskHandle_t process_task_handle;
+static TaskHandle_t output_task_handle;
+
+static StaticTask_t acquire_tcb, process_tcb, output_tcb, scan_tcb;
+static StackType_t acquire_stack[ACQUIRE_STACK_SIZE];
+static StackType_t process_stack[PROCESS_STACK_SIZE];
+static StackType_t output_stack[OUTPUT_STACK_SIZE];
+static StackType_t scan_stack[SCAN_STACK_SIZE];
+
+static sensor_task_stats_t stats;
+
+static void stage_add(sensor_stage_stat_t *stat, int64_t us)
+{
+    stat->count++;
+    stat->total_us += (uint64_t)us;
+    if ((uint32_t)us > stat->max_us) {
+        stat->max_us = (uint32_t)us;
+    }
+}
+
+/* ===== TASKS ===== */
+static void acquire_task(void *arg)
+{
+    raw_item_t item;
+
+    while (1) {
+        int ret = sensor_scheduler_acquire(scheduler, &item.raw);
+        if (ret == SENSOR_PIPELINE_E_SKIPPED) {
+            continue;
+        }
+        if (ret != SENSOR_PIPELINE_OK) {
+            stats.acquire_failures++;
+            continue;
+        }
+
+        item.ready_us = esp_timer_get_time();
+        stage_add(&stats.acquire, item.ready_us - item.raw.timestamp_us);
+
+        if (!spsc_ring_push(&raw_ring, &item)) {
+            stats.raw_drops++;
+            continue;
+        }
+        xTaskNotifyGive(process_task_handle);
+    }
+}
+
+static void process_task(void *arg)
+{
+    raw_item_t in;
+    sample_item_t out;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (spsc_ring_pop(&raw_ring, &in)) {
+            int64_t start = esp_timer_get_time();
+            stage_add(&stats.queue, start - in.ready_us);
+
+            if (sensor_pipeline_process(pipeline, &in.raw, &out.sample) != SENSOR_PIPELINE_OK) {
+                stats.process_failures++;
+                continue;
+            }
+
+            out.ready_us = esp_timer_get_time();
+            stage_add(&stats.process, out.ready_us - start);
+
+            if (!spsc_ring_push(&sample_ring, &out)) {
+                stats.sample_drops++;
+                continue;
+            }
+            xTaskNotifyGive(output_task_handle);
+        }
+    }
+}
+
+static void output_task(void *arg)
+{
+    sample_item_t item;
+    heater_scan_vector_t vector;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (spsc_ring_pop(&sample_ring, &item)) {
+            output_fn(&item.sample);
+            stage_add(&stats.output, esp_timer_get_time() - item.ready_us);
+        }
+        while (spsc_ring_pop(&scan_ring, &vector)) {
+            scan_output_fn(&vector);
+        }
+    }
+}
+
+/* Fields buffer three conversions deep, so waking on the scan's schedule loses none */
+static void scan_task(void *arg)
+{
+    const sensor_hal_t *hal = pipeline->hal;
+    heater_scan_vector_t vector;
+
+    while (1) {
+        int64_t wait = sensor_pipeline_scan_next_us(pipeline) - esp_timer_get_time();
+        if (wait > 0) {
+            hal->delay_us(hal->ctx, (uint32_t)wait);
+        }
+
+        if (sensor_pipeline_scan_poll(pipeline, &vector) != 1) {
+            continue;
+        }
+        if (!spsc_ring_push(&scan_ring, &vector)) {
+            stats.scan_drops++;
+            continue;
+        }
+        xTaskNotifyGive(output_task_handle);
+    }
+}
+
+/* ===== PUBLIC API ===== */
+esp_err_t sensor_tasks_start(sensor_pipeline_t *p, sensor_scheduler_t *s, sensor_output_fn output,
+                             sensor_scan_output_fn scan_output)
+{
+    pipeline = p;
+    scheduler = s;
+    output_fn = output;
+    scan_output_fn = scan_output;
+
+    spsc_ring_init(&raw_ring, raw_storage, sizeof(raw_item_t), RAW_RING_LEN);
+    spsc_ring_init(&sample_ring, sample_storage, sizeof(sample_item_t), SAMPLE_RING_LEN);
+    spsc_ring_init(&scan_ring, scan_storage, sizeof(heater_scan_vector_t), SCAN_RING_LEN);
+
+    /* Consumers first so the producers always have a task to notify */
+    output_task_handle = xTaskCreateStaticPinnedToCore(output_task, "output", OUTPUT_STACK_SIZE, NULL,
+                                                       OUTPUT_PRIORITY, output_stack, &output_tcb, OUTPUT_CORE);
+    process_task_handle = xTaskCreateStaticPinnedToCore(process_task, "process", PROCESS_STACK_SIZE, NULL,
+                                                        PROCESS_PRIORITY, process_stack, &process_tcb, PROCESS_CORE);
+    TaskHandle_t acquire = xTaskCreateStaticPinnedToCore(acquire_task, "acquire", ACQUIRE_STACK_SIZE, NULL,
+                                                         ACQUIRE_PRIORITY, acquire_stack, &acquire_tcb, ACQUIRE_CORE);
+
+    if (output_task_handle == NULL || process_task_handle == NULL || acquire == NULL) {
+        ESP_LOGE(TAG, "Failed to create pipeline tasks");
+        return ESP_FAIL;
+    }
+
+    if (p->scanning && scan_output != NULL &&
+        xTaskCreateStaticPinnedToCore(scan_task, "scan", SCAN_STACK_SIZE, NULL,
+                                      SCAN_PRIORITY, scan_stack, &scan_tcb, SCAN_CORE) == NULL) {
+        ESP_LOGE(TAG, "Failed to create scan task");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+const sensor_task_stats_t *sensor_tasks_stats(void)
+{
+    return &stats;
+}
+
+static void log_stage(const char *name, const sensor_stage_stat_t *stat)
+{
+    if (stat->count == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "%-8s n=%u mean %llu us, max %u us", name, (unsigned)stat->count,
+             (unsigned long long)(stat->total_us / stat->count), (unsigned)stat->max_us);
+}
+
+void sensor_tasks_log_stats(void)
+{
+    log_stage("acquire", &stats.acquire);
+    log_stage("queue", &stats.queue);
+    log_stage("process", &stats.process);
+    log_stage("output", &stats.output);
+    ESP_LOGI(TAG, "drops raw %u, sample %u, scan %u, failures acquire %u, process %u",
+             (unsigned)stats.raw_drops, (unsigned)stats.sample_drops, (unsigned)stats.scan_drops,
+             (unsigned)stats.acquire_failures, (unsigned)stats.process_failures);
+}
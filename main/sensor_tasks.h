@@ -0,0 +1,62 @@
+#ifndef SENSOR_TASKS_H
+#define SENSOR_TASKS_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sensor_pipeline.h"
+#include "sensor_scheduler.h"
+
+/*
+ * Pipelined firmware loop.
+ *
+ *   acquisition task (core 1)  --raw ring-->  processing task (core 0)
+ *                                                   |
+ *                              output task (core 0) <--sample ring--
+ *
+ * Acquisition only triggers and reads sensors on the BSEC schedule, so a
+ * slow UART or transport write never delays the next BME680 trigger. The
+ * rings are lock-free SPSC buffers in static memory; consumers sleep on a
+ * task notification until the producer pushes.
+ *
+ * With a heater scan sensor, a fourth task (core 1) reads it on the scan's
+ * own schedule and hands each finished pass to the output task through a
+ * third ring, so both kinds of record go out from one task.
+ */
+
+typedef void (*sensor_output_fn)(const sensor_sample_t *sample);
+typedef void (*sensor_scan_output_fn)(const heater_scan_vector_t *vector);
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+} sensor_stage_stat_t;
+
+typedef struct {
+    sensor_stage_stat_t acquire;    /* trigger to raw reading ready */
+    sensor_stage_stat_t queue;      /* raw reading waiting for the processing task */
+    sensor_stage_stat_t process;    /* BSEC and AQI */
+    sensor_stage_stat_t output;     /* sample ready to output done */
+    uint32_t raw_drops;             /* raw ring full */
+    uint32_t sample_drops;          /* sample ring full */
+    uint32_t scan_drops;            /* scan ring full */
+    /* One writer each: the acquire and process tasks run on different cores */
+    uint32_t acquire_failures;      /* acquire errors */
+    uint32_t process_failures;      /* BSEC or AQI errors */
+} sensor_task_stats_t;
+
+/*
+ * Start the three tasks, and the scan task when the pipeline has a scan
+ * sensor; `output` and `scan_output` run on the output task for every sample
+ * and every scan pass
+ */
+esp_err_t sensor_tasks_start(sensor_pipeline_t *pipeline, sensor_scheduler_t *scheduler, sensor_output_fn output,
+                             sensor_scan_output_fn scan_output);
+
+const sensor_task_stats_t *sensor_tasks_stats(void);
+
+/* Log per-stage latency (mean/max) and drop counters */
+void sensor_tasks_log_stats(void);
+
+#endif
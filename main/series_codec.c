@@ -0,0 +1,248 @@
+#include <string.h>
+
+#include "series_codec.h"
+
+/* ===== BITS ===== */
+void series_writer_init(series_writer_t *w, uint8_t *buf, uint32_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->bits = 0;
+}
+
+void series_reader_init(series_reader_t *r, const uint8_t *buf, uint32_t len)
+{
+    r->buf = buf;
+    r->len = len;
+    r->bits = 0;
+}
+
+uint32_t series_writer_bytes(const series_writer_t *w)
+{
+    return (w->bits + 7) / 8;
+}
+
+/* Low `n` bits of v, n <= 32; the caller has checked the room */
+static void put_bits(series_writer_t *w, uint32_t v, uint32_t n)
+{
+    while (n > 0) {
+        uint32_t used = w->bits & 7;
+        uint32_t room = 8 - used;
+        uint32_t take = (n < room) ? n : room;
+        uint8_t part = (uint8_t)((v >> (n - take)) & ((1u << take) - 1));
+        uint8_t *b = &w->buf[w->bits >> 3];
+
+        *b = (uint8_t)((used ? *b : 0) | (part << (room - take)));
+        w->bits += take;
+        n -= take;
+    }
+}
+
+static int has_bits(const series_reader_t *r, uint32_t n)
+{
+    return r->bits + n <= r->len * 8;
+}
+
+/* Next `n` bits, n <= 32; the caller has checked they are there */
+static uint32_t get_bits(series_reader_t *r, uint32_t n)
+{
+    uint32_t v = 0;
+
+    while (n > 0) {
+        uint32_t used = r->bits & 7;
+        uint32_t room = 8 - used;
+        uint32_t take = (n < room) ? n : room;
+        uint8_t b = r->buf[r->bits >> 3];
+
+        v = (v << take) | ((uint32_t)(b >> (room - take)) & ((1u << take) - 1));
+        r->bits += take;
+        n -= take;
+    }
+    return v;
+}
+
+/* n bit two's complement back to int32 */
+static int32_t sign_extend(uint32_t v, uint32_t n)
+{
+    uint32_t sign = 1u << (n - 1);
+    return (int32_t)((v ^ sign) - sign);
+}
+
+/* ===== INTEGER COLUMNS ===== */
+static void put_diff(series_writer_t *w, int32_t d)
+{
+    if (d == 0) {
+        put_bits(w, 0x0, 1);
+    } else if (d >= -64 && d <= 63) {
+        put_bits(w, 0x2, 2);
+        put_bits(w, (uint32_t)d & 0x7F, 7);
+    } else if (d >= -256 && d <= 255) {
+        put_bits(w, 0x6, 3);
+        put_bits(w, (uint32_t)d & 0x1FF, 9);
+    } else if (d >= -2048 && d <= 2047) {
+        put_bits(w, 0xE, 4);
+        put_bits(w, (uint32_t)d & 0xFFF, 12);
+    } else {
+        put_bits(w, 0xF, 4);
+        put_bits(w, (uint32_t)d, 32);
+    }
+}
+
+int series_put_int(series_writer_t *w, series_int_t *col, int32_t v)
+{
+    if (w->bits + SERIES_INT_BITS_MAX > w->cap * 8) {
+        return SERIES_E_FULL;
+    }
+
+    uint32_t delta = (uint32_t)v - col->prev;
+    uint32_t d = (col->order == 2 && col->n == 2) ? delta - col->delta : delta;
+
+    put_diff(w, (int32_t)d);
+    col->prev = (uint32_t)v;
+    col->delta = delta;
+    if (col->n < 2) {
+        col->n++;
+    }
+    return SERIES_OK;
+}
+
+int series_get_int(series_reader_t *r, series_int_t *col, int32_t *v)
+{
+    static const uint8_t payload_bits[5] = { 0, 7, 9, 12, 32 };
+    uint32_t ones = 0;
+
+    /* Unary bucket number, at most four ones */
+    while (ones < 4) {
+        if (!has_bits(r, 1)) {
+            return SERIES_E_TRUNCATED;
+        }
+        if (get_bits(r, 1) == 0) {
+            break;
+        }
+        ones++;
+    }
+    if (!has_bits(r, payload_bits[ones])) {
+        return SERIES_E_TRUNCATED;
+    }
+
+    uint32_t d = 0;
+    if (ones == 4) {
+        d = get_bits(r, 32);
+    } else if (ones > 0) {
+        d = (uint32_t)sign_extend(get_bits(r, payload_bits[ones]), payload_bits[ones]);
+    }
+
+    uint32_t delta = (col->order == 2 && col->n == 2) ? col->delta + d : d;
+    col->prev += delta;
+    col->delta = delta;
+    if (col->n < 2) {
+        col->n++;
+    }
+    *v = (int32_t)col->prev;
+    return SERIES_OK;
+}
+
+/* ===== FLOAT COLUMNS ===== */
+int series_put_float(series_writer_t *w, series_float_t *col, float v)
+{
+    uint32_t bits;
+
+    if (w->bits + SERIES_FLOAT_BITS_MAX > w->cap * 8) {
+        return SERIES_E_FULL;
+    }
+    memcpy(&bits, &v, sizeof(bits));
+
+    uint32_t x = bits ^ col->prev;
+    col->prev = bits;
+    if (x == 0) {
+        put_bits(w, 0x0, 1);
+        return SERIES_OK;
+    }
+
+    uint32_t leading = (uint32_t)__builtin_clz(x);
+    uint32_t trailing = (uint32_t)__builtin_ctz(x);
+
+    if (col->have_window && leading >= col->leading && trailing >= col->trailing) {
+        put_bits(w, 0x2, 2);
+        put_bits(w, x >> col->trailing, 32u - col->leading - col->trailing);
+        return SERIES_OK;
+    }
+
+    uint32_t len = 32 - leading - trailing;
+    put_bits(w, 0x3, 2);
+    put_bits(w, leading, 5);
+    put_bits(w, len - 1, 5);
+    put_bits(w, x >> trailing, len);
+    col->leading = (uint8_t)leading;
+    col->trailing = (uint8_t)trailing;
+    col->have_window = 1;
+    return SERIES_OK;
+}
+
+int series_get_float(series_reader_t *r, series_float_t *col, float *v)
+{
+    uint32_t x = 0;
+
+    if (!has_bits(r, 1)) {
+        return SERIES_E_TRUNCATED;
+    }
+    if (get_bits(r, 1) == 1) {
+        if (!has_bits(r, 1)) {
+            return SERIES_E_TRUNCATED;
+        }
+        if (get_bits(r, 1) == 1) {
+            if (!has_bits(r, 10)) {
+                return SERIES_E_TRUNCATED;
+            }
+            col->leading = (uint8_t)get_bits(r, 5);
+            col->trailing = (uint8_t)(32 - col->leading - (get_bits(r, 5) + 1));
+            col->have_window = 1;
+        } else if (!col->have_window) {
+            return SERIES_E_TRUNCATED;
+        }
+
+        uint32_t len = 32u - col->leading - col->trailing;
+        if (!has_bits(r, len)) {
+            return SERIES_E_TRUNCATED;
+        }
+        x = get_bits(r, len) << col->trailing;
+    }
+
+    col->prev ^= x;
+    memcpy(v, &col->prev, sizeof(*v));
+    return SERIES_OK;
+}
+
+/* ===== VARINTS ===== */
+uint8_t *series_put_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+const uint8_t *series_get_varint(const uint8_t *p, const uint8_t *end, uint64_t *v)
+{
+    *v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+uint32_t series_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+int32_t series_unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
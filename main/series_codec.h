@@ -0,0 +1,101 @@
+#ifndef SERIES_CODEC_H
+#define SERIES_CODEC_H
+
+#include <stdint.h>
+
+/*
+ * Compression of slowly changing sample series, after Facebook's Gorilla
+ * time series store: consecutive values are coded against the ones before,
+ * so a reading that barely moved takes a few bits instead of a full field.
+ *
+ * Bit level codecs write MSB first into a byte buffer. Each column of a
+ * series keeps its own state, and rows are written column after column, so
+ * a block can be decoded as it arrives.
+ *
+ * Integer columns (timestamps, fixed point readings) code the difference of
+ * order 1 (delta) or 2 (delta of delta) in one of five buckets:
+ *
+ *   0                   0
+ *   10   + 7 bits       -64 .. 63
+ *   110  + 9 bits       -256 .. 255
+ *   1110 + 12 bits      -2048 .. 2047
+ *   1111 + 32 bits      anything else
+ *
+ * The first value is coded against 0 and, at order 2, the second as a plain
+ * delta. Arithmetic wraps at 32 bits, so any int32 or uint32 sequence round
+ * trips exactly. Regular timestamps want order 2 (one bit each); noisy
+ * readings order 1, since a second difference doubles the noise.
+ *
+ * Float columns code the XOR with the previous value's bits:
+ *
+ *   0                                       same value
+ *   10 + the bits inside the previous window of meaningful bits
+ *   11 + 5 bits leading zeros + 5 bits (length - 1) + length bits
+ *
+ * NaN payloads, infinities and -0 are kept bit for bit.
+ *
+ * Byte level varints (LEB128, with zigzag for signed values) are for
+ * formats that must stay byte aligned, like the flash sample log records.
+ */
+
+#define SERIES_OK           0
+#define SERIES_E_FULL      -1   /* not enough room; nothing was written */
+#define SERIES_E_TRUNCATED -2   /* the data ends inside a value */
+
+/* Most bits one value can take */
+#define SERIES_INT_BITS_MAX     36
+#define SERIES_FLOAT_BITS_MAX   44
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t cap;           /* bytes */
+    uint32_t bits;          /* written */
+} series_writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    uint32_t len;           /* bytes */
+    uint32_t bits;          /* read */
+} series_reader_t;
+
+/* State of one integer column; zero it, then set order to 1 or 2 */
+typedef struct {
+    uint8_t order;
+    uint8_t n;              /* values so far, saturating at 2 */
+    uint32_t prev;
+    uint32_t delta;
+} series_int_t;
+
+/* State of one float column; zero it */
+typedef struct {
+    uint32_t prev;          /* bits of the previous value */
+    uint8_t leading;        /* window of the last XOR written with a new window */
+    uint8_t trailing;
+    uint8_t have_window;
+} series_float_t;
+
+void series_writer_init(series_writer_t *w, uint8_t *buf, uint32_t cap);
+void series_reader_init(series_reader_t *r, const uint8_t *buf, uint32_t len);
+
+/* Bytes used so far, the last one padded with zero bits */
+uint32_t series_writer_bytes(const series_writer_t *w);
+
+/* Append `v` to the column; SERIES_OK or SERIES_E_FULL */
+int series_put_int(series_writer_t *w, series_int_t *col, int32_t v);
+int series_put_float(series_writer_t *w, series_float_t *col, float v);
+
+/* Read the column's next value; SERIES_OK or SERIES_E_TRUNCATED */
+int series_get_int(series_reader_t *r, series_int_t *col, int32_t *v);
+int series_get_float(series_reader_t *r, series_float_t *col, float *v);
+
+/* Byte level: returns the position after the varint */
+uint8_t *series_put_varint(uint8_t *p, uint64_t v);
+
+/* Returns the position after the varint, or NULL if it runs past `end` */
+const uint8_t *series_get_varint(const uint8_t *p, const uint8_t *end, uint64_t *v);
+
+/* Signed to unsigned so that small magnitudes give short varints */
+uint32_t series_zigzag(int32_t v);
+int32_t series_unzigzag(uint32_t v);
+
+#endif
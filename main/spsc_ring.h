@@ -0,0 +1,37 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Lock-free single-producer/single-consumer ring of fixed-size elements.
+ *
+ * One task pushes and one task pops; neither blocks. Elements are copied in
+ * and out of caller-provided storage of `capacity * elem_size` bytes, where
+ * capacity is a power of two. head and tail run freely and wrap, so all
+ * `capacity` slots are usable.
+ */
+
+typedef struct {
+    uint8_t *storage;
+    size_t elem_size;
+    uint32_t mask;
+    _Atomic uint32_t head;      /* next slot to write, owned by the producer */
+    _Atomic uint32_t tail;      /* next slot to read, owned by the consumer */
+} spsc_ring_t;
+
+/* Returns false if capacity is not a power of two */
+bool spsc_ring_init(spsc_ring_t *ring, void *storage, size_t elem_size, uint32_t capacity);
+
+/* Producer side; returns false when the ring is full */
+bool spsc_ring_push(spsc_ring_t *ring, const void *elem);
+
+/* Consumer side; returns false when the ring is empty */
+bool spsc_ring_pop(spsc_ring_t *ring, void *elem);
+
+uint32_t spsc_ring_count(const spsc_ring_t *ring);
+
+#endif
@@ -0,0 +1,628 @@
+#include <math.h>
+#include <string.h>
+
+#include "series_codec.h"
+#include "telemetry.h"
+
+const char *const telemetry_aqi_levels[TELEMETRY_N_AQI_LEVELS] = {
+    "Good",
+    "Moderate",
+    "Unhealthy for Sensitive Groups",
+    "Unhealthy",
+    "Very Unhealthy",
+    "Hazardous",
+    "Unknown",
+    "Very Low",
+    "Low",
+    "Medium",
+    "High",
+    "Very High",
+    "Satisfactory",
+    "Moderately Polluted",
+    "Poor",
+    "Very Poor",
+    "Severe",
+};
+
+/* ===== HELPERS ===== */
+uint16_t telemetry_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+/*
+ * Scale and round half to even, saturating. Like this the fixed-point value
+ * matches what printf shows at the same number of decimals.
+ */
+static uint32_t fixed_u32(float value, double scale, uint32_t max)
+{
+    double v = rint((double)value * scale);
+    if (!(v > 0.0)) {
+        return 0;
+    }
+    return (v >= (double)max) ? max : (uint32_t)v;
+}
+
+static uint16_t fixed_u16(float value, double scale)
+{
+    return (uint16_t)fixed_u32(value, scale, 65535);
+}
+
+static int16_t fixed_i16(float value, double scale)
+{
+    double v = rint((double)value * scale);
+    if (v <= -32768.0) {
+        return -32768;
+    }
+    return (v >= 32767.0) ? 32767 : (int16_t)v;
+}
+
+/* x10 like fixed_u16, with 0xFFFF for a rolling value there is none of yet (negative) */
+static uint16_t optional_u16(float value)
+{
+    return (value < 0.0f) ? 0xFFFF : (uint16_t)fixed_u32(value, 10.0, 0xFFFE);
+}
+
+static float optional_value(uint16_t v)
+{
+    return (v == 0xFFFF) ? -1.0f : v / 10.0f;
+}
+
+static int has_averages(const sensor_sample_t *s)
+{
+    const pm_average_values_t *v = &s->pm_average;
+    int any = s->aqi_nowcast >= 0.0f || s->aqi_1h >= 0.0f || s->aqi_24h >= 0.0f;
+
+    for (int p = 0; p < AQI_N_POLLUTANTS; p++) {
+        any |= v->nowcast[p] >= 0.0f || v->mean_1h[p] >= 0.0f || v->mean_24h[p] >= 0.0f;
+    }
+    return any;
+}
+
+static uint8_t aqi_level_index(const char *level)
+{
+    for (uint8_t i = 0; level != NULL && i < TELEMETRY_N_AQI_LEVELS; i++) {
+        if (level == telemetry_aqi_levels[i] || strcmp(level, telemetry_aqi_levels[i]) == 0) {
+            return i;
+        }
+    }
+    return TELEMETRY_AQI_UNKNOWN;
+}
+
+/* COBS: replace each zero with the distance to the next one */
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_pos = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        } else {
+            out[o++] = in[i];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+
+    return o;
+}
+
+static int cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t out_len)
+{
+    size_t o = 0;
+
+    for (size_t i = 0; i < len;) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return TELEMETRY_E_FRAMING;
+        }
+        for (uint8_t j = 1; j < code; j++) {
+            if (o >= out_len) {
+                return TELEMETRY_E_SIZE;
+            }
+            out[o++] = in[i++];
+        }
+        if (code != 0xFF && i < len) {
+            if (o >= out_len) {
+                return TELEMETRY_E_SIZE;
+            }
+            out[o++] = 0;
+        }
+    }
+
+    return (int)o;
+}
+
+/* ===== ENCODE ===== */
+/* CRC, COBS and the delimiters around the payload ending at `end` */
+static int finish_frame(uint8_t *payload, uint8_t *end, uint8_t *frame)
+{
+    end = put_u16(end, telemetry_crc16(payload, (size_t)(end - payload)));
+
+    frame[0] = 0;
+    size_t n = cobs_encode(payload, (size_t)(end - payload), &frame[1]);
+    frame[1 + n] = 0;
+
+    return (int)(n + 2);
+}
+
+int telemetry_encode_sample(const sensor_sample_t *s, uint16_t seq, uint8_t *frame, size_t len)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+    uint8_t *p = payload;
+    uint8_t blocks = 0;
+
+    if (len < TELEMETRY_FRAME_MAX) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    if (s->n_channels > SENSOR_CHANNEL_EXHAUST) {
+        blocks |= TELEMETRY_BLOCK_EXHAUST;
+    }
+    if (s->h2s_mv >= 0 && s->odor_mv >= 0) {
+        blocks |= TELEMETRY_BLOCK_ANALOG;
+    }
+    if (s->aqi_pollutant < AQI_N_POLLUTANTS) {
+        blocks |= TELEMETRY_BLOCK_AQI;
+    }
+    if (has_averages(s)) {
+        blocks |= TELEMETRY_BLOCK_AVERAGES;
+    }
+
+    /* Boards without optional data keep sending version 1 */
+    *p++ = blocks ? 3 : 1;
+    *p++ = TELEMETRY_TYPE_SAMPLE;
+    p = put_u16(p, seq);
+
+    p = put_u32(p, (uint32_t)(s->timestamp_us / 1000));
+    p = put_u16(p, (uint16_t)fixed_i16(s->temperature, 100.0));
+    p = put_u16(p, fixed_u16(s->humidity, 100.0));
+    p = put_u32(p, fixed_u32(s->pressure, 100.0, UINT32_MAX));
+    p = put_u16(p, fixed_u16(s->iaq, 10.0));
+    p = put_u16(p, (uint16_t)s->h2s_raw);
+    p = put_u16(p, (uint16_t)s->odor_raw);
+    p = put_u16(p, s->pm1_0);
+    p = put_u16(p, s->pm2_5);
+    p = put_u16(p, s->pm10);
+    p = put_u16(p, fixed_u16(s->aqi, 10.0));
+    *p++ = aqi_level_index(s->aqi_level);
+
+    if (blocks) {
+        *p++ = blocks;
+    }
+
+    if (blocks & TELEMETRY_BLOCK_EXHAUST) {
+        const sensor_channel_sample_t *x = &s->channels[SENSOR_CHANNEL_EXHAUST];
+
+        p = put_u16(p, (uint16_t)fixed_i16(x->temperature, 100.0));
+        p = put_u16(p, fixed_u16(x->humidity, 100.0));
+        p = put_u32(p, fixed_u32(x->pressure, 100.0, UINT32_MAX));
+        p = put_u16(p, fixed_u16(x->iaq, 10.0));
+    }
+
+    if (blocks & TELEMETRY_BLOCK_ANALOG) {
+        p = put_u16(p, (uint16_t)s->h2s_mv);
+        p = put_u16(p, (uint16_t)s->odor_mv);
+        p = put_u16(p, fixed_u16(s->h2s_noise_mv, 100.0));
+        p = put_u16(p, fixed_u16(s->odor_noise_mv, 100.0));
+    }
+
+    if (blocks & TELEMETRY_BLOCK_AQI) {
+        *p++ = s->aqi_pollutant;
+    }
+
+    if (blocks & TELEMETRY_BLOCK_AVERAGES) {
+        p = put_u16(p, optional_u16(s->aqi_nowcast));
+        p = put_u16(p, optional_u16(s->aqi_1h));
+        p = put_u16(p, optional_u16(s->aqi_24h));
+        for (int i = 0; i < AQI_N_POLLUTANTS; i++) {
+            p = put_u16(p, optional_u16(s->pm_average.nowcast[i]));
+            p = put_u16(p, optional_u16(s->pm_average.mean_1h[i]));
+            p = put_u16(p, optional_u16(s->pm_average.mean_24h[i]));
+        }
+    }
+
+    return finish_frame(payload, p, frame);
+}
+
+int telemetry_encode_scan(const heater_scan_vector_t *v, uint8_t *frame, size_t len)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+    uint8_t *p = payload;
+    uint8_t n_steps = (v->n_steps < HEATER_SCAN_MAX_STEPS) ? v->n_steps : HEATER_SCAN_MAX_STEPS;
+
+    if (len < TELEMETRY_FRAME_MAX) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    *p++ = TELEMETRY_VERSION;
+    *p++ = TELEMETRY_TYPE_GAS_SCAN;
+    p = put_u16(p, (uint16_t)v->seq);
+
+    p = put_u32(p, (uint32_t)(v->timestamp_us / 1000));
+    p = put_u16(p, (uint16_t)fixed_i16(v->temperature, 100.0));
+    p = put_u16(p, fixed_u16(v->humidity, 100.0));
+    p = put_u32(p, fixed_u32(v->pressure, 100.0, UINT32_MAX));
+    p = put_u16(p, v->stable_mask);
+    *p++ = n_steps;
+    for (uint8_t i = 0; i < n_steps; i++) {
+        p = put_u32(p, fixed_u32(v->gas_ohm[i], 1.0, UINT32_MAX));
+    }
+
+    return finish_frame(payload, p, frame);
+}
+
+int telemetry_encode_log_chunk(const telemetry_log_chunk_t *chunk, uint16_t seq, uint8_t *frame, size_t len)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+    uint8_t *p = payload;
+
+    if (len < TELEMETRY_FRAME_MAX || chunk->len > TELEMETRY_LOG_CHUNK_MAX) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    *p++ = TELEMETRY_VERSION;
+    *p++ = TELEMETRY_TYPE_LOG_CHUNK;
+    p = put_u16(p, seq);
+
+    p = put_u32(p, chunk->page_seq);
+    p = put_u16(p, chunk->offset);
+    p = put_u16(p, chunk->page_len);
+    memcpy(p, chunk->data, chunk->len);
+    p += chunk->len;
+
+    return finish_frame(payload, p, frame);
+}
+
+/* Columns of a history row after the timestamp: the mean, or count, min, mean and max of every metric */
+static int history_columns(sample_history_tier_t tier)
+{
+    return (tier == SAMPLE_HISTORY_RAW) ? SAMPLE_HISTORY_N_METRICS : 1 + 3 * SAMPLE_HISTORY_N_METRICS;
+}
+
+int telemetry_encode_history(sample_history_tier_t tier, const sample_history_point_t *points, uint32_t n,
+                             uint32_t *taken, uint16_t seq, uint8_t *frame, size_t len)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+    uint8_t *p = payload;
+    series_writer_t w;
+    series_int_t time_col = { .order = 2 };
+    series_int_t count_col = { .order = 1 };
+    series_int_t value_col[3][SAMPLE_HISTORY_N_METRICS];
+    int rollup = (tier != SAMPLE_HISTORY_RAW);
+    uint32_t i;
+
+    if (len < TELEMETRY_FRAME_MAX || (unsigned)tier >= SAMPLE_HISTORY_N_TIERS) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    *p++ = TELEMETRY_VERSION;
+    *p++ = TELEMETRY_TYPE_HISTORY;
+    p = put_u16(p, seq);
+
+    for (int c = 0; c < 3; c++) {
+        for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+            value_col[c][m] = (series_int_t){ .order = 1 };
+        }
+    }
+    series_writer_init(&w, p + 3, TELEMETRY_HISTORY_STREAM_MAX);
+
+    /* Whole rows only */
+    for (i = 0; i < n && i < TELEMETRY_HISTORY_POINTS_MAX &&
+                w.bits + SERIES_INT_BITS_MAX * (1 + history_columns(tier)) <= w.cap * 8; i++) {
+        const sample_history_point_t *point = &points[i];
+
+        series_put_int(&w, &time_col, (int32_t)(uint32_t)point->timestamp_ms);
+        if (rollup) {
+            series_put_int(&w, &count_col, point->count);
+        }
+        for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+            series_put_int(&w, &value_col[0][m], point->mean[m]);
+            if (rollup) {
+                series_put_int(&w, &value_col[1][m], point->min[m]);
+                series_put_int(&w, &value_col[2][m], point->max[m]);
+            }
+        }
+    }
+
+    p[0] = (uint8_t)tier;
+    p[1] = (uint8_t)i;
+    p[2] = SAMPLE_HISTORY_N_METRICS;
+    p += 3 + series_writer_bytes(&w);
+    *taken = i;
+
+    return finish_frame(payload, p, frame);
+}
+
+/* ===== DECODE ===== */
+/* Undo COBS into `payload` (TELEMETRY_PAYLOAD_MAX bytes) and check the CRC; returns its length */
+static int open_payload(const uint8_t *encoded, size_t len, uint8_t *payload)
+{
+    int n = cobs_decode(encoded, len, payload, TELEMETRY_PAYLOAD_MAX);
+    if (n < 0) {
+        return n;
+    }
+    if (n < 6) {
+        return TELEMETRY_E_SIZE;
+    }
+    if (telemetry_crc16(payload, (size_t)n - 2) != get_u16(&payload[n - 2])) {
+        return TELEMETRY_E_CRC;
+    }
+    return n;
+}
+
+int telemetry_decode_sample(const uint8_t *encoded, size_t len, sensor_sample_t *s, uint16_t *seq)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+    uint8_t blocks = 0;
+    size_t expect = 4 + TELEMETRY_SAMPLE_BODY_LEN + 2;
+
+    int n = open_payload(encoded, len, payload);
+    if (n < 0) {
+        return n;
+    }
+    if (payload[0] < 1 || payload[0] > TELEMETRY_VERSION || payload[1] != TELEMETRY_TYPE_SAMPLE) {
+        return TELEMETRY_E_VERSION;
+    }
+
+    const uint8_t *p = &payload[4];
+    const uint8_t *block = p + TELEMETRY_SAMPLE_BODY_LEN;
+
+    if (payload[0] == 2) {
+        blocks = TELEMETRY_BLOCK_EXHAUST;
+    } else if (payload[0] == 3) {
+        if ((size_t)n < expect + 1) {
+            return TELEMETRY_E_SIZE;
+        }
+        blocks = *block++;
+        expect++;
+        if (blocks & ~(TELEMETRY_BLOCK_EXHAUST | TELEMETRY_BLOCK_ANALOG | TELEMETRY_BLOCK_AQI |
+                       TELEMETRY_BLOCK_AVERAGES)) {
+            return TELEMETRY_E_VERSION;
+        }
+    }
+    expect += (blocks & TELEMETRY_BLOCK_EXHAUST) ? TELEMETRY_CHANNEL_BODY_LEN : 0;
+    expect += (blocks & TELEMETRY_BLOCK_ANALOG) ? TELEMETRY_ANALOG_BODY_LEN : 0;
+    expect += (blocks & TELEMETRY_BLOCK_AQI) ? TELEMETRY_AQI_BODY_LEN : 0;
+    expect += (blocks & TELEMETRY_BLOCK_AVERAGES) ? TELEMETRY_AVERAGES_BODY_LEN : 0;
+    if ((size_t)n != expect) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    *seq = get_u16(&payload[2]);
+
+    s->timestamp_us = (int64_t)get_u32(p) * 1000;
+    s->temperature = (int16_t)get_u16(p + 4) / 100.0f;
+    s->humidity = get_u16(p + 6) / 100.0f;
+    s->pressure = get_u32(p + 8) / 100.0f;
+    s->iaq = get_u16(p + 12) / 10.0f;
+    s->h2s_raw = get_u16(p + 14);
+    s->odor_raw = get_u16(p + 16);
+    s->pm1_0 = get_u16(p + 18);
+    s->pm2_5 = get_u16(p + 20);
+    s->pm10 = get_u16(p + 22);
+    s->aqi = get_u16(p + 24) / 10.0f;
+    s->aqi_level = telemetry_aqi_levels[p[26] < TELEMETRY_N_AQI_LEVELS ? p[26] : TELEMETRY_AQI_UNKNOWN];
+
+    s->n_channels = 1;
+    s->channels[SENSOR_CHANNEL_INTAKE].temperature = s->temperature;
+    s->channels[SENSOR_CHANNEL_INTAKE].humidity = s->humidity;
+    s->channels[SENSOR_CHANNEL_INTAKE].pressure = s->pressure;
+    s->channels[SENSOR_CHANNEL_INTAKE].iaq = s->iaq;
+
+    if (blocks & TELEMETRY_BLOCK_EXHAUST) {
+        sensor_channel_sample_t *x = &s->channels[SENSOR_CHANNEL_EXHAUST];
+
+        s->n_channels = 2;
+        x->temperature = (int16_t)get_u16(block) / 100.0f;
+        x->humidity = get_u16(block + 2) / 100.0f;
+        x->pressure = get_u32(block + 4) / 100.0f;
+        x->iaq = get_u16(block + 8) / 10.0f;
+        block += TELEMETRY_CHANNEL_BODY_LEN;
+    }
+
+    s->h2s_mv = -1;
+    s->odor_mv = -1;
+    s->h2s_noise_mv = 0.0f;
+    s->odor_noise_mv = 0.0f;
+    if (blocks & TELEMETRY_BLOCK_ANALOG) {
+        s->h2s_mv = get_u16(block);
+        s->odor_mv = get_u16(block + 2);
+        s->h2s_noise_mv = get_u16(block + 4) / 100.0f;
+        s->odor_noise_mv = get_u16(block + 6) / 100.0f;
+        block += TELEMETRY_ANALOG_BODY_LEN;
+    }
+
+    s->aqi_pollutant = AQI_N_POLLUTANTS;
+    if (blocks & TELEMETRY_BLOCK_AQI) {
+        s->aqi_pollutant = (*block < AQI_N_POLLUTANTS) ? *block : AQI_N_POLLUTANTS;
+        block += TELEMETRY_AQI_BODY_LEN;
+    }
+
+    uint16_t averages[TELEMETRY_AVERAGES_BODY_LEN / 2];
+    for (int i = 0; i < TELEMETRY_AVERAGES_BODY_LEN / 2; i++) {
+        averages[i] = (blocks & TELEMETRY_BLOCK_AVERAGES) ? get_u16(block + 2 * i) : 0xFFFF;
+    }
+    s->aqi_nowcast = optional_value(averages[0]);
+    s->aqi_1h = optional_value(averages[1]);
+    s->aqi_24h = optional_value(averages[2]);
+    for (int i = 0; i < AQI_N_POLLUTANTS; i++) {
+        s->pm_average.nowcast[i] = optional_value(averages[3 + 3 * i]);
+        s->pm_average.mean_1h[i] = optional_value(averages[4 + 3 * i]);
+        s->pm_average.mean_24h[i] = optional_value(averages[5 + 3 * i]);
+    }
+
+    return TELEMETRY_OK;
+}
+
+int telemetry_decode_scan(const uint8_t *encoded, size_t len, heater_scan_vector_t *v)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+
+    int n = open_payload(encoded, len, payload);
+    if (n < 0) {
+        return n;
+    }
+    if (payload[0] != TELEMETRY_VERSION || payload[1] != TELEMETRY_TYPE_GAS_SCAN) {
+        return TELEMETRY_E_VERSION;
+    }
+
+    const uint8_t *p = &payload[4];
+    if ((size_t)n < 4 + TELEMETRY_SCAN_BODY_LEN(0) + 2 || p[14] > HEATER_SCAN_MAX_STEPS ||
+        (size_t)n != (size_t)(4 + TELEMETRY_SCAN_BODY_LEN(p[14]) + 2)) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    v->seq = get_u16(&payload[2]);
+    v->timestamp_us = (int64_t)get_u32(p) * 1000;
+    v->temperature = (int16_t)get_u16(p + 4) / 100.0f;
+    v->humidity = get_u16(p + 6) / 100.0f;
+    v->pressure = get_u32(p + 8) / 100.0f;
+    v->stable_mask = get_u16(p + 12);
+    v->n_steps = p[14];
+    for (uint8_t i = 0; i < v->n_steps; i++) {
+        v->gas_ohm[i] = (float)get_u32(p + 15 + 4 * i);
+    }
+
+    return TELEMETRY_OK;
+}
+
+int telemetry_decode_log_chunk(const uint8_t *encoded, size_t len, telemetry_log_chunk_t *chunk, uint16_t *seq)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+
+    int n = open_payload(encoded, len, payload);
+    if (n < 0) {
+        return n;
+    }
+    if (payload[0] != TELEMETRY_VERSION || payload[1] != TELEMETRY_TYPE_LOG_CHUNK) {
+        return TELEMETRY_E_VERSION;
+    }
+    if (n < 4 + 8 + 2) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    const uint8_t *p = &payload[4];
+    *seq = get_u16(&payload[2]);
+    chunk->page_seq = get_u32(p);
+    chunk->offset = get_u16(p + 4);
+    chunk->page_len = get_u16(p + 6);
+    chunk->len = (uint16_t)(n - (4 + 8 + 2));
+    memcpy(chunk->data, p + 8, chunk->len);
+
+    return TELEMETRY_OK;
+}
+
+int telemetry_decode_history(const uint8_t *encoded, size_t len, sample_history_tier_t *tier,
+                             sample_history_point_t *points, uint32_t max, uint32_t *n, uint16_t *seq)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+    series_reader_t r;
+    series_int_t time_col = { .order = 2 };
+    series_int_t count_col = { .order = 1 };
+    series_int_t value_col[3][SAMPLE_HISTORY_N_METRICS];
+
+    int len_payload = open_payload(encoded, len, payload);
+    if (len_payload < 0) {
+        return len_payload;
+    }
+    if (payload[0] != TELEMETRY_VERSION || payload[1] != TELEMETRY_TYPE_HISTORY) {
+        return TELEMETRY_E_VERSION;
+    }
+    if (len_payload < 4 + 3 + 2 || payload[4] >= SAMPLE_HISTORY_N_TIERS || payload[6] != SAMPLE_HISTORY_N_METRICS) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    int rollup = (payload[4] != SAMPLE_HISTORY_RAW);
+    uint32_t count = payload[5];
+    if (count > max) {
+        return TELEMETRY_E_SIZE;
+    }
+
+    for (int c = 0; c < 3; c++) {
+        for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+            value_col[c][m] = (series_int_t){ .order = 1 };
+        }
+    }
+    series_reader_init(&r, &payload[7], (uint32_t)len_payload - (4 + 3 + 2));
+
+    for (uint32_t i = 0; i < count; i++) {
+        sample_history_point_t *point = &points[i];
+        int32_t v;
+
+        if (series_get_int(&r, &time_col, &v) != SERIES_OK) {
+            return TELEMETRY_E_SIZE;
+        }
+        point->timestamp_ms = (uint32_t)v;
+        point->count = 1;
+        if (rollup) {
+            if (series_get_int(&r, &count_col, &v) != SERIES_OK) {
+                return TELEMETRY_E_SIZE;
+            }
+            point->count = (uint16_t)v;
+        }
+        for (int m = 0; m < SAMPLE_HISTORY_N_METRICS; m++) {
+            if (series_get_int(&r, &value_col[0][m], &v) != SERIES_OK) {
+                return TELEMETRY_E_SIZE;
+            }
+            point->min[m] = (int16_t)v;
+            point->mean[m] = (int16_t)v;
+            point->max[m] = (int16_t)v;
+            if (rollup) {
+                if (series_get_int(&r, &value_col[1][m], &v) != SERIES_OK) {
+                    return TELEMETRY_E_SIZE;
+                }
+                point->min[m] = (int16_t)v;
+                if (series_get_int(&r, &value_col[2][m], &v) != SERIES_OK) {
+                    return TELEMETRY_E_SIZE;
+                }
+                point->max[m] = (int16_t)v;
+            }
+        }
+    }
+
+    *tier = (sample_history_tier_t)payload[4];
+    *seq = get_u16(&payload[2]);
+    *n = count;
+    return TELEMETRY_OK;
+}
@@ -0,0 +1,162 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sample_history.h"
+#include "sensor_pipeline.h"
+
+/*
+ * Binary framed telemetry for the UART link.
+ *
+ * A frame is 0x00, the COBS encoding of the payload, then 0x00. The leading
+ * delimiter resynchronizes the receiver after any log text on the same UART.
+ * Payload (little-endian):
+ *
+ *   u8 version, u8 type, u16 seq, body, u16 CRC-16/CCITT-FALSE of all before it
+ *
+ * Sample body, version 1 (fixed point at the precision of the JSON output):
+ *
+ *   u32 timestamp_ms, i16 temperature_cC, u16 humidity_cpct, u32 pressure_Pa,
+ *   u16 iaq_x10, u16 h2s_raw, u16 odor_raw, u16 pm1_0, u16 pm2_5, u16 pm10,
+ *   u16 aqi_x10, u8 aqi_level (index into telemetry_aqi_levels)
+ *
+ * Version 2 appends the exhaust BME680 (sent by earlier firmware, still
+ * accepted):
+ *
+ *   i16 temperature_cC, u16 humidity_cpct, u32 pressure_Pa, u16 iaq_x10
+ *
+ * Version 3 appends a u8 bitmask of the optional blocks that follow, in bit
+ * order, and is sent whenever there is one; otherwise the frame is version 1.
+ *
+ *   TELEMETRY_BLOCK_EXHAUST  the version 2 exhaust block
+ *   TELEMETRY_BLOCK_ANALOG   u16 h2s_mV, u16 odor_mV, u16 h2s_noise_cmV, u16 odor_noise_cmV
+ *   TELEMETRY_BLOCK_AQI      u8 dominant pollutant (AQI_POLLUTANT_*)
+ *   TELEMETRY_BLOCK_AVERAGES u16 x10 each of aqi_nowcast, aqi_1h, aqi_24h, then
+ *                            nowcast, 1 h and 24 h mean of PM2.5 and of PM10
+ *                            (pm_average.h); 0xFFFF while there is none
+ *
+ * Gas scan body (type TELEMETRY_TYPE_GAS_SCAN, version 3), one heater
+ * profile pass of the scan sensor; seq is the low half of the pass number:
+ *
+ *   u32 timestamp_ms, i16 temperature_cC, u16 humidity_cpct, u32 pressure_Pa,
+ *   u16 stable_mask, u8 n_steps, then n_steps x u32 gas_ohm
+ *
+ * Log chunk body (type TELEMETRY_TYPE_LOG_CHUNK, version 3), a piece of one
+ * flash page of the sample log (sample_log.h) sent by the log export
+ * command; seq is the chunk number within the export:
+ *
+ *   u32 page_seq, u16 offset, u16 page_len, then up to
+ *   TELEMETRY_LOG_CHUNK_MAX bytes of the page from offset
+ *
+ * History body (type TELEMETRY_TYPE_HISTORY, version 3), entries of one
+ * tier of the sample history (sample_history.h) sent by the history
+ * command in binary output mode; seq is the frame number within the
+ * answer:
+ *
+ *   u8 tier, u8 count, u8 n_metrics, then a series_codec.h bit stream of
+ *   count rows: timestamp_ms (low 32 bits like the sample's, integer,
+ *   order 2); in a rollup tier the bucket's sample count (integer,
+ *   order 1); then for each metric its mean, and in a rollup tier its
+ *   min and max, in the history's fixed point (integer, order 1 each)
+ *
+ * Decoders must reject frames with an unknown version; new fields go into a
+ * new version rather than changing the meaning of an existing one.
+ */
+
+#define TELEMETRY_VERSION           3   /* highest version accepted */
+#define TELEMETRY_TYPE_SAMPLE       1
+#define TELEMETRY_TYPE_GAS_SCAN     2
+#define TELEMETRY_TYPE_LOG_CHUNK    3
+#define TELEMETRY_TYPE_HISTORY      4
+
+#define TELEMETRY_BLOCK_EXHAUST     0x01
+#define TELEMETRY_BLOCK_ANALOG      0x02
+#define TELEMETRY_BLOCK_AQI         0x04
+#define TELEMETRY_BLOCK_AVERAGES    0x08
+
+#define TELEMETRY_SAMPLE_BODY_LEN   27
+#define TELEMETRY_CHANNEL_BODY_LEN  10
+#define TELEMETRY_ANALOG_BODY_LEN   8
+#define TELEMETRY_AQI_BODY_LEN      1
+#define TELEMETRY_AVERAGES_BODY_LEN 18
+#define TELEMETRY_SCAN_BODY_LEN(n)  (15 + 4 * (n))
+#define TELEMETRY_SAMPLE_PAYLOAD_MAX (4 + TELEMETRY_SAMPLE_BODY_LEN + 1 + TELEMETRY_CHANNEL_BODY_LEN + \
+                                      TELEMETRY_ANALOG_BODY_LEN + TELEMETRY_AQI_BODY_LEN + \
+                                      TELEMETRY_AVERAGES_BODY_LEN + 2)
+#define TELEMETRY_SCAN_PAYLOAD_MAX  (4 + TELEMETRY_SCAN_BODY_LEN(HEATER_SCAN_MAX_STEPS) + 2)
+#define TELEMETRY_LOG_CHUNK_MAX     232
+#define TELEMETRY_LOG_PAYLOAD_MAX   (4 + 8 + TELEMETRY_LOG_CHUNK_MAX + 2)
+#define TELEMETRY_HISTORY_STREAM_MAX (TELEMETRY_LOG_PAYLOAD_MAX - 4 - 3 - 2)
+#define TELEMETRY_HISTORY_POINTS_MAX 255
+/* The log chunk is the largest (a history frame fills the same); sized so the payload stays under one COBS block */
+#define TELEMETRY_PAYLOAD_MAX       TELEMETRY_LOG_PAYLOAD_MAX
+/* Delimiters, COBS overhead (one byte per 254) and payload */
+#define TELEMETRY_FRAME_MAX         (2 + 1 + TELEMETRY_PAYLOAD_MAX)
+
+#define TELEMETRY_OK                0
+#define TELEMETRY_E_SIZE           -1
+#define TELEMETRY_E_FRAMING        -2
+#define TELEMETRY_E_CRC            -3
+#define TELEMETRY_E_VERSION        -4
+
+#define TELEMETRY_N_AQI_LEVELS      17
+#define TELEMETRY_AQI_UNKNOWN       6
+
+/*
+ * AQI level names of all scales (aqi.h): the EPA ones, "Unknown" (also for
+ * indices past the end), then those of the other scales
+ */
+extern const char *const telemetry_aqi_levels[TELEMETRY_N_AQI_LEVELS];
+
+/* Encode `sample` as a complete frame; returns the frame length or TELEMETRY_E_SIZE */
+int telemetry_encode_sample(const sensor_sample_t *sample, uint16_t seq, uint8_t *frame, size_t len);
+
+/*
+ * Decode the bytes between two delimiters (without them) into `sample`;
+ * aqi_level points into telemetry_aqi_levels. Blocks a frame does not carry
+ * leave n_channels at 1, the millivolt fields and rolling values at -1 and
+ * aqi_pollutant at AQI_N_POLLUTANTS. Returns TELEMETRY_OK or an error.
+ */
+int telemetry_decode_sample(const uint8_t *encoded, size_t len, sensor_sample_t *sample, uint16_t *seq);
+
+/* Encode one heater scan pass as a complete frame; returns the frame length or TELEMETRY_E_SIZE */
+int telemetry_encode_scan(const heater_scan_vector_t *vector, uint8_t *frame, size_t len);
+
+/* Decode a gas scan frame; `vector->seq` gets the 16-bit frame seq. Returns TELEMETRY_OK or an error */
+int telemetry_decode_scan(const uint8_t *encoded, size_t len, heater_scan_vector_t *vector);
+
+/* A piece of a sample log page */
+typedef struct {
+    uint32_t page_seq;
+    uint16_t offset;
+    uint16_t page_len;
+    uint16_t len;
+    uint8_t data[TELEMETRY_LOG_CHUNK_MAX];
+} telemetry_log_chunk_t;
+
+/* Encode a log chunk as a complete frame; returns the frame length or TELEMETRY_E_SIZE */
+int telemetry_encode_log_chunk(const telemetry_log_chunk_t *chunk, uint16_t seq, uint8_t *frame, size_t len);
+
+/* Decode a log chunk frame; returns TELEMETRY_OK or an error */
+int telemetry_decode_log_chunk(const uint8_t *encoded, size_t len, telemetry_log_chunk_t *chunk, uint16_t *seq);
+
+/*
+ * Encode as many of the `n` entries of `tier` as fit into one history
+ * frame (only the mean of raw entries) and set *taken to how many; returns
+ * the frame length or TELEMETRY_E_SIZE
+ */
+int telemetry_encode_history(sample_history_tier_t tier, const sample_history_point_t *points, uint32_t n,
+                             uint32_t *taken, uint16_t seq, uint8_t *frame, size_t len);
+
+/*
+ * Decode a history frame into its tier and up to `max` entries and set *n
+ * to how many it held; returns TELEMETRY_OK or an error
+ */
+int telemetry_decode_history(const uint8_t *encoded, size_t len, sample_history_tier_t *tier,
+                             sample_history_point_t *points, uint32_t max, uint32_t *n, uint16_t *seq);
+
+uint16_t telemetry_crc16(const uint8_t *data, size_t len);
+
+#endif
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Decoder for the firmware's flash sample log (see main/sample_log.h).
+
+  sample_log.py image samplelog.bin [--from MS] [--to MS] > samples.csv
+  sample_log.py export [--serial PORT] [--from MS] [--to MS] > samples.csv
+
+image decodes a dump of the samplelog partition (esptool.py read_flash
+0x110000 0xF0000 samplelog.bin) or the file of air_quality_sim -L. export
+asks a connected board for the pages over the console UART with the log
+command; stop bridge.py first, it holds the port.
+
+Rows are in log time: milliseconds that continue across resets (the boot
+column marks the first sample after one).
+"""
+import argparse
+import struct
+import sys
+
+from telemetry import HISTORY_METRICS as METRICS, HISTORY_SCALE as SCALE, FrameReader, crc16
+
+MAGIC = 0x474F4C53     # "SLOG"
+FORMAT = 1
+
+# magic, format, n_metrics, pad, seq, base_ms, crc, pad
+_HEADER = struct.Struct('<IBBHIQHH')
+SECTOR = 4096
+
+
+def _varint(data, pos, end):
+    value = shift = 0
+    while pos < end:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+    raise ValueError('truncated varint')
+
+
+def _unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def decode_page(page):
+    """Records of one page as (seq, [(timestamp_ms, boot, values)]); None for no valid header"""
+    if len(page) < _HEADER.size:
+        return None
+    magic, fmt, n_metrics, _, seq, base_ms, crc, _ = _HEADER.unpack_from(page)
+    if magic != MAGIC or fmt != FORMAT or n_metrics != len(METRICS) or crc16(page[:20]) != crc:
+        return None
+
+    records = []
+    t = base_ms
+    values = [0] * len(METRICS)
+    pos = _HEADER.size
+    while pos < len(page) and page[pos] != 0xFF:
+        body_len = page[pos]
+        end = pos + 1 + body_len
+        if body_len == 0 or end + 2 > len(page) or \
+                crc16(page[pos:end]) != struct.unpack_from('<H', page, end)[0]:
+            break   # torn by a power loss; nothing after it was written
+        v, p = _varint(page, pos + 1, end)
+        t += v >> 1
+        for m in range(len(METRICS)):
+            d, p = _varint(page, p, end)
+            values[m] = (values[m] + _unzigzag(d) + 0x8000) % 0x10000 - 0x8000
+        records.append((t, v & 1, tuple(values)))
+        pos = end + 2
+    return seq, records
+
+
+def decode_pages(pages):
+    """Records of all pages in sequence order"""
+    decoded = sorted(filter(None, map(decode_page, pages)))
+    return [record for _, records in decoded for record in records]
+
+
+def image_pages(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    return [data[i:i + SECTOR] for i in range(0, len(data), SECTOR)]
+
+
+def export_pages(port, from_ms, to_ms, timeout):
+    """Run the log command on the board and reassemble the pages it sends"""
+    import serial
+
+    ser = serial.Serial(port, 115200, timeout=timeout)
+    ser.reset_input_buffer()
+    ser.write(f"log {from_ms} {to_ms}\n".encode())
+
+    reader = FrameReader()
+    pages = {}
+    while True:
+        data = ser.read(ser.in_waiting or 1)
+        if not data:
+            raise TimeoutError('no log_end from the board')
+        for sample in reader.feed(data):
+            if 'log_chunk' in sample:
+                chunk = sample['log_chunk']
+                page = pages.setdefault(chunk['page_seq'], bytearray(b'\xff' * chunk['page_len']))
+                page[chunk['offset']:chunk['offset'] + len(chunk['data'])] = chunk['data']
+            elif 'log_end' in sample:
+                end = sample['log_end']
+                print(f"{end['pages']} pages in {end['chunks']} chunks, log time now {end['now_ms']} ms",
+                      file=sys.stderr)
+                return [bytes(pages[seq]) for seq in sorted(pages)]
+
+
+def write_csv(records, from_ms, to_ms, out):
+    out.write('timestamp_ms,boot,' + ','.join(METRICS) + '\n')
+    for t, boot, values in records:
+        if from_ms <= t < to_ms:
+            out.write(f'{t},{boot},' + ','.join(f'{v / s:g}' for v, s in zip(values, SCALE)) + '\n')
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Decode the flash sample log to CSV')
+    sub = parser.add_subparsers(dest='command', required=True)
+    image = sub.add_parser('image', help='decode a partition dump or simulator file')
+    image.add_argument('file')
+    export = sub.add_parser('export', help='read the log from a board over serial')
+    export.add_argument('--serial', default='/dev/ttyUSB0')
+    export.add_argument('--timeout', type=float, default=10.0)
+    for p in (image, export):
+        p.add_argument('--from', dest='from_ms', type=int, default=0)
+        p.add_argument('--to', dest='to_ms', type=int, default=2**63 - 1)
+    args = parser.parse_args()
+
+    if args.command == 'image':
+        pages = image_pages(args.file)
+    else:
+        pages = export_pages(args.serial, args.from_ms, args.to_ms, args.timeout)
+    write_csv(decode_pages(pages), args.from_ms, args.to_ms, sys.stdout)
@@ -1,7 +1,9 @@
 #!/usr/bin/env python3
 """
-Serial Bridge: Reads JSON from ESP32 serial port and serves via HTTP
+Serial Bridge: Reads telemetry (binary frames or JSON lines) from the ESP32
+serial port and serves it via HTTP
 """
+import functools
 import serial
 import json
 import threading
@@ -9,6 +11,8 @@ import time
 from http.server import HTTPServer, BaseHTTPRequestHandler
 from urllib.parse import urlparse
 
+from telemetry import FrameReader, merge_sample
+
 PORT = 8888
 BAUD_RATE = 115200
 SERIAL_PORT = "/dev/ttyUSB0"
@@ -30,22 +34,15 @@ class SerialReader(threading.Thread):
             ser = serial.Serial(self.port, self.baud_rate, timeout=1)
             print(f"Connected to {self.port} at {self.baud_rate} baud")
             
+            reader = FrameReader()
+            
             while self.running:
                 try:
-                    raw_line = ser.readline()
-                    try:
-                        line = raw_line.decode('utf-8', errors='ignore').strip()
-                    except:
-                        continue
-                        
-                    if line.startswith('{') and line.endswith('}'):
-                        try:
-                            data = json.loads(line)
-                            with data_lock:
-                                latest_data = data
-                            print(f"Updated: {len(latest_data)} fields")
-                        except json.JSONDecodeError:
-                            pass
+                    samples = reader.feed(ser.read(ser.in_waiting or 1))
+                    if samples:
+                        with data_lock:
+                            latest_data = functools.reduce(merge_sample, samples, latest_data)
+                        print(f"Updated: {len(latest_data)} fields")
                 except Exception as e:
                     time.sleep(0.1)
         except serial.SerialException as e:
@@ -0,0 +1,378 @@
+#!/usr/bin/env python3
+"""Decoder for the firmware's framed binary telemetry (see main/telemetry.h).
+
+Frames are COBS-encoded payloads between 0x00 delimiters. Anything else on
+the serial line (ESP log text, JSON lines from the debug output mode) ends up
+in segments that fail the CRC; FrameReader passes JSON lines from those
+through unchanged so the bridge works with either firmware output mode.
+"""
+import json
+import struct
+
+VERSION = 3     # highest version understood; 1 carries no optional blocks
+TYPE_SAMPLE = 1
+TYPE_GAS_SCAN = 2
+TYPE_LOG_CHUNK = 3
+TYPE_HISTORY = 4
+
+AQI_LEVELS = (
+    "Good",
+    "Moderate",
+    "Unhealthy for Sensitive Groups",
+    "Unhealthy",
+    "Very Unhealthy",
+    "Hazardous",
+    "Unknown",
+    "Very Low",
+    "Low",
+    "Medium",
+    "High",
+    "Very High",
+    "Satisfactory",
+    "Moderately Polluted",
+    "Poor",
+    "Very Poor",
+    "Severe",
+)
+AQI_UNKNOWN = 6
+# Dominant pollutant of the AQI block (AQI_POLLUTANT_* in main/aqi.h)
+AQI_POLLUTANTS = ('pm2_5', 'pm10')
+
+# version, type, seq, then the version 1 sample body
+_SAMPLE = struct.Struct('<BBHIhHIHHHHHHHB')
+# appended in version 2: the exhaust BME680
+_EXHAUST = struct.Struct('<hHIH')
+# version 3: a block bitmask, then the blocks it names in bit order
+BLOCK_EXHAUST = 0x01
+BLOCK_ANALOG = 0x02
+BLOCK_AQI = 0x04
+BLOCK_AVERAGES = 0x08
+_ANALOG = struct.Struct('<HHHH')
+# Rolling AQI and PM means, x10, 0xFFFF while there is not enough data yet
+AVERAGE_KEYS = ('aqi_nowcast', 'aqi_1h', 'aqi_24h', 'pm2_5_nowcast', 'pm2_5_1h', 'pm2_5_24h',
+                'pm10_nowcast', 'pm10_1h', 'pm10_24h')
+_AVERAGES = struct.Struct('<9H')
+_NO_AVERAGE = 0xFFFF
+# gas scan frame: header, conditions of the last step, then n_steps x u32 ohm
+_SCAN = struct.Struct('<BBHIhHIHB')
+_GAS = struct.Struct('<I')
+# log chunk frame: header, page seq, offset and length, then the page bytes
+_LOG_CHUNK = struct.Struct('<BBHIHH')
+# history frame: header, tier, count, n_metrics, then a series_codec.h bit stream
+_HISTORY = struct.Struct('<BBHBBB')
+# Sample history tiers and metrics, in order, and the metrics' fixed point (main/sample_history.h)
+HISTORY_TIERS = ('raw', '1m', '15m', '1h')
+HISTORY_METRICS = ('temperature', 'humidity', 'pressure', 'iaq', 'pm1_0', 'pm2_5', 'pm10', 'aqi')
+HISTORY_SCALE = (100, 100, 10, 10, 1, 1, 1, 10)
+
+# Longer than any encoded frame; undelimited data past this is text
+MAX_FRAME = 260
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            out.append(len(block) + 1)
+            out += block
+            block.clear()
+        else:
+            block.append(byte)
+            if len(block) == 0xFE:
+                out.append(0xFF)
+                out += block
+                block.clear()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError('bad COBS framing')
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_frame(encoded):
+    """Decode the bytes between two delimiters into a sample dict, or raise ValueError"""
+    payload = cobs_decode(encoded)
+    if len(payload) < 6:
+        raise ValueError('short frame')
+    if crc16(payload[:-2]) != struct.unpack_from('<H', payload, len(payload) - 2)[0]:
+        raise ValueError('CRC mismatch')
+    if payload[0] == VERSION and payload[1] == TYPE_GAS_SCAN:
+        return _decode_scan(payload)
+    if payload[0] == VERSION and payload[1] == TYPE_LOG_CHUNK:
+        return _decode_log_chunk(payload)
+    if payload[0] == VERSION and payload[1] == TYPE_HISTORY:
+        return _decode_history(payload)
+    if not 1 <= payload[0] <= VERSION or payload[1] != TYPE_SAMPLE:
+        raise ValueError(f'unsupported version {payload[0]} type {payload[1]}')
+    offset = _SAMPLE.size
+    blocks = BLOCK_EXHAUST if payload[0] == 2 else 0
+    if payload[0] == 3:
+        if len(payload) < offset + 3:
+            raise ValueError('bad sample length')
+        blocks = payload[offset]
+        offset += 1
+        if blocks & ~(BLOCK_EXHAUST | BLOCK_ANALOG | BLOCK_AQI | BLOCK_AVERAGES):
+            raise ValueError(f'unknown blocks {blocks:#x}')
+    expect = offset + 2
+    expect += _EXHAUST.size if blocks & BLOCK_EXHAUST else 0
+    expect += _ANALOG.size if blocks & BLOCK_ANALOG else 0
+    expect += 1 if blocks & BLOCK_AQI else 0
+    expect += _AVERAGES.size if blocks & BLOCK_AVERAGES else 0
+    if len(payload) != expect:
+        raise ValueError('bad sample length')
+
+    (_, _, seq, timestamp_ms, temperature, humidity, pressure, iaq, h2s, odor,
+     pm1_0, pm2_5, pm10, aqi, level) = _SAMPLE.unpack_from(payload)
+
+    # Same keys and precision as the JSON output
+    sample = {
+        'seq': seq,
+        'timestamp_ms': timestamp_ms,
+        'temperature': temperature / 100,
+        'humidity': humidity / 100,
+        'pressure': pressure / 100,
+        'iaq': iaq / 10,
+        'h2s': h2s,
+        'odor': odor,
+        'pm1_0': pm1_0,
+        'pm2_5': pm2_5,
+        'pm10': pm10,
+        'aqi': aqi / 10,
+        'aqi_level': AQI_LEVELS[level] if level < len(AQI_LEVELS) else AQI_LEVELS[AQI_UNKNOWN],
+    }
+    if blocks & BLOCK_EXHAUST:
+        temperature, humidity, pressure, iaq = _EXHAUST.unpack_from(payload, offset)
+        offset += _EXHAUST.size
+        sample['exhaust'] = {
+            'temperature': temperature / 100,
+            'humidity': humidity / 100,
+            'pressure': pressure / 100,
+            'iaq': iaq / 10,
+        }
+    if blocks & BLOCK_ANALOG:
+        h2s_mv, odor_mv, h2s_noise, odor_noise = _ANALOG.unpack_from(payload, offset)
+        sample['h2s_voltage'] = h2s_mv / 1000
+        sample['odor_voltage'] = odor_mv / 1000
+        sample['h2s_noise_mv'] = h2s_noise / 100
+        sample['odor_noise_mv'] = odor_noise / 100
+        offset += _ANALOG.size
+    if blocks & BLOCK_AQI:
+        if payload[offset] < len(AQI_POLLUTANTS):
+            sample['aqi_pollutant'] = AQI_POLLUTANTS[payload[offset]]
+        offset += 1
+    if blocks & BLOCK_AVERAGES:
+        for key, value in zip(AVERAGE_KEYS, _AVERAGES.unpack_from(payload, offset)):
+            if value != _NO_AVERAGE:
+                sample[key] = value / 10
+    return sample
+
+
+def _decode_scan(payload):
+    """A heater profile pass, in the shape of the firmware's gas_scan JSON line"""
+    if len(payload) < _SCAN.size + 2:
+        raise ValueError('short gas scan')
+    (_, _, seq, timestamp_ms, temperature, humidity, pressure, stable,
+     n_steps) = _SCAN.unpack_from(payload)
+    if len(payload) != _SCAN.size + n_steps * _GAS.size + 2:
+        raise ValueError('bad gas scan length')
+    gas = [_GAS.unpack_from(payload, _SCAN.size + i * _GAS.size)[0] for i in range(n_steps)]
+    return {'gas_scan': {
+        'seq': seq,
+        'timestamp_ms': timestamp_ms,
+        'temperature': temperature / 100,
+        'humidity': humidity / 100,
+        'pressure': pressure / 100,
+        'stable': stable,
+        'gas': gas,
+    }}
+
+
+def _decode_log_chunk(payload):
+    """A piece of a sample log page from the log export (see sample_log.py)"""
+    if len(payload) < _LOG_CHUNK.size + 2:
+        raise ValueError('short log chunk')
+    _, _, seq, page_seq, offset, page_len = _LOG_CHUNK.unpack_from(payload)
+    return {'log_chunk': {
+        'seq': seq,
+        'page_seq': page_seq,
+        'offset': offset,
+        'page_len': page_len,
+        'data': payload[_LOG_CHUNK.size:-2],
+    }}
+
+
+class _Bits:
+    """MSB-first bit reader over a series_codec.h stream"""
+
+    def __init__(self, data):
+        self.value = int.from_bytes(data, 'big')
+        self.left = len(data) * 8
+
+    def read(self, n):
+        if n > self.left:
+            raise ValueError('truncated history')
+        self.left -= n
+        return (self.value >> self.left) & ((1 << n) - 1)
+
+
+class _IntColumn:
+    """Integer column of order 1 (delta) or 2 (delta of delta); wraps at 32 bits"""
+    _PAYLOAD_BITS = (0, 7, 9, 12, 32)
+
+    def __init__(self, order):
+        self.order = order
+        self.n = 0
+        self.prev = 0
+        self.delta = 0
+
+    def read(self, bits):
+        ones = 0
+        while ones < 4 and bits.read(1):
+            ones += 1
+        width = self._PAYLOAD_BITS[ones]
+        d = bits.read(width) if width else 0
+        if 0 < width < 32 and d & (1 << (width - 1)):
+            d -= 1 << width
+        delta = (self.delta + d) if self.order == 2 and self.n == 2 else d
+        self.delta = delta & 0xFFFFFFFF
+        self.prev = (self.prev + delta) & 0xFFFFFFFF
+        self.n = min(self.n + 1, 2)
+        return self.prev
+
+
+def _decode_history(payload):
+    """Entries of one history tier, as the history command's JSON lines would carry them"""
+    if len(payload) < _HISTORY.size + 2:
+        raise ValueError('short history frame')
+    _, _, seq, tier, count, n_metrics = _HISTORY.unpack_from(payload)
+    if tier >= len(HISTORY_TIERS):
+        raise ValueError(f'history frame of tier {tier}')
+    if n_metrics != len(HISTORY_METRICS):
+        raise ValueError(f'history frame with {n_metrics} metrics')
+    rollup = tier != 0
+    bits = _Bits(payload[_HISTORY.size:-2])
+    time_col = _IntColumn(2)
+    count_col = _IntColumn(1)
+    # mean, then min and max in a rollup tier
+    value_cols = [[_IntColumn(1) for _ in range(3 if rollup else 1)] for _ in HISTORY_METRICS]
+
+    def read_value(col, scale):
+        value = col.read(bits)
+        return (value - 0x10000 if value & 0x8000 else value) / scale
+
+    points = []
+    for _ in range(count):
+        point = {'timestamp_ms': time_col.read(bits), 'count': count_col.read(bits) if rollup else 1}
+        for name, scale, cols in zip(HISTORY_METRICS, HISTORY_SCALE, value_cols):
+            mean, *spread = [read_value(col, scale) for col in cols]
+            # [min, mean, max] like the JSON lines
+            point[name] = [spread[0], mean, spread[1]] if rollup else mean
+        points.append(point)
+    return {'history_block': {'seq': seq, 'tier': HISTORY_TIERS[tier], 'points': points}}
+
+
+def encode_frame(sample, seq):
+    """Encode a sample dict like the firmware does (for tests and fake sources)"""
+    level = AQI_LEVELS.index(sample['aqi_level']) if sample['aqi_level'] in AQI_LEVELS else AQI_UNKNOWN
+    exhaust = sample.get('exhaust')
+    analog = 'h2s_voltage' in sample
+    pollutant = sample.get('aqi_pollutant')
+    averages = any(key in sample for key in AVERAGE_KEYS)
+    blocks = ((BLOCK_EXHAUST if exhaust else 0) | (BLOCK_ANALOG if analog else 0) |
+              (BLOCK_AQI if pollutant else 0) | (BLOCK_AVERAGES if averages else 0))
+    payload = _SAMPLE.pack(
+        3 if blocks else 1, TYPE_SAMPLE, seq, sample['timestamp_ms'],
+        round(sample['temperature'] * 100), round(sample['humidity'] * 100),
+        round(sample['pressure'] * 100), round(sample['iaq'] * 10),
+        sample['h2s'], sample['odor'], sample['pm1_0'], sample['pm2_5'], sample['pm10'],
+        round(sample['aqi'] * 10), level)
+    if blocks:
+        payload += bytes([blocks])
+    if exhaust:
+        payload += _EXHAUST.pack(
+            round(exhaust['temperature'] * 100), round(exhaust['humidity'] * 100),
+            round(exhaust['pressure'] * 100), round(exhaust['iaq'] * 10))
+    if analog:
+        payload += _ANALOG.pack(
+            round(sample['h2s_voltage'] * 1000), round(sample['odor_voltage'] * 1000),
+            round(sample['h2s_noise_mv'] * 100), round(sample['odor_noise_mv'] * 100))
+    if pollutant:
+        payload += bytes([AQI_POLLUTANTS.index(pollutant)])
+    if averages:
+        payload += _AVERAGES.pack(*(round(sample[key] * 10) if key in sample else _NO_AVERAGE
+                                    for key in AVERAGE_KEYS))
+    payload += struct.pack('<H', crc16(payload))
+    return b'\x00' + cobs_encode(payload) + b'\x00'
+
+
+def merge_sample(data, sample):
+    """Samples replace `data`; the latest heater scan pass rides along with them"""
+    if 'gas_scan' in sample:
+        return dict(data, gas_scan=sample['gas_scan'])
+    if 'gas_scan' in data:
+        return dict(sample, gas_scan=data['gas_scan'])
+    return sample
+
+
+class FrameReader:
+    """Incremental decoder: feed() raw serial bytes, get sample dicts back"""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.frames = 0
+        self.errors = 0
+
+    def feed(self, data):
+        self.buf += data
+        *segments, self.buf = self.buf.split(b'\x00')
+        samples = []
+        for segment in segments:
+            if not segment:
+                continue
+            try:
+                samples.append(decode_frame(bytes(segment)))
+                self.frames += 1
+                continue
+            except ValueError:
+                pass
+            samples.extend(self._json_lines(segment))
+        # JSON-only output has no delimiters, so flush complete text lines
+        if len(self.buf) > MAX_FRAME and b'\n' in self.buf:
+            text, _, self.buf = self.buf.rpartition(b'\n')
+            samples.extend(self._json_lines(text))
+        return samples
+
+    def _json_lines(self, text):
+        samples = []
+        for line in text.decode('utf-8', errors='ignore').splitlines():
+            line = line.strip()
+            if line.startswith('{') and line.endswith('}'):
+                try:
+                    samples.append(json.loads(line))
+                except json.JSONDecodeError:
+                    self.errors += 1
+        return samples
@@ -5,7 +5,8 @@ let intakeData = {
     gasResistance: 50000, h2sRaw: 0, h2sVoltage: 0,
     odorRaw: 0, odorVoltage: 0, stabilization: 50, runIn: 75,
     compTemp: 25.2, compHum: 46.5,
-    pm1_0: 10, pm2_5: 25, pm10: 40, aqi: 60, aqi_level: "Moderate"
+    pm1_0: 10, pm2_5: 25, pm10: 40, aqi: null, aqi_level: "Unknown", aqi_pollutant: null,
+    aqi_nowcast: null, aqi_24h: null
 };
 
 let exhaustData = {
@@ -14,12 +15,29 @@ let exhaustData = {
     gasResistance: 80000, h2sRaw: 500, h2sVoltage: 0.4,
     odorRaw: 400, odorVoltage: 0.3, stabilization: 90, runIn: 95,
     compTemp: 26.5, compHum: 43.0,
-    pm1_0: 3, pm2_5: 8, pm10: 12, aqi: 30, aqi_level: "Good"
+    pm1_0: 3, pm2_5: 8, pm10: 12, aqi: null, aqi_level: "Unknown", aqi_pollutant: null,
+    aqi_nowcast: null, aqi_24h: null
 };
 
+const BRIDGE_URL = 'http://localhost:8888';
+const RECONNECT_MIN_MS = 1000;
+const RECONNECT_MAX_MS = 30000;
+// Failed stream attempts before checking whether the bridge only supports polling
+const STREAM_ATTEMPTS_BEFORE_PROBE = 3;
+
 let isConnected = false;
 let updateInterval = 3;
 
+// Exactly one of these is active at a time: the stream, or the single poll/reconnect timer
+let bridge = {
+    mode: 'stream',
+    source: null,
+    timer: null,
+    backoffMs: RECONNECT_MIN_MS,
+    failedAttempts: 0
+};
+let simulationTimer = null;
+
 document.addEventListener('DOMContentLoaded', () => {
     initializeTabs();
     initializeData();
@@ -31,9 +49,167 @@ document.addEventListener('DOMContentLoaded', () => {
 
 // ============== SERIAL BRIDGE CONNECTION ==============
 function connectToSerialBridge() {
+    if (window.EventSource) {
+        openStream();
+    } else {
+        startPolling();
+    }
+}
+
+// Server-Sent Events from bridge.py: one message per sample
+function openStream() {
+    bridge.timer = null;
+    const source = new EventSource(BRIDGE_URL + '/api/stream');
+    let opened = false;
+    bridge.source = source;
+
+    source.onopen = () => {
+        opened = true;
+        bridge.failedAttempts = 0;
+        bridge.backoffMs = RECONNECT_MIN_MS;
+    };
+    source.onmessage = (event) => {
+        handleSensorData(JSON.parse(event.data));
+    };
+    source.onerror = () => {
+        // Reconnect with our own backoff instead of the browser's fixed retry
+        source.close();
+        bridge.source = null;
+        bridgeLost();
+
+        if (!opened && ++bridge.failedAttempts >= STREAM_ATTEMPTS_BEFORE_PROBE) {
+            probeForPolling();
+        } else {
+            scheduleBridge(openStream, nextBackoff());
+        }
+    };
+}
+
+// The stream keeps failing: fall back to polling if the bridge answers plain requests
+function probeForPolling() {
+    bridge.failedAttempts = 0;
+    fetch(BRIDGE_URL + '/api/sensors', { mode: 'cors', method: 'GET' })
+        .then(response => {
+            if (!response.ok) throw new Error(`HTTP ${response.status}`);
+            console.warn('Bridge has no event stream, polling instead');
+            startPolling();
+        })
+        .catch(() => scheduleBridge(openStream, nextBackoff()));
+}
+
+function startPolling() {
+    bridge.mode = 'poll';
+    bridge.backoffMs = RECONNECT_MIN_MS;
     fetchSensorData();
 }
 
+function scheduleBridge(fn, delayMs) {
+    clearTimeout(bridge.timer);
+    bridge.timer = setTimeout(fn, delayMs);
+}
+
+// Exponential backoff with jitter so many dashboards don't reconnect in lockstep
+function nextBackoff() {
+    const delay = bridge.backoffMs * (0.5 + Math.random() * 0.5);
+    bridge.backoffMs = Math.min(bridge.backoffMs * 2, RECONNECT_MAX_MS);
+    return delay;
+}
+
+function bridgeLost() {
+    setConnectionStatus(false);
+    startSimulation();
+}
+
+// ============== SENSOR DATA HANDLING ==============
+function handleSensorData(data) {
+    if (data.connected === false || data.temperature === undefined) {
+        // Bridge is up but has no sample from the ESP32 (yet)
+        stopSimulation();
+        setConnectionStatus(false, 'Waiting for ESP32');
+        return;
+    }
+
+    stopSimulation();
+    applySensorData(data);
+    deriveExhaustData();
+    if (data.exhaust) applyExhaustData(data.exhaust);
+    setConnectionStatus(true);
+    updateAllDisplay();
+}
+
+// First key present in data, or the fallback (0 is a valid reading)
+function pick(data, keys, fallback) {
+    for (const key of keys) {
+        if (data[key] !== undefined && data[key] !== null) return data[key];
+    }
+    return fallback;
+}
+
+function applySensorData(data) {
+    const d = intakeData;
+    d.iaq = pick(data, ['iaq'], d.iaq);
+    d.staticIAQ = pick(data, ['static_iaq'], d.staticIAQ);
+    d.eCO2 = pick(data, ['eco2'], d.eCO2);
+    d.bVOC = pick(data, ['bvoc'], d.bVOC);
+    d.temperature = pick(data, ['temperature'], d.temperature);
+    d.humidity = pick(data, ['humidity'], d.humidity);
+    d.pressure = pick(data, ['pressure'], d.pressure);
+    d.gasResistance = pick(data, ['gas_resistance'], d.gasResistance);
+    d.h2sRaw = pick(data, ['h2s', 'h2s_raw'], d.h2sRaw);
+    d.h2sVoltage = pick(data, ['h2s_voltage'], (d.h2sRaw * 3.3 / 4095).toFixed(3));
+    d.odorRaw = pick(data, ['odor', 'odor_raw'], d.odorRaw);
+    d.odorVoltage = pick(data, ['odor_voltage'], (d.odorRaw * 3.3 / 4095).toFixed(3));
+    d.stabilization = pick(data, ['stabilization'], d.stabilization);
+    d.runIn = pick(data, ['run_in'], d.runIn);
+    d.compTemp = pick(data, ['comp_temp'], d.compTemp);
+    d.compHum = pick(data, ['comp_hum'], d.compHum);
+    d.pm1_0 = pick(data, ['pm1_0'], d.pm1_0);
+    d.pm2_5 = pick(data, ['pm2_5'], d.pm2_5);
+    d.pm10 = pick(data, ['pm10'], d.pm10);
+    d.aqi = pick(data, ['aqi'], d.aqi);
+    d.aqi_level = pick(data, ['aqi_level'], d.aqi_level);
+    // Left out by the firmware without PM readings, or until its windows hold enough data
+    d.aqi_pollutant = pick(data, ['aqi_pollutant'], null);
+    d.aqi_nowcast = pick(data, ['aqi_nowcast'], null);
+    d.aqi_24h = pick(data, ['aqi_24h'], null);
+}
+
+// Readings of the exhaust BME680, when the board has one; the rest stays derived
+function applyExhaustData(data) {
+    const d = exhaustData;
+    d.iaq = pick(data, ['iaq'], d.iaq);
+    d.temperature = pick(data, ['temperature'], d.temperature);
+    d.humidity = pick(data, ['humidity'], d.humidity);
+    d.pressure = pick(data, ['pressure'], d.pressure);
+}
+
+// Exhaust values without a sensor of their own are a reduced percentage of intake
+function deriveExhaustData() {
+    exhaustData.iaq = intakeData.iaq * 0.5;
+    exhaustData.staticIAQ = intakeData.staticIAQ * 0.5;
+    exhaustData.eCO2 = intakeData.eCO2 * 0.8;
+    exhaustData.bVOC = intakeData.bVOC * 0.4;
+    exhaustData.temperature = intakeData.temperature - 1;
+    exhaustData.humidity = intakeData.humidity - 3;
+    exhaustData.pressure = intakeData.pressure;
+    exhaustData.gasResistance = intakeData.gasResistance * 2;
+    exhaustData.h2sRaw = Math.floor(intakeData.h2sRaw * 0.3);
+    exhaustData.h2sVoltage = (exhaustData.h2sRaw * 3.3 / 4095).toFixed(3);
+    exhaustData.odorRaw = Math.floor(intakeData.odorRaw * 0.25);
+    exhaustData.odorVoltage = (exhaustData.odorRaw * 3.3 / 4095).toFixed(3);
+    exhaustData.stabilization = intakeData.stabilization;
+    exhaustData.runIn = intakeData.runIn;
+    exhaustData.compTemp = intakeData.compTemp;
+    exhaustData.compHum = intakeData.compHum;
+    
+    // PM data reduction for exhaust
+    exhaustData.pm1_0 = intakeData.pm1_0 * 0.3;
+    exhaustData.pm2_5 = intakeData.pm2_5 * 0.3;
+    exhaustData.pm10 = intakeData.pm10 * 0.3;
+
+    // The AQI comes from the firmware, on its configured scale; there is none for derived PM
+}
+
 // ============== TAB HANDLING ==============
 function initializeTabs() {
     const tabButtons = document.querySelectorAll('.tab-button');
@@ -55,98 +231,94 @@ function initializeData() {
 }
 
 // ============== SIMULATED DATA UPDATES ==============
-function simulateData() {
-    setInterval(() => {
-        intakeData.temperature += (Math.random() - 0.5) * 0.3;
-        intakeData.temperature = Math.max(20, Math.min(30, intakeData.temperature));
-        intakeData.humidity += (Math.random() - 0.5) * 2;
-        intakeData.humidity = Math.max(30, Math.min(70, intakeData.humidity));
-        intakeData.h2sRaw = Math.floor(Math.random() * 2048);
-        intakeData.h2sVoltage = (intakeData.h2sRaw * 3.3 / 4095).toFixed(3);
-        intakeData.odorRaw = Math.floor(Math.random() * 2048);
-        intakeData.odorVoltage = (intakeData.odorRaw * 3.3 / 4095).toFixed(3);
-        intakeData.iaq += (Math.random() - 0.5) * 5;
-        intakeData.iaq = Math.max(0, Math.min(500, intakeData.iaq));
-        intakeData.eCO2 += (Math.random() - 0.5) * 20;
-        intakeData.eCO2 = Math.max(400, Math.min(5000, intakeData.eCO2));
-        intakeData.bVOC += (Math.random() - 0.5) * 0.05;
-        intakeData.bVOC = Math.max(0, Math.min(5, intakeData.bVOC));
-        intakeData.gasResistance += (Math.random() - 0.5) * 5000;
-        intakeData.gasResistance = Math.max(1000, Math.min(100000, intakeData.gasResistance));
-        
-        // PM data simulation
-        intakeData.pm1_0 += (Math.random() - 0.5) * 3;
-        intakeData.pm1_0 = Math.max(0, Math.min(500, intakeData.pm1_0));
-        intakeData.pm2_5 += (Math.random() - 0.5) * 4;
-        intakeData.pm2_5 = Math.max(0, Math.min(500, intakeData.pm2_5));
-        intakeData.pm10 += (Math.random() - 0.5) * 5;
-        intakeData.pm10 = Math.max(0, Math.min(500, intakeData.pm10));
-        
-        // Calculate AQI based on PM2.5
-        calculateAQI(intakeData);
-
-        exhaustData.temperature = intakeData.temperature - 1;
-        exhaustData.humidity = intakeData.humidity - 3;
-        exhaustData.h2sRaw = Math.floor(intakeData.h2sRaw * 0.3);
-        exhaustData.h2sVoltage = (exhaustData.h2sRaw * 3.3 / 4095).toFixed(3);
-        exhaustData.odorRaw = Math.floor(intakeData.odorRaw * 0.25);
-        exhaustData.odorVoltage = (exhaustData.odorRaw * 3.3 / 4095).toFixed(3);
-        exhaustData.iaq = intakeData.iaq * 0.5;
-        exhaustData.eCO2 = intakeData.eCO2 * 0.8;
-        exhaustData.bVOC = intakeData.bVOC * 0.4;
-        exhaustData.gasResistance = intakeData.gasResistance * 2;
-        
-        // Exhaust PM data (reduced)
-        exhaustData.pm1_0 = intakeData.pm1_0 * 0.3;
-        exhaustData.pm2_5 = intakeData.pm2_5 * 0.3;
-        exhaustData.pm10 = intakeData.pm10 * 0.3;
-        
-        // Calculate AQI for exhaust
-        calculateAQI(exhaustData);
-
-        updateAllDisplay();
-    }, updateInterval * 1000);
+// Runs only while there is no bridge, so it never overwrites real data
+function startSimulation() {
+    if (simulationTimer === null) {
+        simulationTimer = setInterval(simulateData, updateInterval * 1000);
+    }
 }
 
-// ============== AQI CALCULATION ==============
-function calculateAQI(dataSet) {
-    const pm25 = dataSet.pm2_5;
+function stopSimulation() {
+    clearInterval(simulationTimer);
+    simulationTimer = null;
+}
+
+function simulateData() {
+    intakeData.temperature += (Math.random() - 0.5) * 0.3;
+    intakeData.temperature = Math.max(20, Math.min(30, intakeData.temperature));
+    intakeData.humidity += (Math.random() - 0.5) * 2;
+    intakeData.humidity = Math.max(30, Math.min(70, intakeData.humidity));
+    intakeData.h2sRaw = Math.floor(Math.random() * 2048);
+    intakeData.h2sVoltage = (intakeData.h2sRaw * 3.3 / 4095).toFixed(3);
+    intakeData.odorRaw = Math.floor(Math.random() * 2048);
+    intakeData.odorVoltage = (intakeData.odorRaw * 3.3 / 4095).toFixed(3);
+    intakeData.iaq += (Math.random() - 0.5) * 5;
+    intakeData.iaq = Math.max(0, Math.min(500, intakeData.iaq));
+    intakeData.eCO2 += (Math.random() - 0.5) * 20;
+    intakeData.eCO2 = Math.max(400, Math.min(5000, intakeData.eCO2));
+    intakeData.bVOC += (Math.random() - 0.5) * 0.05;
+    intakeData.bVOC = Math.max(0, Math.min(5, intakeData.bVOC));
+    intakeData.gasResistance += (Math.random() - 0.5) * 5000;
+    intakeData.gasResistance = Math.max(1000, Math.min(100000, intakeData.gasResistance));
     
-    if (pm25 <= 12.0) {
-        dataSet.aqi = pm25 * (50.0 / 12.0);
-        dataSet.aqi_level = "Good";
-    }
-    else if (pm25 <= 35.4) {
-        dataSet.aqi = 50.0 + (pm25 - 12.0) * ((100.0 - 50.0) / (35.4 - 12.0));
-        dataSet.aqi_level = "Moderate";
-    }
-    else if (pm25 <= 55.4) {
-        dataSet.aqi = 100.0 + (pm25 - 35.4) * ((150.0 - 100.0) / (55.4 - 35.4));
-        dataSet.aqi_level = "Unhealthy for Sensitive Groups";
-    }
-    else if (pm25 <= 150.4) {
-        dataSet.aqi = 150.0 + (pm25 - 55.4) * ((200.0 - 150.0) / (150.4 - 55.4));
-        dataSet.aqi_level = "Unhealthy";
-    }
-    else if (pm25 <= 250.4) {
-        dataSet.aqi = 200.0 + (pm25 - 150.4) * ((300.0 - 200.0) / (250.4 - 150.4));
-        dataSet.aqi_level = "Very Unhealthy";
-    }
-    else {
-        dataSet.aqi = 300.0;
-        dataSet.aqi_level = "Hazardous";
-    }
+    // PM data simulation
+    intakeData.pm1_0 += (Math.random() - 0.5) * 3;
+    intakeData.pm1_0 = Math.max(0, Math.min(500, intakeData.pm1_0));
+    intakeData.pm2_5 += (Math.random() - 0.5) * 4;
+    intakeData.pm2_5 = Math.max(0, Math.min(500, intakeData.pm2_5));
+    intakeData.pm10 += (Math.random() - 0.5) * 5;
+    intakeData.pm10 = Math.max(0, Math.min(500, intakeData.pm10));
+
+    deriveExhaustData();
+    updateAllDisplay();
 }
 
 // ============== UPDATE ALL DISPLAY ==============
+// DOM writes only happen for values that changed since the last update
+const elements = new Map();
+const rendered = new Map();
+const POLLUTANT_LABELS = { pm2_5: "PM2.5", pm10: "PM10" };
+
+function element(id) {
+    let el = elements.get(id);
+    if (el === undefined) {
+        el = document.getElementById(id);
+        elements.set(id, el);
+    }
+    return el;
+}
+
+function render(id, what, value, apply) {
+    const key = id + ':' + what;
+    if (rendered.get(key) === value) return;
+    rendered.set(key, value);
+    apply(element(id), value);
+}
+
+function setText(id, value) {
+    render(id, 'text', String(value), (el, v) => { el.textContent = v; });
+}
+
+function setClass(id, value) {
+    render(id, 'class', value, (el, v) => { el.className = v; });
+}
+
+function setWidth(id, percent) {
+    render(id, 'width', percent + '%', (el, v) => { el.style.width = v; });
+}
+
+function setTransform(id, value) {
+    render(id, 'transform', value, (el, v) => { el.setAttribute('transform', v); });
+}
+
 function updateAllDisplay() {
-    updateIntakeSensors();
-    updateExhaustSensors();
+    updateSensorPanel('intake', intakeData);
+    updateSensorPanel('exhaust', exhaustData);
 }
 
-function updateIntakeSensors() {
-    const iaqScore = Math.round(intakeData.iaq);
-    document.getElementById('intakeIaqScore').textContent = iaqScore;
+function updateSensorPanel(prefix, data) {
+    const iaqScore = Math.round(data.iaq);
+    setText(prefix + 'IaqScore', iaqScore);
     
     let status = 'Excellent';
     let statusClass = '';
@@ -156,113 +328,69 @@ function updateIntakeSensors() {
     else if (iaqScore >= 200 && iaqScore < 300) { status = 'Heavily Polluted'; statusClass = 'poor'; }
     else if (iaqScore >= 300) { status = 'Severely Polluted'; statusClass = 'poor'; }
     
-    const statusEl = document.getElementById('intakeIaqStatus');
-    statusEl.textContent = status;
-    statusEl.className = `iaq-status ${statusClass}`;
+    setText(prefix + 'IaqStatus', status);
+    setClass(prefix + 'IaqStatus', `iaq-status ${statusClass}`);
     
     const angle = (iaqScore / 500) * 180 - 90;
-    document.getElementById('intakeIaqNeedle').setAttribute('transform', `translate(100, 100) rotate(${angle})`);
+    setTransform(prefix + 'IaqNeedle', `translate(100, 100) rotate(${angle})`);
     
-    document.getElementById('intakeTemp').textContent = intakeData.temperature.toFixed(1);
-    document.getElementById('intakeHum').textContent = intakeData.humidity.toFixed(1);
-    document.getElementById('intakePres').textContent = intakeData.pressure.toFixed(1);
+    setText(prefix + 'Temp', data.temperature.toFixed(1));
+    setText(prefix + 'Hum', data.humidity.toFixed(1));
+    setText(prefix + 'Pres', data.pressure.toFixed(1));
     
-    document.getElementById('intakeH2sRaw').textContent = intakeData.h2sRaw;
-    document.getElementById('intakeH2sVolt').textContent = intakeData.h2sVoltage;
-    document.getElementById('intakeH2sBar').style.width = (intakeData.h2sRaw / 4095 * 100) + '%';
+    setText(prefix + 'H2sRaw', data.h2sRaw);
+    setText(prefix + 'H2sVolt', data.h2sVoltage);
+    setWidth(prefix + 'H2sBar', data.h2sRaw / 4095 * 100);
     
-    document.getElementById('intakeOdorRaw').textContent = intakeData.odorRaw;
-    document.getElementById('intakeOdorVolt').textContent = intakeData.odorVoltage;
-    document.getElementById('intakeOdorBar').style.width = (intakeData.odorRaw / 4095 * 100) + '%';
+    setText(prefix + 'OdorRaw', data.odorRaw);
+    setText(prefix + 'OdorVolt', data.odorVoltage);
+    setWidth(prefix + 'OdorBar', data.odorRaw / 4095 * 100);
     
-    document.getElementById('intakeEco2').textContent = Math.round(intakeData.eCO2);
-    document.getElementById('intakeBvoc').textContent = intakeData.bVOC.toFixed(2);
-    document.getElementById('intakeGas').textContent = Math.round(intakeData.gasResistance).toLocaleString();
+    setText(prefix + 'Eco2', Math.round(data.eCO2));
+    setText(prefix + 'Bvoc', data.bVOC.toFixed(2));
+    setText(prefix + 'Gas', Math.round(data.gasResistance).toLocaleString());
     
-    document.getElementById('intakePm1').textContent = Math.round(intakeData.pm1_0);
-    document.getElementById('intakePm25').textContent = Math.round(intakeData.pm2_5);
-    document.getElementById('intakePm10').textContent = Math.round(intakeData.pm10);
+    setText(prefix + 'Pm1', Math.round(data.pm1_0));
+    setText(prefix + 'Pm25', Math.round(data.pm2_5));
+    setText(prefix + 'Pm10', Math.round(data.pm10));
     
-    document.getElementById('intakeAqiScore').textContent = Math.round(intakeData.aqi);
-    const aqiLevelEl = document.getElementById('intakeAqiLevel');
-    aqiLevelEl.textContent = intakeData.aqi_level;
-    aqiLevelEl.className = 'value-lg aqi-level ' + getAQIClass(intakeData.aqi_level);
+    setText(prefix + 'AqiScore', data.aqi === null ? '--' : Math.round(data.aqi));
+    setText(prefix + 'AqiPollutant', data.aqi_pollutant ? POLLUTANT_LABELS[data.aqi_pollutant] : '');
+    setText(prefix + 'AqiLevel', data.aqi_level);
+    setClass(prefix + 'AqiLevel', 'value-lg aqi-level ' + getAQIClass(data.aqi_level));
+    setText(prefix + 'AqiNowcast', data.aqi_nowcast === null ? '--' : Math.round(data.aqi_nowcast));
+    setText(prefix + 'Aqi24h', data.aqi_24h === null ? '--' : Math.round(data.aqi_24h));
     
-    document.getElementById('intakeStab').style.width = intakeData.stabilization + '%';
-    document.getElementById('intakeStabVal').textContent = Math.round(intakeData.stabilization) + '%';
-    document.getElementById('intakeRunIn').style.width = intakeData.runIn + '%';
-    document.getElementById('intakeRunInVal').textContent = Math.round(intakeData.runIn) + '%';
+    setWidth(prefix + 'Stab', data.stabilization);
+    setText(prefix + 'StabVal', Math.round(data.stabilization) + '%');
+    setWidth(prefix + 'RunIn', data.runIn);
+    setText(prefix + 'RunInVal', Math.round(data.runIn) + '%');
 }
 
 // ============== GET AQI COLOR CLASS ==============
-function getAQIClass(level) {
-    if (level === "Good") return "aqi-good";
-    if (level === "Moderate") return "aqi-moderate";
-    if (level.includes("Unhealthy for Sensitive")) return "aqi-sensitive";
-    if (level === "Unhealthy") return "aqi-unhealthy";
-    if (level === "Very Unhealthy") return "aqi-very-unhealthy";
-    if (level === "Hazardous") return "aqi-hazardous";
-    return "";
-}
+// Levels of the other firmware scales (CAQI, NAQI) take the color of the same rank
+const AQI_CLASSES = {
+    "Good": "aqi-good", "Very Low": "aqi-good",
+    "Moderate": "aqi-moderate", "Low": "aqi-moderate", "Satisfactory": "aqi-moderate",
+    "Unhealthy for Sensitive Groups": "aqi-sensitive", "Medium": "aqi-sensitive",
+    "Moderately Polluted": "aqi-sensitive",
+    "Unhealthy": "aqi-unhealthy", "High": "aqi-unhealthy", "Poor": "aqi-unhealthy",
+    "Very Unhealthy": "aqi-very-unhealthy", "Very High": "aqi-very-unhealthy", "Very Poor": "aqi-very-unhealthy",
+    "Hazardous": "aqi-hazardous", "Severe": "aqi-hazardous",
+};
 
-function updateExhaustSensors() {
-    const iaqScore = Math.round(exhaustData.iaq);
-    document.getElementById('exhaustIaqScore').textContent = iaqScore;
-    
-    let status = 'Excellent';
-    let statusClass = '';
-    if (iaqScore >= 50 && iaqScore < 100) status = 'Good';
-    else if (iaqScore >= 100 && iaqScore < 150) { status = 'Lightly Polluted'; statusClass = 'moderate'; }
-    else if (iaqScore >= 150 && iaqScore < 200) { status = 'Moderately Polluted'; statusClass = 'moderate'; }
-    else if (iaqScore >= 200 && iaqScore < 300) { status = 'Heavily Polluted'; statusClass = 'poor'; }
-    else if (iaqScore >= 300) { status = 'Severely Polluted'; statusClass = 'poor'; }
-    
-    const statusEl = document.getElementById('exhaustIaqStatus');
-    statusEl.textContent = status;
-    statusEl.className = `iaq-status ${statusClass}`;
-    
-    const angle = (iaqScore / 500) * 180 - 90;
-    document.getElementById('exhaustIaqNeedle').setAttribute('transform', `translate(100, 100) rotate(${angle})`);
-    
-    document.getElementById('exhaustTemp').textContent = exhaustData.temperature.toFixed(1);
-    document.getElementById('exhaustHum').textContent = exhaustData.humidity.toFixed(1);
-    document.getElementById('exhaustPres').textContent = exhaustData.pressure.toFixed(1);
-    
-    document.getElementById('exhaustH2sRaw').textContent = exhaustData.h2sRaw;
-    document.getElementById('exhaustH2sVolt').textContent = exhaustData.h2sVoltage;
-    document.getElementById('exhaustH2sBar').style.width = (exhaustData.h2sRaw / 4095 * 100) + '%';
-    
-    document.getElementById('exhaustOdorRaw').textContent = exhaustData.odorRaw;
-    document.getElementById('exhaustOdorVolt').textContent = exhaustData.odorVoltage;
-    document.getElementById('exhaustOdorBar').style.width = (exhaustData.odorRaw / 4095 * 100) + '%';
-    
-    document.getElementById('exhaustEco2').textContent = Math.round(exhaustData.eCO2);
-    document.getElementById('exhaustBvoc').textContent = exhaustData.bVOC.toFixed(2);
-    document.getElementById('exhaustGas').textContent = Math.round(exhaustData.gasResistance).toLocaleString();
-    
-    document.getElementById('exhaustPm1').textContent = Math.round(exhaustData.pm1_0);
-    document.getElementById('exhaustPm25').textContent = Math.round(exhaustData.pm2_5);
-    document.getElementById('exhaustPm10').textContent = Math.round(exhaustData.pm10);
-    
-    document.getElementById('exhaustAqiScore').textContent = Math.round(exhaustData.aqi);
-    const exhaustAqiLevelEl = document.getElementById('exhaustAqiLevel');
-    exhaustAqiLevelEl.textContent = exhaustData.aqi_level;
-    exhaustAqiLevelEl.className = 'value-lg aqi-level ' + getAQIClass(exhaustData.aqi_level);
-    
-    document.getElementById('exhaustStab').style.width = exhaustData.stabilization + '%';
-    document.getElementById('exhaustStabVal').textContent = Math.round(exhaustData.stabilization) + '%';
-    document.getElementById('exhaustRunIn').style.width = exhaustData.runIn + '%';
-    document.getElementById('exhaustRunInVal').textContent = Math.round(exhaustData.runIn) + '%';
+function getAQIClass(level) {
+    return AQI_CLASSES[level] || "";
 }
 
 // ============== SETUP AUTO UPDATE ==============
 function setupAutoUpdate() {
     setConnectionStatus(false);
-    simulateData();
+    startSimulation();
 }
 
 // ============== CONNECTION STATUS ==============
-function setConnectionStatus(connected) {
+function setConnectionStatus(connected, text) {
     isConnected = connected;
     const statusDot = document.getElementById('connectionStatus');
     const statusText = document.getElementById('connectionText');
@@ -270,11 +398,11 @@ function setConnectionStatus(connected) {
     if (connected) {
         statusDot.classList.remove('disconnected');
         statusDot.classList.add('connected');
-        statusText.textContent = 'Connected to ESP32';
+        statusText.textContent = text || 'Connected to ESP32';
     } else {
         statusDot.classList.remove('connected');
         statusDot.classList.add('disconnected');
-        statusText.textContent = 'Using Simulated Data';
+        statusText.textContent = text || 'Using Simulated Data';
     }
 }
 
@@ -288,69 +416,23 @@ function updateClock() {
 }
 
 // ============== SENSOR DATA FETCHING ==============
+// Polling fallback: the next request is only scheduled once this one is done
 function fetchSensorData() {
-    const apiUrl = 'http://localhost:8888/api/sensors';
+    bridge.timer = null;
     
-    fetch(apiUrl, { mode: 'cors', method: 'GET' })
-        .then(response => response.json())
+    fetch(BRIDGE_URL + '/api/sensors', { mode: 'cors', method: 'GET' })
+        .then(response => {
+            if (!response.ok) throw new Error(`HTTP ${response.status}`);
+            return response.json();
+        })
         .then(data => {
-            intakeData = {
-                iaq: data.iaq || intakeData.iaq,
-                staticIAQ: data.static_iaq || intakeData.staticIAQ,
-                eCO2: data.eco2 || intakeData.eCO2,
-                bVOC: data.bvoc || intakeData.bVOC,
-                temperature: data.temperature || intakeData.temperature,
-                humidity: data.humidity || intakeData.humidity,
-                pressure: data.pressure || intakeData.pressure,
-                gasResistance: data.gas_resistance || intakeData.gasResistance,
-                h2sRaw: data.h2s_raw || intakeData.h2sRaw,
-                h2sVoltage: data.h2s_voltage || intakeData.h2sVoltage,
-                odorRaw: data.odor_raw || intakeData.odorRaw,
-                odorVoltage: data.odor_voltage || intakeData.odorVoltage,
-                stabilization: data.stabilization || intakeData.stabilization,
-                runIn: data.run_in || intakeData.runIn,
-                compTemp: data.comp_temp || intakeData.compTemp,
-                compHum: data.comp_hum || intakeData.compHum,
-                pm1_0: data.pm1_0 || intakeData.pm1_0,
-                pm2_5: data.pm2_5 || intakeData.pm2_5,
-                pm10: data.pm10 || intakeData.pm10,
-                aqi: data.aqi || intakeData.aqi,
-                aqi_level: data.aqi_level || intakeData.aqi_level
-            };
-            
-            // Exhaust data is reduced percentage of intake
-            exhaustData.iaq = intakeData.iaq * 0.5;
-            exhaustData.staticIAQ = intakeData.staticIAQ * 0.5;
-            exhaustData.eCO2 = intakeData.eCO2 * 0.8;
-            exhaustData.bVOC = intakeData.bVOC * 0.4;
-            exhaustData.temperature = intakeData.temperature - 1;
-            exhaustData.humidity = intakeData.humidity - 3;
-            exhaustData.pressure = intakeData.pressure;
-            exhaustData.gasResistance = intakeData.gasResistance * 2;
-            exhaustData.h2sRaw = Math.floor(intakeData.h2sRaw * 0.3);
-            exhaustData.h2sVoltage = (exhaustData.h2sRaw * 3.3 / 4095).toFixed(3);
-            exhaustData.odorRaw = Math.floor(intakeData.odorRaw * 0.25);
-            exhaustData.odorVoltage = (exhaustData.odorRaw * 3.3 / 4095).toFixed(3);
-            exhaustData.stabilization = intakeData.stabilization;
-            exhaustData.runIn = intakeData.runIn;
-            exhaustData.compTemp = intakeData.compTemp;
-            exhaustData.compHum = intakeData.compHum;
-            
-            // PM data reduction for exhaust
-            exhaustData.pm1_0 = intakeData.pm1_0 * 0.3;
-            exhaustData.pm2_5 = intakeData.pm2_5 * 0.3;
-            exhaustData.pm10 = intakeData.pm10 * 0.3;
-            
-            // Recalculate AQI for exhaust data
-            calculateAQI(exhaustData);
-            
-            setConnectionStatus(true);
-            updateAllDisplay();
+            bridge.backoffMs = RECONNECT_MIN_MS;
+            handleSensorData(data);
+            scheduleBridge(fetchSensorData, updateInterval * 1000);
         })
         .catch(error => {
             console.error('Failed to fetch sensor data:', error);
-            setConnectionStatus(false);
+            bridgeLost();
+            scheduleBridge(fetchSensorData, nextBackoff());
         });
-    
-    setInterval(fetchSensorData, 3000);
 }